@@ -0,0 +1,56 @@
+#!/bin/sh
+#
+# Runs the rule engine benchmarks and summarizes the statistics that
+# (watch statistics) prints at the end of each run.
+#
+#   run.sh [clips-executable] [benchmark ...]
+#
+# The executable defaults to the native build in ../core. Benchmarks
+# are named by their file name without the .clp extension and all of
+# them are run when none are named. Each benchmark file defines a
+# bench-setup function that asserts its data after a reset, so only
+# the run itself is measured.
+#
+# The join comparison counts are only reported by executables built
+# with DEVELOPER set in setup.h.
+
+BENCH_DIR=$(cd "$(dirname "$0")" && pwd)
+
+CLIPS=${1:-$BENCH_DIR/../core/clips}
+[ $# -gt 0 ] && shift
+BENCHMARKS=${*:-"manners waltz waltzdb arp churn cool"}
+
+if [ ! -x "$CLIPS" ]; then
+   echo "run.sh: $CLIPS is not an executable (run make in core first)" >&2
+   exit 1
+fi
+
+printf '%-10s %10s %9s %12s %10s %12s %12s\n' \
+       benchmark rules seconds rules/sec "peak KB" "l->r cmps" "r->l cmps"
+
+status=0
+for name in $BENCHMARKS; do
+   if [ ! -f "$BENCH_DIR/$name.clp" ]; then
+      echo "run.sh: no benchmark named $name" >&2
+      status=1
+      continue
+   fi
+
+   printf '(reset)\n(bench-setup)\n(watch statistics)\n(run)\n(exit)\n' |
+   "$CLIPS" -l "$BENCH_DIR/$name.clp" 2>&1 |
+   awk -v name="$name" '
+      /^\[/                           { print name ": " $0 > "/dev/stderr"; errors++ }
+      / rules fired/                  { rules = $1; seconds = ($4 == "Run") ? $7 : "-" }
+      / rules per second/             { rate = $1 }
+      / bytes of memory in use /      { peak = $7; sub(/^\(/,"",peak) }
+      / left to right comparisons/    { lr = $1 }
+      / right to left comparisons/    { rl = $1 }
+      END {
+         if (rules == "") { printf "%-10s failed\n", name; exit 1 }
+         printf "%-10s %10d %9.3f %12.0f %10d %12s %12s\n", name, rules,
+                seconds, rate, peak / 1024, (lr == "") ? "-" : lr, (rl == "") ? "-" : rl
+         exit errors > 0
+      }' || status=1
+done
+
+exit $status
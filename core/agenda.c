@@ -56,6 +56,10 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Salience groups are found by binary search of  */
+/*            a per module index. Activations refer to their */
+/*            salience group directly.                       */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
@@ -95,8 +99,11 @@
    static const char             *SalienceEvaluationName(int);
    static int                     EvaluateSalience(Environment *,Defrule *);
    static struct salienceGroup   *ReuseOrCreateSalienceGroup(Environment *,struct defruleModule *,int);
-   static struct salienceGroup   *FindSalienceGroup(struct defruleModule *,int);
+   static unsigned int            SalienceGroupPosition(struct defruleModule *,int);
+   static void                    RemoveSalienceGroup(Environment *,struct salienceGroup *,struct defruleModule *);
+   static void                    ReturnSalienceGroups(Environment *,struct defruleModule *);
    static void                    RemoveActivationFromGroup(Environment *,Activation *,struct defruleModule *);
+   static void                    ReturnSkipLinks(Environment *,Activation *);
    
 /*************************************************/
 /* InitializeAgenda: Initializes the activations */
@@ -169,6 +176,11 @@ void AddActivation(
    newActivation->randomID = genrand();
    newActivation->prev = NULL;
    newActivation->next = NULL;
+   newActivation->group = NULL;
+   newActivation->skipLinks = NULL;
+   newActivation->skipLevels = 0;
+   newActivation->recency = NULL;
+   newActivation->recencyCount = 0;
 
    AgendaData(theEnv)->NumberOfActivations++;
 
@@ -198,74 +210,195 @@ void AddActivation(
 
     theModuleItem = (struct defruleModule *) theRule->header.whichModule;
     
+    if ((AgendaData(theEnv)->Strategy == LEX_STRATEGY) ||
+        (AgendaData(theEnv)->Strategy == MEA_STRATEGY))
+      { SetActivationRecency(theEnv,newActivation); }
+
     theGroup = ReuseOrCreateSalienceGroup(theEnv,theModuleItem,newActivation->salience);
     
     PlaceActivation(theEnv,&(theModuleItem->agenda),newActivation,theGroup);
    }
 
-/*******************************/
-/* ReuseOrCreateSalienceGroup: */
-/*******************************/
+/****************************************************************/
+/* ReuseOrCreateSalienceGroup: Returns the salience group of a  */
+/*   module for the specified salience, creating it if needed.  */
+/****************************************************************/
 static struct salienceGroup *ReuseOrCreateSalienceGroup(
   Environment *theEnv,
   struct defruleModule *theRuleModule,
   int salience)
   {
-   struct salienceGroup *theGroup, *lastGroup, *newGroup;
-   
-   for (lastGroup = NULL, theGroup = theRuleModule->groupings;
-        theGroup != NULL;
-        lastGroup = theGroup, theGroup = theGroup->next)
+   struct salienceGroup *newGroup, **newIndex;
+   unsigned int position, newSize;
+   int i;
+
+   position = SalienceGroupPosition(theRuleModule,salience);
+
+   if ((position < theRuleModule->groupCount) &&
+       (theRuleModule->groupIndex[position]->salience == salience))
+     { return(theRuleModule->groupIndex[position]); }
+
+   /*=============================================*/
+   /* Grow the salience group index if necessary. */
+   /*=============================================*/
+
+   if (theRuleModule->groupCount == theRuleModule->groupIndexSize)
      {
-      if (theGroup->salience == salience)
-        { return(theGroup); }
-        
-      if (theGroup->salience < salience)
-        { break; }
+      if (theRuleModule->groupIndexSize == 0)
+        { newSize = 8; }
+      else
+        { newSize = theRuleModule->groupIndexSize * 2; }
+
+      newIndex = (struct salienceGroup **)
+                 gm2(theEnv,sizeof(struct salienceGroup *) * newSize);
+
+      if (theRuleModule->groupCount != 0)
+        {
+         memcpy(newIndex,theRuleModule->groupIndex,
+                sizeof(struct salienceGroup *) * theRuleModule->groupCount);
+        }
+
+      if (theRuleModule->groupIndex != NULL)
+        {
+         rm(theEnv,theRuleModule->groupIndex,
+            sizeof(struct salienceGroup *) * theRuleModule->groupIndexSize);
+        }
+
+      theRuleModule->groupIndex = newIndex;
+      theRuleModule->groupIndexSize = newSize;
      }
-     
+
+   /*=======================================================*/
+   /* Create the group. The index is ordered by decreasing  */
+   /* salience, so the groups adjacent to the new group in  */
+   /* the list are the neighbors of its index position.     */
+   /*=======================================================*/
+
    newGroup = get_struct(theEnv,salienceGroup);
    newGroup->salience = salience;
    newGroup->first = NULL;
    newGroup->last = NULL;
-   newGroup->next = theGroup;
-   newGroup->prev = lastGroup;
-   
+   for (i = 0; i < AGENDA_SKIP_LEVELS; i++)
+     {
+      newGroup->skipFirst[i] = NULL;
+      newGroup->skipLast[i] = NULL;
+     }
+
+   if (position < theRuleModule->groupCount)
+     { newGroup->next = theRuleModule->groupIndex[position]; }
+   else
+     { newGroup->next = NULL; }
+
+   if (position > 0)
+     { newGroup->prev = theRuleModule->groupIndex[position - 1]; }
+   else
+     { newGroup->prev = NULL; }
+
    if (newGroup->next != NULL)
      { newGroup->next->prev = newGroup; }
 
    if (newGroup->prev != NULL)
      { newGroup->prev->next = newGroup; }
-   
-   if (lastGroup == NULL)
+   else
      { theRuleModule->groupings = newGroup; }
-     
+
+   memmove(&theRuleModule->groupIndex[position + 1],
+           &theRuleModule->groupIndex[position],
+           sizeof(struct salienceGroup *) * (theRuleModule->groupCount - position));
+   theRuleModule->groupIndex[position] = newGroup;
+   theRuleModule->groupCount++;
+
    return newGroup;
   }
 
-/**********************/
-/* FindSalienceGroup: */
-/**********************/
-static struct salienceGroup *FindSalienceGroup(
+/*******************************************************************/
+/* SalienceGroupPosition: Returns the position in the salience     */
+/*   group index of a module of the first group with a salience    */
+/*   less than or equal to the specified salience.                 */
+/*******************************************************************/
+static unsigned int SalienceGroupPosition(
   struct defruleModule *theRuleModule,
   int salience)
   {
-   struct salienceGroup *theGroup;
-   
-   for (theGroup = theRuleModule->groupings;
-        theGroup != NULL;
-        theGroup = theGroup->next)
+   unsigned int low = 0, high, middle;
+
+   high = theRuleModule->groupCount;
+
+   while (low < high)
      {
-      if (theGroup->salience == salience)
-        { return(theGroup); }
-        
-      if (theGroup->salience < salience)
-        { break; }
+      middle = low + ((high - low) / 2);
+      if (theRuleModule->groupIndex[middle]->salience > salience)
+        { low = middle + 1; }
+      else
+        { high = middle; }
+     }
+
+   return low;
+  }
+
+/*****************************************************************/
+/* RemoveSalienceGroup: Removes an empty salience group from the */
+/*   group list and index of a module and returns its memory.    */
+/*****************************************************************/
+static void RemoveSalienceGroup(
+  Environment *theEnv,
+  struct salienceGroup *theGroup,
+  struct defruleModule *theRuleModule)
+  {
+   unsigned int position;
+
+   if (theGroup->prev == NULL)
+     { theRuleModule->groupings = theGroup->next; }
+   else
+     { theGroup->prev->next = theGroup->next; }
+
+   if (theGroup->next != NULL)
+     { theGroup->next->prev = theGroup->prev; }
+
+   position = SalienceGroupPosition(theRuleModule,theGroup->salience);
+   if ((position < theRuleModule->groupCount) &&
+       (theRuleModule->groupIndex[position] == theGroup))
+     {
+      theRuleModule->groupCount--;
+      memmove(&theRuleModule->groupIndex[position],
+              &theRuleModule->groupIndex[position + 1],
+              sizeof(struct salienceGroup *) * (theRuleModule->groupCount - position));
      }
-     
-   return NULL;
+
+   rtn_struct(theEnv,salienceGroup,theGroup);
   }
-  
+
+/****************************************************************/
+/* ReturnSalienceGroups: Returns the memory of all the salience */
+/*   groups of a module along with the salience group index.    */
+/****************************************************************/
+static void ReturnSalienceGroups(
+  Environment *theEnv,
+  struct defruleModule *theRuleModule)
+  {
+   struct salienceGroup *theGroup, *tempGroup;
+
+   theGroup = theRuleModule->groupings;
+   while (theGroup != NULL)
+     {
+      tempGroup = theGroup->next;
+      rtn_struct(theEnv,salienceGroup,theGroup);
+      theGroup = tempGroup;
+     }
+
+   theRuleModule->groupings = NULL;
+
+   if (theRuleModule->groupIndex != NULL)
+     {
+      rm(theEnv,theRuleModule->groupIndex,
+         sizeof(struct salienceGroup *) * theRuleModule->groupIndexSize);
+     }
+
+   theRuleModule->groupIndex = NULL;
+   theRuleModule->groupCount = 0;
+   theRuleModule->groupIndexSize = 0;
+  }
+
 /***************************************************************/
 /* ClearRuleFromAgenda: Clears the agenda of a specified rule. */
 /***************************************************************/
@@ -465,6 +598,15 @@ bool MoveActivationToTop(
 
    if (theActivation == theModuleItem->agenda) return false;
 
+   /*=====================================================*/
+   /* The activation no longer belongs to the salience    */
+   /* ordering once it has been moved, so remove it from  */
+   /* its salience group.                                 */
+   /*=====================================================*/
+
+   RemoveActivationFromGroup(theEnv,theActivation,theModuleItem);
+   ReturnSkipLinks(theEnv,theActivation);
+
    /*=================================================*/
    /* Update the pointers of the activation preceding */
    /* and following the activation being moved.       */
@@ -532,6 +674,8 @@ bool DetachActivation(
    theModuleItem = (struct defruleModule *) theActivation->theRule->header.whichModule;
 
    RemoveActivationFromGroup(theEnv,theActivation,theModuleItem);
+   ReturnSkipLinks(theEnv,theActivation);
+   ReturnActivationRecency(theEnv,theActivation);
 
    /*========================================================*/
    /* If the activation is the top activation on the agenda, */
@@ -683,22 +827,54 @@ void RemoveActivation(
 
    AgendaData(theEnv)->NumberOfActivations--;
 
+   ReturnSkipLinks(theEnv,theActivation);
+   ReturnActivationRecency(theEnv,theActivation);
    rtn_struct(theEnv,activation,theActivation);
   }
 
-/******************************/
-/* RemoveActivationFromGroup: */
-/******************************/
+/******************************************************************/
+/* RemoveActivationFromGroup: Removes an activation from the      */
+/*   skip levels of its salience group and updates the first      */
+/*   and last activations of the group. The group is removed      */
+/*   when its last remaining activation is removed.               */
+/******************************************************************/
 static void RemoveActivationFromGroup(
   Environment *theEnv,
   Activation *theActivation,
   struct defruleModule *theRuleModule)
   {
    struct salienceGroup *theGroup;
-   
-   theGroup = FindSalienceGroup(theRuleModule,theActivation->salience);
+   struct activationLink *theLink;
+   unsigned short i;
+
+   theGroup = theActivation->group;
    if (theGroup == NULL) return;
-   
+
+   theActivation->group = NULL;
+
+   /*=========================================*/
+   /* Unlink the activation from each of the  */
+   /* skip levels on which it appears.        */
+   /*=========================================*/
+
+   for (i = 0; i < theActivation->skipLevels; i++)
+     {
+      theLink = &theActivation->skipLinks[i];
+
+      if (theLink->prev == NULL)
+        { theGroup->skipFirst[i] = theLink->next; }
+      else
+        { theLink->prev->skipLinks[i].next = theLink->next; }
+
+      if (theLink->next == NULL)
+        { theGroup->skipLast[i] = theLink->prev; }
+      else
+        { theLink->next->skipLinks[i].prev = theLink->prev; }
+
+      theLink->prev = NULL;
+      theLink->next = NULL;
+     }
+
    if (theActivation == theGroup->first)
      {
       /*====================================================*/
@@ -707,17 +883,7 @@ static void RemoveActivationFromGroup(
       /*====================================================*/
       
       if (theActivation == theGroup->last)
-        {
-         if (theGroup->prev == NULL)
-           { theRuleModule->groupings = theGroup->next; }
-         else
-           { theGroup->prev->next = theGroup->next; }
-           
-         if (theGroup->next != NULL)
-           { theGroup->next->prev = theGroup->prev; }
-           
-         rtn_struct(theEnv,salienceGroup,theGroup);
-        }
+        { RemoveSalienceGroup(theEnv,theGroup,theRuleModule); }
         
       /*======================================================*/
       /* Otherwise this is the first activation in the group, */
@@ -747,6 +913,23 @@ static void RemoveActivationFromGroup(
      }
   }
 
+/****************************************************************/
+/* ReturnSkipLinks: Returns the skip level links of an          */
+/*   activation which is no longer part of a salience group.    */
+/****************************************************************/
+static void ReturnSkipLinks(
+  Environment *theEnv,
+  Activation *theActivation)
+  {
+   if (theActivation->skipLinks == NULL) return;
+
+   rtn_mem(theEnv,sizeof(struct activationLink) * theActivation->skipLevels,
+           theActivation->skipLinks);
+
+   theActivation->skipLinks = NULL;
+   theActivation->skipLevels = 0;
+  }
+
 /**************************************************************/
 /* AgendaClearFunction: Agenda clear routine for use with the */
 /*   clear command. Resets the current time tag to zero.      */
@@ -765,7 +948,6 @@ void RemoveAllActivations(
   Environment *theEnv)
   {
    struct activation *tempPtr, *theActivation;
-   struct salienceGroup *theGroup, *tempGroup;
 
    theActivation = GetDefruleModuleItem(theEnv,NULL)->agenda;
    while (theActivation != NULL)
@@ -775,14 +957,34 @@ void RemoveAllActivations(
       theActivation = tempPtr;
      }
 
-   theGroup = GetDefruleModuleItem(theEnv,NULL)->groupings;
-   while (theGroup != NULL)
+   ReturnSalienceGroups(theEnv,GetDefruleModuleItem(theEnv,NULL));
+ }
+
+/****************************************************************/
+/* ReturnModuleAgenda: Returns the memory of the activations    */
+/*   and salience groups of a defrule module without updating   */
+/*   the join network. Used when the rules are being deleted.   */
+/****************************************************************/
+void ReturnModuleAgenda(
+  Environment *theEnv,
+  struct defruleModule *theModuleItem)
+  {
+   struct activation *theActivation, *tmpActivation;
+
+   theActivation = theModuleItem->agenda;
+   while (theActivation != NULL)
      {
-      tempGroup = theGroup->next;
-      rtn_struct(theEnv,salienceGroup,theGroup);
-      theGroup = tempGroup;
+      tmpActivation = theActivation->next;
+      ReturnSkipLinks(theEnv,theActivation);
+      ReturnActivationRecency(theEnv,theActivation);
+      rtn_struct(theEnv,activation,theActivation);
+      theActivation = tmpActivation;
      }
- }
+
+   theModuleItem->agenda = NULL;
+
+   ReturnSalienceGroups(theEnv,theModuleItem);
+  }
 
 /*********************************************************/
 /* EnvGetAgendaChanged: Returns the value of the boolean */
@@ -817,7 +1019,7 @@ void EnvReorderAgenda(
    struct activation *theActivation, *tempPtr;
    bool allModules = false;
    struct defruleModule *theModuleItem;
-   struct salienceGroup *theGroup, *tempGroup;
+   struct salienceGroup *theGroup;
 
    /*=============================================*/
    /* If the module specified is a NULL pointer,  */
@@ -847,15 +1049,7 @@ void EnvReorderAgenda(
       theActivation = theModuleItem->agenda;
       theModuleItem->agenda = NULL;
 
-      theGroup = theModuleItem->groupings;
-      while (theGroup != NULL)
-        {
-         tempGroup = theGroup->next;
-         rtn_struct(theEnv,salienceGroup,theGroup);
-         theGroup = tempGroup;
-        }
-
-      theModuleItem->groupings = NULL;
+      ReturnSalienceGroups(theEnv,theModuleItem);
         
       /*=========================================*/
       /* Reorder the activations by placing them */
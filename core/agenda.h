@@ -54,6 +54,11 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Salience groups keep a skip list over their    */
+/*            activations and are indexed by salience so     */
+/*            that placement is logarithmic for every        */
+/*            conflict resolution strategy.                  */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_agenda
@@ -74,11 +79,21 @@ typedef struct activation Activation;
 
 #define MAX_DEFRULE_SALIENCE  10000
 #define MIN_DEFRULE_SALIENCE -10000
+
+#ifndef AGENDA_SKIP_LEVELS
+#define AGENDA_SKIP_LEVELS 12
+#endif
   
 /*******************/
 /* DATA STRUCTURES */
 /*******************/
 
+struct activationLink
+  {
+   struct activation *prev;
+   struct activation *next;
+  };
+
 struct activation
   {
    Defrule *theRule;
@@ -88,8 +103,21 @@ struct activation
    int randomID;
    struct activation *prev;
    struct activation *next;
+   struct salienceGroup *group;
+   struct activationLink *skipLinks;
+   unsigned short skipLevels;
+   unsigned short recencyCount;
+   unsigned long long *recency;
   };
 
+/*============================================================*/
+/* The activations of a salience group are contiguous in the  */
+/* agenda list, which serves as the bottom level of a skip    */
+/* list. Activations with skipLevels greater than zero are    */
+/* also linked into the higher levels through skipLinks, with */
+/* skipFirst and skipLast anchoring each level in the group.  */
+/*============================================================*/
+
 struct salienceGroup
   {
    int salience;
@@ -97,6 +125,8 @@ struct salienceGroup
    struct activation *last;
    struct salienceGroup *next;
    struct salienceGroup *prev;
+   struct activation *skipFirst[AGENDA_SKIP_LEVELS];
+   struct activation *skipLast[AGENDA_SKIP_LEVELS];
   };
 
 #define AGENDA_DATA 17
@@ -135,6 +165,7 @@ struct agendaData
    void                    EnvAgenda(Environment *,const char *,Defmodule *);
    void                    RemoveActivation(Environment *,Activation *,bool,bool);
    void                    RemoveAllActivations(Environment *);
+   void                    ReturnModuleAgenda(Environment *,struct defruleModule *);
    bool                    EnvGetAgendaChanged(Environment *);
    void                    EnvSetAgendaChanged(Environment *,bool);
    unsigned long           GetNumberOfActivations(Environment *);
@@ -51,6 +51,10 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added instance slot indexes to classes.        */
+/*                                                           */
+/*            Added a count of class table changes.          */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -342,6 +346,7 @@ void PrintPackedClassLinks(
   INPUTS       : The class
   RETURNS      : Nothing useful
   SIDE EFFECTS : Class inserted
+                 Count of class table changes incremented
   NOTES        : None
  *******************************************************/
 void PutClassInTable(
@@ -351,6 +356,7 @@ void PutClassInTable(
    cls->hashTableIndex = HashClass(GetDefclassNamePointer(cls));
    cls->nxtHash = DefclassData(theEnv)->ClassTable[cls->hashTableIndex];
    DefclassData(theEnv)->ClassTable[cls->hashTableIndex] = cls;
+   DefclassData(theEnv)->ClassTableChanges++;
   }
 
 /*********************************************************
@@ -359,6 +365,7 @@ void PutClassInTable(
   INPUTS       : The class
   RETURNS      : Nothing useful
   SIDE EFFECTS : Class removed
+                 Count of class table changes incremented
   NOTES        : None
  *********************************************************/
 void RemoveClassFromTable(
@@ -378,6 +385,7 @@ void RemoveClassFromTable(
      DefclassData(theEnv)->ClassTable[cls->hashTableIndex] = cls->nxtHash;
    else
      prvhsh->nxtHash = cls->nxtHash;
+   DefclassData(theEnv)->ClassTableChanges++;
   }
 
 /***************************************************
@@ -558,6 +566,7 @@ Defclass *NewClass(
    cls->nxtHash = NULL;
    cls->scopeMap = NULL;
    ClearBitString(cls->traversalRecord,TRAVERSAL_BYTES);
+   cls->slotIndexes = NULL;
    return(cls);
   }
   
@@ -752,6 +761,8 @@ void RemoveDefclass(
 
    InstallClass(theEnv,cls,false);
 
+   ReturnInstanceSlotIndexes(theEnv,cls);
+
    DeletePackedClassLinks(theEnv,&cls->directSuperclasses,false);
    DeletePackedClassLinks(theEnv,&cls->allSuperclasses,false);
    DeletePackedClassLinks(theEnv,&cls->directSubclasses,false);
@@ -822,6 +833,7 @@ void DestroyDefclass(
    DeletePackedClassLinks(theEnv,&cls->allSuperclasses,false);
    DeletePackedClassLinks(theEnv,&cls->directSubclasses,false);
 #endif
+   ReturnInstanceSlotIndexes(theEnv,cls);
    for (i = 0 ; i < cls->slotCount ; i++)
      {
       if (cls->slots[i].defaultValue != NULL)
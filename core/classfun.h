@@ -45,6 +45,9 @@
 /*                                                           */
 /*      6.50: Removed initial-object support.                */
 /*                                                           */
+/*            Added a count of class table changes for the   */
+/*            generic function dispatch caches.              */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_classfun
@@ -135,6 +138,7 @@ struct defclassData
    unsigned short CTID;
    struct token ObjectParseToken;
    unsigned short ClassDefaultsMode;
+   unsigned long ClassTableChanges;
   };
 
 #define DefclassData(theEnv) ((struct defclassData *) GetEnvironmentData(theEnv,DEFCLASS_DATA))
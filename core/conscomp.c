@@ -732,9 +732,11 @@ static bool WriteInitializationFunction(
    fprintf(fp,"  {\n");
    fprintf(fp,"   static Environment *theEnv = NULL;\n\n");
    fprintf(fp,"   if (theEnv != NULL) return NULL;\n\n");
-   fprintf(fp,"   theEnv = CreateRuntimeEnvironment(sht%d,fht%d,iht%d,bmht%d);\n\n",
-           ConstructCompilerData(theEnv)->ImageID,ConstructCompilerData(theEnv)->ImageID,
-           ConstructCompilerData(theEnv)->ImageID,ConstructCompilerData(theEnv)->ImageID);   
+   fprintf(fp,"   theEnv = CreateRuntimeEnvironment(sht%d,%luUL,fht%d,%luUL,iht%d,%luUL,bmht%d,%luUL);\n\n",
+           ConstructCompilerData(theEnv)->ImageID,GetSymbolTableSize(theEnv),
+           ConstructCompilerData(theEnv)->ImageID,GetFloatTableSize(theEnv),
+           ConstructCompilerData(theEnv)->ImageID,GetIntegerTableSize(theEnv),
+           ConstructCompilerData(theEnv)->ImageID,GetBitMapTableSize(theEnv));
 
    fprintf(fp,"   EnvClear(theEnv);\n");
 
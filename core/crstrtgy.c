@@ -50,6 +50,13 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Activations are placed by searching the skip   */
+/*            list of their salience group using a single    */
+/*            ordering predicate for each strategy.          */
+/*                                                           */
+/*            The sorted timetags used by the lex and mea    */
+/*            strategies are computed once per activation.   */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
@@ -76,16 +83,14 @@
 /* LOCAL INTERNAL FUNCTION DEFINITIONS */
 /***************************************/
 
-   static Activation             *PlaceDepthActivation(Activation *,struct salienceGroup *);
-   static Activation             *PlaceBreadthActivation(Activation *,struct salienceGroup *);
-   static Activation             *PlaceLEXActivation(Environment *,Activation *,struct salienceGroup *);
-   static Activation             *PlaceMEAActivation(Environment *,Activation *,struct salienceGroup *);
-   static Activation             *PlaceComplexityActivation(Activation *,struct salienceGroup *);
-   static Activation             *PlaceSimplicityActivation(Activation *,struct salienceGroup *);
-   static Activation             *PlaceRandomActivation(Activation *,struct salienceGroup *);
+   static Activation             *FindInsertionPoint(Environment *,Activation *,struct salienceGroup *,Activation **);
+   static void                    LinkSkipLevels(Environment *,Activation *,struct salienceGroup *,Activation **);
+   static unsigned short          SkipLevelsForTimetag(unsigned long long);
+   static bool                    PlacedBefore(Environment *,Activation *,Activation *);
+   static bool                    PlacedBeforeLast(Environment *,Activation *,Activation *);
+   static int                     CompareMEA(Environment *,Activation *,Activation *);
    static int                     ComparePartialMatches(Environment *,Activation *,Activation *);
    static const char             *GetStrategyName(int);
-   static unsigned long long     *SortPartialMatch(Environment *,struct partialMatch *);
    
 /******************************************************************/
 /* PlaceActivation: Coordinates placement of an activation on the */
@@ -97,7 +102,8 @@ void PlaceActivation(
   Activation *newActivation,
   struct salienceGroup *theGroup)
   {
-   Activation *placeAfter = NULL;
+   Activation *placeAfter, *lastAct;
+   Activation *update[AGENDA_SKIP_LEVELS];
 
    /*================================================*/
    /* Set the flag which indicates that a change has */
@@ -109,47 +115,34 @@ void PlaceActivation(
    /*=============================================*/
    /* Determine the location where the activation */
    /* should be placed in the agenda based on the */
-   /* current conflict resolution strategy.       */
-   /*==============================================*/
-
-   if (*whichAgenda != NULL) 
-     {
-      switch (AgendaData(theEnv)->Strategy)
-        {
-         case DEPTH_STRATEGY:
-           placeAfter = PlaceDepthActivation(newActivation,theGroup);
-           break;
+   /* current conflict resolution strategy. The   */
+   /* activation is placed before activations of  */
+   /* lower salience and after activations of     */
+   /* higher salience, so only its salience group */
+   /* needs to be searched.                       */
+   /*=============================================*/
 
-         case BREADTH_STRATEGY:
-           placeAfter = PlaceBreadthActivation(newActivation,theGroup);
-           break;
+   lastAct = FindInsertionPoint(theEnv,newActivation,theGroup,update);
 
-         case LEX_STRATEGY:
-           placeAfter = PlaceLEXActivation(theEnv,newActivation,theGroup);
-           break;
+   if (lastAct != NULL)
+     { placeAfter = lastAct; }
+   else if (theGroup->prev != NULL)
+     { placeAfter = theGroup->prev->last; }
+   else
+     { placeAfter = NULL; }
 
-         case MEA_STRATEGY:
-           placeAfter = PlaceMEAActivation(theEnv,newActivation,theGroup);
-           break;
+   /*========================================*/
+   /* Update the salience group information. */
+   /*========================================*/
 
-         case COMPLEXITY_STRATEGY:
-           placeAfter = PlaceComplexityActivation(newActivation,theGroup);
-           break;
+   if (lastAct == NULL)
+     { theGroup->first = newActivation; }
 
-         case SIMPLICITY_STRATEGY:
-           placeAfter = PlaceSimplicityActivation(newActivation,theGroup);
-           break;
+   if (theGroup->last == lastAct)
+     { theGroup->last = newActivation; }
 
-         case RANDOM_STRATEGY:
-           placeAfter = PlaceRandomActivation(newActivation,theGroup);
-           break;
-        }
-     } 
-   else
-     {
-      theGroup->first = newActivation;
-      theGroup->last = newActivation;
-     }
+   newActivation->group = theGroup;
+   LinkSkipLevels(theEnv,newActivation,theGroup,update);
 
    /*==============================================================*/
    /* Place the activation at the appropriate place in the agenda. */
@@ -157,6 +150,7 @@ void PlaceActivation(
 
    if (placeAfter == NULL) /* then place it at the beginning of then agenda. */
      {
+      newActivation->prev = NULL;
       newActivation->next = *whichAgenda;
       *whichAgenda = newActivation;
       if (newActivation->next != NULL) newActivation->next->prev = newActivation;
@@ -172,643 +166,372 @@ void PlaceActivation(
   }
 
 /*******************************************************************/
-/* PlaceDepthActivation: Determines the location in the agenda     */
-/*    where a new activation should be placed for the depth        */
-/*    strategy. Returns a pointer to the activation after which    */
-/*    the new activation should be placed (or NULL if the          */
-/*    activation should be placed at the beginning of the agenda). */
+/* FindInsertionPoint: Determines the location in a salience group */
+/*   where a new activation should be placed. Returns a pointer to */
+/*   the activation in the group after which the new activation    */
+/*   should be placed (or NULL if the activation should be placed  */
+/*   at the beginning of the group). The update array receives the */
+/*   activation preceding the insertion point on each skip level.  */
 /*******************************************************************/
-static Activation *PlaceDepthActivation(
+static Activation *FindInsertionPoint(
+  Environment *theEnv,
   Activation *newActivation,
-  struct salienceGroup *theGroup)
+  struct salienceGroup *theGroup,
+  Activation **update)
   {
-   Activation *lastAct, *actPtr;
-   unsigned long long timetag;
-     
-   /*============================================*/
-   /* Set up initial information for the search. */
-   /*============================================*/
-
-   timetag = newActivation->timetag;
-   if (theGroup->prev == NULL)
-     { lastAct = NULL; }
-   else
-     { lastAct = theGroup->prev->last; }
+   Activation *lastAct = NULL, *actPtr;
+   int i;
 
-   /*=========================================================*/
-   /* Find the insertion point in the agenda. The activation  */
-   /* is placed before activations of lower salience and      */
-   /* after activations of higher salience. Among activations */
-   /* of equal salience, the activation is placed before      */
-   /* activations with an equal or lower timetag (yielding    */
-   /* depth first traversal).                                 */
-   /*=========================================================*/
+   /*=====================================*/
+   /* An empty group needs no searching.  */
+   /*=====================================*/
 
-   actPtr = theGroup->first;
-   while (actPtr != NULL)
+   if (theGroup->first == NULL)
      {
-      if (timetag < actPtr->timetag)
-        {
-         lastAct = actPtr;
-         if (actPtr == theGroup->last)
-           { break; }
-         else 
-           { actPtr = actPtr->next; }
-        }
-      else
-        { break; }
+      for (i = 0; i < AGENDA_SKIP_LEVELS; i++)
+        { update[i] = NULL; }
+      return NULL;
      }
 
-   /*========================================*/
-   /* Update the salience group information. */
-   /*========================================*/
-   
-   if ((lastAct == NULL) || 
-       ((theGroup->prev != NULL) && (theGroup->prev->last == lastAct)))
-     { theGroup->first = newActivation; }
-     
-   if ((theGroup->last == NULL) || (theGroup->last == lastAct))
-     { theGroup->last = newActivation; }
-
-   /*===========================================*/
-   /* Return the insertion point in the agenda. */
-   /*===========================================*/
-
-   return(lastAct);
-  }
+   /*================================================*/
+   /* Look first at the very end of the group to see */
+   /* if the activation should be placed there. This */
+   /* is the common case for the breadth, lex, and   */
+   /* mea strategies.                                */
+   /*================================================*/
 
-/*******************************************************************/
-/* PlaceBreadthActivation: Determines the location in the agenda   */
-/*    where a new activation should be placed for the breadth      */
-/*    strategy. Returns a pointer to the activation after which    */
-/*    the new activation should be placed (or NULL if the          */
-/*    activation should be placed at the beginning of the agenda). */
-/*******************************************************************/
-static Activation *PlaceBreadthActivation(
-  Activation *newActivation,
-  struct salienceGroup *theGroup)
-  {
-   unsigned long long timetag;
-   Activation *lastAct, *actPtr;
-
-   /*============================================*/
-   /* Set up initial information for the search. */
-   /*============================================*/
-
-   timetag = newActivation->timetag;
-   if (theGroup->last == NULL)
-     {    
-      if (theGroup->prev == NULL)
-        { lastAct = NULL; }
-      else
-        { lastAct = theGroup->prev->last; }
+   if (PlacedBeforeLast(theEnv,theGroup->last,newActivation))
+     {
+      for (i = 0; i < AGENDA_SKIP_LEVELS; i++)
+        { update[i] = theGroup->skipLast[i]; }
+      return theGroup->last;
      }
-   else
-     { lastAct = theGroup->last; }
 
    /*=========================================================*/
-   /* Find the insertion point in the agenda. The activation  */
-   /* is placed before activations of lower salience and      */
-   /* after activations of higher salience. Among activations */
-   /* of equal salience, the activation is placed after       */
-   /* activations with a lessor timetag (yielding breadth     */
-   /* first traversal).                                       */
+   /* Descend the skip levels of the group. On each level,    */
+   /* advance past the activations which are placed before    */
+   /* the new activation. Activations in a group are ordered  */
+   /* by the strategy, so the activations placed before the   */
+   /* new activation always form a prefix of the group.       */
    /*=========================================================*/
 
-   actPtr = theGroup->last;
-   while (actPtr != NULL)
+   for (i = AGENDA_SKIP_LEVELS - 1; i >= 0; i--)
      {
-      if (timetag < actPtr->timetag)
-        {
-         if (actPtr == theGroup->first)
-           {
-            if (theGroup->prev == NULL)
-              { lastAct = NULL; }
-            else
-              { lastAct = theGroup->prev->last; }
-            break;
-           }
-         else 
-           { actPtr = actPtr->prev; }
-        }
+      if (lastAct == NULL)
+        { actPtr = theGroup->skipFirst[i]; }
       else
+        { actPtr = lastAct->skipLinks[i].next; }
+
+      while ((actPtr != NULL) && PlacedBefore(theEnv,actPtr,newActivation))
         {
-         lastAct = actPtr; 
-         break; 
+         lastAct = actPtr;
+         actPtr = actPtr->skipLinks[i].next;
         }
+
+      update[i] = lastAct;
      }
-     
-   /*========================================*/
-   /* Update the salience group information. */
-   /*========================================*/
-   
-   if ((lastAct == NULL) || 
-       ((theGroup->prev != NULL) && (theGroup->prev->last == lastAct)))
-     { theGroup->first = newActivation; }
-     
-   if ((theGroup->last == NULL) || (theGroup->last == lastAct))
-     { theGroup->last = newActivation; }
 
-   /*===========================================*/
-   /* Return the insertion point in the agenda. */
-   /*===========================================*/
+   /*================================================*/
+   /* Finish the search on the bottom level, which   */
+   /* is the portion of the agenda for the group.    */
+   /*================================================*/
+
+   while (lastAct != theGroup->last)
+     {
+      if (lastAct == NULL)
+        { actPtr = theGroup->first; }
+      else
+        { actPtr = lastAct->next; }
+
+      if (! PlacedBefore(theEnv,actPtr,newActivation))
+        { break; }
+
+      lastAct = actPtr;
+     }
 
-   return(lastAct);
+   return lastAct;
   }
 
-/*******************************************************************/
-/* PlaceLEXActivation: Determines the location in the agenda       */
-/*    where a new activation should be placed for the lex          */
-/*    strategy. Returns a pointer to the activation after which    */
-/*    the new activation should be placed (or NULL if the          */
-/*    activation should be placed at the beginning of the agenda). */
-/*******************************************************************/
-static Activation *PlaceLEXActivation(
+/****************************************************************/
+/* LinkSkipLevels: Links an activation into the skip levels of  */
+/*   its salience group following the activations recorded in   */
+/*   the update array by FindInsertionPoint.                    */
+/****************************************************************/
+static void LinkSkipLevels(
   Environment *theEnv,
   Activation *newActivation,
-  struct salienceGroup *theGroup)
+  struct salienceGroup *theGroup,
+  Activation **update)
   {
-   unsigned long long timetag;
-   Activation *lastAct, *actPtr;
-   int flag;
-
-   /*============================================*/
-   /* Set up initial information for the search. */
-   /*============================================*/
-
-   timetag = newActivation->timetag;
-   if (theGroup->prev == NULL)
-     { lastAct = NULL; }
-   else
-     { lastAct = theGroup->prev->last; }
+   unsigned short i;
+   Activation *nextAct;
 
    /*================================================*/
-   /* Look first at the very end of the group to see */
-   /* if the activation should be placed there.      */
+   /* The number of levels depends only on the time  */
+   /* tag, so an activation being placed again when  */
+   /* the agenda is reordered keeps its skip links.  */
    /*================================================*/
-   
-   actPtr = theGroup->last;
-   if (actPtr != NULL)
+
+   if (newActivation->skipLinks == NULL)
      {
-      flag = ComparePartialMatches(theEnv,actPtr,newActivation);
-      
-      if ((flag == LESS_THAN) ||
-          ((flag == EQUAL) &&  (timetag > actPtr->timetag)))
-        {
-         theGroup->last = newActivation; 
-         
-         return(actPtr);
-        }
+      newActivation->skipLevels = SkipLevelsForTimetag(newActivation->timetag);
+      if (newActivation->skipLevels == 0) return;
+
+      newActivation->skipLinks = (struct activationLink *)
+         get_mem(theEnv,sizeof(struct activationLink) * newActivation->skipLevels);
      }
-     
-   /*=========================================================*/
-   /* Find the insertion point in the agenda. The activation  */
-   /* is placed before activations of lower salience and      */
-   /* after activations of higher salience. Among activations */
-   /* of equal salience, the OPS5 lex strategy is used for    */
-   /* determining placement.                                  */
-   /*=========================================================*/
 
-   actPtr = theGroup->first;
-   while (actPtr != NULL)
+   for (i = 0; i < newActivation->skipLevels; i++)
      {
-      flag = ComparePartialMatches(theEnv,actPtr,newActivation);
-
-      if (flag == LESS_THAN)
+      if (update[i] == NULL)
         {
-         lastAct = actPtr;
-         if (actPtr == theGroup->last)
-           { break; }
-         else 
-           { actPtr = actPtr->next; }
+         nextAct = theGroup->skipFirst[i];
+         theGroup->skipFirst[i] = newActivation;
         }
-      else if (flag == GREATER_THAN)
-        { break; }
-      else /* flag == EQUAL */
+      else
         {
-         if (timetag > actPtr->timetag)
-           {
-            lastAct = actPtr;
-            if (actPtr == theGroup->last)
-              { break; }
-            else 
-              { actPtr = actPtr->next; }
-           }
-         else
-           { break; }
+         nextAct = update[i]->skipLinks[i].next;
+         update[i]->skipLinks[i].next = newActivation;
         }
+
+      newActivation->skipLinks[i].prev = update[i];
+      newActivation->skipLinks[i].next = nextAct;
+
+      if (nextAct == NULL)
+        { theGroup->skipLast[i] = newActivation; }
+      else
+        { nextAct->skipLinks[i].prev = newActivation; }
      }
-     
-   /*========================================*/
-   /* Update the salience group information. */
-   /*========================================*/
-   
-   if ((lastAct == NULL) || 
-       ((theGroup->prev != NULL) && (theGroup->prev->last == lastAct)))
-     { theGroup->first = newActivation; }
-     
-   if ((theGroup->last == NULL) || (theGroup->last == lastAct))
-     { theGroup->last = newActivation; }
+  }
+
+/*****************************************************************/
+/* SkipLevelsForTimetag: Returns the number of skip levels above */
+/*   the agenda list for an activation. A quarter of the         */
+/*   activations appear on each successive level. The levels are */
+/*   derived from a hash of the time tag rather than the random  */
+/*   number generator so the random strategy is not disturbed.   */
+/*****************************************************************/
+static unsigned short SkipLevelsForTimetag(
+  unsigned long long timetag)
+  {
+   unsigned long long hash;
+   unsigned short levels = 0;
 
-   /*===========================================*/
-   /* Return the insertion point in the agenda. */
-   /*===========================================*/
+   hash = ((timetag + 1) * 0x9E3779B97F4A7C15ULL) >> 32;
 
-   return(lastAct);
+   while (((hash & 0x3) == 0) && (levels < AGENDA_SKIP_LEVELS))
+     {
+      levels++;
+      hash >>= 2;
+     }
+
+   return levels;
   }
 
 /*******************************************************************/
-/* PlaceMEAActivation: Determines the location in the agenda       */
-/*    where a new activation should be placed for the mea          */
-/*    strategy. Returns a pointer to the activation after which    */
-/*    the new activation should be placed (or NULL if the          */
-/*    activation should be placed at the beginning of the agenda). */
+/* PlacedBefore: Returns true if an activation already on the      */
+/*    agenda should be placed before a new activation of the same  */
+/*    salience for the current conflict resolution strategy.       */
 /*******************************************************************/
-static Activation *PlaceMEAActivation(
+static bool PlacedBefore(
   Environment *theEnv,
-  Activation *newActivation,
-  struct salienceGroup *theGroup)
+  Activation *actPtr,
+  Activation *newActivation)
   {
-   unsigned long long timetag;
-   Activation *lastAct, *actPtr;
+   unsigned long long timetag = newActivation->timetag;
    int flag;
-   long long cWhoset = 0, oWhoset = 0;
-   bool cSet, oSet;
 
-   /*============================================*/
-   /* Set up initial information for the search. */
-   /*============================================*/
-
-   timetag = newActivation->timetag;
-   if (theGroup->prev == NULL)
-     { lastAct = NULL; }
-   else
-     { lastAct = theGroup->prev->last; }
-
-   /*================================================*/
-   /* Look first at the very end of the group to see */
-   /* if the activation should be placed there.      */
-   /*================================================*/
-   
-   actPtr = theGroup->last;
-   if (actPtr != NULL)
+   switch (AgendaData(theEnv)->Strategy)
      {
-      if (GetMatchingItem(newActivation,0) != NULL)
-        { 
-         cWhoset = GetMatchingItem(newActivation,0)->timeTag; 
-         cSet = true;
-        }
-      else
-        { cSet = false; }
-        
-      if (GetMatchingItem(actPtr,0) != NULL)
-        {
-         oWhoset = GetMatchingItem(actPtr,0)->timeTag; 
-         oSet = true;
-        }
-      else
-        { oSet = false; }
-        
-      if ((cSet == false) && (oSet == false))
-        { flag = ComparePartialMatches(theEnv,actPtr,newActivation); }
-      else if ((cSet == true) && (oSet == false))
-        { flag = GREATER_THAN; }
-      else if ((cSet == false) && (oSet == true))
-        { flag = LESS_THAN; }
-      else if (oWhoset < cWhoset)
-        { flag = GREATER_THAN; }
-      else if (oWhoset > cWhoset)
-        { flag = LESS_THAN; }
-      else
-        { flag = ComparePartialMatches(theEnv,actPtr,newActivation); }
+      /*=====================================================*/
+      /* The depth strategy places the activation before     */
+      /* activations with an equal or lower timetag.         */
+      /*=====================================================*/
 
-      if ((flag == LESS_THAN) ||
-          ((flag == EQUAL) &&  (timetag > actPtr->timetag)))
-        {
-         theGroup->last = newActivation; 
-         
-         return(actPtr);
-        }
-     }
+      case DEPTH_STRATEGY:
+        return(timetag < actPtr->timetag);
 
-   /*=========================================================*/
-   /* Find the insertion point in the agenda. The activation  */
-   /* is placed before activations of lower salience and      */
-   /* after activations of higher salience. Among activations */
-   /* of equal salience, the OPS5 mea strategy is used for    */
-   /* determining placement.                                  */
-   /*=========================================================*/
+      /*=====================================================*/
+      /* The breadth strategy places the activation after    */
+      /* activations with a lessor or equal timetag.         */
+      /*=====================================================*/
 
-   actPtr = theGroup->first;
-   while (actPtr != NULL)
-     {
-      cWhoset = -1;
-      oWhoset = -1;
-      if (GetMatchingItem(newActivation,0) != NULL)
-        { cWhoset = GetMatchingItem(newActivation,0)->timeTag; }
-        
-      if (GetMatchingItem(actPtr,0) != NULL)
-        { oWhoset = GetMatchingItem(actPtr,0)->timeTag; }
-        
-      if (oWhoset < cWhoset)
-        {
-         if (cWhoset > 0) flag = GREATER_THAN;
-         else flag = LESS_THAN;
-        }
-      else if (oWhoset > cWhoset)
-        {
-         if (oWhoset > 0) flag = LESS_THAN;
-         else flag = GREATER_THAN;
-        }
-      else
-        { flag = ComparePartialMatches(theEnv,actPtr,newActivation); }
+      case BREADTH_STRATEGY:
+        return(timetag >= actPtr->timetag);
 
-      if (flag == LESS_THAN)
-        {
-         lastAct = actPtr;
-         if (actPtr == theGroup->last)
-           { break; }
-         else 
-           { actPtr = actPtr->next; }
-        }
-      else if (flag == GREATER_THAN)
-        { break; }
-      else /* flag == EQUAL */
-        {
-         if (timetag > actPtr->timetag)
-           {
-            lastAct = actPtr;
-            if (actPtr == theGroup->last)
-              { break; }
-            else 
-              { actPtr = actPtr->next; }
-           }
-         else
-           { break; }
-        }
-     }
-     
-   /*========================================*/
-   /* Update the salience group information. */
-   /*========================================*/
-   
-   if ((lastAct == NULL) || 
-       ((theGroup->prev != NULL) && (theGroup->prev->last == lastAct)))
-     { theGroup->first = newActivation; }
-     
-   if ((theGroup->last == NULL) || (theGroup->last == lastAct))
-     { theGroup->last = newActivation; }
+      /*=====================================================*/
+      /* The OPS5 lex and mea strategies compare the sorted  */
+      /* timetags of the partial matches.                    */
+      /*=====================================================*/
 
-   /*===========================================*/
-   /* Return the insertion point in the agenda. */
-   /*===========================================*/
+      case LEX_STRATEGY:
+        flag = ComparePartialMatches(theEnv,actPtr,newActivation);
+        break;
 
-   return(lastAct);
-  }
+      case MEA_STRATEGY:
+        flag = CompareMEA(theEnv,actPtr,newActivation);
+        break;
 
-/*********************************************************************/
-/* PlaceComplexityActivation: Determines the location in the agenda  */
-/*    where a new activation should be placed for the complexity     */
-/*    strategy. Returns a pointer to the activation  after which the */
-/*    new activation should be placed (or NULL if the activation     */
-/*    should be placed at the beginning of the agenda).              */
-/*********************************************************************/
-static Activation *PlaceComplexityActivation(
-  Activation *newActivation,
-  struct salienceGroup *theGroup)
-  {
-   int complexity;
-   unsigned long long timetag;
-   Activation *lastAct, *actPtr;
+      /*=====================================================*/
+      /* The complexity strategy places the activation       */
+      /* before activations of equal or lessor complexity.   */
+      /* The simplicity strategy places the activation after */
+      /* activations of equal or greater complexity.         */
+      /*=====================================================*/
 
-   /*========================================*/
-   /* Set up initial information for search. */
-   /*========================================*/
+      case COMPLEXITY_STRATEGY:
+        if (newActivation->theRule->complexity < actPtr->theRule->complexity)
+          { flag = LESS_THAN; }
+        else if (newActivation->theRule->complexity > actPtr->theRule->complexity)
+          { flag = GREATER_THAN; }
+        else
+          { flag = EQUAL; }
+        break;
 
-   timetag = newActivation->timetag;
-   complexity = newActivation->theRule->complexity;
-   if (theGroup->prev == NULL)
-     { lastAct = NULL; }
-   else
-     { lastAct = theGroup->prev->last; }
+      case SIMPLICITY_STRATEGY:
+        if (newActivation->theRule->complexity > actPtr->theRule->complexity)
+          { flag = LESS_THAN; }
+        else if (newActivation->theRule->complexity < actPtr->theRule->complexity)
+          { flag = GREATER_THAN; }
+        else
+          { flag = EQUAL; }
+        break;
 
-   /*=========================================================*/
-   /* Find the insertion point in the agenda. The activation  */
-   /* is placed before activations of lower salience and      */
-   /* after activations of higher salience. Among activations */
-   /* of equal salience, the activation is placed before      */
-   /* activations of equal or lessor complexity.              */
-   /*=========================================================*/
+      /*=====================================================*/
+      /* The random strategy uses the random number assigned */
+      /* to the activation when it was created.              */
+      /*=====================================================*/
 
-   actPtr = theGroup->first;
-   while (actPtr != NULL)
-     {
-      if (complexity < (int) actPtr->theRule->complexity)
-        {
-         lastAct = actPtr;
-         if (actPtr == theGroup->last)
-           { break; }
-         else 
-           { actPtr = actPtr->next; }
-        }
-      else if (complexity > (int) actPtr->theRule->complexity)
-        { break; }
-      else if (timetag > actPtr->timetag)
-        {
-         lastAct = actPtr;
-         if (actPtr == theGroup->last)
-           { break; }
-         else 
-           { actPtr = actPtr->next; }
-        }
-      else
-        { break; }
+      case RANDOM_STRATEGY:
+        if (newActivation->randomID > actPtr->randomID)
+          { flag = LESS_THAN; }
+        else if (newActivation->randomID < actPtr->randomID)
+          { flag = GREATER_THAN; }
+        else
+          { flag = EQUAL; }
+        break;
+
+      default:
+        return false;
      }
-     
-   /*========================================*/
-   /* Update the salience group information. */
-   /*========================================*/
-   
-   if ((lastAct == NULL) || 
-       ((theGroup->prev != NULL) && (theGroup->prev->last == lastAct)))
-     { theGroup->first = newActivation; }
-     
-   if ((theGroup->last == NULL) || (theGroup->last == lastAct))
-     { theGroup->last = newActivation; }
 
-   /*===========================================*/
-   /* Return the insertion point in the agenda. */
-   /*===========================================*/
+   /*==================================================*/
+   /* Ties are broken by placing the activation after  */
+   /* activations with a lessor timetag.               */
+   /*==================================================*/
+
+   if (flag == LESS_THAN)
+     { return true; }
+   else if (flag == GREATER_THAN)
+     { return false; }
 
-   return(lastAct);
+   return(timetag > actPtr->timetag);
   }
 
-/*********************************************************************/
-/* PlaceSimplicityActivation: Determines the location in the agenda  */
-/*    where a new activation should be placed for the simplicity     */
-/*    strategy. Returns a pointer to the activation  after which the */
-/*    new activation should be placed (or NULL if the activation     */
-/*    should be placed at the beginning of the agenda).              */
-/*********************************************************************/
-static Activation *PlaceSimplicityActivation(
-  Activation *newActivation,
-  struct salienceGroup *theGroup)
+/*******************************************************************/
+/* PlacedBeforeLast: Returns true if the last activation of a      */
+/*   salience group should be placed before a new activation, in   */
+/*   which case the new activation is placed at the end of the     */
+/*   group. For mea, the comparison of the first pattern treats a  */
+/*   zero timetag as set, which the full search does not.          */
+/*******************************************************************/
+static bool PlacedBeforeLast(
+  Environment *theEnv,
+  Activation *actPtr,
+  Activation *newActivation)
   {
-   int complexity;
-   unsigned long long timetag;
-   Activation *lastAct, *actPtr;
-
-   /*============================================*/
-   /* Set up initial information for the search. */
-   /*============================================*/
-
-   timetag = newActivation->timetag;
-   complexity = newActivation->theRule->complexity;
-   if (theGroup->prev == NULL)
-     { lastAct = NULL; }
-   else
-     { lastAct = theGroup->prev->last; }
+   long long cWhoset = 0, oWhoset = 0;
+   bool cSet, oSet;
+   int flag;
 
-   /*=========================================================*/
-   /* Find the insertion point in the agenda. The activation  */
-   /* is placed before activations of lower salience and      */
-   /* after activations of higher salience. Among activations */
-   /* of equal salience, the activation is placed after       */
-   /* activations of equal or greater complexity.             */
-   /*=========================================================*/
+   if (AgendaData(theEnv)->Strategy != MEA_STRATEGY)
+     { return PlacedBefore(theEnv,actPtr,newActivation); }
 
-   actPtr = theGroup->first;
-   while (actPtr != NULL)
+   if (GetMatchingItem(newActivation,0) != NULL)
      {
-      if (complexity > (int) actPtr->theRule->complexity)
-        {
-         lastAct = actPtr;
-         if (actPtr == theGroup->last)
-           { break; }
-         else 
-           { actPtr = actPtr->next; }
-        }
-      else if (complexity < (int) actPtr->theRule->complexity)
-        { break; }
-      else if (timetag > actPtr->timetag)
-        {
-         lastAct = actPtr;
-         if (actPtr == theGroup->last)
-           { break; }
-         else 
-           { actPtr = actPtr->next; }
-        }
-      else
-       { break; }
+      cWhoset = GetMatchingItem(newActivation,0)->timeTag;
+      cSet = true;
      }
-     
-   /*========================================*/
-   /* Update the salience group information. */
-   /*========================================*/
-   
-   if ((lastAct == NULL) || 
-       ((theGroup->prev != NULL) && (theGroup->prev->last == lastAct)))
-     { theGroup->first = newActivation; }
-     
-   if ((theGroup->last == NULL) || (theGroup->last == lastAct))
-     { theGroup->last = newActivation; }
+   else
+     { cSet = false; }
 
-   /*===========================================*/
-   /* Return the insertion point in the agenda. */
-   /*===========================================*/
+   if (GetMatchingItem(actPtr,0) != NULL)
+     {
+      oWhoset = GetMatchingItem(actPtr,0)->timeTag;
+      oSet = true;
+     }
+   else
+     { oSet = false; }
+
+   if ((cSet == false) && (oSet == false))
+     { flag = ComparePartialMatches(theEnv,actPtr,newActivation); }
+   else if ((cSet == true) && (oSet == false))
+     { flag = GREATER_THAN; }
+   else if ((cSet == false) && (oSet == true))
+     { flag = LESS_THAN; }
+   else if (oWhoset < cWhoset)
+     { flag = GREATER_THAN; }
+   else if (oWhoset > cWhoset)
+     { flag = LESS_THAN; }
+   else
+     { flag = ComparePartialMatches(theEnv,actPtr,newActivation); }
 
-   return(lastAct);
+   if (flag == LESS_THAN)
+     { return true; }
+   else if (flag == GREATER_THAN)
+     { return false; }
+
+   return(newActivation->timetag > actPtr->timetag);
   }
 
 /*******************************************************************/
-/* PlaceRandomActivation: Determines the location in the agenda    */
-/*    where a new activation should be placed for the random       */
-/*    strategy. Returns a pointer to the activation  after which   */
-/*    the new activation should be placed (or NULL if the          */
-/*    activation should be placed at the beginning of the agenda). */
+/* CompareMEA: Compares two activations using the mea conflict     */
+/*   resolution strategy. The timetag of the first pattern takes   */
+/*   precedence, followed by the lex comparison.                   */
 /*******************************************************************/
-static Activation *PlaceRandomActivation(
-  Activation *newActivation,
-  struct salienceGroup *theGroup)
+static int CompareMEA(
+  Environment *theEnv,
+  Activation *actPtr,
+  Activation *newActivation)
   {
-   int randomID;
-   unsigned long long timetag;
-   Activation *lastAct, *actPtr;
-
-   /*============================================*/
-   /* Set up initial information for the search. */
-   /*============================================*/
-
-   timetag = newActivation->timetag;
-   randomID = newActivation->randomID;
-   if (theGroup->prev == NULL)
-     { lastAct = NULL; }
-   else
-     { lastAct = theGroup->prev->last; }
+   long long cWhoset = -1, oWhoset = -1;
 
-   /*=========================================================*/
-   /* Find the insertion point in the agenda. The activation  */
-   /* is placed before activations of lower salience and      */
-   /* after activations of higher salience. Among activations */
-   /* of equal salience, the placement of the activation is   */
-   /* determined through the generation of a random number.   */
-   /*=========================================================*/
+   if (GetMatchingItem(newActivation,0) != NULL)
+     { cWhoset = GetMatchingItem(newActivation,0)->timeTag; }
+
+   if (GetMatchingItem(actPtr,0) != NULL)
+     { oWhoset = GetMatchingItem(actPtr,0)->timeTag; }
 
-   actPtr = theGroup->first;
-   while (actPtr != NULL)
+   if (oWhoset < cWhoset)
      {
-      if (randomID > actPtr->randomID)
-        {
-         lastAct = actPtr;
-         if (actPtr == theGroup->last)
-           { break; }
-         else 
-           { actPtr = actPtr->next; }
-        }
-      else if (randomID < actPtr->randomID)
-       { break; }
-      else if (timetag > actPtr->timetag)
-        {
-         lastAct = actPtr;
-         if (actPtr == theGroup->last)
-           { break; }
-         else 
-           { actPtr = actPtr->next; }
-        }
-      else
-       { break; }
+      if (cWhoset > 0) return(GREATER_THAN);
+      else return(LESS_THAN);
+     }
+   else if (oWhoset > cWhoset)
+     {
+      if (oWhoset > 0) return(LESS_THAN);
+      else return(GREATER_THAN);
      }
-     
-   /*========================================*/
-   /* Update the salience group information. */
-   /*========================================*/
-   
-   if ((lastAct == NULL) || 
-       ((theGroup->prev != NULL) && (theGroup->prev->last == lastAct)))
-     { theGroup->first = newActivation; }
-     
-   if ((theGroup->last == NULL) || (theGroup->last == lastAct))
-     { theGroup->last = newActivation; }
-
-   /*===========================================*/
-   /* Return the insertion point in the agenda. */
-   /*===========================================*/
 
-   return(lastAct);
+   return(ComparePartialMatches(theEnv,actPtr,newActivation));
   }
 
-/*********************************************************/
-/* SortPartialMatch: Creates an array of sorted timetags */
-/*    in ascending order from a partial match.           */
-/*********************************************************/
-static unsigned long long *SortPartialMatch(
+/********************************************************************/
+/* SetActivationRecency: Creates the array of timetags from the     */
+/*   partial match of an activation sorted in descending order. The */
+/*   array is used by the lex and mea strategies for comparing      */
+/*   activations and is kept until the activation is removed.       */
+/********************************************************************/
+void SetActivationRecency(
   Environment *theEnv,
-  struct partialMatch *binds)
+  Activation *theActivation)
   {
+   struct partialMatch *binds = theActivation->basis;
    unsigned long long *nbinds;
    unsigned long long temp;
-   bool flag;
-   unsigned j, k;
+   unsigned short i, j;
+
+   if (theActivation->recency != NULL) return;
 
    /*====================================================*/
    /* Copy the array. Use 0 to represent the timetags of */
@@ -817,42 +540,44 @@ static unsigned long long *SortPartialMatch(
    /*====================================================*/
 
    nbinds = (unsigned long long *) get_mem(theEnv,sizeof(long long) * binds->bcount);
-      
-   for (j = 0; j < (unsigned) binds->bcount; j++)
+
+   for (i = 0; i < binds->bcount; i++)
      {
-      if ((binds->binds[j].gm.theMatch != NULL) &&
-          (binds->binds[j].gm.theMatch->matchingItem != NULL))
-        { nbinds[j] = binds->binds[j].gm.theMatch->matchingItem->timeTag; }
+      if ((binds->binds[i].gm.theMatch != NULL) &&
+          (binds->binds[i].gm.theMatch->matchingItem != NULL))
+        { temp = binds->binds[i].gm.theMatch->matchingItem->timeTag; }
       else
-        { nbinds[j] = 0; }
-     }
+        { temp = 0; }
 
-   /*=================*/
-   /* Sort the array. */
-   /*=================*/
+      /*=======================================*/
+      /* Insert the timetag into the portion   */
+      /* of the array which is already sorted. */
+      /*=======================================*/
 
-   for (flag = true, k = binds->bcount - 1;
-        flag == true;
-        k--)
-     {
-      flag = false;
-      for (j = 0 ; j < k ; j++)
-        {
-         if (nbinds[j] < nbinds[j + 1])
-           {
-            temp = nbinds[j];
-            nbinds[j] = nbinds[j+1];
-            nbinds[j+1] = temp;
-            flag = true;
-           }
-        }
+      for (j = i; (j > 0) && (nbinds[j-1] < temp); j--)
+        { nbinds[j] = nbinds[j-1]; }
+
+      nbinds[j] = temp;
      }
 
-   /*===================*/
-   /* Return the array. */
-   /*===================*/
+   theActivation->recency = nbinds;
+   theActivation->recencyCount = binds->bcount;
+  }
+
+/*******************************************************************/
+/* ReturnActivationRecency: Returns the sorted array of timetags   */
+/*   created for an activation by the lex and mea strategies.      */
+/*******************************************************************/
+void ReturnActivationRecency(
+  Environment *theEnv,
+  Activation *theActivation)
+  {
+   if (theActivation->recency == NULL) return;
+
+   rtn_mem(theEnv,sizeof(long long) * theActivation->recencyCount,theActivation->recency);
 
-   return(nbinds);
+   theActivation->recency = NULL;
+   theActivation->recencyCount = 0;
   }
 
 /**************************************************************************/
@@ -869,13 +594,20 @@ static int ComparePartialMatches(
    int cCount, oCount, mCount, i;
    unsigned long long *basis1, *basis2;
 
-   /*=================================================*/
-   /* If the activation already on the agenda doesn't */
-   /* have a set of sorted timetags, then create one. */
-   /*=================================================*/
+   /*===================================================*/
+   /* If either activation doesn't have a set of sorted */
+   /* timetags (because it was created while another    */
+   /* strategy was in effect), then create one.         */
+   /*===================================================*/
 
-   basis1 = SortPartialMatch(theEnv,newActivation->basis);
-   basis2 = SortPartialMatch(theEnv,actPtr->basis);
+   if (newActivation->recency == NULL)
+     { SetActivationRecency(theEnv,newActivation); }
+
+   if (actPtr->recency == NULL)
+     { SetActivationRecency(theEnv,actPtr); }
+
+   basis1 = newActivation->recency;
+   basis2 = actPtr->recency;
    
    /*==============================================================*/
    /* Determine the number of timetags in each of the activations. */
@@ -883,8 +615,8 @@ static int ComparePartialMatches(
    /* two numbers.                                                 */
    /*==============================================================*/
 
-   cCount = newActivation->basis->bcount;
-   oCount = actPtr->basis->bcount;
+   cCount = newActivation->recencyCount;
+   oCount = actPtr->recencyCount;
  
    if (oCount > cCount) mCount = cCount;
    else mCount = oCount;
@@ -900,21 +632,10 @@ static int ComparePartialMatches(
    for (i = 0 ; i < mCount ; i++)
      {
       if (basis1[i] < basis2[i])
-        { 
-         rtn_mem(theEnv,sizeof(long long) * cCount,basis1);
-         rtn_mem(theEnv,sizeof(long long) * oCount,basis2);
-         return(LESS_THAN); 
-        }
+        { return(LESS_THAN); }
       else if (basis1[i] > basis2[i])
-        { 
-         rtn_mem(theEnv,sizeof(long long) * cCount,basis1);
-         rtn_mem(theEnv,sizeof(long long) * oCount,basis2);
-         return(GREATER_THAN); 
-        }
+        { return(GREATER_THAN); }
      }
-  
-   rtn_mem(theEnv,sizeof(long long) * cCount,basis1);
-   rtn_mem(theEnv,sizeof(long long) * oCount,basis2);
 
    /*==========================================================*/
    /* If the sorted timetags are identical up to the number of */
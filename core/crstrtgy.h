@@ -72,6 +72,8 @@
 #define DEFAULT_STRATEGY DEPTH_STRATEGY
 
    void                           PlaceActivation(Environment *,Activation **,Activation *,struct salienceGroup *);
+   void                           SetActivationRecency(Environment *,Activation *);
+   void                           ReturnActivationRecency(Environment *,Activation *);
    int                            EnvSetStrategy(Environment *,int);
    int                            EnvGetStrategy(Environment *);
    void                           SetStrategyCommand(Environment *,UDFContext *,CLIPSValue *);
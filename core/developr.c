@@ -46,6 +46,11 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added memory-usage command.                    */
+/*                                                           */
+/*            Added class-table-usage command and the table  */
+/*            size and load to instance-table-usage.         */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
@@ -56,6 +61,7 @@
 #include "envrnmnt.h"
 #include "extnfunc.h"
 #include "inscom.h"
+#include "memalloc.h"
 #include "modulutl.h"
 #include "router.h"
 #include "utility.h"
@@ -68,10 +74,10 @@
 
 #if DEFRULE_CONSTRUCT && OBJECT_SYSTEM
 #include "classcom.h"
-#include "classfun.h"
 #include "objrtmch.h"
 #endif
 #if OBJECT_SYSTEM
+#include "classfun.h"
 #include "insfun.h"
 #endif
 
@@ -82,6 +88,11 @@
 #if DEFRULE_CONSTRUCT && OBJECT_SYSTEM
    static void                    PrintOPNLevel(Environment *,OBJECT_PATTERN_NODE *,char *,int);
 #endif
+#if OBJECT_SYSTEM
+   static void                    CountInstanceChain(Instance *,unsigned long *,unsigned long *,
+                                                     unsigned long *,unsigned long *);
+   static void                    PrintChainCounts(Environment *,unsigned long *);
+#endif
 
 /**************************************************/
 /* DeveloperCommands: Sets up developer commands. */
@@ -92,6 +103,7 @@ void DeveloperCommands(
 #if ! RUN_TIME
    EnvAddUDF(theEnv,"primitives-info","v",0,0,NULL,PrimitiveTablesInfoCommand,"PrimitiveTablesInfoCommand",NULL);
    EnvAddUDF(theEnv,"primitives-usage","v",0,0,NULL,PrimitiveTablesUsageCommand,"PrimitiveTablesUsageCommand",NULL);
+   EnvAddUDF(theEnv,"memory-usage","v",0,0,NULL,MemoryUsageCommand,"MemoryUsageCommand",NULL);
 
 #if DEFRULE_CONSTRUCT && DEFTEMPLATE_CONSTRUCT
    EnvAddUDF(theEnv,"validate-fact-integrity","b", 0,0,NULL,ValidateFactIntegrityCommand,"ValidateFactIntegrityCommand",NULL);
@@ -106,6 +118,7 @@ void DeveloperCommands(
 
 #if OBJECT_SYSTEM
    EnvAddUDF(theEnv,"instance-table-usage","v",0,0,NULL,InstanceTableUsageCommand,"InstanceTableUsageCommand",NULL);
+   EnvAddUDF(theEnv,"class-table-usage","v",0,0,NULL,ClassTableUsageCommand,"ClassTableUsageCommand",NULL);
 #endif
 
 #endif
@@ -133,7 +146,7 @@ void PrimitiveTablesInfoCommand(
    /*====================================*/
 
    symbolArray = GetSymbolTable(theEnv);
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < GetSymbolTableSize(theEnv); i++)
      {
       for (symbolPtr = symbolArray[i]; symbolPtr != NULL; symbolPtr = symbolPtr->next)
         { symbolCount++; }
@@ -144,7 +157,7 @@ void PrimitiveTablesInfoCommand(
    /*====================================*/
 
    integerArray = GetIntegerTable(theEnv);
-   for (i = 0; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < GetIntegerTableSize(theEnv); i++)
      {
       for (integerPtr = integerArray[i]; integerPtr != NULL; integerPtr = integerPtr->next)
         { integerCount++; }
@@ -155,7 +168,7 @@ void PrimitiveTablesInfoCommand(
    /*====================================*/
 
    floatArray = GetFloatTable(theEnv);
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < GetFloatTableSize(theEnv); i++)
      {
       for (floatPtr = floatArray[i]; floatPtr != NULL; floatPtr = floatPtr->next)
         { floatCount++; }
@@ -166,7 +179,7 @@ void PrimitiveTablesInfoCommand(
    /*====================================*/
 
    bitMapArray = GetBitMapTable(theEnv);
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < GetBitMapTableSize(theEnv); i++)
      {
       for (bitMapPtr = bitMapArray[i]; bitMapPtr != NULL; bitMapPtr = bitMapPtr->next)
         { bitMapCount++; }
@@ -188,6 +201,21 @@ void PrimitiveTablesInfoCommand(
    EnvPrintRouter(theEnv,WDISPLAY,"BitMaps: ");
    PrintLongInteger(theEnv,WDISPLAY,(long long) bitMapCount);
    EnvPrintRouter(theEnv,WDISPLAY,"\n");
+
+   /*============================*/
+   /* Print the size of each of  */
+   /* the resizable hash tables. */
+   /*============================*/
+
+   EnvPrintRouter(theEnv,WDISPLAY,"Table sizes: ");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) GetSymbolTableSize(theEnv));
+   EnvPrintRouter(theEnv,WDISPLAY," ");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) GetIntegerTableSize(theEnv));
+   EnvPrintRouter(theEnv,WDISPLAY," ");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) GetFloatTableSize(theEnv));
+   EnvPrintRouter(theEnv,WDISPLAY," ");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) GetBitMapTableSize(theEnv));
+   EnvPrintRouter(theEnv,WDISPLAY,"\n");
    /*
    EnvPrintRouter(theEnv,WDISPLAY,"Ephemerals: ");
    PrintLongInteger(theEnv,WDISPLAY,(long long) EphemeralSymbolCount());
@@ -224,7 +252,7 @@ void PrimitiveTablesUsageCommand(
    /*====================================*/
 
    symbolArray = GetSymbolTable(theEnv);
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < GetSymbolTableSize(theEnv); i++)
      {
       symbolCount = 0;
       for (symbolPtr = symbolArray[i]; symbolPtr != NULL; symbolPtr = symbolPtr->next)
@@ -244,7 +272,7 @@ void PrimitiveTablesUsageCommand(
    /*===================================*/
    
    floatArray = GetFloatTable(theEnv);
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < GetFloatTableSize(theEnv); i++)
      {
       floatCount = 0;
       for (floatPtr = floatArray[i]; floatPtr != NULL; floatPtr = floatPtr->next)
@@ -288,6 +316,56 @@ void PrimitiveTablesUsageCommand(
 
   }
 
+/******************************************************/
+/* MemoryUsageCommand: Prints the number of pages,    */
+/*   blocks in use, and allocations for each of the   */
+/*   size classes of the small block allocator along  */
+/*   with the number of arenas.                       */
+/******************************************************/
+void MemoryUsageCommand(
+  Environment *theEnv,
+  UDFContext *context,
+  CLIPSValue *returnValue)
+  {
+#if (MEM_TABLE_SIZE > 0)
+   unsigned int i;
+   struct slabClass *theClass;
+
+   EnvPrintRouter(theEnv,WDISPLAY,"Size Pages Blocks Allocations\n");
+   for (i = 1; i <= SLAB_CLASS_COUNT; i++)
+     {
+      theClass = &MemoryData(theEnv)->SlabClasses[i];
+      if (theClass->allocations == 0) continue;
+
+      PrintLongInteger(theEnv,WDISPLAY,(long long) (i * SLAB_GRANULE));
+      EnvPrintRouter(theEnv,WDISPLAY," ");
+      PrintLongInteger(theEnv,WDISPLAY,(long long) theClass->pageCount);
+      EnvPrintRouter(theEnv,WDISPLAY," ");
+      PrintLongInteger(theEnv,WDISPLAY,(long long) theClass->liveBlocks);
+      EnvPrintRouter(theEnv,WDISPLAY," ");
+      PrintLongInteger(theEnv,WDISPLAY,(long long) theClass->allocations);
+      EnvPrintRouter(theEnv,WDISPLAY,"\n");
+     }
+
+   EnvPrintRouter(theEnv,WDISPLAY,"Segments: ");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) MemoryData(theEnv)->SegmentCount);
+   EnvPrintRouter(theEnv,WDISPLAY," (");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) MemoryData(theEnv)->EmptySegmentCount);
+   EnvPrintRouter(theEnv,WDISPLAY," unused)\n");
+   EnvPrintRouter(theEnv,WDISPLAY,"Arenas: ");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) MemoryData(theEnv)->ArenaCount);
+   EnvPrintRouter(theEnv,WDISPLAY," (");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) MemoryData(theEnv)->ArenaPageCount);
+   EnvPrintRouter(theEnv,WDISPLAY," pages)\n");
+#endif
+
+   EnvPrintRouter(theEnv,WDISPLAY,"Memory in use: ");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) EnvMemUsed(theEnv));
+   EnvPrintRouter(theEnv,WDISPLAY,"\nFree pool: ");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) PoolSize(theEnv));
+   EnvPrintRouter(theEnv,WDISPLAY,"\n");
+  }
+
 #if DEFRULE_CONSTRUCT && DEFTEMPLATE_CONSTRUCT
 
 /******************************************************/
@@ -554,30 +632,32 @@ void InstanceTableUsageCommand(
   CLIPSValue *returnValue)
   {
    unsigned long i;
-   int instanceCounts[COUNT_SIZE];
-   Instance *ins;
-   unsigned long int instanceCount, totalInstanceCount = 0;
+   unsigned long instanceCounts[COUNT_SIZE];
+   unsigned long chainCount = 0, longestChain = 0;
+   unsigned long totalInstanceCount = 0;
 
    for (i = 0; i < COUNT_SIZE; i++)
      { instanceCounts[i] = 0; }
      
-   /*======================================*/
-   /* Count entries in the instance table. */
-   /*======================================*/
+   /*==================================================*/
+   /* Count entries in the instance table and in the   */
+   /* chains of the old table which have not yet been  */
+   /* moved if the table is being rehashed.            */
+   /*==================================================*/
 
-   for (i = 0; i < INSTANCE_TABLE_HASH_SIZE; i++)
+   for (i = 0; i < InstanceData(theEnv)->InstanceTableSize; i++)
      {
-      instanceCount = 0;
-      for (ins = InstanceData(theEnv)->InstanceTable[i]; ins != NULL; ins = ins->nxtHash)
-        { 
-         instanceCount++;
-         totalInstanceCount++;
+      CountInstanceChain(InstanceData(theEnv)->InstanceTable[i],instanceCounts,
+                         &totalInstanceCount,&chainCount,&longestChain);
+     }
+
+   if (InstanceData(theEnv)->OldInstanceTable != NULL)
+     {
+      for (i = InstanceData(theEnv)->InstanceRehashIndex; i < InstanceData(theEnv)->OldInstanceTableSize; i++)
+        {
+         CountInstanceChain(InstanceData(theEnv)->OldInstanceTable[i],instanceCounts,
+                            &totalInstanceCount,&chainCount,&longestChain);
         }
-           
-      if (instanceCount < (COUNT_SIZE - 1))
-        { instanceCounts[instanceCount]++; }
-      else
-        { instanceCounts[COUNT_SIZE - 1]++; }
      }
 
    /*========================*/
@@ -586,12 +666,132 @@ void InstanceTableUsageCommand(
 
    EnvPrintRouter(theEnv,WDISPLAY,"Total Instances: ");
    PrintLongInteger(theEnv,WDISPLAY,(long long) totalInstanceCount);
+   EnvPrintRouter(theEnv,WDISPLAY,"\nTable Size: ");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) InstanceData(theEnv)->InstanceTableSize);
+   if (InstanceData(theEnv)->OldInstanceTable != NULL)
+     {
+      EnvPrintRouter(theEnv,WDISPLAY,"\nRehashing From: ");
+      PrintLongInteger(theEnv,WDISPLAY,(long long) InstanceData(theEnv)->OldInstanceTableSize);
+      EnvPrintRouter(theEnv,WDISPLAY," (");
+      PrintLongInteger(theEnv,WDISPLAY,(long long) InstanceData(theEnv)->InstanceRehashIndex);
+      EnvPrintRouter(theEnv,WDISPLAY," buckets moved)");
+     }
+   EnvPrintRouter(theEnv,WDISPLAY,"\nLoad Factor: ");
+   PrintFloat(theEnv,WDISPLAY,((double) totalInstanceCount) / ((double) InstanceData(theEnv)->InstanceTableSize));
+   EnvPrintRouter(theEnv,WDISPLAY,"\nChains Used: ");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) chainCount);
+   EnvPrintRouter(theEnv,WDISPLAY,"\nLongest Chain: ");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) longestChain);
    EnvPrintRouter(theEnv,WDISPLAY,"\n");
+   PrintChainCounts(theEnv,instanceCounts);
+  }
+
+/*****************************************************/
+/* ClassTableUsageCommand: Prints information about  */
+/*   the classes in the class hash table and the     */
+/*   slot names in the slot name hash table.         */
+/*****************************************************/
+void ClassTableUsageCommand(
+  Environment *theEnv,
+  UDFContext *context,
+  CLIPSValue *returnValue)
+  {
+   unsigned long i;
+   unsigned long classCounts[COUNT_SIZE], slotNameCounts[COUNT_SIZE];
+   unsigned long count, totalClassCount = 0, totalSlotNameCount = 0;
+   Defclass *cls;
+   SLOT_NAME *snp;
+
+   for (i = 0; i < COUNT_SIZE; i++)
+     {
+      classCounts[i] = 0;
+      slotNameCounts[i] = 0;
+     }
+
+   /*=============================================*/
+   /* Count entries in the class and slot tables. */
+   /*=============================================*/
+
+   for (i = 0; i < CLASS_TABLE_HASH_SIZE; i++)
+     {
+      count = 0;
+      for (cls = DefclassData(theEnv)->ClassTable[i]; cls != NULL; cls = cls->nxtHash)
+        { count++; }
+      totalClassCount += count;
+      classCounts[(count < (COUNT_SIZE - 1)) ? count : (COUNT_SIZE - 1)]++;
+     }
+
+   for (i = 0; i < SLOT_NAME_TABLE_HASH_SIZE; i++)
+     {
+      count = 0;
+      for (snp = DefclassData(theEnv)->SlotNameTable[i]; snp != NULL; snp = snp->nxt)
+        { count++; }
+      totalSlotNameCount += count;
+      slotNameCounts[(count < (COUNT_SIZE - 1)) ? count : (COUNT_SIZE - 1)]++;
+     }
+
+   /*========================*/
+   /* Print the information. */
+   /*========================*/
+
+   EnvPrintRouter(theEnv,WDISPLAY,"Total Classes: ");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) totalClassCount);
+   EnvPrintRouter(theEnv,WDISPLAY,"\nTable Size: ");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) CLASS_TABLE_HASH_SIZE);
+   EnvPrintRouter(theEnv,WDISPLAY,"\n");
+   PrintChainCounts(theEnv,classCounts);
+
+   EnvPrintRouter(theEnv,WDISPLAY,"\nTotal Slot Names: ");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) totalSlotNameCount);
+   EnvPrintRouter(theEnv,WDISPLAY,"\nTable Size: ");
+   PrintLongInteger(theEnv,WDISPLAY,(long long) SLOT_NAME_TABLE_HASH_SIZE);
+   EnvPrintRouter(theEnv,WDISPLAY,"\n");
+   PrintChainCounts(theEnv,slotNameCounts);
+  }
+
+/*****************************************************/
+/* CountInstanceChain: Adds the length of a chain in */
+/*   the instance hash table to the usage counts.    */
+/*****************************************************/
+static void CountInstanceChain(
+  Instance *ins,
+  unsigned long *instanceCounts,
+  unsigned long *totalInstanceCount,
+  unsigned long *chainCount,
+  unsigned long *longestChain)
+  {
+   unsigned long instanceCount = 0;
+
+   for ( ; ins != NULL; ins = ins->nxtHash)
+     { instanceCount++; }
+
+   *totalInstanceCount += instanceCount;
+   if (instanceCount > 0)
+     { (*chainCount)++; }
+   if (instanceCount > *longestChain)
+     { *longestChain = instanceCount; }
+
+   if (instanceCount < (COUNT_SIZE - 1))
+     { instanceCounts[instanceCount]++; }
+   else
+     { instanceCounts[COUNT_SIZE - 1]++; }
+  }
+
+/****************************************************/
+/* PrintChainCounts: Prints the number of chains of */
+/*   each length in a hash table.                   */
+/****************************************************/
+static void PrintChainCounts(
+  Environment *theEnv,
+  unsigned long *counts)
+  {
+   unsigned long i;
+
    for (i = 0; i < COUNT_SIZE; i++)
      {
       PrintLongInteger(theEnv,WDISPLAY,(long long) i);
       EnvPrintRouter(theEnv,WDISPLAY," ");
-      PrintLongInteger(theEnv,WDISPLAY,(long long) instanceCounts[i]);
+      PrintLongInteger(theEnv,WDISPLAY,(long long) counts[i]);
       EnvPrintRouter(theEnv,WDISPLAY,"\n");
      }
   }
@@ -38,6 +38,8 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added class-table-usage command.               */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_developr
@@ -49,6 +51,7 @@
    void                           DeveloperCommands(Environment *);
    void                           PrimitiveTablesInfoCommand(Environment *,UDFContext *,CLIPSValue *);
    void                           PrimitiveTablesUsageCommand(Environment *,UDFContext *,CLIPSValue *);
+   void                           MemoryUsageCommand(Environment *,UDFContext *,CLIPSValue *);
 
 #if DEFRULE_CONSTRUCT && DEFTEMPLATE_CONSTRUCT
    void                           ShowFactPatternNetworkCommand(Environment *,UDFContext *,CLIPSValue *);
@@ -59,6 +62,7 @@
 #endif
 #if OBJECT_SYSTEM
    void                           InstanceTableUsageCommand(Environment *,UDFContext *,CLIPSValue *);
+   void                           ClassTableUsageCommand(Environment *,UDFContext *,CLIPSValue *);
 #endif
 #if DEFRULE_CONSTRUCT
    void                           ValidateBetaMemoriesCommand(Environment *,UDFContext *,CLIPSValue *);
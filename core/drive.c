@@ -47,6 +47,16 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Partial matches are allocated for the beta     */
+/*            memory in which they will be stored.           */
+/*                                                           */
+/*            Hash values are truncated to the size stored   */
+/*            in a partial match.                            */
+/*                                                           */
+/*            Join hash values are computed from the fact    */
+/*            index and instance name of facts and instances */
+/*            rather than their address.                     */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
@@ -275,16 +285,16 @@ void NetworkAssertRight(
         {
          if (join->patternIsExists)
            {
-            AddBlockedLink(lhsBinds,rhsBinds);
+            AddBlockedLink(theEnv,lhsBinds,rhsBinds);
             PPDrive(theEnv,lhsBinds,NULL,join,operation);
            }
          else if (join->patternIsNegated || join->joinFromTheRight)
            {
-            AddBlockedLink(lhsBinds,rhsBinds);
+            AddBlockedLink(theEnv,lhsBinds,rhsBinds);
             if (lhsBinds->children != NULL)
               { PosEntryRetractBeta(theEnv,lhsBinds,lhsBinds->children,operation); }
             /*
-            if (lhsBinds->dependents != NULL) 
+            if (PMDependents(lhsBinds) != NULL) 
               { RemoveLogicalSupport(theEnv,lhsBinds); }
             */
            } 
@@ -509,7 +519,7 @@ void NetworkAssertLeft(
          
          else if (join->patternIsExists)
            { 
-            AddBlockedLink(lhsBinds,rhsBinds);
+            AddBlockedLink(theEnv,lhsBinds,rhsBinds);
             PPDrive(theEnv,lhsBinds,NULL,join,operation);
             EngineData(theEnv)->GlobalLHSBinds = oldLHSBinds;
             EngineData(theEnv)->GlobalRHSBinds = oldRHSBinds;
@@ -530,7 +540,7 @@ void NetworkAssertLeft(
 
          else
            {
-            AddBlockedLink(lhsBinds,rhsBinds);
+            AddBlockedLink(theEnv,lhsBinds,rhsBinds);
             break;
            }
         }
@@ -767,7 +777,7 @@ bool EvaluateSecondaryNetworkTest(
 /************************/
 /* BetaMemoryHashValue: */
 /************************/
-unsigned long BetaMemoryHashValue(
+unsigned int BetaMemoryHashValue(
   Environment *theEnv,
   struct expr *hashExpr,
   struct partialMatch *lbinds,
@@ -778,13 +788,7 @@ unsigned long BetaMemoryHashValue(
    struct partialMatch *oldLHSBinds;
    struct partialMatch *oldRHSBinds;
    struct joinNode *oldJoin;
-   unsigned long hashValue = 0;
-   unsigned long multiplier = 1;
-   union
-     {
-      void *vv;
-      unsigned long liv;
-     } fis;
+   unsigned long long hashValue = 0;
    
    /*======================================*/
    /* A NULL expression evaluates to zero. */
@@ -835,44 +839,13 @@ unsigned long BetaMemoryHashValue(
       else
         { EvaluateExpression(theEnv,hashExpr,&theResult); }
 
-      switch (theResult.type)
-        {
-         case STRING:
-         case SYMBOL:
-         case INSTANCE_NAME:
-           hashValue += (((SYMBOL_HN *) theResult.value)->bucket * multiplier);
-           break;
-             
-         case INTEGER:
-            hashValue += (((INTEGER_HN *) theResult.value)->bucket * multiplier);
-            break;
-             
-         case FLOAT:
-           hashValue += (((FLOAT_HN *) theResult.value)->bucket * multiplier);
-           break;
-           
-          case FACT_ADDRESS:
-#if OBJECT_SYSTEM
-          case INSTANCE_ADDRESS:
-#endif
-            fis.liv = 0;
-            fis.vv = theResult.value;
-            hashValue += (unsigned long) (fis.liv * multiplier);
-            break;
-
-          case EXTERNAL_ADDRESS:
-            fis.liv = 0;
-            fis.vv = ValueToExternalAddress(theResult.value);
-            hashValue += (unsigned long) (fis.liv * multiplier);
-            break;
-        }
+      hashValue = AddJoinHashValue(hashValue,&theResult);
 
       /*==============================================*/
       /* Move to the next expression to be evaluated. */
       /*==============================================*/
 
       hashExpr = hashExpr->nextArg;
-	  multiplier = multiplier * 509;
 	 }
 
    /*=======================================*/
@@ -885,9 +858,11 @@ unsigned long BetaMemoryHashValue(
 
    /*=================================================*/
    /* Return the result of evaluating the expression. */
+   /* The hash value is truncated to the size stored  */
+   /* in a partial match.                             */
    /*=================================================*/
 
-   return hashValue;
+   return (unsigned int) hashValue;
   }
 
 /*******************************************************************/
@@ -928,7 +903,7 @@ void PPDrive(
       /* Merge the alpha and beta memory partial matches. */
       /*==================================================*/
 
-      linker = MergePartialMatches(theEnv,lhsBinds,rhsBinds);
+      linker = MergePartialMatches(theEnv,lhsBinds,rhsBinds,listOfJoins->join,listOfJoins->enterDirection);
 
       /*================================================*/
       /* Determine the hash value of the partial match. */
@@ -1078,12 +1053,12 @@ static void EmptyDrive(
       if (notParent->marker != NULL)
         { return; }
         
-      AddBlockedLink(notParent,rhsBinds);
+      AddBlockedLink(theEnv,notParent,rhsBinds);
       
       if (notParent->children != NULL)
         { PosEntryRetractBeta(theEnv,notParent,notParent->children,operation); }
       /*
-      if (notParent->dependents != NULL) 
+      if (PMDependents(notParent) != NULL) 
 		{ RemoveLogicalSupport(theEnv,notParent); } 
         */
               
@@ -1102,7 +1077,7 @@ static void EmptyDrive(
       existsParent = join->leftMemory->beta[0];
       if (existsParent->marker != NULL)
         { return; }
-      AddBlockedLink(existsParent,rhsBinds);
+      AddBlockedLink(theEnv,existsParent,rhsBinds);
      }
 
    /*============================================*/
@@ -1133,7 +1108,7 @@ static void EmptyDrive(
       /*=============================================================*/
 
       else
-        { linker = CopyPartialMatch(theEnv,rhsBinds); }
+        { linker = CopyPartialMatch(theEnv,rhsBinds,listOfJoins->join,listOfJoins->enterDirection); }
      
       /*================================================*/
       /* Determine the hash value of the partial match. */
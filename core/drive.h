@@ -53,7 +53,7 @@
    void                           NetworkAssertLeft(Environment *,struct partialMatch *,struct joinNode *,int);
    void                           NetworkAssertRight(Environment *,struct partialMatch *,struct joinNode *,int);
    void                           PPDrive(Environment *,struct partialMatch *,struct partialMatch *,struct joinNode *,int);
-   unsigned long                  BetaMemoryHashValue(Environment *,struct expr *,struct partialMatch *,struct partialMatch *,struct joinNode *);
+   unsigned int                   BetaMemoryHashValue(Environment *,struct expr *,struct partialMatch *,struct partialMatch *,struct joinNode *);
    bool                           EvaluateSecondaryNetworkTest(Environment *,struct partialMatch *,struct joinNode *);
    void                           EPMDrive(Environment *,struct partialMatch *,struct joinNode *,int);
    
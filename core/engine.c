@@ -82,6 +82,14 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            The statistics watch item reports the maximum  */
+/*            amount of memory used during a run.            */
+/*                                                           */
+/*      6.50: Pending fact batch changes are propagated to   */
+/*            the join network before rules are run. Facts   */
+/*            asserted and retracted by rule actions aren't  */
+/*            deferred unless the actions open a batch.      */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
@@ -174,6 +182,7 @@ long long EnvRun(
 #if OBJECT_SYSTEM
    unsigned long maxInstances = 0, sumInstances = 0;
 #endif
+   long maxMemory = 0, tempMemory;
    double endTime, startTime = 0.0;
    unsigned long tempValue;
 #endif
@@ -188,6 +197,9 @@ long long EnvRun(
    struct trackedMemory *theTM;
    int danglingConstructs;
    struct CLIPSBlock gcBlock;
+#if DEFTEMPLATE_CONSTRUCT
+   unsigned int factBatchDepth;
+#endif
    
    /*=====================================================*/
    /* Make sure the run command is not already executing. */
@@ -196,6 +208,20 @@ long long EnvRun(
    if (EngineData(theEnv)->AlreadyRunning)
      { return 0; }
    EngineData(theEnv)->AlreadyRunning = true;
+
+   /*===================================================*/
+   /* Propagate the pending changes of an open fact     */
+   /* batch so that the agenda is up to date. The batch */
+   /* is suspended while rules are run so that the      */
+   /* changes made by rule actions are matched as they  */
+   /* are made.                                         */
+   /*===================================================*/
+
+#if DEFTEMPLATE_CONSTRUCT
+   factBatchDepth = FactData(theEnv)->FactBatchDepth;
+   FactData(theEnv)->FactBatchDepth = 0;
+   FlushFactBatch(theEnv);
+#endif
     
    /*========================================*/
    /* Set up the frame for tracking garbage. */
@@ -220,6 +246,7 @@ long long EnvRun(
 #endif
       maxActivations = GetNumberOfActivations(theEnv);
       sumActivations = maxActivations;
+      maxMemory = EnvMemUsed(theEnv);
       startTime = gentime();
      }
 #endif
@@ -467,6 +494,8 @@ long long EnvRun(
          tempValue = GetNumberOfActivations(theEnv);
          if (tempValue > maxActivations) maxActivations = tempValue;
          sumActivations += tempValue;
+         tempMemory = EnvMemUsed(theEnv);
+         if (tempMemory > maxMemory) maxMemory = tempMemory;
         }
 #endif
 
@@ -595,6 +624,10 @@ long long EnvRun(
                           (long) (((double) sumActivations / (rulesFired + 1)) + 0.5),
                           maxActivations);
       EnvPrintRouter(theEnv,WDIALOG,printSpace);
+
+      gensprintf(printSpace,"%ld bytes of memory in use (%ld maximum).\n",
+                          EnvMemUsed(theEnv),maxMemory);
+      EnvPrintRouter(theEnv,WDIALOG,printSpace);
       
 #if DEVELOPER
       gensprintf(printSpace,"%9ld left to right comparisons.\n",
@@ -663,6 +696,10 @@ long long EnvRun(
    /* Return the number of rules fired. */
    /*===================================*/
 
+#if DEFTEMPLATE_CONSTRUCT
+   FactData(theEnv)->FactBatchDepth = factBatchDepth;
+#endif
+
    EngineData(theEnv)->AlreadyRunning = false;
    return rulesFired;
   }
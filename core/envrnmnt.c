@@ -135,14 +135,18 @@
 /***************************************/
 
    static void                    RemoveEnvironmentCleanupFunctions(struct environmentData *);
-   static void                   *CreateEnvironmentDriver(struct symbolHashNode **,struct floatHashNode **,
-                                                          struct integerHashNode **,struct bitMapHashNode **,
+   static void                   *CreateEnvironmentDriver(struct symbolHashNode **,unsigned long,
+                                                          struct floatHashNode **,unsigned long,
+                                                          struct integerHashNode **,unsigned long,
+                                                          struct bitMapHashNode **,unsigned long,
                                                           struct externalAddressHashNode **);
    static void                    SystemFunctionDefinitions(Environment *);
    static void                    InitializeKeywords(Environment *);
-   static void                    EnvInitializeEnvironment(Environment *,struct symbolHashNode **,struct floatHashNode **,
-					   								       struct integerHashNode **,struct bitMapHashNode **,
-														   struct externalAddressHashNode **);
+   static void                    EnvInitializeEnvironment(Environment *,struct symbolHashNode **,unsigned long,
+                                                           struct floatHashNode **,unsigned long,
+                                                           struct integerHashNode **,unsigned long,
+                                                           struct bitMapHashNode **,unsigned long,
+                                                           struct externalAddressHashNode **);
 
 /*******************************************************/
 /* AllocateEnvironmentData: Allocates environment data */
@@ -216,7 +220,7 @@ bool AllocateEnvironmentData(
 /************************************************************/
 void *CreateEnvironment()
   {
-   return CreateEnvironmentDriver(NULL,NULL,NULL,NULL,NULL);
+   return CreateEnvironmentDriver(NULL,0,NULL,0,NULL,0,NULL,0,NULL);
   }
 
 /**********************************************************/
@@ -225,11 +229,16 @@ void *CreateEnvironment()
 /**********************************************************/
 void *CreateRuntimeEnvironment(
   struct symbolHashNode **symbolTable,
+  unsigned long symbolTableSize,
   struct floatHashNode **floatTable,
+  unsigned long floatTableSize,
   struct integerHashNode **integerTable,
-  struct bitMapHashNode **bitmapTable)
+  unsigned long integerTableSize,
+  struct bitMapHashNode **bitmapTable,
+  unsigned long bitmapTableSize)
   {
-   return CreateEnvironmentDriver(symbolTable,floatTable,integerTable,bitmapTable,NULL);
+   return CreateEnvironmentDriver(symbolTable,symbolTableSize,floatTable,floatTableSize,
+                                  integerTable,integerTableSize,bitmapTable,bitmapTableSize,NULL);
   }
   
 /*********************************************************/
@@ -238,9 +247,13 @@ void *CreateRuntimeEnvironment(
 /*********************************************************/
 void *CreateEnvironmentDriver(
   struct symbolHashNode **symbolTable,
+  unsigned long symbolTableSize,
   struct floatHashNode **floatTable,
+  unsigned long floatTableSize,
   struct integerHashNode **integerTable,
+  unsigned long integerTableSize,
   struct bitMapHashNode **bitmapTable,
+  unsigned long bitmapTableSize,
   struct externalAddressHashNode **externalAddressTable)
   {
    struct environmentData *theEnvironment;
@@ -291,7 +304,8 @@ void *CreateEnvironmentDriver(
    memset(theData,0,sizeof(void (*)(struct environmentData *)) * MAXIMUM_ENVIRONMENT_POSITIONS);
    theEnvironment->cleanupFunctions = (void (**)(Environment *))theData;
 
-   EnvInitializeEnvironment(theEnvironment,symbolTable,floatTable,integerTable,bitmapTable,externalAddressTable);
+   EnvInitializeEnvironment(theEnvironment,symbolTable,symbolTableSize,floatTable,floatTableSize,
+                            integerTable,integerTableSize,bitmapTable,bitmapTableSize,externalAddressTable);
 
    return(theEnvironment);
   }
@@ -453,10 +467,6 @@ bool DestroyEnvironment(
       rv = false;
      }
 
-#if (MEM_TABLE_SIZE > 0)
-   free(theMemData->MemoryTable);
-#endif
-
    for (i = 0; i < MAXIMUM_ENVIRONMENT_POSITIONS; i++)
      {
       if (theEnvironment->theData[i] != NULL)
@@ -545,9 +555,13 @@ static void RemoveEnvironmentCleanupFunctions(
 static void EnvInitializeEnvironment(
   Environment *theEnvironment,
   struct symbolHashNode **symbolTable,
+  unsigned long symbolTableSize,
   struct floatHashNode **floatTable,
+  unsigned long floatTableSize,
   struct integerHashNode **integerTable,
+  unsigned long integerTableSize,
   struct bitMapHashNode **bitmapTable,
+  unsigned long bitmapTableSize,
   struct externalAddressHashNode **externalAddressTable)
   {   
    /*================================================*/
@@ -587,7 +601,8 @@ static void EnvInitializeEnvironment(
    /* Initialize the hash tables for atomic values. */
    /*===============================================*/
 
-   InitializeAtomTables(theEnvironment,symbolTable,floatTable,integerTable,bitmapTable,externalAddressTable);
+   InitializeAtomTables(theEnvironment,symbolTable,symbolTableSize,floatTable,floatTableSize,
+                        integerTable,integerTableSize,bitmapTable,bitmapTableSize,externalAddressTable);
 
    /*=========================================*/
    /* Initialize file and string I/O routers. */
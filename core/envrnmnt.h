@@ -96,8 +96,10 @@ struct environmentData
 
    bool                           AllocateEnvironmentData(Environment *,unsigned int,unsigned long,void (*)(Environment *));
    void                          *CreateEnvironment(void);
-   void                          *CreateRuntimeEnvironment(struct symbolHashNode **,struct floatHashNode **,
-                                                                  struct integerHashNode **,struct bitMapHashNode **);
+   void                          *CreateRuntimeEnvironment(struct symbolHashNode **,unsigned long,
+                                                           struct floatHashNode **,unsigned long,
+                                                           struct integerHashNode **,unsigned long,
+                                                           struct bitMapHashNode **,unsigned long);
    bool                           DestroyEnvironment(Environment *);
    bool                           AddEnvironmentCleanupFunction(Environment *,const char *,void (*)(Environment *),int);
    void                          *GetEnvironmentContext(Environment *);
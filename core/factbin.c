@@ -29,6 +29,9 @@
 /*            Removed use of void pointers for specific      */
 /*            data structures.                               */
 /*                                                           */
+/*            Saves the bitmaps of the slots referenced by   */
+/*            the patterns using or ending at a node.        */
+/*                                                           */
 /*************************************************************/
 
 #include "setup.h"
@@ -58,11 +61,14 @@ struct bsaveFactPatternNode
    unsigned short whichSlot;
    unsigned short whichField;
    unsigned short leaveFields;
+   bool slotSensitive;
    long networkTest;
    long nextLevel;
    long lastLevel;
    long leftNode;
    long rightNode;
+   long modifySlots;
+   long stopSlots;
   };
 
 #define BSAVE_FIND         0
@@ -197,6 +203,10 @@ static void BsaveDriver(
         {
          case BSAVE_FIND:
            thePattern->bsaveID = FactBinaryData(theEnv)->NumberOfPatterns++;
+           if (thePattern->modifySlots != NULL)
+             { thePattern->modifySlots->neededBitMap = true; }
+           if (thePattern->stopSlots != NULL)
+             { thePattern->stopSlots->neededBitMap = true; }
            break;
 
          case BSAVE_PATTERNS:
@@ -302,12 +312,21 @@ static void BsavePatternNode(
 
    tempNode.whichField = thePattern->whichField;
    tempNode.leaveFields = thePattern->leaveFields;
+   tempNode.slotSensitive = thePattern->slotSensitive;
    tempNode.whichSlot = thePattern->whichSlot;
    tempNode.networkTest = HashedExpressionIndex(theEnv,thePattern->networkTest);
    tempNode.nextLevel =  BsaveFactPatternIndex(thePattern->nextLevel);
    tempNode.lastLevel =  BsaveFactPatternIndex(thePattern->lastLevel);
    tempNode.leftNode =  BsaveFactPatternIndex(thePattern->leftNode);
    tempNode.rightNode =  BsaveFactPatternIndex(thePattern->rightNode);
+   if (thePattern->modifySlots != NULL)
+     { tempNode.modifySlots = (long) thePattern->modifySlots->bucket; }
+   else
+     { tempNode.modifySlots = -1L; }
+   if (thePattern->stopSlots != NULL)
+     { tempNode.stopSlots = (long) thePattern->stopSlots->bucket; }
+   else
+     { tempNode.stopSlots = -1L; }
 
    GenWrite(&tempNode,(unsigned long) sizeof(struct bsaveFactPatternNode),fp);
   }
@@ -403,6 +422,7 @@ static void UpdateFactPatterns(
    FactBinaryData(theEnv)->FactPatternArray[obji].bsaveID = 0L;
    FactBinaryData(theEnv)->FactPatternArray[obji].whichField = bp->whichField;
    FactBinaryData(theEnv)->FactPatternArray[obji].leaveFields = bp->leaveFields;
+   FactBinaryData(theEnv)->FactPatternArray[obji].slotSensitive = bp->slotSensitive;
    FactBinaryData(theEnv)->FactPatternArray[obji].whichSlot = bp->whichSlot;
 
    FactBinaryData(theEnv)->FactPatternArray[obji].networkTest = HashedExpressionPointer(bp->networkTest);
@@ -410,6 +430,22 @@ static void UpdateFactPatterns(
    FactBinaryData(theEnv)->FactPatternArray[obji].nextLevel = BloadFactPatternPointer(bp->nextLevel);
    FactBinaryData(theEnv)->FactPatternArray[obji].lastLevel = BloadFactPatternPointer(bp->lastLevel);
    FactBinaryData(theEnv)->FactPatternArray[obji].leftNode  = BloadFactPatternPointer(bp->leftNode);
+
+   if (bp->modifySlots != -1L)
+     {
+      FactBinaryData(theEnv)->FactPatternArray[obji].modifySlots = BitMapPointer(bp->modifySlots);
+      IncrementBitMapCount(FactBinaryData(theEnv)->FactPatternArray[obji].modifySlots);
+     }
+   else
+     { FactBinaryData(theEnv)->FactPatternArray[obji].modifySlots = NULL; }
+
+   if (bp->stopSlots != -1L)
+     {
+      FactBinaryData(theEnv)->FactPatternArray[obji].stopSlots = BitMapPointer(bp->stopSlots);
+      IncrementBitMapCount(FactBinaryData(theEnv)->FactPatternArray[obji].stopSlots);
+     }
+   else
+     { FactBinaryData(theEnv)->FactPatternArray[obji].stopSlots = NULL; }
   }
 
 /***************************************************/
@@ -432,6 +468,12 @@ static void ClearBload(
                                         FactBinaryData(theEnv)->FactPatternArray[i].networkTest->type,
                                         FactBinaryData(theEnv)->FactPatternArray[i].networkTest->value); 
         }
+
+      if (FactBinaryData(theEnv)->FactPatternArray[i].modifySlots != NULL)
+        { DecrementBitMapCount(theEnv,FactBinaryData(theEnv)->FactPatternArray[i].modifySlots); }
+
+      if (FactBinaryData(theEnv)->FactPatternArray[i].stopSlots != NULL)
+        { DecrementBitMapCount(theEnv,FactBinaryData(theEnv)->FactPatternArray[i].stopSlots); }
      }
 
 
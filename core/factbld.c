@@ -35,6 +35,17 @@
 /*                                                           */
 /*      6.50: Removed initial-fact support.                  */
 /*                                                           */
+/*            Pattern nodes keep a bitmap of the slots       */
+/*            referenced by the patterns which use them so   */
+/*            that modify only rematches those patterns.     */
+/*            The patterns of rules which aren't declared    */
+/*            slot-sensitive reference every slot and don't  */
+/*            share pattern nodes with slot-sensitive ones.  */
+/*                                                           */
+/*            Rule excision clears the pattern matches of    */
+/*            facts whose retraction is pending in a fact    */
+/*            batch.                                         */
+/*                                                           */
 /*************************************************************/
 
 #include "setup.h"
@@ -52,6 +63,7 @@
 #include "factmngr.h"
 #include "memalloc.h"
 #include "modulutl.h"
+#include "pattern.h"
 #include "reorder.h"
 #include "reteutil.h"
 #include "router.h"
@@ -65,14 +77,17 @@
 
 #if (! RUN_TIME) && (! BLOAD_ONLY)
    static struct factPatternNode    *FindPatternNode(struct factPatternNode *,struct lhsParseNode *,
-                                                  struct factPatternNode **,bool,bool);
+                                                  struct factPatternNode **,bool,bool,bool);
    static struct factPatternNode    *CreateNewPatternNode(Environment *,struct lhsParseNode *,struct factPatternNode *,
-                                                       struct factPatternNode *,bool,bool);
+                                                       struct factPatternNode *,bool,bool,bool);
    static void                       ClearPatternMatches(Environment *,struct factPatternNode *);
+   static void                       ClearFactPatternMatches(Environment *,Fact *,struct factPatternNode *);
    static void                       DetachFactPattern(Environment *,struct patternNodeHeader *);
    static struct patternNodeHeader  *PlaceFactPattern(Environment *,struct lhsParseNode *);
-   static struct lhsParseNode       *RemoveUnneededSlots(Environment *,struct lhsParseNode *);
+   static struct lhsParseNode       *RemoveUnneededSlots(Environment *,struct lhsParseNode *,bool);
    static void                       FindAndSetDeftemplatePatternNetwork(Environment *,struct factPatternNode *,struct factPatternNode *);
+   static BITMAP_HN                 *FormModifySlotBitMap(Environment *,struct lhsParseNode *,Deftemplate *,bool);
+   static void                       AddModifySlots(Environment *,BITMAP_HN **,BITMAP_HN *);
 #endif
 
 /*********************************************************/
@@ -160,6 +175,8 @@ static struct patternNodeHeader *PlaceFactPattern(
    bool endSlot;
    int count;
    const char *deftemplateName;
+   BITMAP_HN *modifySlots;
+   bool slotSensitive;
 
    /*======================================================================*/
    /* Get the name of the deftemplate associated with the pattern being    */
@@ -168,11 +185,38 @@ static struct patternNodeHeader *PlaceFactPattern(
 
    deftemplateName = ValueToString(thePattern->right->bottom->value);
 
+   /*============================================================*/
+   /* Get a pointer to the deftemplate data structure associated */
+   /* with the pattern (use the deftemplate name extracted from  */
+   /* the first field of the pattern).                           */
+   /*============================================================*/
+
+   FactData(theEnv)->CurrentDeftemplate = (Deftemplate *)
+                        FindImportedConstruct(theEnv,"deftemplate",NULL,
+                                              deftemplateName,&count,
+                                              true,NULL);
+
+   /*=======================================================*/
+   /* Determine the slots referenced by the pattern before  */
+   /* the slots which only bind variables are removed. A    */
+   /* modify of any other slot leaves the pattern's matches */
+   /* in place. Unless the rule is slot-sensitive, every    */
+   /* slot is considered to be referenced.                  */
+   /*=======================================================*/
+
+   slotSensitive = PatternData(theEnv)->GlobalSlotSensitive;
+   modifySlots = FormModifySlotBitMap(theEnv,thePattern,
+                                      FactData(theEnv)->CurrentDeftemplate,
+                                      slotSensitive);
+
    /*=====================================================*/
    /* Remove any slot tests that test only for existance. */
+   /* The slots of a slot-sensitive pattern are kept so   */
+   /* that it only ends at the same pattern node as other */
+   /* patterns referencing the same slots.                */
    /*=====================================================*/
 
-   thePattern->right = RemoveUnneededSlots(theEnv,thePattern->right);
+   thePattern->right = RemoveUnneededSlots(theEnv,thePattern->right,slotSensitive);
 
    /*========================================================*/
    /* If the constant test for the relation name is the only */
@@ -182,10 +226,12 @@ static struct patternNodeHeader *PlaceFactPattern(
    /* the join network. Otherwise, remove the test for the   */
    /* relation name since this test has already been done    */
    /* before entering the pattern network (since each        */
-   /* deftemplate has its own pattern network).              */
+   /* deftemplate has its own pattern network). The node is  */
+   /* always kept for a slot-sensitive pattern so that it    */
+   /* can't be shared with the node for the first slot.      */
    /*========================================================*/
 
-   if (thePattern->right->right == NULL)
+   if ((thePattern->right->right == NULL) || slotSensitive)
      {
       ReturnExpression(theEnv,thePattern->right->networkTest);
       ReturnExpression(theEnv,thePattern->right->constantSelector);
@@ -223,17 +269,6 @@ static struct patternNodeHeader *PlaceFactPattern(
    thePattern->rightHash = NULL;
 
    tempPattern = NULL;
-        
-   /*============================================================*/
-   /* Get a pointer to the deftemplate data structure associated */
-   /* with the pattern (use the deftemplate name extracted from  */
-   /* the first field of the pattern).                           */
-   /*============================================================*/
-
-   FactData(theEnv)->CurrentDeftemplate = (Deftemplate *)
-                        FindImportedConstruct(theEnv,"deftemplate",NULL,
-                                              deftemplateName,&count,
-                                              true,NULL);
 
    /*================================================*/
    /* Initialize some pointers to indicate where the */
@@ -277,7 +312,7 @@ static struct patternNodeHeader *PlaceFactPattern(
       /* that can be reused (shared)?           */
       /*========================================*/
 
-      newNode = FindPatternNode(currentLevel,thePattern,&nodeBeforeMatch,endSlot,false);
+      newNode = FindPatternNode(currentLevel,thePattern,&nodeBeforeMatch,endSlot,false,slotSensitive);
 
       /*================================================*/
       /* If the pattern node cannot be shared, then add */
@@ -285,16 +320,20 @@ static struct patternNodeHeader *PlaceFactPattern(
       /*================================================*/
 
       if (newNode == NULL)
-        { newNode = CreateNewPatternNode(theEnv,thePattern,nodeBeforeMatch,lastLevel,endSlot,false); }
+        { newNode = CreateNewPatternNode(theEnv,thePattern,nodeBeforeMatch,lastLevel,endSlot,false,slotSensitive); }
+
+      AddModifySlots(theEnv,&newNode->modifySlots,modifySlots);
 
       if (thePattern->constantSelector != NULL)
         {
          currentLevel = newNode->nextLevel;
          lastLevel = newNode;
-         newNode = FindPatternNode(currentLevel,thePattern,&nodeBeforeMatch,endSlot,true);
+         newNode = FindPatternNode(currentLevel,thePattern,&nodeBeforeMatch,endSlot,true,slotSensitive);
          
          if (newNode == NULL)
-           { newNode = CreateNewPatternNode(theEnv,thePattern,nodeBeforeMatch,lastLevel,endSlot,true); }
+           { newNode = CreateNewPatternNode(theEnv,thePattern,nodeBeforeMatch,lastLevel,endSlot,true,slotSensitive); }
+
+         AddModifySlots(theEnv,&newNode->modifySlots,modifySlots);
         }
       
       /*===========================================================*/
@@ -314,9 +353,15 @@ static struct patternNodeHeader *PlaceFactPattern(
       /* pattern network, then mark the last pattern node added   */
       /* as a stop node (i.e. if you get to this node and the     */
       /* network test succeeds, then a pattern has been matched). */
+      /* The slots of the patterns ending at the node determine   */
+      /* whether a modify retracts its alpha matches.             */
       /*==========================================================*/
 
-      if (thePattern == NULL) newNode->header.stopNode = true;
+      if (thePattern == NULL)
+        {
+         newNode->header.stopNode = true;
+         AddModifySlots(theEnv,&newNode->stopSlots,modifySlots);
+        }
 
       /*================================================*/
       /* Update the pointers which indicate where we're */
@@ -339,13 +384,16 @@ static struct patternNodeHeader *PlaceFactPattern(
 /* FindPatternNode: Looks for a pattern node at a specified  */
 /*  level in the pattern network that can be reused (shared) */
 /*  with a pattern field being added to the pattern network. */
+/*  The nodes of slot-sensitive patterns are only shared     */
+/*  with other slot-sensitive patterns.                      */
 /*************************************************************/
 static struct factPatternNode *FindPatternNode(
   struct factPatternNode *listOfNodes,
   struct lhsParseNode *thePattern,
   struct factPatternNode **nodeBeforeMatch,
   bool endSlot,
-  bool constantSelector)
+  bool constantSelector,
+  bool slotSensitive)
   {
    struct expr *compareTest;
    *nodeBeforeMatch = NULL;
@@ -376,6 +424,7 @@ static struct factPatternNode *FindPatternNode(
         {
          if ((listOfNodes->header.singlefieldNode) &&
              (listOfNodes->header.endSlot == endSlot) &&
+             (listOfNodes->slotSensitive == slotSensitive) &&
              (listOfNodes->whichField == thePattern->index) &&
              (listOfNodes->whichSlot == (thePattern->slotNumber - 1)) &&
              IdenticalExpression(listOfNodes->networkTest,compareTest) &&
@@ -386,6 +435,7 @@ static struct factPatternNode *FindPatternNode(
         {
          if ((listOfNodes->header.multifieldNode) &&
              (listOfNodes->header.endSlot == endSlot) &&
+             (listOfNodes->slotSensitive == slotSensitive) &&
              (listOfNodes->leaveFields == thePattern->singleFieldsAfter) &&
              (listOfNodes->whichField == thePattern->index) &&
              (listOfNodes->whichSlot == (thePattern->slotNumber - 1)) &&
@@ -421,11 +471,14 @@ static struct factPatternNode *FindPatternNode(
 /*                                                           */
 /*   The x and y slot pattern nodes can be discarded since   */
 /*   all foo facts will have these two slots in the fact     */
-/*   data structure used to store them.                      */
+/*   data structure used to store them. If keepSlots is      */
+/*   true, a pattern node without a test is kept for each    */
+/*   slot (but not for the restrictions within a slot).      */
 /*************************************************************/
 static struct lhsParseNode *RemoveUnneededSlots(
   Environment *theEnv,
-  struct lhsParseNode *thePattern)
+  struct lhsParseNode *thePattern,
+  bool keepSlots)
   {
    struct lhsParseNode *tempPattern = thePattern;
    struct lhsParseNode *lastPattern = NULL, *head = thePattern;
@@ -440,7 +493,8 @@ static struct lhsParseNode *RemoveUnneededSlots(
       /*=============================================================*/
 
       if (((tempPattern->type == SF_WILDCARD) || (tempPattern->type == SF_VARIABLE)) &&
-          (tempPattern->networkTest == NULL))
+          (tempPattern->networkTest == NULL) &&
+          (! keepSlots))
         {
          if (lastPattern != NULL) lastPattern->right = tempPattern->right;
          else head = tempPattern->right;
@@ -541,15 +595,23 @@ static struct lhsParseNode *RemoveUnneededSlots(
          /* Remove any unneeded pattern restrictions from the slot. */
          /*=========================================================*/
 
-         tempPattern->bottom = RemoveUnneededSlots(theEnv,tempPattern->bottom);
+         tempPattern->bottom = RemoveUnneededSlots(theEnv,tempPattern->bottom,false);
 
          /*===========================================================*/
          /* If the slot no longer contains any restrictions, then the */
-         /* multifield slot can be completely removed. In any case,   */
-         /* move on to the next slot to be examined for removal.      */
+         /* multifield slot can be completely removed (or replaced by */
+         /* a single field node without a test if the slot is kept).  */
+         /* In any case, move on to the next slot to be examined.     */
          /*===========================================================*/
 
-         if (tempPattern->bottom == NULL)
+         if ((tempPattern->bottom == NULL) && keepSlots)
+           {
+            tempPattern->type = SF_WILDCARD;
+            tempPattern->multifieldSlot = false;
+            lastPattern = tempPattern;
+            tempPattern = tempPattern->right;
+           }
+         else if (tempPattern->bottom == NULL)
            {
             if (lastPattern != NULL) lastPattern->right = tempPattern->right;
             else head = tempPattern->right;
@@ -598,7 +660,8 @@ static struct factPatternNode *CreateNewPatternNode(
   struct factPatternNode *nodeBeforeMatch,
   struct factPatternNode *upperLevel,
   bool endSlot,
-  bool constantSelector)
+  bool constantSelector,
+  bool slotSensitive)
   {
    struct factPatternNode *newNode;
 
@@ -611,7 +674,10 @@ static struct factPatternNode *CreateNewPatternNode(
    newNode->nextLevel = NULL;
    newNode->rightNode = NULL;
    newNode->leftNode = NULL;
+   newNode->modifySlots = NULL;
+   newNode->stopSlots = NULL;
    newNode->leaveFields = thePattern->singleFieldsAfter;
+   newNode->slotSensitive = slotSensitive;
    InitializePatternHeader(theEnv,(struct patternNodeHeader *) &newNode->header);
 
    if (thePattern->index > 0) 
@@ -752,7 +818,15 @@ static void DetachFactPattern(
    /* not be removed since other patterns make use of it.   */
    /*=======================================================*/
 
-   if (patternPtr->header.entryJoin == NULL) patternPtr->header.stopNode = false;
+   if (patternPtr->header.entryJoin == NULL)
+     {
+      patternPtr->header.stopNode = false;
+      if (patternPtr->stopSlots != NULL)
+        {
+         DecrementBitMapCount(theEnv,patternPtr->stopSlots);
+         patternPtr->stopSlots = NULL;
+        }
+     }
    if (patternPtr->nextLevel != NULL) return;
 
    /*==============================================================*/
@@ -788,6 +862,10 @@ static void DetachFactPattern(
 
          RemoveHashedExpression(theEnv,patternPtr->networkTest);
          RemoveHashedExpression(theEnv,patternPtr->header.rightHash);
+         if (patternPtr->modifySlots != NULL)
+           { DecrementBitMapCount(theEnv,patternPtr->modifySlots); }
+         if (patternPtr->stopSlots != NULL)
+           { DecrementBitMapCount(theEnv,patternPtr->stopSlots); }
          rtn_struct(theEnv,factPatternNode,patternPtr);
         }
       else if (upperLevel->leftNode != NULL)
@@ -810,6 +888,10 @@ static void DetachFactPattern(
 
          RemoveHashedExpression(theEnv,patternPtr->networkTest);
          RemoveHashedExpression(theEnv,patternPtr->header.rightHash);
+         if (patternPtr->modifySlots != NULL)
+           { DecrementBitMapCount(theEnv,patternPtr->modifySlots); }
+         if (patternPtr->stopSlots != NULL)
+           { DecrementBitMapCount(theEnv,patternPtr->stopSlots); }
          rtn_struct(theEnv,factPatternNode,patternPtr);
          upperLevel = NULL;
         }
@@ -836,6 +918,10 @@ static void DetachFactPattern(
 
          RemoveHashedExpression(theEnv,patternPtr->networkTest);
          RemoveHashedExpression(theEnv,patternPtr->header.rightHash);
+         if (patternPtr->modifySlots != NULL)
+           { DecrementBitMapCount(theEnv,patternPtr->modifySlots); }
+         if (patternPtr->stopSlots != NULL)
+           { DecrementBitMapCount(theEnv,patternPtr->stopSlots); }
          rtn_struct(theEnv,factPatternNode,patternPtr); 
          upperLevel = NULL;
         }
@@ -964,7 +1050,7 @@ static void ClearPatternMatches(
   struct factPatternNode *patternPtr)
   {
    Fact *theFact;
-   struct patternMatch *lastMatch, *theMatch;
+   unsigned long i;
 
    /*===========================================*/
    /* Loop through every fact in the fact list. */
@@ -973,59 +1059,205 @@ static void ClearPatternMatches(
    for (theFact = EnvGetNextFact(theEnv,NULL);
         theFact != NULL;
         theFact = EnvGetNextFact(theEnv,theFact))
-     {
-      /*========================================*/
-      /* Loop through every match for the fact. */
-      /*========================================*/
+     { ClearFactPatternMatches(theEnv,theFact,patternPtr); }
 
-      lastMatch = NULL;
-      theMatch = (struct patternMatch *) theFact->list;
+   /*================================================*/
+   /* Facts whose retraction is pending in a fact    */
+   /* batch are no longer in the fact list, but they */
+   /* keep their matches until the batch commits.    */
+   /*================================================*/
 
-      while (theMatch != NULL)
-        {
-         /*================================================*/
-         /* If the match is for the pattern being deleted, */
-         /* then remove the match.                         */
-         /*================================================*/
+   for (i = 0; i < FactData(theEnv)->BatchRetracts.count; i++)
+     { ClearFactPatternMatches(theEnv,FactData(theEnv)->BatchRetracts.facts[i],patternPtr); }
+  }
 
-         if (theMatch->matchingPattern == (struct patternNodeHeader *) patternPtr)
-           {
-            if (lastMatch == NULL)
-              {
-               /*=====================================*/
-               /* Remove the first match of the fact. */
-               /*=====================================*/
-
-               theFact->list = theMatch->next;
-               rtn_struct(theEnv,patternMatch,theMatch);
-               theMatch = (struct patternMatch *) theFact->list;
-              }
-            else
-             {
-               /*===================================*/
-               /* Remove a match for the fact which */
-               /* follows the first match.          */
-               /*===================================*/
-
-              lastMatch->next = theMatch->next;
-              rtn_struct(theEnv,patternMatch,theMatch);
-              theMatch = lastMatch->next;
-             }
-           }
+/***************************************************************/
+/* ClearFactPatternMatches: Removes the pointers of a fact to  */
+/*   a specific pattern from the fact's list of matches.       */
+/***************************************************************/
+static void ClearFactPatternMatches(
+  Environment *theEnv,
+  Fact *theFact,
+  struct factPatternNode *patternPtr)
+  {
+   struct patternMatch *lastMatch, *theMatch;
 
-         /*====================================================*/
-         /* If the match is not for the pattern being deleted, */
-         /* then move on to the next match for the fact.       */
-         /*====================================================*/
+   /*========================================*/
+   /* Loop through every match for the fact. */
+   /*========================================*/
+
+   lastMatch = NULL;
+   theMatch = (struct patternMatch *) theFact->list;
+
+   while (theMatch != NULL)
+     {
+      /*================================================*/
+      /* If the match is for the pattern being deleted, */
+      /* then remove the match.                         */
+      /*================================================*/
 
+      if (theMatch->matchingPattern == (struct patternNodeHeader *) patternPtr)
+        {
+         if (lastMatch == NULL)
+           {
+            /*=====================================*/
+            /* Remove the first match of the fact. */
+            /*=====================================*/
+
+            theFact->list = theMatch->next;
+            rtn_struct(theEnv,patternMatch,theMatch);
+            theMatch = (struct patternMatch *) theFact->list;
+           }
          else
           {
-           lastMatch = theMatch;
-           theMatch = theMatch->next;
+            /*===================================*/
+            /* Remove a match for the fact which */
+            /* follows the first match.          */
+            /*===================================*/
+
+           lastMatch->next = theMatch->next;
+           rtn_struct(theEnv,patternMatch,theMatch);
+           theMatch = lastMatch->next;
           }
+        }
+
+      /*====================================================*/
+      /* If the match is not for the pattern being deleted, */
+      /* then move on to the next match for the fact.       */
+      /*====================================================*/
+
+      else
+       {
+        lastMatch = theMatch;
+        theMatch = theMatch->next;
        }
     }
   }
+
+/*****************************************************************/
+/* FormModifySlotBitMap: Returns a bitmap of the slots which are */
+/*   tested or bound by a fact pattern. A modify which changes   */
+/*   none of these slots can not affect the pattern's matches.   */
+/*   Unless the pattern belongs to a slot-sensitive rule, all of */
+/*   the deftemplate's slots are considered to be referenced, so */
+/*   that a modify of any slot rematches the pattern. NULL is    */
+/*   returned if the pattern references no slots.                */
+/*****************************************************************/
+static BITMAP_HN *FormModifySlotBitMap(
+  Environment *theEnv,
+  struct lhsParseNode *thePattern,
+  Deftemplate *theDeftemplate,
+  bool slotSensitive)
+  {
+   struct lhsParseNode *theSlot;
+   int maxSlot = -1;
+   unsigned size;
+   unsigned short i;
+   char *theMap;
+   BITMAP_HN *rv;
+
+   /*=================================================*/
+   /* Skip the relation name and find the last slot   */
+   /* referenced to determine the size of the bitmap  */
+   /* (the deftemplate's last slot if every slot is   */
+   /* considered to be referenced).                   */
+   /*=================================================*/
+
+   if (! slotSensitive)
+     { maxSlot = theDeftemplate->numberOfSlots; }
+   else for (theSlot = thePattern->right->right;
+             theSlot != NULL;
+             theSlot = theSlot->right)
+     {
+      if (theSlot->slotNumber > maxSlot)
+        { maxSlot = theSlot->slotNumber; }
+     }
+
+   if (maxSlot <= 0) return NULL;
+
+   /*==================================*/
+   /* Set the bit for each slot in the */
+   /* pattern and add the bitmap.      */
+   /*==================================*/
+
+   size = (unsigned) ((maxSlot - 1) / BITS_PER_BYTE + 1);
+   theMap = (char *) gm2(theEnv,size);
+   ClearBitString(theMap,size);
+
+   if (! slotSensitive)
+     {
+      for (i = 0; i < theDeftemplate->numberOfSlots; i++)
+        { SetBitMap(theMap,i); }
+     }
+   else for (theSlot = thePattern->right->right;
+        theSlot != NULL;
+        theSlot = theSlot->right)
+     {
+      if (theSlot->slotNumber > 0)
+        { SetBitMap(theMap,theSlot->slotNumber - 1); }
+     }
+
+   rv = (BITMAP_HN *) EnvAddBitMap(theEnv,theMap,size);
+   rm(theEnv,theMap,size);
+
+   return rv;
+  }
+
+/*****************************************************************/
+/* AddModifySlots: Merges the slots referenced by a pattern into */
+/*   one of the bitmaps of a pattern node. Since a node's modify */
+/*   slots are shared by every pattern beneath it, a modify can  */
+/*   skip any node whose bitmap has no changed slots. The stop   */
+/*   slots are only those of the patterns ending at the node.    */
+/*****************************************************************/
+static void AddModifySlots(
+  Environment *theEnv,
+  BITMAP_HN **nodeSlots,
+  BITMAP_HN *patternSlots)
+  {
+   BITMAP_HN *oldSlots = *nodeSlots;
+   unsigned short size, i;
+   char *theMap;
+
+   if (patternSlots == NULL) return;
+
+   /*==================================================*/
+   /* If the node has no slots, it can share the       */
+   /* pattern's bitmap. If the node already includes   */
+   /* the pattern's slots, there's nothing to do.      */
+   /*==================================================*/
+
+   if (oldSlots == patternSlots) return;
+
+   if (oldSlots == NULL)
+     {
+      *nodeSlots = patternSlots;
+      IncrementBitMapCount(patternSlots);
+      return;
+     }
+
+   /*===============================================*/
+   /* Otherwise form the union of the two bitmaps.  */
+   /*===============================================*/
+
+   size = oldSlots->size;
+   if (patternSlots->size > size)
+     { size = patternSlots->size; }
+
+   theMap = (char *) gm2(theEnv,size);
+   ClearBitString(theMap,size);
+
+   for (i = 0; i < oldSlots->size; i++)
+     { theMap[i] |= oldSlots->contents[i]; }
+
+   for (i = 0; i < patternSlots->size; i++)
+     { theMap[i] |= patternSlots->contents[i]; }
+
+   *nodeSlots = (BITMAP_HN *) EnvAddBitMap(theEnv,theMap,size);
+   IncrementBitMapCount(*nodeSlots);
+   DecrementBitMapCount(theEnv,oldSlots);
+   rm(theEnv,theMap,size);
+  }
   
 #endif /* (! RUN_TIME) && (! BLOAD_ONLY) */
 
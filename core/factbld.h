@@ -28,6 +28,13 @@
 /*            Removed use of void pointers for specific      */
 /*            data structures.                               */
 /*                                                           */
+/*            Added a bitmap of the slots referenced by the  */
+/*            patterns using a pattern node for modify.      */
+/*                                                           */
+/*            Added a bitmap of the slots referenced by the  */
+/*            patterns ending at a pattern node and a flag   */
+/*            for the nodes of slot-sensitive patterns.      */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_factbld
@@ -48,11 +55,14 @@ struct factPatternNode
    unsigned short whichField;
    unsigned short whichSlot;
    unsigned short leaveFields;
+   bool slotSensitive;
    struct expr *networkTest;
    struct factPatternNode *nextLevel;
    struct factPatternNode *lastLevel;
    struct factPatternNode *leftNode;
    struct factPatternNode *rightNode;
+   struct bitMapHashNode *modifySlots;
+   struct bitMapHashNode *stopSlots;
   };
 
    void                           InitializeFactPatterns(Environment *);
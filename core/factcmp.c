@@ -31,6 +31,9 @@
 /*            Removed use of void pointers for specific      */
 /*            data structures.                               */
 /*                                                           */
+/*            Writes the bitmaps of the slots referenced by  */
+/*            the patterns using or ending at a node.        */
+/*                                                           */
 /*************************************************************/
 
 #include "setup.h"
@@ -44,6 +47,7 @@
 #include "factbld.h"
 #include "conscomp.h"
 #include "factcmp.h"
+#include "symblcmp.h"
 #include "tmpltdef.h"
 #include "envrnmnt.h"
 
@@ -294,9 +298,10 @@ static void PatternNodeToCode(
    /* Field and Slot Indices */
    /*========================*/
 
-   fprintf(theFile,",0,%d,%d,%d,",thePatternNode->whichField,
+   fprintf(theFile,",0,%d,%d,%d,%d,",thePatternNode->whichField,
                              thePatternNode->whichSlot,
-                             thePatternNode->leaveFields);
+                             thePatternNode->leaveFields,
+                             thePatternNode->slotSensitive);
 
    /*===============*/
    /* Network Tests */
@@ -348,13 +353,27 @@ static void PatternNodeToCode(
    /*============*/
 
    if (thePatternNode->rightNode == NULL)
-     { fprintf(theFile,"NULL}"); }
+     { fprintf(theFile,"NULL,"); }
    else
      {
-      fprintf(theFile,"&%s%d_%ld[%ld]}",FactPrefix(),
+      fprintf(theFile,"&%s%d_%ld[%ld],",FactPrefix(),
             imageID,(thePatternNode->rightNode->bsaveID / maxIndices) + 1,
                 thePatternNode->rightNode->bsaveID % maxIndices);
      }
+
+   /*==============*/
+   /* Modify Slots */
+   /*==============*/
+
+   PrintBitMapReference(theEnv,theFile,thePatternNode->modifySlots);
+   fprintf(theFile,",");
+
+   /*============*/
+   /* Stop Slots */
+   /*============*/
+
+   PrintBitMapReference(theEnv,theFile,thePatternNode->stopSlots);
+   fprintf(theFile,"}");
   }
 
 /**********************************************************/
@@ -65,6 +65,8 @@
 /*      6.50: Watch facts for modify command only prints     */
 /*            changed slots.                                 */
 /*                                                           */
+/*            Added with-fact-batch function.                */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
@@ -86,6 +88,7 @@
 #include "match.h"
 #include "memalloc.h"
 #include "modulutl.h"
+#include "prcdrfun.h"
 #include "router.h"
 #include "scanner.h"
 #include "strngrtr.h"
@@ -140,9 +143,11 @@ void FactCommandDefinitions(
    EnvAddUDF(theEnv,"save-facts","b",1,UNBOUNDED,"y;sy",SaveFactsCommand,"SaveFactsCommand",NULL);
    EnvAddUDF(theEnv,"load-facts","b",1,1,"sy",LoadFactsCommand,"LoadFactsCommand",NULL);
    EnvAddUDF(theEnv,"fact-index","l",1,1,"f",FactIndexFunction,"FactIndexFunction",NULL);
+   EnvAddUDF(theEnv,"with-fact-batch","*",0,UNBOUNDED,NULL,WithFactBatchFunction,"WithFactBatchFunction",NULL);
 
    AddFunctionParser(theEnv,"assert",AssertParse);
    FuncSeqOvlFlags(theEnv,"assert",false,false);
+   FuncSeqOvlFlags(theEnv,"with-fact-batch",false,false);
 #else
 #if MAC_XCD
 #pragma unused(theEnv)
@@ -456,6 +461,47 @@ void FactIndexFunction(
    mCVSetInteger(returnValue,EnvFactIndex(theEnv,GetValue(theArg)));
   }
 
+/*******************************************/
+/* WithFactBatchFunction: H/L access       */
+/*   routine for the with-fact-batch       */
+/*   function. Evaluates its arguments in  */
+/*   a fact batch and returns the value of */
+/*   the last one, like progn.             */
+/*******************************************/
+void WithFactBatchFunction(
+  Environment *theEnv,
+  UDFContext *context,
+  CLIPSValue *returnValue)
+  {
+   struct expr *argPtr;
+
+   mCVSetBoolean(returnValue,false);
+
+   EnvBeginFactBatch(theEnv);
+
+   for (argPtr = EvaluationData(theEnv)->CurrentExpression->argList;
+        (argPtr != NULL) && (EnvGetHaltExecution(theEnv) != true);
+        argPtr = argPtr->nextArg)
+     {
+      EvaluateExpression(theEnv,argPtr,returnValue);
+
+      if ((ProcedureFunctionData(theEnv)->BreakFlag == true) ||
+          (ProcedureFunctionData(theEnv)->ReturnFlag == true))
+        { break; }
+     }
+
+   /*=============================================*/
+   /* The changes are committed even if an error  */
+   /* occurred, since they've already been made   */
+   /* to the fact-list.                           */
+   /*=============================================*/
+
+   EnvCommitFactBatch(theEnv);
+
+   if (EnvGetHaltExecution(theEnv) == true)
+     { mCVSetBoolean(returnValue,false); }
+  }
+
 #if DEBUGGING_FUNCTIONS
 
 /**************************************/
@@ -53,6 +53,8 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added with-fact-batch function.                */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_factcom
@@ -73,6 +75,7 @@
    void                           GetFactDuplicationCommand(Environment *,UDFContext *,CLIPSValue *);
    void                           SaveFactsCommand(Environment *,UDFContext *,CLIPSValue *);
    void                           LoadFactsCommand(Environment *,UDFContext *,CLIPSValue *);
+   void                           WithFactBatchFunction(Environment *,UDFContext *,CLIPSValue *);
    bool                           EnvSaveFacts(Environment *,const char *,int);
    bool                           EnvSaveFactsDriver(Environment *,const char *,int,struct expr *);
    bool                           EnvLoadFacts(Environment *,const char *);
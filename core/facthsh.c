@@ -43,18 +43,30 @@
 /*                                                           */
 /*      6.50: Modify command preserves fact id and address.  */
 /*                                                           */
+/*            Added slot indexes for looking up the facts of */
+/*            a deftemplate by the value of a slot.          */
+/*                                                           */
+/*            The hash value of a modified fact is updated   */
+/*            for its changed slots rather than recomputed.  */
+/*                                                           */
+/*            The fact hash table isn't shrunk during a      */
+/*            reset.                                         */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "setup.h"
 
 #if DEFTEMPLATE_CONSTRUCT
 
 #include "constant.h"
+#include "constrct.h"
 #include "envrnmnt.h"
 #include "memalloc.h"
+#include "reteutil.h"
 #include "router.h"
 #include "sysdep.h"
 
@@ -72,6 +84,10 @@
    static struct factHashEntry  **CreateFactHashTable(Environment *,unsigned long);
    static void                    ResizeFactHashTable(Environment *);
    static void                    ResetFactHashTable(Environment *);
+   static unsigned long           HashSlotIndexValue(unsigned short,void *);
+   static void                    AddSlotIndexEntry(Environment *,struct factSlotIndex *,Fact *);
+   static void                    ResizeSlotIndex(Environment *,struct factSlotIndex *);
+   static int                     CompareIndexedFacts(const void *,const void *);
    
 /************************************************/
 /* HashFact: Returns the hash value for a fact. */
@@ -107,6 +123,23 @@ unsigned long HashFact(
    return(count);
   }
 
+/***************************************************************/
+/* UpdateFactHash: Updates the hash value of a fact for a slot */
+/*   whose value is being replaced by a modify. This must be   */
+/*   called before the old value is removed from the fact.     */
+/***************************************************************/
+void UpdateFactHash(
+  Fact *theFact,
+  unsigned long position,
+  unsigned short type,
+  void *value)
+  {
+   struct field *theField = &theFact->theProposition.theFields[position];
+
+   theFact->hashValue -= HashMultifieldField(theField->type,theField->value,position,0);
+   theFact->hashValue += HashMultifieldField(type,value,position,0);
+  }
+
 /**********************************************/
 /* FactExists: Determines if a specified fact */
 /*   already exists in the fact hash table.   */
@@ -170,8 +203,7 @@ bool RemoveHashedFact(
    unsigned long hashValue;
    struct factHashEntry *hptr, *prev;
 
-   hashValue = HashFact(theFact);
-   hashValue = (hashValue % FactData(theEnv)->FactHashTableSize);
+   hashValue = (theFact->hashValue % FactData(theEnv)->FactHashTableSize);
 
    for (hptr = FactData(theEnv)->FactHashTable[hashValue], prev = NULL;
         hptr != NULL;
@@ -239,7 +271,16 @@ unsigned long HandleFactDuplication(
    unsigned long hashValue;
    *duplicate = false;
    
-   hashValue = HashFact(theFact);
+   /*=====================================================*/
+   /* The hash value of a fact being modified was updated */
+   /* as its slots were replaced, so it only needs to be  */
+   /* computed for a new fact.                            */
+   /*=====================================================*/
+
+   if (reuseIndex > 0)
+     { hashValue = theFact->hashValue; }
+   else
+     { hashValue = HashFact(theFact); }
 
    if (FactData(theEnv)->FactDuplication)
      { return hashValue; }
@@ -379,6 +420,15 @@ static void ResetFactHashTable(
     
     if (FactData(theEnv)->FactHashTableSize == SIZE_FACT_HASH)
       { return; }
+
+    /*=================================================*/
+    /* The table keeps its size across a reset so the  */
+    /* deffacts don't grow it through the same resizes */
+    /* again when they're asserted.                    */
+    /*=================================================*/
+
+    if (ConstructData(theEnv)->ResetInProgress)
+      { return; }
           
     /*=======================*/
     /* Create the new table. */
@@ -395,6 +445,344 @@ static void ResetFactHashTable(
     FactData(theEnv)->FactHashTable = newTable;
    }
       
+/*******************************************************/
+/* CreateSlotIndex: Creates an index of the facts of a */
+/*   deftemplate by the value of one of its single     */
+/*   field slots and adds the existing facts to it.    */
+/*   The index is then maintained as facts are         */
+/*   asserted, retracted, and modified. The slot's     */
+/*   existing index is returned if it already has one. */
+/*******************************************************/
+struct factSlotIndex *CreateSlotIndex(
+  Environment *theEnv,
+  Deftemplate *theDeftemplate,
+  SYMBOL_HN *slotName,
+  unsigned short slotPosition)
+  {
+   struct factSlotIndex *theIndex;
+   Fact *theFact;
+
+   theIndex = FindSlotIndex(theDeftemplate,slotName);
+   if (theIndex != NULL)
+     { return theIndex; }
+
+   /*=======================================*/
+   /* The deftemplate's slot name symbols   */
+   /* are kept for as long as it is, so the */
+   /* index doesn't need to count its own.  */
+   /*=======================================*/
+
+   theIndex = get_struct(theEnv,factSlotIndex);
+   theIndex->slotName = slotName;
+   theIndex->slotPosition = slotPosition;
+   theIndex->count = 0;
+   theIndex->size = SIZE_SLOT_INDEX_HASH;
+   theIndex->table = (struct factSlotIndexEntry **)
+                     gm2(theEnv,sizeof(struct factSlotIndexEntry *) * theIndex->size);
+   memset(theIndex->table,0,sizeof(struct factSlotIndexEntry *) * theIndex->size);
+   theIndex->next = theDeftemplate->slotIndexes;
+   theDeftemplate->slotIndexes = theIndex;
+
+   /*==========================================*/
+   /* Add the existing facts to the new index. */
+   /*==========================================*/
+
+   for (theFact = theDeftemplate->factList;
+        theFact != NULL;
+        theFact = theFact->nextTemplateFact)
+     { AddSlotIndexEntry(theEnv,theIndex,theFact); }
+
+   return theIndex;
+  }
+
+/***************************************************/
+/* FindSlotIndex: Returns the index of a slot of a */
+/*   deftemplate or NULL if it has no index.       */
+/***************************************************/
+struct factSlotIndex *FindSlotIndex(
+  Deftemplate *theDeftemplate,
+  SYMBOL_HN *slotName)
+  {
+   struct factSlotIndex *theIndex;
+
+   for (theIndex = theDeftemplate->slotIndexes;
+        theIndex != NULL;
+        theIndex = theIndex->next)
+     {
+      if (theIndex->slotName == slotName)
+        { return theIndex; }
+     }
+
+   return NULL;
+  }
+
+/***********************************************************/
+/* FindIndexedFacts: Looks up the facts whose indexed slot */
+/*   holds a value which is eq to the specified value. The */
+/*   facts are returned in an array allocated with gm2 in  */
+/*   the order of their fact indices (and so in the order  */
+/*   they appear in the fact-list). The number of facts is */
+/*   returned and the array is NULL if there are none.     */
+/***********************************************************/
+unsigned long FindIndexedFacts(
+  Environment *theEnv,
+  struct factSlotIndex *theIndex,
+  unsigned short type,
+  void *value,
+  Fact ***theFacts)
+  {
+   struct factSlotIndexEntry *theEntry;
+   struct field *theField;
+   unsigned long hashValue, count = 0;
+
+   *theFacts = NULL;
+
+   if (type == MULTIFIELD)
+     { return 0; }
+
+   hashValue = HashSlotIndexValue(type,value);
+
+   /*====================================*/
+   /* Count the matches in the bucket so */
+   /* the array can be allocated.        */
+   /*====================================*/
+
+   for (theEntry = theIndex->table[hashValue & (theIndex->size - 1)];
+        theEntry != NULL;
+        theEntry = theEntry->next)
+     {
+      theField = &theEntry->theFact->theProposition.theFields[theIndex->slotPosition];
+      if ((theEntry->hashValue == hashValue) &&
+          (theField->type == type) && (theField->value == value))
+        { count++; }
+     }
+
+   if (count == 0)
+     { return 0; }
+
+   /*========================================*/
+   /* Gather the matches and sort them by    */
+   /* fact index. A bucket holds its entries */
+   /* in no particular order.                */
+   /*========================================*/
+
+   *theFacts = (Fact **) gm2(theEnv,sizeof(Fact *) * count);
+
+   count = 0;
+   for (theEntry = theIndex->table[hashValue & (theIndex->size - 1)];
+        theEntry != NULL;
+        theEntry = theEntry->next)
+     {
+      theField = &theEntry->theFact->theProposition.theFields[theIndex->slotPosition];
+      if ((theEntry->hashValue == hashValue) &&
+          (theField->type == type) && (theField->value == value))
+        { (*theFacts)[count++] = theEntry->theFact; }
+     }
+
+   if (count > 1)
+     { qsort(*theFacts,count,sizeof(Fact *),CompareIndexedFacts); }
+
+   return count;
+  }
+
+/*****************************************************/
+/* AddSlotIndexEntries: Adds a fact being asserted   */
+/*   to each of the slot indexes of its deftemplate. */
+/*****************************************************/
+void AddSlotIndexEntries(
+  Environment *theEnv,
+  Fact *theFact)
+  {
+   struct factSlotIndex *theIndex;
+
+   theFact->slotIndexEntries = NULL;
+
+   for (theIndex = theFact->whichDeftemplate->slotIndexes;
+        theIndex != NULL;
+        theIndex = theIndex->next)
+     { AddSlotIndexEntry(theEnv,theIndex,theFact); }
+  }
+
+/********************************************************/
+/* RemoveSlotIndexEntries: Removes a fact being         */
+/*   retracted from each of the slot indexes it is in.  */
+/*   For a modify, this happens before the slot values  */
+/*   of the fact are replaced, so the fact is indexed   */
+/*   again by its new values when it is asserted again. */
+/********************************************************/
+void RemoveSlotIndexEntries(
+  Environment *theEnv,
+  Fact *theFact)
+  {
+   struct factSlotIndexEntry *theEntry, *nextEntry;
+   struct factSlotIndex *theIndex;
+
+   for (theEntry = theFact->slotIndexEntries;
+        theEntry != NULL;
+        theEntry = nextEntry)
+     {
+      nextEntry = theEntry->nextForFact;
+      theIndex = theEntry->whichIndex;
+
+      if (theEntry->previous == NULL)
+        { theIndex->table[theEntry->hashValue & (theIndex->size - 1)] = theEntry->next; }
+      else
+        { theEntry->previous->next = theEntry->next; }
+
+      if (theEntry->next != NULL)
+        { theEntry->next->previous = theEntry->previous; }
+
+      theIndex->count--;
+      rtn_struct(theEnv,factSlotIndexEntry,theEntry);
+     }
+
+   theFact->slotIndexEntries = NULL;
+  }
+
+/*********************************************************/
+/* ReturnSlotIndexes: Returns the slot indexes of a      */
+/*   deftemplate (and any entries remaining in them when */
+/*   the environment is destroyed) to free memory.       */
+/*********************************************************/
+void ReturnSlotIndexes(
+  Environment *theEnv,
+  Deftemplate *theDeftemplate)
+  {
+   struct factSlotIndex *theIndex, *nextIndex;
+   struct factSlotIndexEntry *theEntry, *nextEntry;
+   unsigned long i;
+
+   for (theIndex = theDeftemplate->slotIndexes;
+        theIndex != NULL;
+        theIndex = nextIndex)
+     {
+      nextIndex = theIndex->next;
+
+      for (i = 0; i < theIndex->size; i++)
+        {
+         for (theEntry = theIndex->table[i];
+              theEntry != NULL;
+              theEntry = nextEntry)
+           {
+            nextEntry = theEntry->next;
+            rtn_struct(theEnv,factSlotIndexEntry,theEntry);
+           }
+        }
+
+      rm(theEnv,theIndex->table,sizeof(struct factSlotIndexEntry *) * theIndex->size);
+      rtn_struct(theEnv,factSlotIndex,theIndex);
+     }
+
+   theDeftemplate->slotIndexes = NULL;
+  }
+
+/*********************************************************/
+/* HashSlotIndexValue: Returns the hash value of a slot  */
+/*   value for a slot index. Values are hashed as they   */
+/*   are in the join network, so values which are eq     */
+/*   have the same hash value.                           */
+/*********************************************************/
+static unsigned long HashSlotIndexValue(
+  unsigned short type,
+  void *value)
+  {
+   CLIPSValue theValue;
+
+   theValue.type = type;
+   theValue.value = value;
+
+   return(FoldJoinHashValue(AddJoinHashValue(0,&theValue)));
+  }
+
+/*******************************************************/
+/* AddSlotIndexEntry: Adds a fact to a slot index. The */
+/*   table is doubled in size when it holds more       */
+/*   entries than it has buckets.                      */
+/*******************************************************/
+static void AddSlotIndexEntry(
+  Environment *theEnv,
+  struct factSlotIndex *theIndex,
+  Fact *theFact)
+  {
+   struct factSlotIndexEntry *theEntry, **theBucket;
+   struct field *theField;
+
+   if (theIndex->count >= theIndex->size)
+     { ResizeSlotIndex(theEnv,theIndex); }
+
+   theField = &theFact->theProposition.theFields[theIndex->slotPosition];
+
+   theEntry = get_struct(theEnv,factSlotIndexEntry);
+   theEntry->theFact = theFact;
+   theEntry->whichIndex = theIndex;
+   theEntry->hashValue = HashSlotIndexValue(theField->type,theField->value);
+
+   theBucket = &theIndex->table[theEntry->hashValue & (theIndex->size - 1)];
+   theEntry->previous = NULL;
+   theEntry->next = *theBucket;
+   if (*theBucket != NULL)
+     { (*theBucket)->previous = theEntry; }
+   *theBucket = theEntry;
+
+   theEntry->nextForFact = theFact->slotIndexEntries;
+   theFact->slotIndexEntries = theEntry;
+
+   theIndex->count++;
+  }
+
+/************************************************/
+/* ResizeSlotIndex: Doubles the number of       */
+/*   buckets in a slot index and moves each     */
+/*   entry to its bucket in the new table.      */
+/************************************************/
+static void ResizeSlotIndex(
+  Environment *theEnv,
+  struct factSlotIndex *theIndex)
+  {
+   struct factSlotIndexEntry **newTable, *theEntry, *nextEntry, **theBucket;
+   unsigned long i, newSize;
+
+   newSize = theIndex->size * 2;
+   newTable = (struct factSlotIndexEntry **)
+              gm2(theEnv,sizeof(struct factSlotIndexEntry *) * newSize);
+   memset(newTable,0,sizeof(struct factSlotIndexEntry *) * newSize);
+
+   for (i = 0; i < theIndex->size; i++)
+     {
+      for (theEntry = theIndex->table[i];
+           theEntry != NULL;
+           theEntry = nextEntry)
+        {
+         nextEntry = theEntry->next;
+         theBucket = &newTable[theEntry->hashValue & (newSize - 1)];
+         theEntry->previous = NULL;
+         theEntry->next = *theBucket;
+         if (*theBucket != NULL)
+           { (*theBucket)->previous = theEntry; }
+         *theBucket = theEntry;
+        }
+     }
+
+   rm(theEnv,theIndex->table,sizeof(struct factSlotIndexEntry *) * theIndex->size);
+   theIndex->table = newTable;
+   theIndex->size = newSize;
+  }
+
+/*****************************************************/
+/* CompareIndexedFacts: Orders facts by fact index.  */
+/*****************************************************/
+static int CompareIndexedFacts(
+  const void *f1,
+  const void *f2)
+  {
+   long long i1 = (*(Fact * const *) f1)->factIndex;
+   long long i2 = (*(Fact * const *) f2)->factIndex;
+
+   if (i1 < i2) return -1;
+   if (i1 > i2) return 1;
+   return 0;
+  }
+
 #if DEVELOPER
 
 /****************************************************/
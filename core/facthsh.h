@@ -43,6 +43,12 @@
 /*                                                           */
 /*      6.50: Modify command preserves fact id and address.  */
 /*                                                           */
+/*            Added slot indexes for looking up the facts of */
+/*            a deftemplate by the value of a slot.          */
+/*                                                           */
+/*            The hash value of a modified fact is updated   */
+/*            for its changed slots rather than recomputed.  */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_facthsh
@@ -52,6 +58,8 @@
 #define _H_facthsh
 
 struct factHashEntry;
+struct factSlotIndex;
+struct factSlotIndexEntry;
 
 #include "factmngr.h"
 
@@ -61,8 +69,32 @@ struct factHashEntry
    struct factHashEntry *next;
   };
 
+struct factSlotIndex
+  {
+   SYMBOL_HN *slotName;
+   unsigned short slotPosition;
+   unsigned long count;
+   unsigned long size;
+   struct factSlotIndexEntry **table;
+   struct factSlotIndex *next;
+  };
+
+struct factSlotIndexEntry
+  {
+   struct fact *theFact;
+   struct factSlotIndex *whichIndex;
+   unsigned long hashValue;
+   struct factSlotIndexEntry *previous;
+   struct factSlotIndexEntry *next;
+   struct factSlotIndexEntry *nextForFact;
+  };
+
 #define SIZE_FACT_HASH 16231
 
+#ifndef SIZE_SLOT_INDEX_HASH
+#define SIZE_SLOT_INDEX_HASH 16
+#endif
+
    void                           AddHashedFact(Environment *,Fact *,unsigned long);
    bool                           RemoveHashedFact(Environment *,Fact *);
    unsigned long                  HandleFactDuplication(Environment *,Fact *,bool *,long long);
@@ -71,7 +103,14 @@ struct factHashEntry
    void                           InitializeFactHashTable(Environment *);
    void                           ShowFactHashTableCommand(Environment *,UDFContext *,CLIPSValue *);
    unsigned long                  HashFact(Fact *);
+   void                           UpdateFactHash(Fact *,unsigned long,unsigned short,void *);
    bool                           FactWillBeAsserted(Environment *,Fact *);
+   struct factSlotIndex          *CreateSlotIndex(Environment *,Deftemplate *,SYMBOL_HN *,unsigned short);
+   struct factSlotIndex          *FindSlotIndex(Deftemplate *,SYMBOL_HN *);
+   unsigned long                  FindIndexedFacts(Environment *,struct factSlotIndex *,unsigned short,void *,Fact ***);
+   void                           AddSlotIndexEntries(Environment *,Fact *);
+   void                           RemoveSlotIndexEntries(Environment *,Fact *);
+   void                           ReturnSlotIndexes(Environment *,Deftemplate *);
 
 #endif /* _H_facthsh */
 
@@ -46,6 +46,9 @@
 /*      6.50: Watch facts for modify command only prints     */
 /*            changed slots.                                 */
 /*                                                           */
+/*            Pattern nodes which reference none of the      */
+/*            slots changed by a modify are skipped.         */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
@@ -541,6 +544,18 @@ static void ProcessFactAlphaMatch(
    struct joinNode *listOfJoins;
    unsigned long hashValue;
 
+  /*===================================================*/
+  /* When a modified fact is matched, the alpha match  */
+  /* for a node whose patterns don't reference any of  */
+  /* the changed slots was kept by the retraction. The */
+  /* node may still be traversed for the patterns that */
+  /* continue beneath it.                              */
+  /*===================================================*/
+
+  if ((FactData(theEnv)->CurrentPatternChangeMap != NULL) &&
+      (! FactPatternSlotsChanged(thePattern->stopSlots,FactData(theEnv)->CurrentPatternChangeMap)))
+    { return; }
+
   /*============================================*/
   /* Create the hash value for the alpha match. */
   /*============================================*/
@@ -789,8 +804,11 @@ static void TraceErrorToJoin(
 /* SkipFactPatternNode: During an incremental reset, only fact pattern */
 /*   nodes associated with new patterns are traversed. Given a pattern */
 /*   node, this routine will return true if the pattern node should be */
-/*   traversed during incremental reset pattern matching or false if   */
-/*   the node should be skipped.                                       */
+/*   skipped during incremental reset pattern matching or false if the */
+/*   node should be traversed. When a modified fact is matched, nodes  */
+/*   used only by patterns which don't reference any of the changed    */
+/*   slots are also skipped since the fact's matches for those         */
+/*   patterns were kept by the retraction.                             */
 /***********************************************************************/
 static bool SkipFactPatternNode(
   Environment *theEnv,
@@ -802,6 +820,33 @@ static bool SkipFactPatternNode(
      { return true; }
 #endif
 
+   if ((FactData(theEnv)->CurrentPatternChangeMap != NULL) &&
+       (! FactPatternSlotsChanged(thePattern->modifySlots,FactData(theEnv)->CurrentPatternChangeMap)))
+     { return true; }
+
+   return false;
+  }
+
+/*******************************************************************/
+/* FactPatternSlotsChanged: Returns true if any of the slots in a  */
+/*   modify change map are in the slots bitmap of a pattern node,  */
+/*   otherwise false. A node whose patterns don't reference any    */
+/*   slots is never affected by a modify.                          */
+/*******************************************************************/
+bool FactPatternSlotsChanged(
+  struct bitMapHashNode *theSlots,
+  const char *changeMap)
+  {
+   unsigned short i;
+
+   if (theSlots == NULL) return false;
+
+   for (i = 0; i < theSlots->size; i++)
+     {
+      if (theSlots->contents[i] & changeMap[i])
+        { return true; }
+     }
+
    return false;
   }
 
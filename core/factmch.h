@@ -40,6 +40,8 @@
 /*            Removed use of void pointers for specific      */
 /*            data structures.                               */
 /*                                                           */
+/*            Added FactPatternSlotsChanged.                 */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_factmch
@@ -58,6 +60,7 @@
                                                struct multifieldMarker *);
    void                           MarkFactPatternForIncrementalReset(Environment *,struct patternNodeHeader *,int);
    void                           FactsIncrementalReset(Environment *);
+   bool                           FactPatternSlotsChanged(struct bitMapHashNode *,const char *);
 
 #endif /* _H_factmch */
 
@@ -84,9 +84,37 @@
 /*            Watch facts for modify command only prints     */
 /*            changed slots.                                 */
 /*                                                           */
+/*            Added fact index table for constant time       */
+/*            lookup of facts by fact index.                 */
+/*            Its pages are released once they no longer     */
+/*            hold any facts.                                */
+/*                                                           */
+/*            Added a count of fact-list changes so that     */
+/*            fact-set queries can tell when their indexes   */
+/*            are stale.                                     */
+/*                                                           */
+/*            Added slot indexes for looking up the facts of */
+/*            a deftemplate by the value of a slot.          */
+/*                                                           */
+/*            Modify only retracts and rematches the         */
+/*            patterns which reference the changed slots of  */
+/*            the fact. The partial matches of the other     */
+/*            patterns are kept.                             */
+/*                                                           */
+/*            Modify callback functions are passed the map   */
+/*            of the slots changed by the modify.            */
+/*                                                           */
+/*            Added fact batches which defer the pattern     */
+/*            matching of assertions and retractions until   */
+/*            the batch is committed. An assertion retracted */
+/*            within the batch is never pattern matched.     */
+/*                                                           */
+/*            Reset keeps the fact index page directory.     */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "setup.h"
 
@@ -122,6 +150,16 @@
    static bool                    ClearFactsReady(Environment *);
    static void                    RemoveGarbageFacts(Environment *);
    static void                    DeallocateFactData(Environment *);
+   static void                    AddIndexedFact(Environment *,Fact *);
+   static void                    RemoveIndexedFact(Environment *,Fact *);
+   static void                    ResizeFactIndexPages(Environment *,unsigned long,unsigned long);
+   static void                    ReleaseFactIndexPages(Environment *);
+   static struct patternMatch    *RetractChangedMatches(Environment *,Fact *,char *);
+   static void                    RetractKeptMatches(Environment *,Fact *);
+   static void                    AddToFactBatch(Environment *,struct factBatch *,Fact *);
+   static void                    SortFactBatch(Environment *,struct factBatch *);
+   static int                     CompareBatchTemplates(const void *,const void *);
+   static int                     CompareBatchGroups(const void *,const void *);
 
 /**************************************************************/
 /* InitializeFacts: Initializes the fact data representation. */
@@ -149,8 +187,8 @@ void InitializeFacts(
         (bool (*)(void *,void *)) FactIsDeleted
       };
    
-   Fact dummyFact = { { NULL, NULL, 0, 0L }, NULL, NULL, -1L, 0, 1,
-                      NULL, NULL, NULL, NULL, NULL, { 1, 0UL, NULL, { { 0, NULL } } } };
+   Fact dummyFact = { { NULL, NULL, 0, 0L }, NULL, NULL, -1L, 0, 1, 0,
+                      NULL, NULL, NULL, NULL, NULL, NULL, { 1, 0UL, NULL, { { 0, NULL } } } };
 
    AllocateEnvironmentData(theEnv,FACTS_DATA,sizeof(struct factsData),DeallocateFactData);
 
@@ -257,6 +295,8 @@ static void DeallocateFactData(
   
    rm3(theEnv,FactData(theEnv)->FactHashTable,
        sizeof(struct factHashEntry *) * FactData(theEnv)->FactHashTableSize);
+
+   ReleaseFactIndexPages(theEnv);
                  
    tmpFactPtr = FactData(theEnv)->FactList;
    while (tmpFactPtr != NULL)
@@ -274,9 +314,37 @@ static void DeallocateFactData(
       ReturnEntityDependencies(theEnv,(struct patternEntity *) tmpFactPtr);
 
       ReturnFact(theEnv,tmpFactPtr);
-      tmpFactPtr = nextFactPtr; 
+      tmpFactPtr = nextFactPtr;
      }
-     
+
+   /*===================================================*/
+   /* Facts whose retraction is pending in a fact batch */
+   /* are on the garbage list, but still hold matches.  */
+   /*===================================================*/
+
+   for (i = 0; i < FactData(theEnv)->BatchRetracts.count; i++)
+     {
+      theMatch = (struct patternMatch *) FactData(theEnv)->BatchRetracts.facts[i]->list;
+      while (theMatch != NULL)
+        {
+         tmpMatch = theMatch->next;
+         rtn_struct(theEnv,patternMatch,theMatch);
+         theMatch = tmpMatch;
+        }
+     }
+
+   if (FactData(theEnv)->BatchAsserts.maximum != 0)
+     {
+      rm3(theEnv,FactData(theEnv)->BatchAsserts.facts,
+          sizeof(Fact *) * FactData(theEnv)->BatchAsserts.maximum);
+     }
+
+   if (FactData(theEnv)->BatchRetracts.maximum != 0)
+     {
+      rm3(theEnv,FactData(theEnv)->BatchRetracts.facts,
+          sizeof(Fact *) * FactData(theEnv)->BatchRetracts.maximum);
+     }
+
    tmpFactPtr = FactData(theEnv)->GarbageFacts;
    while (tmpFactPtr != NULL)
      {
@@ -480,6 +548,14 @@ void MatchFactFunction(
   Environment *theEnv,
   Fact *theFact)
   {
+   /*=============================================*/
+   /* A fact whose assertion is pending in a fact */
+   /* batch is matched against all of its         */
+   /* patterns when the batch is committed.       */
+   /*=============================================*/
+
+   if (theFact->batchAssert) return;
+
    FactPatternMatch(theEnv,theFact,theFact->whichDeftemplate->patternNetwork,0,NULL,NULL);
   }
 
@@ -557,6 +633,7 @@ bool RetractDriver(
    /*==================================*/
 
    FactData(theEnv)->ChangeToFactList = true;
+   FactData(theEnv)->FactListChanges++;
 
    /*===============================================*/
    /* Remove any links between the fact and partial */
@@ -572,6 +649,20 @@ bool RetractDriver(
 
    RemoveHashedFact(theEnv,theFact);
 
+   /*============================================*/
+   /* Remove the fact from the fact index table. */
+   /*============================================*/
+
+   RemoveIndexedFact(theEnv,theFact);
+
+   /*============================================*/
+   /* Remove the fact from the slot indexes of   */
+   /* its deftemplate while its slots still hold */
+   /* the values by which it was indexed.        */
+   /*============================================*/
+
+   RemoveSlotIndexEntries(theEnv,theFact);
+
    /*=========================================*/
    /* Remove the fact from its template list. */
    /*=========================================*/
@@ -636,6 +727,22 @@ bool RetractDriver(
 
    EnvSetEvaluationError(theEnv,false);
 
+   /*=================================================*/
+   /* If a fact batch is open, the retraction of the  */
+   /* fact's pattern matches is deferred until the    */
+   /* batch is committed. A fact without matches (for */
+   /* example one whose assertion is pending in the   */
+   /* batch) has nothing to defer and is retracted.   */
+   /*=================================================*/
+
+   if ((FactData(theEnv)->FactBatchDepth > 0) &&
+       (! modifyOperation) &&
+       (theFact->list != NULL))
+     {
+      AddToFactBatch(theEnv,&FactData(theEnv)->BatchRetracts,theFact);
+      return true;
+     }
+
    /*===========================================*/
    /* Loop through the list of all the patterns */
    /* that matched the fact and process the     */
@@ -643,8 +750,13 @@ bool RetractDriver(
    /*===========================================*/
 
    EngineData(theEnv)->JoinOperationInProgress = true;
-   NetworkRetract(theEnv,(struct patternMatch *) theFact->list);
-   theFact->list = NULL;
+   if (modifyOperation && (changeMap != NULL))
+     { theFact->list = RetractChangedMatches(theEnv,theFact,changeMap); }
+   else
+     {
+      NetworkRetract(theEnv,(struct patternMatch *) theFact->list);
+      theFact->list = NULL;
+     }
    EngineData(theEnv)->JoinOperationInProgress = false;
 
    /*=========================================*/
@@ -696,6 +808,67 @@ bool EnvRetract(
    return RetractDriver(theEnv,theFact,false,NULL);
   }
 
+/*****************************************************************/
+/* RetractChangedMatches: Retracts the pattern matches of a fact */
+/*   being modified for the patterns which reference one of the  */
+/*   changed slots. The matches for the other patterns can't be  */
+/*   affected by the modify and are returned so they can be kept */
+/*   as the fact's matches when it's asserted again.             */
+/*****************************************************************/
+static struct patternMatch *RetractChangedMatches(
+  Environment *theEnv,
+  Fact *theFact,
+  char *changeMap)
+  {
+   struct patternMatch *theMatch, *nextMatch;
+   struct patternMatch *keptMatches = NULL, *changedMatches = NULL;
+
+   for (theMatch = (struct patternMatch *) theFact->list;
+        theMatch != NULL;
+        theMatch = nextMatch)
+     {
+      nextMatch = theMatch->next;
+
+      if (FactPatternSlotsChanged(((struct factPatternNode *) theMatch->matchingPattern)->stopSlots,changeMap))
+        {
+         theMatch->next = changedMatches;
+         changedMatches = theMatch;
+        }
+      else
+        {
+         theMatch->next = keptMatches;
+         keptMatches = theMatch;
+        }
+     }
+
+   NetworkRetract(theEnv,changedMatches);
+
+   return keptMatches;
+  }
+
+/*****************************************************************/
+/* RetractKeptMatches: Retracts the pattern matches kept by the  */
+/*   retraction of a modified fact when the fact is not asserted */
+/*   again (because it's a duplicate or its logical support was  */
+/*   removed).                                                   */
+/*****************************************************************/
+static void RetractKeptMatches(
+  Environment *theEnv,
+  Fact *theFact)
+  {
+   if (theFact->list == NULL) return;
+
+   EngineData(theEnv)->JoinOperationInProgress = true;
+   NetworkRetract(theEnv,(struct patternMatch *) theFact->list);
+   theFact->list = NULL;
+   EngineData(theEnv)->JoinOperationInProgress = false;
+
+   if (EngineData(theEnv)->ExecutingRule == NULL)
+     { FlushGarbagePartialMatches(theEnv); }
+
+   ForceLogicalRetractions(theEnv);
+  }
+
 /*******************************************************************/
 /* RemoveGarbageFacts: Returns facts that have been retracted to   */
 /*   the pool of available memory. It is necessary to postpone     */
@@ -778,7 +951,12 @@ Fact *AssertDriver(
    /*========================================================*/
 
    hashValue = HandleFactDuplication(theEnv,theFact,&duplicate,reuseIndex);
-   if (duplicate) return NULL;
+   if (duplicate)
+     {
+      if (reuseIndex > 0)
+        { RetractKeptMatches(theEnv,theFact); }
+      return NULL;
+     }
 
    /*==========================================================*/
    /* If necessary, add logical dependency links between the   */
@@ -795,6 +973,7 @@ Fact *AssertDriver(
          FactData(theEnv)->GarbageFacts = theFact;
          UtilityData(theEnv)->CurrentGarbageFrame->dirty = true;
          theFact->garbage = true;
+         RetractKeptMatches(theEnv,theFact);
         }
       return NULL;
      }
@@ -870,6 +1049,18 @@ Fact *AssertDriver(
      
    theFact->factHeader.timeTag = DefruleData(theEnv)->CurrentEntityTimeTag++;
 
+   /*=======================================*/
+   /* Add the fact to the fact index table. */
+   /*=======================================*/
+
+   AddIndexedFact(theEnv,theFact);
+
+   /*======================================================*/
+   /* Add the fact to the slot indexes of its deftemplate. */
+   /*======================================================*/
+
+   AddSlotIndexEntries(theEnv,theFact);
+
    /*=====================*/
    /* Update busy counts. */
    /*=====================*/
@@ -909,6 +1100,7 @@ Fact *AssertDriver(
    /*==================================*/
 
    FactData(theEnv)->ChangeToFactList = true;
+   FactData(theEnv)->FactListChanges++;
 
    /*==========================================*/
    /* Check for constraint errors in the fact. */
@@ -923,13 +1115,39 @@ Fact *AssertDriver(
 
    EnvSetEvaluationError(theEnv,false);
 
+   /*=================================================*/
+   /* If a fact batch is open, pattern matching is    */
+   /* deferred until the batch is committed. The fact */
+   /* is kept busy so that it isn't released if it's  */
+   /* retracted before then. A modified fact which    */
+   /* kept some of its matches is matched now.        */
+   /*=================================================*/
+
+   if ((FactData(theEnv)->FactBatchDepth > 0) && (theFact->list == NULL))
+     {
+      if (! theFact->batchAssert)
+        {
+         theFact->batchAssert = true;
+         EnvIncrementFactCount(theEnv,theFact);
+         AddToFactBatch(theEnv,&FactData(theEnv)->BatchAsserts,theFact);
+        }
+
+      return theFact;
+     }
+
    /*=============================================*/
    /* Pattern match the fact using the associated */
-   /* deftemplate's pattern network.              */
+   /* deftemplate's pattern network. For a modify */
+   /* only the patterns referencing the changed   */
+   /* slots are matched since the matches for the */
+   /* other patterns were kept by the retraction. */
    /*=============================================*/
 
    EngineData(theEnv)->JoinOperationInProgress = true;
+   if (reuseIndex > 0)
+     { FactData(theEnv)->CurrentPatternChangeMap = changeMap; }
    FactPatternMatch(theEnv,theFact,theFact->whichDeftemplate->patternNetwork,0,NULL,NULL);
+   FactData(theEnv)->CurrentPatternChangeMap = NULL;
    EngineData(theEnv)->JoinOperationInProgress = false;
 
    /*===================================================*/
@@ -1382,6 +1600,7 @@ Fact *CreateFactBySize(
    theFact = get_var_struct(theEnv,fact,sizeof(struct field) * (newSize - 1));
 
    theFact->garbage = false;
+   theFact->batchAssert = false;
    theFact->factIndex = 0LL;
    theFact->factHeader.busyCount = 0;
    theFact->factHeader.theInfo = &FactData(theEnv)->FactInfo;
@@ -1393,6 +1612,7 @@ Fact *CreateFactBySize(
    theFact->nextTemplateFact = NULL;
    theFact->list = NULL;
    theFact->basisSlots = NULL;
+   theFact->slotIndexEntries = NULL;
 
    theFact->theProposition.multifieldLength = size;
    theFact->theProposition.busyCount = 0;
@@ -1687,6 +1907,14 @@ static void ResetFacts(
    /*======================================*/
 
    RemoveAllFacts(theEnv);
+   FlushFactBatch(theEnv);
+
+   /*======================================================*/
+   /* Each page of the fact index table was released as    */
+   /* its last fact was removed. The page directory is     */
+   /* kept for the facts asserted by the reset, which      */
+   /* reuse the indices from the start of the table.       */
+   /*======================================================*/
   }
 
 /************************************************************/
@@ -1715,6 +1943,7 @@ static bool ClearFactsReady(
    /*======================================*/
 
    RemoveAllFacts(theEnv);
+   FlushFactBatch(theEnv);
 
    /*==============================================*/
    /* If for some reason there are any facts still */
@@ -1723,6 +1952,8 @@ static bool ClearFactsReady(
 
    if (EnvGetNextFact(theEnv,NULL) != NULL) return false;
 
+   ReleaseFactIndexPages(theEnv);
+
    /*=============================*/
    /* Return true to indicate the */
    /* clear command can continue. */
@@ -1739,17 +1970,238 @@ Fact *FindIndexedFact(
   Environment *theEnv,
   long long factIndexSought)
   {
-   Fact *theFact;
+   unsigned long long page;
+   struct factIndexPage *thePage;
+
+   if (factIndexSought <= 0) return NULL;
+
+   page = (unsigned long long) factIndexSought / FACT_INDEX_PAGE_SIZE;
+
+   if ((page < FactData(theEnv)->FactIndexPageBase) ||
+       ((page - FactData(theEnv)->FactIndexPageBase) >= FactData(theEnv)->FactIndexPageCount))
+     { return NULL; }
+
+   thePage = FactData(theEnv)->FactIndexPages[page - FactData(theEnv)->FactIndexPageBase];
+   if (thePage == NULL)
+     { return NULL; }
+
+   return thePage->facts[factIndexSought % FACT_INDEX_PAGE_SIZE];
+  }
+
+/**************************************************************/
+/* AddIndexedFact: Stores a fact in the fact index table, a   */
+/*   paged array indexed by fact index. Since fact indices    */
+/*   are assigned sequentially, pages are densely populated.  */
+/*   The page directory covers the pages from the page base   */
+/*   onward. Pages and the directory are allocated on demand. */
+/**************************************************************/
+static void AddIndexedFact(
+  Environment *theEnv,
+  Fact *theFact)
+  {
+   unsigned long page, low, high, i;
+   struct factIndexPage *thePage;
+   Fact **theSlot;
+
+   page = (unsigned long) (theFact->factIndex / FACT_INDEX_PAGE_SIZE);
+
+   /*=================================================*/
+   /* Resize the page directory if it doesn't yet     */
+   /* cover the page in which the fact index is       */
+   /* stored. If the directory holds no pages, it can */
+   /* simply be moved to start at the page.           */
+   /*=================================================*/
+
+   if ((page < FactData(theEnv)->FactIndexPageBase) ||
+       ((page - FactData(theEnv)->FactIndexPageBase) >= FactData(theEnv)->FactIndexPageCount))
+     {
+      if (FactData(theEnv)->LiveFactIndexPages == 0)
+        {
+         if (FactData(theEnv)->FactIndexPageCount == 0)
+           { ResizeFactIndexPages(theEnv,page,1); }
+         else
+           { FactData(theEnv)->FactIndexPageBase = page; }
+        }
+      else
+        {
+         low = FactData(theEnv)->FactIndexPageBase;
+         high = low + FactData(theEnv)->FactIndexPageCount - 1;
+         if (page < low) low = page;
+         if (page > high) high = page;
+
+         if ((high - low + 1) < (FactData(theEnv)->FactIndexPageCount * 2))
+           { ResizeFactIndexPages(theEnv,low,FactData(theEnv)->FactIndexPageCount * 2); }
+         else
+           { ResizeFactIndexPages(theEnv,low,high - low + 1); }
+        }
+     }
 
-   for (theFact = EnvGetNextFact(theEnv,NULL);
-        theFact != NULL;
-        theFact = EnvGetNextFact(theEnv,theFact))
+   /*=================================*/
+   /* Allocate the page if necessary. */
+   /*=================================*/
+
+   thePage = FactData(theEnv)->FactIndexPages[page - FactData(theEnv)->FactIndexPageBase];
+   if (thePage == NULL)
      {
-      if (theFact->factIndex == factIndexSought)
-        { return(theFact); }
+      if (FactData(theEnv)->SpareFactIndexPage != NULL)
+        {
+         thePage = FactData(theEnv)->SpareFactIndexPage;
+         FactData(theEnv)->SpareFactIndexPage = NULL;
+        }
+      else
+        {
+         thePage = (struct factIndexPage *) gm3(theEnv,sizeof(struct factIndexPage));
+         thePage->count = 0;
+         for (i = 0; i < FACT_INDEX_PAGE_SIZE; i++)
+           { thePage->facts[i] = NULL; }
+        }
+
+      FactData(theEnv)->FactIndexPages[page - FactData(theEnv)->FactIndexPageBase] = thePage;
+      FactData(theEnv)->LiveFactIndexPages++;
      }
 
-   return NULL;
+   theSlot = &thePage->facts[theFact->factIndex % FACT_INDEX_PAGE_SIZE];
+   if (*theSlot == NULL)
+     { thePage->count++; }
+   *theSlot = theFact;
+  }
+
+/******************************************************/
+/* RemoveIndexedFact: Removes a fact from the fact    */
+/*   index table. The entry is only cleared if it     */
+/*   still refers to the fact being removed. A page   */
+/*   is released once it no longer holds any facts,   */
+/*   and the page directory is compacted once most of */
+/*   its pages have been released.                    */
+/******************************************************/
+static void RemoveIndexedFact(
+  Environment *theEnv,
+  Fact *theFact)
+  {
+   unsigned long page, first, last;
+   struct factIndexPage *thePage;
+   Fact **theSlot;
+
+   if (theFact->factIndex <= 0) return;
+
+   page = (unsigned long) (theFact->factIndex / FACT_INDEX_PAGE_SIZE);
+
+   if ((page < FactData(theEnv)->FactIndexPageBase) ||
+       ((page - FactData(theEnv)->FactIndexPageBase) >= FactData(theEnv)->FactIndexPageCount))
+     { return; }
+
+   thePage = FactData(theEnv)->FactIndexPages[page - FactData(theEnv)->FactIndexPageBase];
+   if (thePage == NULL)
+     { return; }
+
+   theSlot = &thePage->facts[theFact->factIndex % FACT_INDEX_PAGE_SIZE];
+   if (*theSlot != theFact)
+     { return; }
+
+   *theSlot = NULL;
+   thePage->count--;
+   if (thePage->count != 0)
+     { return; }
+
+   /*=================================================*/
+   /* Release the empty page. One empty page is kept  */
+   /* as a spare so that a modify of the only fact on */
+   /* a page doesn't release and reallocate the page. */
+   /*=================================================*/
+
+   FactData(theEnv)->FactIndexPages[page - FactData(theEnv)->FactIndexPageBase] = NULL;
+   FactData(theEnv)->LiveFactIndexPages--;
+
+   if (FactData(theEnv)->SpareFactIndexPage == NULL)
+     { FactData(theEnv)->SpareFactIndexPage = thePage; }
+   else
+     { rm3(theEnv,thePage,sizeof(struct factIndexPage)); }
+
+   /*==================================================*/
+   /* Compact the page directory to the range of pages */
+   /* still in use once it is no more than a quarter   */
+   /* full. An empty directory is kept for reuse.      */
+   /*==================================================*/
+
+   if ((FactData(theEnv)->LiveFactIndexPages == 0) ||
+       ((FactData(theEnv)->LiveFactIndexPages * 4) > FactData(theEnv)->FactIndexPageCount))
+     { return; }
+
+   for (first = 0; FactData(theEnv)->FactIndexPages[first] == NULL; first++)
+     { /* Do Nothing */ }
+   for (last = FactData(theEnv)->FactIndexPageCount - 1; FactData(theEnv)->FactIndexPages[last] == NULL; last--)
+     { /* Do Nothing */ }
+
+   ResizeFactIndexPages(theEnv,FactData(theEnv)->FactIndexPageBase + first,(last - first + 1) * 2);
+  }
+
+/*****************************************************/
+/* ResizeFactIndexPages: Replaces the page directory */
+/*   of the fact index table with one of the given   */
+/*   size starting at the given page. Every page in  */
+/*   use must be covered by the new directory.       */
+/*****************************************************/
+static void ResizeFactIndexPages(
+  Environment *theEnv,
+  unsigned long newBase,
+  unsigned long newCount)
+  {
+   struct factIndexPage **newPages;
+   unsigned long i;
+
+   newPages = (struct factIndexPage **) gm3(theEnv,sizeof(struct factIndexPage *) * newCount);
+
+   for (i = 0; i < newCount; i++)
+     { newPages[i] = NULL; }
+
+   for (i = 0; i < FactData(theEnv)->FactIndexPageCount; i++)
+     {
+      if (FactData(theEnv)->FactIndexPages[i] != NULL)
+        { newPages[FactData(theEnv)->FactIndexPageBase + i - newBase] = FactData(theEnv)->FactIndexPages[i]; }
+     }
+
+   if (FactData(theEnv)->FactIndexPages != NULL)
+     {
+      rm3(theEnv,FactData(theEnv)->FactIndexPages,
+          sizeof(struct factIndexPage *) * FactData(theEnv)->FactIndexPageCount);
+     }
+
+   FactData(theEnv)->FactIndexPages = newPages;
+   FactData(theEnv)->FactIndexPageBase = newBase;
+   FactData(theEnv)->FactIndexPageCount = newCount;
+  }
+
+/****************************************************/
+/* ReleaseFactIndexPages: Returns the memory used   */
+/*   by the fact index table. Called when there are */
+/*   no longer any facts in the fact list.          */
+/****************************************************/
+static void ReleaseFactIndexPages(
+  Environment *theEnv)
+  {
+   unsigned long i;
+
+   if (FactData(theEnv)->SpareFactIndexPage != NULL)
+     {
+      rm3(theEnv,FactData(theEnv)->SpareFactIndexPage,sizeof(struct factIndexPage));
+      FactData(theEnv)->SpareFactIndexPage = NULL;
+     }
+
+   if (FactData(theEnv)->FactIndexPages == NULL) return;
+
+   for (i = 0; i < FactData(theEnv)->FactIndexPageCount; i++)
+     {
+      if (FactData(theEnv)->FactIndexPages[i] != NULL)
+        { rm3(theEnv,FactData(theEnv)->FactIndexPages[i],sizeof(struct factIndexPage)); }
+     }
+
+   rm3(theEnv,FactData(theEnv)->FactIndexPages,
+       sizeof(struct factIndexPage *) * FactData(theEnv)->FactIndexPageCount);
+
+   FactData(theEnv)->FactIndexPages = NULL;
+   FactData(theEnv)->FactIndexPageBase = 0;
+   FactData(theEnv)->FactIndexPageCount = 0;
+   FactData(theEnv)->LiveFactIndexPages = 0;
   }
 
 /*****************************************/
@@ -1858,14 +2310,16 @@ bool EnvRemoveRetractFunction(
    return false;
   }
 
-/*****************************************/
-/* EnvAddModifyFunction: Adds a function */
-/*   to the ListOfModifyFunctions.       */
-/*****************************************/
+/*****************************************************/
+/* EnvAddModifyFunction: Adds a function to the      */
+/*   ListOfModifyFunctions. The function is called   */
+/*   with the fact before and after it's modified    */
+/*   along with a bitmap of the slots that changed.  */
+/*****************************************************/
 bool EnvAddModifyFunction(
   Environment *theEnv,
   const char *name,
-  void (*functionPtr)(Environment *, void *, void *),
+  void (*functionPtr)(Environment *, void *, void *, const char *),
   int priority)
   {
    FactData(theEnv)->ListOfModifyFunctions =
@@ -1882,7 +2336,7 @@ bool EnvAddModifyFunction(
 bool EnvAddModifyFunctionWithContext(
   Environment *theEnv,
   const char *name,
-  void (*functionPtr)(Environment *, void *, void *),
+  void (*functionPtr)(Environment *, void *, void *, const char *),
   int priority,
   void *context)
   {
@@ -1912,5 +2366,247 @@ bool EnvRemoveModifyFunction(
    return false;
   }
 
+/*******************************************************/
+/* EnvBeginFactBatch: Opens a fact batch. Until the    */
+/*   batch is committed, the pattern matching of facts */
+/*   asserted and retracted is deferred. Batches nest, */
+/*   only committing the outermost batch propagates    */
+/*   the changes to the join network.                  */
+/*******************************************************/
+void EnvBeginFactBatch(
+  Environment *theEnv)
+  {
+   FactData(theEnv)->FactBatchDepth++;
+  }
+
+/********************************************************/
+/* EnvCommitFactBatch: Closes a fact batch. Returns     */
+/*   false if no batch is open, otherwise true. When    */
+/*   the outermost batch is closed, the net changes     */
+/*   made within it are propagated to the join network. */
+/********************************************************/
+bool EnvCommitFactBatch(
+  Environment *theEnv)
+  {
+   if (FactData(theEnv)->FactBatchDepth == 0)
+     { return false; }
+
+   FactData(theEnv)->FactBatchDepth--;
+
+   if (FactData(theEnv)->FactBatchDepth == 0)
+     { FlushFactBatch(theEnv); }
+
+   /*==========================================*/
+   /* Force periodic cleanup if the commit was */
+   /* executed from an embedded application.   */
+   /*==========================================*/
+
+   if ((UtilityData(theEnv)->CurrentGarbageFrame->topLevel) && (! CommandLineData(theEnv)->EvaluatingTopLevelCommand) &&
+       (EvaluationData(theEnv)->CurrentExpression == NULL) && (UtilityData(theEnv)->GarbageCollectionLocks == 0))
+     {
+      CleanCurrentGarbageFrame(theEnv,NULL);
+      CallPeriodicTasks(theEnv);
+     }
+
+   return true;
+  }
+
+/***************************************************************/
+/* FlushFactBatch: Propagates the pending changes of the fact  */
+/*   batch to the join network. The retractions are processed  */
+/*   first, followed by the assertions, and each is grouped by */
+/*   deftemplate. A fact asserted and then retracted within    */
+/*   the batch is skipped. The batch remains open, so this is  */
+/*   also used to bring the network up to date before rules    */
+/*   are run or the fact-list is cleared.                      */
+/***************************************************************/
+void FlushFactBatch(
+  Environment *theEnv)
+  {
+   struct factBatch *theRetracts = &FactData(theEnv)->BatchRetracts;
+   struct factBatch *theAsserts = &FactData(theEnv)->BatchAsserts;
+   Fact *theFact;
+   unsigned long i;
+
+   if (EngineData(theEnv)->JoinOperationInProgress) return;
+
+   /*==================================================*/
+   /* Retracting the logical dependents of the changes */
+   /* may add new retractions while a batch is open.   */
+   /*==================================================*/
+
+   while ((theRetracts->count > 0) || (theAsserts->count > 0))
+     {
+      EnvSetEvaluationError(theEnv,false);
+
+      /*============================================*/
+      /* Retract the pattern matches of the facts   */
+      /* retracted within the batch and then update */
+      /* their busy counts.                         */
+      /*============================================*/
+
+      SortFactBatch(theEnv,theRetracts);
+
+      EngineData(theEnv)->JoinOperationInProgress = true;
+      for (i = 0; i < theRetracts->count; i++)
+        {
+         theFact = theRetracts->facts[i];
+         NetworkRetract(theEnv,(struct patternMatch *) theFact->list);
+         theFact->list = NULL;
+        }
+      EngineData(theEnv)->JoinOperationInProgress = false;
+
+      for (i = 0; i < theRetracts->count; i++)
+        { FactDeinstall(theEnv,theRetracts->facts[i]); }
+      theRetracts->count = 0;
+
+      /*=============================================*/
+      /* Pattern match the facts asserted within the */
+      /* batch which haven't since been retracted.   */
+      /*=============================================*/
+
+      SortFactBatch(theEnv,theAsserts);
+
+      EngineData(theEnv)->JoinOperationInProgress = true;
+      for (i = 0; i < theAsserts->count; i++)
+        {
+         theFact = theAsserts->facts[i];
+         theFact->batchAssert = false;
+         if (! theFact->garbage)
+           { FactPatternMatch(theEnv,theFact,theFact->whichDeftemplate->patternNetwork,0,NULL,NULL); }
+        }
+      EngineData(theEnv)->JoinOperationInProgress = false;
+
+      for (i = 0; i < theAsserts->count; i++)
+        { EnvDecrementFactCount(theEnv,theAsserts->facts[i]); }
+      theAsserts->count = 0;
+
+      /*=========================================*/
+      /* Retract the facts whose logical support */
+      /* was removed by the changes.             */
+      /*=========================================*/
+
+      ForceLogicalRetractions(theEnv);
+
+      if (EngineData(theEnv)->ExecutingRule == NULL)
+        { FlushGarbagePartialMatches(theEnv); }
+     }
+  }
+
+/*****************************************************/
+/* AddToFactBatch: Adds a fact to a list of pending  */
+/*   fact batch changes, growing the list as needed. */
+/*****************************************************/
+static void AddToFactBatch(
+  Environment *theEnv,
+  struct factBatch *theBatch,
+  Fact *theFact)
+  {
+   Fact **newFacts;
+   unsigned long newMaximum;
+
+   if (theBatch->count == theBatch->maximum)
+     {
+      if (theBatch->maximum == 0)
+        { newMaximum = 16; }
+      else
+        { newMaximum = theBatch->maximum * 2; }
+
+      newFacts = (Fact **) gm3(theEnv,sizeof(Fact *) * newMaximum);
+
+      if (theBatch->count > 0)
+        { memcpy(newFacts,theBatch->facts,sizeof(Fact *) * theBatch->count); }
+
+      if (theBatch->maximum != 0)
+        { rm3(theEnv,theBatch->facts,sizeof(Fact *) * theBatch->maximum); }
+
+      theBatch->facts = newFacts;
+      theBatch->maximum = newMaximum;
+     }
+
+   theBatch->facts[theBatch->count++] = theFact;
+  }
+
+/***************************************************************/
+/* SortFactBatch: Groups the facts of a batch by deftemplate.  */
+/*   The groups are ordered by the first appearance of their   */
+/*   deftemplate in the batch and the facts of a group keep    */
+/*   their original order, so the result doesn't depend on the */
+/*   addresses of the deftemplates.                            */
+/***************************************************************/
+static void SortFactBatch(
+  Environment *theEnv,
+  struct factBatch *theBatch)
+  {
+   struct factBatchEntry *theEntries;
+   unsigned long i, group = 0;
+
+   if (theBatch->count < 2) return;
+
+   theEntries = (struct factBatchEntry *)
+                gm3(theEnv,sizeof(struct factBatchEntry) * theBatch->count);
+
+   for (i = 0; i < theBatch->count; i++)
+     {
+      theEntries[i].theFact = theBatch->facts[i];
+      theEntries[i].order = i;
+     }
+
+   qsort(theEntries,theBatch->count,sizeof(struct factBatchEntry),CompareBatchTemplates);
+
+   for (i = 0; i < theBatch->count; i++)
+     {
+      if ((i == 0) ||
+          (theEntries[i].theFact->whichDeftemplate != theEntries[i-1].theFact->whichDeftemplate))
+        { group = theEntries[i].order; }
+      theEntries[i].group = group;
+     }
+
+   qsort(theEntries,theBatch->count,sizeof(struct factBatchEntry),CompareBatchGroups);
+
+   for (i = 0; i < theBatch->count; i++)
+     { theBatch->facts[i] = theEntries[i].theFact; }
+
+   rm3(theEnv,theEntries,sizeof(struct factBatchEntry) * theBatch->count);
+  }
+
+/****************************************************/
+/* CompareBatchTemplates: Orders fact batch entries */
+/*   by deftemplate and then by original order.     */
+/****************************************************/
+static int CompareBatchTemplates(
+  const void *e1,
+  const void *e2)
+  {
+   const struct factBatchEntry *theEntry1 = (const struct factBatchEntry *) e1;
+   const struct factBatchEntry *theEntry2 = (const struct factBatchEntry *) e2;
+   const char *t1 = (const char *) theEntry1->theFact->whichDeftemplate;
+   const char *t2 = (const char *) theEntry2->theFact->whichDeftemplate;
+
+   if (t1 < t2) return -1;
+   if (t1 > t2) return 1;
+   if (theEntry1->order < theEntry2->order) return -1;
+   if (theEntry1->order > theEntry2->order) return 1;
+   return 0;
+  }
+
+/*************************************************/
+/* CompareBatchGroups: Orders fact batch entries */
+/*   by group and then by original order.        */
+/*************************************************/
+static int CompareBatchGroups(
+  const void *e1,
+  const void *e2)
+  {
+   const struct factBatchEntry *theEntry1 = (const struct factBatchEntry *) e1;
+   const struct factBatchEntry *theEntry2 = (const struct factBatchEntry *) e2;
+
+   if (theEntry1->group < theEntry2->group) return -1;
+   if (theEntry1->group > theEntry2->group) return 1;
+   if (theEntry1->order < theEntry2->order) return -1;
+   if (theEntry1->order > theEntry2->order) return 1;
+   return 0;
+  }
+
 #endif /* DEFTEMPLATE_CONSTRUCT && DEFRULE_CONSTRUCT */
 
@@ -71,6 +71,22 @@
 /*            Watch facts for modify command only prints     */
 /*            changed slots.                                 */
 /*                                                           */
+/*            Added fact index table for constant time       */
+/*            lookup of facts by fact index.                 */
+/*                                                           */
+/*            Added slot indexes for looking up the facts of */
+/*            a deftemplate by the value of a slot.          */
+/*                                                           */
+/*            Modify only rematches the patterns which       */
+/*            reference the changed slots of the fact.       */
+/*                                                           */
+/*            Modify callback functions are passed the map   */
+/*            of the slots changed by the modify.            */
+/*                                                           */
+/*            Added fact batches which defer the pattern     */
+/*            matching of assertions and retractions until   */
+/*            the batch is committed.                        */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_factmngr
@@ -95,21 +111,48 @@ struct fact
    long long factIndex;
    unsigned long hashValue;
    unsigned int garbage : 1;
+   unsigned int batchAssert : 1;
    struct fact *previousFact;
    struct fact *nextFact;
    struct fact *previousTemplateFact;
    struct fact *nextTemplateFact;
    struct multifield *basisSlots;
+   struct factSlotIndexEntry *slotIndexEntries;
    struct multifield theProposition;
   };
 
 #include "facthsh.h"
 
+struct factBatch
+  {
+   Fact **facts;
+   unsigned long count;
+   unsigned long maximum;
+  };
+
+struct factBatchEntry
+  {
+   Fact *theFact;
+   unsigned long order;
+   unsigned long group;
+  };
+
+#ifndef FACT_INDEX_PAGE_SIZE
+#define FACT_INDEX_PAGE_SIZE 1024
+#endif
+
+struct factIndexPage
+  {
+   unsigned long count;
+   Fact *facts[FACT_INDEX_PAGE_SIZE];
+  };
+
 #define FACTS_DATA 3
 
 struct factsData
   {
    bool ChangeToFactList;
+   unsigned long FactListChanges;
 #if DEBUGGING_FUNCTIONS
    bool WatchFacts;
 #endif
@@ -131,11 +174,20 @@ struct factsData
 #endif
    struct factHashEntry **FactHashTable;
    unsigned long FactHashTableSize;
+   struct factIndexPage **FactIndexPages;
+   struct factIndexPage *SpareFactIndexPage;
+   unsigned long FactIndexPageBase;
+   unsigned long FactIndexPageCount;
+   unsigned long LiveFactIndexPages;
    bool FactDuplication;
 #if DEFRULE_CONSTRUCT
    struct fact             *CurrentPatternFact;
    struct multifieldMarker *CurrentPatternMarks;
+   const char              *CurrentPatternChangeMap;
 #endif
+   unsigned int FactBatchDepth;
+   struct factBatch BatchAsserts;
+   struct factBatch BatchRetracts;
    long LastModuleIndex;
   };
   
@@ -188,10 +240,13 @@ struct factsData
                                                                    void (*)(Environment *,void *),int,void *);
    bool                           EnvRemoveRetractFunction(Environment *,const char *);
    bool                           EnvAddModifyFunction(Environment *,const char *,
-                                                       void (*)(Environment *,void *,void *),int);
+                                                       void (*)(Environment *,void *,void *,const char *),int);
    bool                           EnvAddModifyFunctionWithContext(Environment *,const char *,
-                                                                  void (*)(Environment *,void *,void *),int,void *);
+                                                                  void (*)(Environment *,void *,void *,const char *),int,void *);
    bool                           EnvRemoveModifyFunction(Environment *,const char *);
+   void                           EnvBeginFactBatch(Environment *);
+   bool                           EnvCommitFactBatch(Environment *);
+   void                           FlushFactBatch(Environment *);
 
 #endif /* _H_factmngr */
 
@@ -42,6 +42,14 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Equality and range tests on slots in the query */
+/*            are used to look up the facts of each fact     */
+/*            variable through a hash or sorted index built  */
+/*            for the query.                                 */
+/*                                                           */
+/*            Eq tests on a slot indexed with create-index   */
+/*            use the slot index instead.                    */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -49,6 +57,8 @@
                EXTERNAL DEFINITIONS
    =========================================
    ***************************************** */
+#include <stdlib.h>
+
 #include "setup.h"
 
 #if FACT_SET_QUERIES
@@ -62,6 +72,8 @@
 #include "insfun.h"
 #include "factqpsr.h"
 #include "prcdrfun.h"
+#include "prdctfun.h"
+#include "reteutil.h"
 #include "router.h"
 #include "utility.h"
 
@@ -78,11 +90,29 @@
    static QUERY_TEMPLATE         *FormChain(Environment *,const char *,CLIPSValue *);
    static void                    DeleteQueryTemplates(Environment *,QUERY_TEMPLATE *);
    static bool                    TestForFirstInChain(Environment *,QUERY_TEMPLATE *,int);
-   static bool                    TestForFirstFactInTemplate(Environment *,Deftemplate *,QUERY_TEMPLATE *,int);
+   static bool                    TestForFirstFactInTemplate(Environment *,QUERY_TEMPLATE *,QUERY_TEMPLATE *,int);
    static void                    TestEntireChain(Environment *,QUERY_TEMPLATE *,int);
-   static void                    TestEntireTemplate(Environment *,Deftemplate *,QUERY_TEMPLATE *,int);
+   static void                    TestEntireTemplate(Environment *,QUERY_TEMPLATE *,QUERY_TEMPLATE *,int);
    static void                    AddSolution(Environment *);
    static void                    PopQuerySoln(Environment *);
+   static QUERY_KEY              *DetermineQueryKeys(Environment *,EXPRESSION *,unsigned);
+   static void                    ExtractQueryKeys(QUERY_KEY *,EXPRESSION *);
+   static SYMBOL_HN              *QuerySlotReference(EXPRESSION *,int *);
+   static bool                    IsQueryKeyExpression(EXPRESSION *,int);
+   static void                    ReturnQueryKeys(Environment *,QUERY_KEY *,unsigned);
+   static bool                    EvaluateQueryKey(Environment *,EXPRESSION *,CLIPSValue *);
+   static bool                    QueryKeyNumber(unsigned short,void *,double *);
+   static unsigned long           QueryKeyBucket(unsigned short,void *,unsigned long);
+   static QUERY_INDEX            *BuildQueryIndex(Environment *,QUERY_TEMPLATE *,QUERY_KEY *);
+   static void                    BuildQueryHashIndex(Environment *,QUERY_INDEX *,Deftemplate *,unsigned long);
+   static void                    BuildQueryRangeIndex(Environment *,QUERY_INDEX *,Deftemplate *,unsigned long);
+   static void                    ClearQueryIndex(Environment *,QUERY_INDEX *);
+   static int                     CompareRangeEntries(const void *,const void *);
+   static int                     CompareFactIndexes(const void *,const void *);
+   static struct fact            *FirstQueryFact(Environment *,QUERY_TEMPLATE *,int,QUERY_CURSOR *);
+   static struct fact            *NextQueryFact(Environment *,QUERY_CURSOR *);
+   static struct fact            *NextQueryCandidate(QUERY_CURSOR *);
+   static void                    ReleaseQueryCursor(Environment *,QUERY_CURSOR *);
 
 /****************************************************
   NAME         : SetupFactQuery
@@ -257,6 +287,28 @@ void GetQueryFactSlot(
      (a1 c1),(a1 c2),(a2 c1),(a2 c2),
      (b1 c1),(b1 c2),(b2 c1),(b2 c2)
 
+     Fact candidate lookup :
+
+     When the query is a conjunction (or a single test) of eq, =, <, <=,
+       > or >= tests comparing a slot of a fact variable with a constant
+       or with a slot of a fact variable to its left, the facts examined
+       for that variable are looked up in an index built for the query
+       instead of being visited one by one. eq tests use a hash index and
+       the numeric tests use an index sorted by slot value. The candidates
+       are still visited in the order given above and the whole query is
+       still evaluated for each fact set, so the indexes only change which
+       fact sets the query is evaluated for, not the result.
+
+     An index is built the first time the facts of a template are needed
+       for a variable and is rebuilt when the fact-list has changed since.
+       If the fact-list changes while a variable's candidates are being
+       visited (from a query action, for example), the remaining facts of
+       the template are visited in order as if no index had been used.
+
+     An eq test on a slot indexed with create-index uses that index
+       rather than one built for the query. It is kept up to date as
+       facts are asserted, retracted and modified, so nothing is built.
+
    =============================================================================
    ============================================================================= */
 
@@ -293,8 +345,10 @@ void AnyFacts(
    FactQueryData(theEnv)->QueryCore = get_struct(theEnv,query_core);
    FactQueryData(theEnv)->QueryCore->solns = (struct fact **) gm2(theEnv,(sizeof(struct fact *) * rcnt));
    FactQueryData(theEnv)->QueryCore->query = GetFirstArgument();
+   FactQueryData(theEnv)->QueryCore->keys = DetermineQueryKeys(theEnv,GetFirstArgument(),rcnt);
    testResult = TestForFirstInChain(theEnv,qtemplates,0);
    FactQueryData(theEnv)->AbortQuery = false;
+   ReturnQueryKeys(theEnv,FactQueryData(theEnv)->QueryCore->keys,rcnt);
    rm(theEnv,FactQueryData(theEnv)->QueryCore->solns,(sizeof(struct fact *) * rcnt));
    rtn_struct(theEnv,query_core,FactQueryData(theEnv)->QueryCore);
    PopQueryCore(theEnv);
@@ -337,6 +391,7 @@ void QueryFindFact(
    FactQueryData(theEnv)->QueryCore->solns = (struct fact **)
                       gm2(theEnv,(sizeof(struct fact *) * rcnt));
    FactQueryData(theEnv)->QueryCore->query = GetFirstArgument();
+   FactQueryData(theEnv)->QueryCore->keys = DetermineQueryKeys(theEnv,GetFirstArgument(),rcnt);
    if (TestForFirstInChain(theEnv,qtemplates,0) == true)
      {
       returnValue->value = EnvCreateMultifield(theEnv,rcnt);
@@ -350,6 +405,7 @@ void QueryFindFact(
    else
       returnValue->value = EnvCreateMultifield(theEnv,0L);
    FactQueryData(theEnv)->AbortQuery = false;
+   ReturnQueryKeys(theEnv,FactQueryData(theEnv)->QueryCore->keys,rcnt);
    rm(theEnv,FactQueryData(theEnv)->QueryCore->solns,(sizeof(struct fact *) * rcnt));
    rtn_struct(theEnv,query_core,FactQueryData(theEnv)->QueryCore);
    PopQueryCore(theEnv);
@@ -397,6 +453,7 @@ void QueryFindAllFacts(
    FactQueryData(theEnv)->QueryCore = get_struct(theEnv,query_core);
    FactQueryData(theEnv)->QueryCore->solns = (struct fact **) gm2(theEnv,(sizeof(struct fact *) * rcnt));
    FactQueryData(theEnv)->QueryCore->query = GetFirstArgument();
+   FactQueryData(theEnv)->QueryCore->keys = DetermineQueryKeys(theEnv,GetFirstArgument(),rcnt);
    FactQueryData(theEnv)->QueryCore->action = NULL;
    FactQueryData(theEnv)->QueryCore->soln_set = NULL;
    FactQueryData(theEnv)->QueryCore->soln_size = rcnt;
@@ -414,6 +471,7 @@ void QueryFindAllFacts(
       returnValue->end = (long) j-2;
       PopQuerySoln(theEnv);
      }
+   ReturnQueryKeys(theEnv,FactQueryData(theEnv)->QueryCore->keys,rcnt);
    rm(theEnv,FactQueryData(theEnv)->QueryCore->solns,(sizeof(struct fact *) * rcnt));
    rtn_struct(theEnv,query_core,FactQueryData(theEnv)->QueryCore);
    PopQueryCore(theEnv);
@@ -452,11 +510,13 @@ void QueryDoForFact(
    FactQueryData(theEnv)->QueryCore = get_struct(theEnv,query_core);
    FactQueryData(theEnv)->QueryCore->solns = (struct fact **) gm2(theEnv,(sizeof(struct fact *) * rcnt));
    FactQueryData(theEnv)->QueryCore->query = GetFirstArgument();
+   FactQueryData(theEnv)->QueryCore->keys = DetermineQueryKeys(theEnv,GetFirstArgument(),rcnt);
    FactQueryData(theEnv)->QueryCore->action = GetFirstArgument()->nextArg;
    if (TestForFirstInChain(theEnv,qtemplates,0) == true)
      EvaluateExpression(theEnv,FactQueryData(theEnv)->QueryCore->action,returnValue);
    FactQueryData(theEnv)->AbortQuery = false;
    ProcedureFunctionData(theEnv)->BreakFlag = false;
+   ReturnQueryKeys(theEnv,FactQueryData(theEnv)->QueryCore->keys,rcnt);
    rm(theEnv,FactQueryData(theEnv)->QueryCore->solns,(sizeof(struct fact *) * rcnt));
    rtn_struct(theEnv,query_core,FactQueryData(theEnv)->QueryCore);
    PopQueryCore(theEnv);
@@ -495,6 +555,7 @@ void QueryDoForAllFacts(
    FactQueryData(theEnv)->QueryCore = get_struct(theEnv,query_core);
    FactQueryData(theEnv)->QueryCore->solns = (struct fact **) gm2(theEnv,(sizeof(struct fact *) * rcnt));
    FactQueryData(theEnv)->QueryCore->query = GetFirstArgument();
+   FactQueryData(theEnv)->QueryCore->keys = DetermineQueryKeys(theEnv,GetFirstArgument(),rcnt);
    FactQueryData(theEnv)->QueryCore->action = GetFirstArgument()->nextArg;
    FactQueryData(theEnv)->QueryCore->result = returnValue;
    ValueInstall(theEnv,FactQueryData(theEnv)->QueryCore->result);
@@ -503,6 +564,7 @@ void QueryDoForAllFacts(
 
    FactQueryData(theEnv)->AbortQuery = false;
    ProcedureFunctionData(theEnv)->BreakFlag = false;
+   ReturnQueryKeys(theEnv,FactQueryData(theEnv)->QueryCore->keys,rcnt);
    rm(theEnv,FactQueryData(theEnv)->QueryCore->solns,(sizeof(struct fact *) * rcnt));
    rtn_struct(theEnv,query_core,FactQueryData(theEnv)->QueryCore);
    PopQueryCore(theEnv);
@@ -547,6 +609,7 @@ void DelayedQueryDoForAllFacts(
    FactQueryData(theEnv)->QueryCore = get_struct(theEnv,query_core);
    FactQueryData(theEnv)->QueryCore->solns = (struct fact **) gm2(theEnv,(sizeof(struct fact *) * rcnt));
    FactQueryData(theEnv)->QueryCore->query = GetFirstArgument();
+   FactQueryData(theEnv)->QueryCore->keys = DetermineQueryKeys(theEnv,GetFirstArgument(),rcnt);
    FactQueryData(theEnv)->QueryCore->action = NULL;
    FactQueryData(theEnv)->QueryCore->soln_set = NULL;
    FactQueryData(theEnv)->QueryCore->soln_size = rcnt;
@@ -580,6 +643,7 @@ void DelayedQueryDoForAllFacts(
    CallPeriodicTasks(theEnv);
 
    ProcedureFunctionData(theEnv)->BreakFlag = false;
+   ReturnQueryKeys(theEnv,FactQueryData(theEnv)->QueryCore->keys,rcnt);
    rm(theEnv,FactQueryData(theEnv)->QueryCore->solns,(sizeof(struct fact *) * rcnt));
    rtn_struct(theEnv,query_core,FactQueryData(theEnv)->QueryCore);
    PopQueryCore(theEnv);
@@ -762,6 +826,7 @@ static QUERY_TEMPLATE *FormChain(
 
       head->chain = NULL;
       head->nxt = NULL;
+      head->index = NULL;
       return(head);
      }
    if (val->type == SYMBOL)
@@ -787,6 +852,7 @@ static QUERY_TEMPLATE *FormChain(
 
       head->chain = NULL;
       head->nxt = NULL;
+      head->index = NULL;
       return(head);
      }
    if (val->type == MULTIFIELD)
@@ -821,6 +887,7 @@ static QUERY_TEMPLATE *FormChain(
 
          tmp->chain = NULL;
          tmp->nxt = NULL;
+         tmp->index = NULL;
          if (head == NULL)
            head = tmp;
          else
@@ -837,7 +904,7 @@ static QUERY_TEMPLATE *FormChain(
   DESCRIPTION  : Deletes a query class-list
   INPUTS       : The query list address
   RETURNS      : Nothing useful
-  SIDE EFFECTS : Nodes deallocated
+  SIDE EFFECTS : Nodes and their fact indexes deallocated
                  Busy count decremented for all templates
   NOTES        : None
  ******************************************************/
@@ -854,11 +921,21 @@ static void DeleteQueryTemplates(
          tmp = qlist->chain;
          qlist->chain = qlist->chain->chain;
          DecrementDeftemplateBusyCount(theEnv,tmp->templatePtr);
+         if (tmp->index != NULL)
+           {
+            ClearQueryIndex(theEnv,tmp->index);
+            rtn_struct(theEnv,query_index,tmp->index);
+           }
          rtn_struct(theEnv,query_template,tmp);
         }
       tmp = qlist;
       qlist = qlist->nxt;
       DecrementDeftemplateBusyCount(theEnv,tmp->templatePtr);
+      if (tmp->index != NULL)
+        {
+         ClearQueryIndex(theEnv,tmp->index);
+         rtn_struct(theEnv,query_index,tmp->index);
+        }
       rtn_struct(theEnv,query_template,tmp);
      }
   }
@@ -887,7 +964,7 @@ static bool TestForFirstInChain(
      {
       FactQueryData(theEnv)->AbortQuery = false;
 
-      if (TestForFirstFactInTemplate(theEnv,qptr->templatePtr,qchain,indx))
+      if (TestForFirstFactInTemplate(theEnv,qptr,qchain,indx))
         { return true; }
         
       if ((EvaluationData(theEnv)->HaltExecution == true) || (FactQueryData(theEnv)->AbortQuery == true))
@@ -899,27 +976,27 @@ static bool TestForFirstInChain(
 /*****************************************************************
   NAME         : TestForFirstFactInTemplate
   DESCRIPTION  : Processes all facts in a template
-  INPUTS       : 1) Visitation traversal id
-                 2) The template
-                 3) The current template restriction chain
-                 4) The index of the current restriction
+  INPUTS       : 1) The template restriction
+                 2) The current template restriction chain
+                 3) The index of the current restriction
   RETURNS      : True if query succeeds, false otherwise
   SIDE EFFECTS : Fact variable values set
   NOTES        : None
  *****************************************************************/
 static bool TestForFirstFactInTemplate(
   Environment *theEnv,
-  Deftemplate *templatePtr,
+  QUERY_TEMPLATE *qtemplate,
   QUERY_TEMPLATE *qchain,
   int indx)
   {
    struct fact *theFact;
    CLIPSValue temp;
    struct CLIPSBlock gcBlock;
+   QUERY_CURSOR cursor;
    
    CLIPSBlockStart(theEnv,&gcBlock);
 
-   theFact = templatePtr->factList;
+   theFact = FirstQueryFact(theEnv,qtemplate,indx,&cursor);
    while (theFact != NULL)
      {
       FactQueryData(theEnv)->QueryCore->solns[indx] = theFact;
@@ -950,11 +1027,10 @@ static bool TestForFirstFactInTemplate(
              (temp.value != EnvFalseSymbol(theEnv)))
            break;
         }
-      theFact = theFact->nextTemplateFact;
-      while ((theFact != NULL) ? (theFact->garbage == 1) : false)
-        theFact = theFact->nextTemplateFact;
+      theFact = NextQueryFact(theEnv,&cursor);
      }
      
+   ReleaseQueryCursor(theEnv,&cursor);
    CLIPSBlockEnd(theEnv,&gcBlock,NULL);
    CallPeriodicTasks(theEnv);
 
@@ -990,7 +1066,7 @@ static void TestEntireChain(
      {
       FactQueryData(theEnv)->AbortQuery = false;
 
-      TestEntireTemplate(theEnv,qptr->templatePtr,qchain,indx);
+      TestEntireTemplate(theEnv,qptr,qchain,indx);
 
       if ((EvaluationData(theEnv)->HaltExecution == true) || (FactQueryData(theEnv)->AbortQuery == true))
         return;
@@ -1000,11 +1076,9 @@ static void TestEntireChain(
 /*****************************************************************
   NAME         : TestEntireTemplate
   DESCRIPTION  : Processes all facts in a template
-  INPUTS       : 1) The module for which templates tested must be
-                    in scope
-                 3) The template
-                 4) The current template restriction chain
-                 5) The index of the current restriction
+  INPUTS       : 1) The template restriction
+                 2) The current template restriction chain
+                 3) The index of the current restriction
   RETURNS      : Nothing useful
   SIDE EFFECTS : Instance variable values set
                  Solution sets stored in global list
@@ -1012,17 +1086,18 @@ static void TestEntireChain(
  *****************************************************************/
 static void TestEntireTemplate(
   Environment *theEnv,
-  Deftemplate *templatePtr,
+  QUERY_TEMPLATE *qtemplate,
   QUERY_TEMPLATE *qchain,
   int indx)
   {
    struct fact *theFact;
    CLIPSValue temp;
    struct CLIPSBlock gcBlock;
+   QUERY_CURSOR cursor;
    
    CLIPSBlockStart(theEnv,&gcBlock);
    
-   theFact = templatePtr->factList;
+   theFact = FirstQueryFact(theEnv,qtemplate,indx,&cursor);
    while (theFact != NULL)
      {
       FactQueryData(theEnv)->QueryCore->solns[indx] = theFact;
@@ -1067,14 +1142,13 @@ static void TestEntireTemplate(
            }
         }
 
-      theFact = theFact->nextTemplateFact;
-      while ((theFact != NULL) ? (theFact->garbage == 1) : false)
-        theFact = theFact->nextTemplateFact;
+      theFact = NextQueryFact(theEnv,&cursor);
 
       CleanCurrentGarbageFrame(theEnv,NULL);
       CallPeriodicTasks(theEnv);
      }
      
+   ReleaseQueryCursor(theEnv,&cursor);
    CLIPSBlockEnd(theEnv,&gcBlock,NULL);
    CallPeriodicTasks(theEnv);
   }
@@ -1126,6 +1200,819 @@ static void PopQuerySoln(
       (sizeof(struct fact *) * FactQueryData(theEnv)->QueryCore->soln_size));
    rm(theEnv,FactQueryData(theEnv)->QueryCore->soln_bottom,sizeof(QUERY_SOLN));
   }
+
+/***************************************************************
+  NAME         : DetermineQueryKeys
+  DESCRIPTION  : Finds the tests in a query which can be used
+                   to look up the facts for each fact variable
+                   instead of visiting every fact of its
+                   templates
+  INPUTS       : 1) The query expression
+                 2) The number of fact variables
+  RETURNS      : An array with a key for each fact variable,
+                   or NULL if no test can be used
+  SIDE EFFECTS : Array allocated
+  NOTES        : Only tests which are the query or one of the
+                   conjuncts of a top level and are used. The
+                   tests are still evaluated with the rest of
+                   the query, so a key only has to select a
+                   superset of the facts which satisfy it.
+ ***************************************************************/
+static QUERY_KEY *DetermineQueryKeys(
+  Environment *theEnv,
+  EXPRESSION *query,
+  unsigned rcnt)
+  {
+   QUERY_KEY *keys;
+   unsigned i;
+
+   keys = (QUERY_KEY *) gm2(theEnv,(sizeof(QUERY_KEY) * rcnt));
+   for (i = 0 ; i < rcnt ; i++)
+     {
+      keys[i].kind = QUERY_NO_KEY;
+      keys[i].slotName = NULL;
+      keys[i].key = NULL;
+      keys[i].low = NULL;
+      keys[i].high = NULL;
+     }
+
+   ExtractQueryKeys(keys,query);
+
+   for (i = 0 ; i < rcnt ; i++)
+     {
+      if (keys[i].kind != QUERY_NO_KEY)
+        return(keys);
+     }
+
+   rm(theEnv,keys,(sizeof(QUERY_KEY) * rcnt));
+   return NULL;
+  }
+
+/***************************************************************
+  NAME         : ExtractQueryKeys
+  DESCRIPTION  : Records the slot tests of a query conjunct in
+                   the keys of the fact variables they constrain
+  INPUTS       : 1) The key array
+                 2) The conjunct
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Keys updated
+  NOTES        : A test is usable when it compares a slot of a
+                   fact variable with a constant, or with a slot
+                   of (or the fact bound to) a variable to its
+                   left. An eq test gives a hash key. The numeric
+                   tests give a range key, and only tests on the
+                   same slot are combined into one range. The
+                   first eq test found for a variable is used in
+                   preference to any range.
+ ***************************************************************/
+static void ExtractQueryKeys(
+  QUERY_KEY *keys,
+  EXPRESSION *theExp)
+  {
+   void (*fptr)(Environment *,UDFContext *,CLIPSValue *);
+   EXPRESSION *target,*other;
+   SYMBOL_HN *slotName;
+   QUERY_KEY *theKey;
+   bool reversed = false;
+   int posn;
+
+   if (theExp->type != FCALL)
+     return;
+   fptr = ExpressionFunctionPointer(theExp);
+
+   if (fptr == AndFunction)
+     {
+      for (theExp = theExp->argList ; theExp != NULL ; theExp = theExp->nextArg)
+        ExtractQueryKeys(keys,theExp);
+      return;
+     }
+
+   if ((fptr != EqFunction) &&
+       (fptr != NumericEqualFunction) &&
+       (fptr != LessThanFunction) &&
+       (fptr != LessThanOrEqualFunction) &&
+       (fptr != GreaterThanFunction) &&
+       (fptr != GreaterThanOrEqualFunction))
+     return;
+
+   if ((theExp->argList == NULL) || (theExp->argList->nextArg == NULL) ||
+       (theExp->argList->nextArg->nextArg != NULL))
+     return;
+
+   /*=============================================*/
+   /* The constrained slot is the one belonging   */
+   /* to the rightmost fact variable in the test. */
+   /*=============================================*/
+
+   target = theExp->argList;
+   other = target->nextArg;
+   slotName = QuerySlotReference(target,&posn);
+   if ((slotName == NULL) || (IsQueryKeyExpression(other,posn) == false))
+     {
+      target = other;
+      other = theExp->argList;
+      reversed = true;
+      slotName = QuerySlotReference(target,&posn);
+      if ((slotName == NULL) || (IsQueryKeyExpression(other,posn) == false))
+        return;
+     }
+
+   theKey = &keys[posn];
+
+   if (fptr == EqFunction)
+     {
+      if (theKey->kind != QUERY_HASH_KEY)
+        {
+         theKey->kind = QUERY_HASH_KEY;
+         theKey->slotName = slotName;
+         theKey->key = other;
+        }
+      return;
+     }
+
+   if ((theKey->kind == QUERY_HASH_KEY) ||
+       ((theKey->kind == QUERY_RANGE_KEY) && (theKey->slotName != slotName)))
+     return;
+
+   theKey->kind = QUERY_RANGE_KEY;
+   theKey->slotName = slotName;
+
+   if (fptr == NumericEqualFunction)
+     {
+      theKey->low = other;
+      theKey->high = other;
+     }
+   else if (((fptr == LessThanFunction) ||
+             (fptr == LessThanOrEqualFunction)) ? (! reversed) : reversed)
+     {
+      if (theKey->high == NULL)
+        theKey->high = other;
+     }
+   else
+     {
+      if (theKey->low == NULL)
+        theKey->low = other;
+     }
+  }
+
+/***************************************************************
+  NAME         : QuerySlotReference
+  DESCRIPTION  : Determines if an expression is a reference to
+                   a slot of one of the fact variables of the
+                   query being evaluated
+  INPUTS       : 1) The expression
+                 2) Caller's buffer for the variable position
+  RETURNS      : The slot name, or NULL if the expression is
+                   not such a reference
+  SIDE EFFECTS : Caller's buffer set
+  NOTES        : References to the variables of enclosing
+                   queries have a non-zero depth
+ ***************************************************************/
+static SYMBOL_HN *QuerySlotReference(
+  EXPRESSION *theExp,
+  int *posn)
+  {
+   EXPRESSION *depth;
+
+   if (theExp->type != FCALL)
+     return NULL;
+   if (ExpressionFunctionPointer(theExp) != GetQueryFactSlot)
+     return NULL;
+
+   depth = theExp->argList;
+   if ((ValueToLong(depth->value) != 0) || (depth->nextArg->nextArg->type != SYMBOL))
+     return NULL;
+
+   *posn = (int) ValueToLong(depth->nextArg->value);
+   return((SYMBOL_HN *) depth->nextArg->nextArg->value);
+  }
+
+/***************************************************************
+  NAME         : IsQueryKeyExpression
+  DESCRIPTION  : Determines if an expression can be used as the
+                   key for a fact variable
+  INPUTS       : 1) The expression
+                 2) The position of the fact variable
+  RETURNS      : True if the expression is a constant or refers
+                   only to the variables left of the position,
+                   false otherwise
+  SIDE EFFECTS : None
+  NOTES        : Function calls are not allowed because a key is
+                   evaluated once for all of the facts it selects
+ ***************************************************************/
+static bool IsQueryKeyExpression(
+  EXPRESSION *theExp,
+  int posn)
+  {
+   int keyPosn;
+
+   switch (theExp->type)
+     {
+      case SYMBOL:
+      case STRING:
+      case INTEGER:
+      case FLOAT:
+      case INSTANCE_NAME:
+        return true;
+
+      case FCALL:
+        if (QuerySlotReference(theExp,&keyPosn) != NULL)
+          return(keyPosn < posn);
+        if ((ExpressionFunctionPointer(theExp) == GetQueryFact) &&
+            (ValueToLong(theExp->argList->value) == 0))
+          return(ValueToLong(theExp->argList->nextArg->value) < posn);
+        break;
+     }
+
+   return false;
+  }
+
+/***************************************************
+  NAME         : ReturnQueryKeys
+  DESCRIPTION  : Deallocates the keys of a query
+  INPUTS       : 1) The key array (can be NULL)
+                 2) The number of fact variables
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Array deallocated
+  NOTES        : The key expressions belong to the
+                   query and are not deallocated
+ ***************************************************/
+static void ReturnQueryKeys(
+  Environment *theEnv,
+  QUERY_KEY *keys,
+  unsigned rcnt)
+  {
+   if (keys != NULL)
+     rm(theEnv,keys,(sizeof(QUERY_KEY) * rcnt));
+  }
+
+/***************************************************************
+  NAME         : EvaluateQueryKey
+  DESCRIPTION  : Determines the value of a key expression for
+                   the facts bound to the variables on its left
+  INPUTS       : 1) The key expression
+                 2) Caller's result buffer
+  RETURNS      : True if the key has a single field value,
+                   false otherwise
+  SIDE EFFECTS : Caller's buffer set
+  NOTES        : A slot the bound fact does not have, or a
+                   multifield slot, gives no key. The facts are
+                   then visited one by one and the query reports
+                   any error itself.
+ ***************************************************************/
+static bool EvaluateQueryKey(
+  Environment *theEnv,
+  EXPRESSION *theExp,
+  CLIPSValue *returnValue)
+  {
+   struct fact *theFact;
+   struct templateSlot *theSlot;
+   short position;
+
+   if (theExp->type != FCALL)
+     {
+      returnValue->type = theExp->type;
+      returnValue->value = theExp->value;
+      return true;
+     }
+
+   theFact = FactQueryData(theEnv)->QueryCore->solns[ValueToLong(theExp->argList->nextArg->value)];
+   if (ExpressionFunctionPointer(theExp) == GetQueryFact)
+     {
+      returnValue->type = FACT_ADDRESS;
+      returnValue->value = theFact;
+      return true;
+     }
+
+   if (theFact->whichDeftemplate->implied)
+     return false;
+
+   theSlot = FindSlot(theFact->whichDeftemplate,
+                      (SYMBOL_HN *) theExp->argList->nextArg->nextArg->value,&position);
+   if ((theSlot == NULL) || theSlot->multislot)
+     return false;
+
+   returnValue->type = theFact->theProposition.theFields[position-1].type;
+   returnValue->value = theFact->theProposition.theFields[position-1].value;
+   return true;
+  }
+
+/***************************************************
+  NAME         : QueryKeyNumber
+  DESCRIPTION  : Converts a field to the value it
+                   is ordered by in a range index
+  INPUTS       : 1) The field type
+                 2) The field value
+                 3) Caller's buffer for the number
+  RETURNS      : True if the field is a number,
+                   false otherwise
+  SIDE EFFECTS : Caller's buffer set
+  NOTES        : NaN is not a usable number
+ ***************************************************/
+static bool QueryKeyNumber(
+  unsigned short type,
+  void *value,
+  double *number)
+  {
+   if (type == INTEGER)
+     *number = (double) ValueToLong(value);
+   else if (type == FLOAT)
+     *number = ValueToDouble(value);
+   else
+     return false;
+
+   return(*number == *number);
+  }
+
+/***************************************************
+  NAME         : QueryKeyBucket
+  DESCRIPTION  : Determines the bucket of a field
+                   in a hash index
+  INPUTS       : 1) The field type
+                 2) The field value
+                 3) The number of buckets
+  RETURNS      : The bucket
+  SIDE EFFECTS : None
+  NOTES        : Fields are hashed as they are in
+                   the join network, so fields which
+                   are eq have the same bucket
+ ***************************************************/
+static unsigned long QueryKeyBucket(
+  unsigned short type,
+  void *value,
+  unsigned long size)
+  {
+   CLIPSValue theValue;
+
+   theValue.type = type;
+   theValue.value = value;
+   return(FoldJoinHashValue(AddJoinHashValue(0,&theValue)) & (size - 1));
+  }
+
+/***************************************************************
+  NAME         : BuildQueryIndex
+  DESCRIPTION  : (Re)builds the index of a template restriction
+                   for the key of its fact variable
+  INPUTS       : 1) The template restriction
+                 2) The key
+  RETURNS      : The index
+  SIDE EFFECTS : Index allocated or rebuilt
+  NOTES        : The index kind is QUERY_NO_KEY when the facts
+                   of the template have to be visited one by one:
+                   the slot does not exist or is a multifield
+                   slot, a range key is used with a slot holding
+                   a value that is not a number, or the template
+                   has too few facts for an index to pay off
+ ***************************************************************/
+static QUERY_INDEX *BuildQueryIndex(
+  Environment *theEnv,
+  QUERY_TEMPLATE *qtemplate,
+  QUERY_KEY *theKey)
+  {
+   QUERY_INDEX *theIndex;
+   Deftemplate *templatePtr = qtemplate->templatePtr;
+   struct templateSlot *theSlot;
+   struct fact *theFact;
+   unsigned long count = 0;
+   short position;
+
+   theIndex = qtemplate->index;
+   if (theIndex == NULL)
+     {
+      theIndex = get_struct(theEnv,query_index);
+      theIndex->buckets = NULL;
+      theIndex->facts = NULL;
+      theIndex->entries = NULL;
+      qtemplate->index = theIndex;
+     }
+   else
+     ClearQueryIndex(theEnv,theIndex);
+
+   theIndex->kind = QUERY_NO_KEY;
+   theIndex->changes = FactData(theEnv)->FactListChanges;
+   theIndex->count = 0;
+   theIndex->size = 0;
+
+   if (templatePtr->implied)
+     return(theIndex);
+
+   theSlot = FindSlot(templatePtr,theKey->slotName,&position);
+   if ((theSlot == NULL) || theSlot->multislot)
+     return(theIndex);
+   theIndex->slotPosition = (short) (position - 1);
+
+   for (theFact = templatePtr->factList ; theFact != NULL ; theFact = theFact->nextTemplateFact)
+     count++;
+   if (count < QUERY_INDEX_MINIMUM)
+     return(theIndex);
+
+   if (theKey->kind == QUERY_HASH_KEY)
+     BuildQueryHashIndex(theEnv,theIndex,templatePtr,count);
+   else
+     BuildQueryRangeIndex(theEnv,theIndex,templatePtr,count);
+
+   return(theIndex);
+  }
+
+/***************************************************************
+  NAME         : BuildQueryHashIndex
+  DESCRIPTION  : Groups the facts of a template by the hash of
+                   the indexed slot
+  INPUTS       : 1) The index
+                 2) The template
+                 3) The number of facts of the template
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Index arrays allocated
+  NOTES        : The facts of each bucket are stored together
+                   in template list order. Bucket i holds the
+                   facts from buckets[i] up to buckets[i+1].
+ ***************************************************************/
+static void BuildQueryHashIndex(
+  Environment *theEnv,
+  QUERY_INDEX *theIndex,
+  Deftemplate *templatePtr,
+  unsigned long count)
+  {
+   struct fact *theFact;
+   struct field *theField;
+   unsigned long size = 1,i,b;
+
+   while (size < count)
+     size <<= 1;
+
+   theIndex->buckets = (unsigned long *) gm2(theEnv,(sizeof(unsigned long) * (size + 1)));
+   theIndex->facts = (struct fact **) gm2(theEnv,(sizeof(struct fact *) * count));
+   for (i = 0 ; i <= size ; i++)
+     theIndex->buckets[i] = 0;
+
+   /*=============================================*/
+   /* Count the facts of each bucket and turn the */
+   /* counts into the start of each bucket.       */
+   /*=============================================*/
+
+   for (theFact = templatePtr->factList ; theFact != NULL ; theFact = theFact->nextTemplateFact)
+     {
+      theField = &theFact->theProposition.theFields[theIndex->slotPosition];
+      theIndex->buckets[QueryKeyBucket(theField->type,theField->value,size) + 1]++;
+     }
+
+   for (b = 1 ; b <= size ; b++)
+     theIndex->buckets[b] += theIndex->buckets[b-1];
+
+   /*=============================================*/
+   /* Place the facts. Each start is advanced to  */
+   /* the start of the next bucket, so the starts */
+   /* are shifted back up once all are placed.    */
+   /*=============================================*/
+
+   for (theFact = templatePtr->factList ; theFact != NULL ; theFact = theFact->nextTemplateFact)
+     {
+      theField = &theFact->theProposition.theFields[theIndex->slotPosition];
+      b = QueryKeyBucket(theField->type,theField->value,size);
+      theIndex->facts[theIndex->buckets[b]++] = theFact;
+     }
+
+   for (b = size ; b > 0 ; b--)
+     theIndex->buckets[b] = theIndex->buckets[b-1];
+   theIndex->buckets[0] = 0;
+
+   theIndex->kind = QUERY_HASH_KEY;
+   theIndex->count = count;
+   theIndex->size = size;
+  }
+
+/***************************************************************
+  NAME         : BuildQueryRangeIndex
+  DESCRIPTION  : Sorts the facts of a template by the numeric
+                   value of the indexed slot
+  INPUTS       : 1) The index
+                 2) The template
+                 3) The number of facts of the template
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Index entries allocated
+  NOTES        : No index is built if any fact has a value that
+                   is not a number in the slot
+ ***************************************************************/
+static void BuildQueryRangeIndex(
+  Environment *theEnv,
+  QUERY_INDEX *theIndex,
+  Deftemplate *templatePtr,
+  unsigned long count)
+  {
+   struct fact *theFact;
+   struct field *theField;
+   QUERY_RANGE_ENTRY *entries;
+   unsigned long i = 0;
+
+   entries = (QUERY_RANGE_ENTRY *) gm2(theEnv,(sizeof(QUERY_RANGE_ENTRY) * count));
+
+   for (theFact = templatePtr->factList ; theFact != NULL ; theFact = theFact->nextTemplateFact)
+     {
+      theField = &theFact->theProposition.theFields[theIndex->slotPosition];
+      if (QueryKeyNumber(theField->type,theField->value,&entries[i].value) == false)
+        {
+         rm(theEnv,entries,(sizeof(QUERY_RANGE_ENTRY) * count));
+         return;
+        }
+      entries[i++].theFact = theFact;
+     }
+
+   qsort(entries,count,sizeof(QUERY_RANGE_ENTRY),CompareRangeEntries);
+
+   theIndex->entries = entries;
+   theIndex->kind = QUERY_RANGE_KEY;
+   theIndex->count = count;
+  }
+
+/***************************************************
+  NAME         : ClearQueryIndex
+  DESCRIPTION  : Deallocates the arrays of an index
+  INPUTS       : The index
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Arrays deallocated
+  NOTES        : The index itself is not
+                   deallocated
+ ***************************************************/
+static void ClearQueryIndex(
+  Environment *theEnv,
+  QUERY_INDEX *theIndex)
+  {
+   if (theIndex->buckets != NULL)
+     rm(theEnv,theIndex->buckets,(sizeof(unsigned long) * (theIndex->size + 1)));
+   if (theIndex->facts != NULL)
+     rm(theEnv,theIndex->facts,(sizeof(struct fact *) * theIndex->count));
+   if (theIndex->entries != NULL)
+     rm(theEnv,theIndex->entries,(sizeof(QUERY_RANGE_ENTRY) * theIndex->count));
+
+   theIndex->buckets = NULL;
+   theIndex->facts = NULL;
+   theIndex->entries = NULL;
+  }
+
+/***************************************************
+  NAME         : CompareRangeEntries
+  DESCRIPTION  : Orders range index entries by
+                   value and then by fact index
+  INPUTS       : The two entries
+  RETURNS      : <0, 0 or >0 as for qsort
+  SIDE EFFECTS : None
+  NOTES        : None
+ ***************************************************/
+static int CompareRangeEntries(
+  const void *e1,
+  const void *e2)
+  {
+   const QUERY_RANGE_ENTRY *r1 = (const QUERY_RANGE_ENTRY *) e1;
+   const QUERY_RANGE_ENTRY *r2 = (const QUERY_RANGE_ENTRY *) e2;
+
+   if (r1->value < r2->value)
+     return -1;
+   if (r1->value > r2->value)
+     return 1;
+   return(CompareFactIndexes(&r1->theFact,&r2->theFact));
+  }
+
+/***************************************************
+  NAME         : CompareFactIndexes
+  DESCRIPTION  : Orders facts by fact index
+  INPUTS       : The addresses of the two facts
+  RETURNS      : <0, 0 or >0 as for qsort
+  SIDE EFFECTS : None
+  NOTES        : Template fact lists are kept in
+                   fact index order (a modified fact
+                   keeps its index and position)
+ ***************************************************/
+static int CompareFactIndexes(
+  const void *f1,
+  const void *f2)
+  {
+   long long i1 = (*(struct fact * const *) f1)->factIndex;
+   long long i2 = (*(struct fact * const *) f2)->factIndex;
+
+   if (i1 < i2)
+     return -1;
+   if (i1 > i2)
+     return 1;
+   return 0;
+  }
+
+/***************************************************************
+  NAME         : FirstQueryFact
+  DESCRIPTION  : Starts visiting the facts of a template for a
+                   fact variable
+  INPUTS       : 1) The template restriction
+                 2) The index of the fact variable
+                 3) Caller's cursor
+  RETURNS      : The first fact to visit, or NULL if none
+  SIDE EFFECTS : Cursor initialized
+                 The index for the restriction is (re)built if
+                   it is missing or the fact-list has changed,
+                   unless an eq key can use the slot index
+                   created for the slot by create-index
+  NOTES        : Candidates from a hash bucket are checked
+                   against the key as they are visited. Those
+                   from a range are sorted back into template
+                   list order unless they all have one value.
+ ***************************************************************/
+static struct fact *FirstQueryFact(
+  Environment *theEnv,
+  QUERY_TEMPLATE *qtemplate,
+  int indx,
+  QUERY_CURSOR *cursor)
+  {
+   QUERY_KEY *theKey;
+   QUERY_INDEX *theIndex;
+   struct factSlotIndex *theSlotIndex;
+   CLIPSValue keyValue;
+   double low = 0.0,high = 0.0;
+   unsigned long first,last,lower,upper,middle,i,b;
+
+   cursor->indexed = false;
+   cursor->ownsCandidates = false;
+   cursor->candidates = NULL;
+   cursor->keyValue = NULL;
+   cursor->theFact = qtemplate->templatePtr->factList;
+
+   if ((FactQueryData(theEnv)->QueryCore->keys == NULL) || (cursor->theFact == NULL))
+     return(cursor->theFact);
+
+   theKey = &FactQueryData(theEnv)->QueryCore->keys[indx];
+   if (theKey->kind == QUERY_NO_KEY)
+     return(cursor->theFact);
+
+   theSlotIndex = NULL;
+   if (theKey->kind == QUERY_HASH_KEY)
+     theSlotIndex = FindSlotIndex(qtemplate->templatePtr,theKey->slotName);
+
+   theIndex = NULL;
+   if (theSlotIndex == NULL)
+     {
+      theIndex = qtemplate->index;
+      if ((theIndex == NULL) || (theIndex->changes != FactData(theEnv)->FactListChanges))
+        theIndex = BuildQueryIndex(theEnv,qtemplate,theKey);
+     }
+
+   if (theSlotIndex != NULL)
+     {
+      if (EvaluateQueryKey(theEnv,theKey->key,&keyValue) == false)
+        return(cursor->theFact);
+
+      cursor->count = FindIndexedFacts(theEnv,theSlotIndex,keyValue.type,keyValue.value,
+                                       &cursor->candidates);
+      cursor->ownsCandidates = (cursor->count > 0) ? true : false;
+     }
+   else if (theIndex->kind == QUERY_HASH_KEY)
+     {
+      if (EvaluateQueryKey(theEnv,theKey->key,&keyValue) == false)
+        return(cursor->theFact);
+
+      b = QueryKeyBucket(keyValue.type,keyValue.value,theIndex->size);
+      cursor->candidates = &theIndex->facts[theIndex->buckets[b]];
+      cursor->count = theIndex->buckets[b+1] - theIndex->buckets[b];
+      cursor->slotPosition = theIndex->slotPosition;
+      cursor->keyType = keyValue.type;
+      cursor->keyValue = keyValue.value;
+     }
+   else if (theIndex->kind == QUERY_RANGE_KEY)
+     {
+      first = 0;
+      last = theIndex->count;
+
+      if (theKey->low != NULL)
+        {
+         if ((EvaluateQueryKey(theEnv,theKey->low,&keyValue) == false) ||
+             (QueryKeyNumber(keyValue.type,keyValue.value,&low) == false))
+           return(cursor->theFact);
+
+         for (lower = 0 , upper = theIndex->count ; lower < upper ; )
+           {
+            middle = lower + (upper - lower) / 2;
+            if (theIndex->entries[middle].value < low)
+              lower = middle + 1;
+            else
+              upper = middle;
+           }
+         first = lower;
+        }
+
+      if (theKey->high != NULL)
+        {
+         if ((EvaluateQueryKey(theEnv,theKey->high,&keyValue) == false) ||
+             (QueryKeyNumber(keyValue.type,keyValue.value,&high) == false))
+           return(cursor->theFact);
+
+         for (lower = first , upper = theIndex->count ; lower < upper ; )
+           {
+            middle = lower + (upper - lower) / 2;
+            if (theIndex->entries[middle].value <= high)
+              lower = middle + 1;
+            else
+              upper = middle;
+           }
+         last = lower;
+        }
+
+      cursor->count = (last > first) ? (last - first) : 0;
+      if (cursor->count > 0)
+        {
+         cursor->candidates = (struct fact **) gm2(theEnv,(sizeof(struct fact *) * cursor->count));
+         cursor->ownsCandidates = true;
+         for (i = 0 ; i < cursor->count ; i++)
+           cursor->candidates[i] = theIndex->entries[first + i].theFact;
+         if (theIndex->entries[first].value != theIndex->entries[last - 1].value)
+           qsort(cursor->candidates,cursor->count,sizeof(struct fact *),CompareFactIndexes);
+        }
+     }
+   else
+     return(cursor->theFact);
+
+   cursor->indexed = true;
+   cursor->next = 0;
+   cursor->changes = FactData(theEnv)->FactListChanges;
+   return(NextQueryCandidate(cursor));
+  }
+
+/***************************************************************
+  NAME         : NextQueryFact
+  DESCRIPTION  : Determines the next fact to visit for a fact
+                   variable
+  INPUTS       : The cursor
+  RETURNS      : The next fact, or NULL if there are no more
+  SIDE EFFECTS : Cursor advanced
+  NOTES        : Once the fact-list has changed, the rest of the
+                   template list after the current fact is
+                   visited as it would be without an index
+ ***************************************************************/
+static struct fact *NextQueryFact(
+  Environment *theEnv,
+  QUERY_CURSOR *cursor)
+  {
+   struct fact *theFact;
+
+   if (cursor->indexed)
+     {
+      if (cursor->changes == FactData(theEnv)->FactListChanges)
+        return(NextQueryCandidate(cursor));
+      cursor->indexed = false;
+     }
+
+   theFact = cursor->theFact->nextTemplateFact;
+   while ((theFact != NULL) ? (theFact->garbage == 1) : false)
+     theFact = theFact->nextTemplateFact;
+
+   cursor->theFact = theFact;
+   return(theFact);
+  }
+
+/***************************************************
+  NAME         : NextQueryCandidate
+  DESCRIPTION  : Finds the next candidate from an
+                   index which matches the key
+  INPUTS       : The cursor
+  RETURNS      : The candidate, or NULL if there
+                   are no more
+  SIDE EFFECTS : Cursor advanced
+  NOTES        : None
+ ***************************************************/
+static struct fact *NextQueryCandidate(
+  QUERY_CURSOR *cursor)
+  {
+   struct fact *theFact;
+   struct field *theField;
+
+   while (cursor->next < cursor->count)
+     {
+      theFact = cursor->candidates[cursor->next++];
+      if (cursor->keyValue != NULL)
+        {
+         theField = &theFact->theProposition.theFields[cursor->slotPosition];
+         if ((theField->type != cursor->keyType) || (theField->value != cursor->keyValue))
+           continue;
+        }
+      cursor->theFact = theFact;
+      return(theFact);
+     }
+
+   cursor->theFact = NULL;
+   return NULL;
+  }
+
+/***************************************************
+  NAME         : ReleaseQueryCursor
+  DESCRIPTION  : Deallocates the candidates held
+                   by a cursor
+  INPUTS       : The cursor
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Candidates deallocated
+  NOTES        : None
+ ***************************************************/
+static void ReleaseQueryCursor(
+  Environment *theEnv,
+  QUERY_CURSOR *cursor)
+  {
+   if (cursor->ownsCandidates)
+     rm(theEnv,cursor->candidates,(sizeof(struct fact *) * cursor->count));
+  }
   
 #endif
 
@@ -41,6 +41,9 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Equality and range tests on slots in the query */
+/*            drive per-query hash and sorted fact indexes.  */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_factqury
@@ -53,12 +56,59 @@
 
 #include "factmngr.h"
 
+#define QUERY_NO_KEY       0
+#define QUERY_HASH_KEY     1
+#define QUERY_RANGE_KEY    2
+
+#ifndef QUERY_INDEX_MINIMUM
+#define QUERY_INDEX_MINIMUM 16
+#endif
+
+typedef struct query_key
+  {
+   unsigned short kind;
+   SYMBOL_HN *slotName;
+   EXPRESSION *key, *low, *high;
+  } QUERY_KEY;
+
+typedef struct query_range_entry
+  {
+   double value;
+   struct fact *theFact;
+  } QUERY_RANGE_ENTRY;
+
+typedef struct query_index
+  {
+   unsigned short kind;
+   short slotPosition;
+   unsigned long changes;
+   unsigned long count;
+   unsigned long size;
+   unsigned long *buckets;
+   struct fact **facts;
+   QUERY_RANGE_ENTRY *entries;
+  } QUERY_INDEX;
+
 typedef struct query_template
   {
    Deftemplate *templatePtr;
    struct query_template *chain, *nxt;
+   QUERY_INDEX *index;
   } QUERY_TEMPLATE;
 
+typedef struct query_cursor
+  {
+   struct fact *theFact;
+   struct fact **candidates;
+   unsigned long next, count;
+   unsigned long changes;
+   short slotPosition;
+   unsigned short keyType;
+   void *keyValue;
+   bool indexed;
+   bool ownsCandidates;
+  } QUERY_CURSOR;
+
 typedef struct query_soln
   {
    struct fact **soln;
@@ -69,6 +119,7 @@ typedef struct query_core
   {
    struct fact **solns;
    EXPRESSION *query,*action;
+   QUERY_KEY *keys;
    QUERY_SOLN *soln_set,*soln_bottom;
    unsigned soln_size,soln_cnt;
    CLIPSValue *result;
@@ -29,6 +29,9 @@
 /*            Removed use of void pointers for specific      */
 /*            data structures.                               */
 /*                                                           */
+/*            Dispatch caches are flushed when methods       */
+/*            are changed or removed.                        */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -46,6 +49,7 @@
 #include "cstrcbin.h"
 #include "envrnmnt.h"
 #include "genrccom.h"
+#include "genrcexe.h"
 #include "memalloc.h"
 #include "modulbin.h"
 #if OBJECT_SYSTEM
@@ -165,6 +169,10 @@ static void DeallocateDefgenericBinaryData(
   {
 #if (BLOAD || BLOAD_ONLY || BLOAD_AND_BSAVE) && (! RUN_TIME)
    size_t space;
+   long i;
+
+   for (i = 0 ; i < DefgenericBinaryData(theEnv)->GenericCount ; i++)
+     FlushDispatchCache(theEnv,&DefgenericBinaryData(theEnv)->DefgenericArray[i]);
 
    space = DefgenericBinaryData(theEnv)->GenericCount * sizeof(Defgeneric);
    if (space != 0) genfree(theEnv,DefgenericBinaryData(theEnv)->DefgenericArray,space);
@@ -765,6 +773,7 @@ static void UpdateGeneric(
    DefgenericBinaryData(theEnv)->DefgenericArray[obji].methods = MethodPointer(bgp->methods);
    DefgenericBinaryData(theEnv)->DefgenericArray[obji].mcnt = bgp->mcnt;
    DefgenericBinaryData(theEnv)->DefgenericArray[obji].new_index = 0;
+   DefgenericBinaryData(theEnv)->DefgenericArray[obji].dispatchCache = NULL;
   }
 
 static void UpdateMethod(
@@ -849,7 +858,10 @@ static void ClearBloadGenerics(
    DefgenericBinaryData(theEnv)->ModuleCount = 0L;
 
    for (i = 0 ; i < DefgenericBinaryData(theEnv)->GenericCount ; i++)
-     UnmarkConstructHeader(theEnv,&DefgenericBinaryData(theEnv)->DefgenericArray[i].header);
+     {
+      UnmarkConstructHeader(theEnv,&DefgenericBinaryData(theEnv)->DefgenericArray[i].header);
+      FlushDispatchCache(theEnv,&DefgenericBinaryData(theEnv)->DefgenericArray[i]);
+     }
 
    space = (sizeof(Defgeneric) * DefgenericBinaryData(theEnv)->GenericCount);
    if (space == 0L)
@@ -68,6 +68,9 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Dispatch caches are flushed when methods       */
+/*            are changed or removed.                        */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -125,9 +128,7 @@
    static void                    IncrementGenericBusyCount(Environment *,Defgeneric *);
    static void                    DeallocateDefgenericData(Environment *);
 
-#if ! RUN_TIME
    static void                    DestroyDefgenericAction(Environment *,struct constructHeader *,void *);
-#endif
 
 #if (! BLOAD_ONLY) && (! RUN_TIME)
 
@@ -327,13 +328,12 @@ static void DeallocateDefgenericData(
       rtn_struct(theEnv,defgenericModule,theModuleItem);
      }
 #else
-#if MAC_XCD
-#pragma unused(theEnv)
-#endif
+   DoForAllConstructs(theEnv,
+                      DestroyDefgenericAction,
+                      DefgenericData(theEnv)->DefgenericModuleIndex,false,NULL);
 #endif
   }
   
-#if ! RUN_TIME
 /****************************************************/
 /* DestroyDefgenericAction: Action used to remove   */
 /*   defgenerics as a result of DestroyEnvironment. */
@@ -352,6 +352,8 @@ static void DestroyDefgenericAction(
    
    if (theDefgeneric == NULL) return;
 
+   FlushDispatchCache(theEnv,theDefgeneric);
+
    for (i = 0 ; i < theDefgeneric->mcnt ; i++)
      { DestroyMethodInfo(theEnv,theDefgeneric,&theDefgeneric->methods[i]); }
 
@@ -362,12 +364,9 @@ static void DestroyDefgenericAction(
 
    rtn_struct(theEnv,defgeneric,theDefgeneric);
 #else
-#if MAC_XCD
-#pragma unused(theEnv,theConstruct)
-#endif
+   FlushDispatchCache(theEnv,(Defgeneric *) theConstruct);
 #endif
   }
-#endif
 
 /***************************************************
   NAME         : EnvFindDefgeneric
@@ -1520,6 +1519,7 @@ static void RemoveDefgenericMethod(
       EnvPrintRouter(theEnv,WERROR,".\n");
       return;
      }
+   FlushDispatchCache(theEnv,gfunc);
    DeleteMethodInfo(theEnv,gfunc,&gfunc->methods[gi]);
    if (gfunc->mcnt == 1)
      {
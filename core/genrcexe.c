@@ -40,6 +40,10 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Applicable methods are looked up in a per-     */
+/*            generic dispatch cache keyed by the classes    */
+/*            of the arguments.                              */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -63,6 +67,7 @@
 #include "constrct.h"
 #include "envrnmnt.h"
 #include "genrccom.h"
+#include "memalloc.h"
 #include "prcdrfun.h"
 #include "prccode.h"
 #include "proflfun.h"
@@ -87,6 +92,11 @@
    ***************************************** */
 
    static Defmethod              *FindApplicableMethod(Environment *,Defgeneric *,Defmethod *);
+   static DISPATCH_ENTRY         *FindDispatchEntry(Environment *,Defgeneric *);
+   static bool                    DispatchCacheAllowed(Defgeneric *);
+   static bool                    DetermineDispatchKeys(Environment *,DISPATCH_KEY *,unsigned long *);
+   static DISPATCH_ENTRY         *AddDispatchEntry(Environment *,Defgeneric *,DISPATCH_KEY *,short,unsigned long);
+   static void                    ReturnDispatchEntries(Environment *,DISPATCH_CACHE *);
 
 #if DEBUGGING_FUNCTIONS
    static void                    WatchGeneric(Environment *,const char *);
@@ -370,6 +380,30 @@ bool IsMethodApplicable(
    return true;
   }
 
+/***************************************************
+  NAME         : FlushDispatchCache
+  DESCRIPTION  : Deletes the dispatch cache of a
+                   generic function
+  INPUTS       : The generic function
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Cache entries and the cache
+                   deallocated
+  NOTES        : Must be called before the methods
+                   of the generic are changed or
+                   deleted. The cache is rebuilt
+                   by the next call of the generic.
+ ***************************************************/
+void FlushDispatchCache(
+  Environment *theEnv,
+  Defgeneric *gfunc)
+  {
+   if (gfunc->dispatchCache == NULL)
+     return;
+   ReturnDispatchEntries(theEnv,gfunc->dispatchCache);
+   rtn_struct(theEnv,dispatchCache,gfunc->dispatchCache);
+   gfunc->dispatchCache = NULL;
+  }
+
 /***************************************************
   NAME         : NextMethodP
   DESCRIPTION  : Determines if a shadowed generic
@@ -589,13 +623,38 @@ void GetGenericCurrentArgument(
                    applicable method (NULL on errors)
   SIDE EFFECTS : Any from evaluating query restrictions
                  Methoid busy count incremented if applicable
-  NOTES        : None
+                 Dispatch cache entry added for the
+                   classes of the arguments
+  NOTES        : If the generic has a dispatch cache
+                   entry for the classes of the arguments,
+                   the next applicable method is taken
+                   from its list of applicable methods
+                   without testing the others
  ************************************************************/
 static Defmethod *FindApplicableMethod(
   Environment *theEnv,
   Defgeneric *gfunc,
   Defmethod *meth)
   {
+   DISPATCH_ENTRY *entry;
+   short i,start;
+
+   entry = FindDispatchEntry(theEnv,gfunc);
+   if (entry != NULL)
+     {
+      start = (short) ((meth != NULL) ? (meth - gfunc->methods) + 1 : 0);
+      for (i = 0 ; i < entry->methodCount ; i++)
+        {
+         if (entry->methods[i] >= start)
+           {
+            meth = &gfunc->methods[entry->methods[i]];
+            meth->busy++;
+            return(meth);
+           }
+        }
+      return NULL;
+     }
+
    if (meth != NULL)
      meth++;
    else
@@ -610,6 +669,273 @@ static Defmethod *FindApplicableMethod(
    return NULL;
   }
 
+/***************************************************************
+  NAME         : FindDispatchEntry
+  DESCRIPTION  : Finds the dispatch cache entry of a generic
+                   function for the classes of the arguments
+                   in the ProcParamArray, adding one if there
+                   is none
+  INPUTS       : The generic function
+  RETURNS      : The cache entry, NULL if the applicable
+                   methods must be found by testing each one
+  SIDE EFFECTS : Dispatch cache created for the generic if
+                   it did not have one
+                 Cache entries deleted if classes have been
+                   added or removed since they were made, or
+                   if the cache is full
+  NOTES        : The cache is only used by generics with no
+                   query restrictions, for only then do the
+                   classes of the arguments determine which
+                   methods are applicable
+ ***************************************************************/
+static DISPATCH_ENTRY *FindDispatchEntry(
+  Environment *theEnv,
+  Defgeneric *gfunc)
+  {
+   DISPATCH_CACHE *cache;
+   DISPATCH_ENTRY *entry;
+   DISPATCH_KEY keys[DISPATCH_CACHE_ARGUMENTS];
+   unsigned long hashValue;
+   short i,argCount;
+
+   argCount = (short) ProceduralPrimitiveData(theEnv)->ProcParamArraySize;
+   if (argCount > DISPATCH_CACHE_ARGUMENTS)
+     return NULL;
+
+   cache = gfunc->dispatchCache;
+   if (cache == NULL)
+     {
+      cache = get_struct(theEnv,dispatchCache);
+      cache->enabled = DispatchCacheAllowed(gfunc);
+#if OBJECT_SYSTEM
+      cache->classTableChanges = DefclassData(theEnv)->ClassTableChanges;
+#endif
+      cache->entryCount = 0;
+      for (i = 0 ; i < DISPATCH_CACHE_SIZE ; i++)
+        cache->table[i] = NULL;
+      gfunc->dispatchCache = cache;
+     }
+   if (! cache->enabled)
+     return NULL;
+
+#if OBJECT_SYSTEM
+   /* ==========================================
+      A new class may have been given the address
+      of a deleted one, or a subclass added to a
+      class in a method restriction
+      ========================================== */
+   if (cache->classTableChanges != DefclassData(theEnv)->ClassTableChanges)
+     {
+      ReturnDispatchEntries(theEnv,cache);
+      cache->classTableChanges = DefclassData(theEnv)->ClassTableChanges;
+     }
+#endif
+
+   if (DetermineDispatchKeys(theEnv,keys,&hashValue) == false)
+     return NULL;
+
+   for (entry = cache->table[hashValue % DISPATCH_CACHE_SIZE] ;
+        entry != NULL ;
+        entry = entry->nxt)
+     {
+      if ((entry->hashValue != hashValue) || (entry->argCount != argCount))
+        continue;
+      for (i = 0 ; i < argCount ; i++)
+        {
+#if OBJECT_SYSTEM
+         if (entry->keys[i].cls != keys[i].cls)
+           break;
+#endif
+         if (entry->keys[i].type != keys[i].type)
+           break;
+        }
+      if (i == argCount)
+        return(entry);
+     }
+
+   if (cache->entryCount >= DISPATCH_CACHE_ENTRIES)
+     ReturnDispatchEntries(theEnv,cache);
+   return(AddDispatchEntry(theEnv,gfunc,keys,argCount,hashValue));
+  }
+
+/***************************************************
+  NAME         : DispatchCacheAllowed
+  DESCRIPTION  : Determines if the applicable
+                   methods of a generic function
+                   can be cached
+  INPUTS       : The generic function
+  RETURNS      : True if no method of the generic
+                   has a query restriction, false
+                   otherwise
+  SIDE EFFECTS : None
+  NOTES        : None
+ ***************************************************/
+static bool DispatchCacheAllowed(
+  Defgeneric *gfunc)
+  {
+   short i,j;
+   Defmethod *meth;
+
+   for (i = 0 ; i < gfunc->mcnt ; i++)
+     {
+      meth = &gfunc->methods[i];
+      for (j = 0 ; j < meth->restrictionCount ; j++)
+        {
+         if (meth->restrictions[j].query != NULL)
+           return false;
+        }
+     }
+   return true;
+  }
+
+/***************************************************************
+  NAME         : DetermineDispatchKeys
+  DESCRIPTION  : Determines the class and type of each of
+                   the arguments in the ProcParamArray
+  INPUTS       : 1) The buffer for the argument keys
+                 2) The buffer for the hash value of the keys
+  RETURNS      : True if the classes of all the arguments
+                   could be determined, false otherwise
+  SIDE EFFECTS : Buffers set
+  NOTES        : Unlike DetermineRestrictionClass(), an
+                   instance which cannot be found is not an
+                   error here - the applicable methods are
+                   then found by testing each one, which
+                   reports the error if there is one
+ ***************************************************************/
+static bool DetermineDispatchKeys(
+  Environment *theEnv,
+  DISPATCH_KEY *keys,
+  unsigned long *hashValue)
+  {
+   CLIPSValue *arg;
+   unsigned long long theHash = 0;
+   short i;
+#if OBJECT_SYSTEM
+   Instance *ins;
+   union
+     {
+      void *vv;
+      unsigned long long liv;
+     } fis;
+#endif
+
+   for (i = 0 ; i < ProceduralPrimitiveData(theEnv)->ProcParamArraySize ; i++)
+     {
+      arg = &ProceduralPrimitiveData(theEnv)->ProcParamArray[i];
+      keys[i].type = arg->type;
+#if OBJECT_SYSTEM
+      if (arg->type == INSTANCE_NAME)
+        {
+         ins = FindInstanceBySymbol(theEnv,(SYMBOL_HN *) arg->value);
+         keys[i].cls = (ins != NULL) ? ins->cls : NULL;
+        }
+      else if (arg->type == INSTANCE_ADDRESS)
+        {
+         ins = (Instance *) arg->value;
+         keys[i].cls = (ins->garbage == 0) ? ins->cls : NULL;
+        }
+      else
+        keys[i].cls = DefclassData(theEnv)->PrimitiveClassMap[arg->type];
+      if (keys[i].cls == NULL)
+        return false;
+      fis.liv = 0;
+      fis.vv = keys[i].cls;
+      theHash = (theHash * 31) + (fis.liv >> 3);
+#endif
+      theHash = (theHash * 31) + keys[i].type;
+     }
+   *hashValue = (unsigned long) (theHash ^ (theHash >> 32));
+   return true;
+  }
+
+/***************************************************************
+  NAME         : AddDispatchEntry
+  DESCRIPTION  : Adds a dispatch cache entry listing the
+                   methods of a generic function applicable
+                   to the arguments in the ProcParamArray
+  INPUTS       : 1) The generic function
+                 2) The argument keys
+                 3) The number of arguments
+                 4) The hash value of the keys
+  RETURNS      : The new cache entry
+  SIDE EFFECTS : Entry added to the generic's dispatch cache
+  NOTES        : Method applicability is tested without any
+                   query evaluation (see DispatchCacheAllowed)
+                 The methods are listed by their position in
+                   the method array in precedence order
+ ***************************************************************/
+static DISPATCH_ENTRY *AddDispatchEntry(
+  Environment *theEnv,
+  Defgeneric *gfunc,
+  DISPATCH_KEY *keys,
+  short argCount,
+  unsigned long hashValue)
+  {
+   DISPATCH_CACHE *cache = gfunc->dispatchCache;
+   DISPATCH_ENTRY *entry;
+   short i,methodCount = 0;
+
+   for (i = 0 ; i < gfunc->mcnt ; i++)
+     {
+      if (IsMethodApplicable(theEnv,&gfunc->methods[i]))
+        methodCount++;
+     }
+
+   entry = get_struct(theEnv,dispatchEntry);
+   entry->hashValue = hashValue;
+   entry->argCount = argCount;
+   entry->methodCount = methodCount;
+   entry->keys = (argCount != 0) ?
+                 (DISPATCH_KEY *) gm2(theEnv,(sizeof(DISPATCH_KEY) * argCount)) : NULL;
+   entry->methods = (methodCount != 0) ?
+                    (short *) gm2(theEnv,(sizeof(short) * methodCount)) : NULL;
+   for (i = 0 ; i < argCount ; i++)
+     entry->keys[i] = keys[i];
+   for (i = 0 , methodCount = 0 ; i < gfunc->mcnt ; i++)
+     {
+      if (IsMethodApplicable(theEnv,&gfunc->methods[i]))
+        entry->methods[methodCount++] = i;
+     }
+
+   entry->nxt = cache->table[hashValue % DISPATCH_CACHE_SIZE];
+   cache->table[hashValue % DISPATCH_CACHE_SIZE] = entry;
+   cache->entryCount++;
+   return(entry);
+  }
+
+/***************************************************
+  NAME         : ReturnDispatchEntries
+  DESCRIPTION  : Deletes all the entries of a
+                   dispatch cache
+  INPUTS       : The dispatch cache
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Entries deallocated
+  NOTES        : None
+ ***************************************************/
+static void ReturnDispatchEntries(
+  Environment *theEnv,
+  DISPATCH_CACHE *cache)
+  {
+   DISPATCH_ENTRY *entry;
+   short i;
+
+   for (i = 0 ; i < DISPATCH_CACHE_SIZE ; i++)
+     {
+      while (cache->table[i] != NULL)
+        {
+         entry = cache->table[i];
+         cache->table[i] = entry->nxt;
+         if (entry->keys != NULL)
+           rm(theEnv,entry->keys,(sizeof(DISPATCH_KEY) * entry->argCount));
+         if (entry->methods != NULL)
+           rm(theEnv,entry->methods,(sizeof(short) * entry->methodCount));
+         rtn_struct(theEnv,dispatchEntry,entry);
+        }
+     }
+   cache->entryCount = 0;
+  }
+
 #if DEBUGGING_FUNCTIONS
 
 /**********************************************************************
@@ -38,6 +38,8 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added FlushDispatchCache.                      */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_genrcexe
@@ -55,6 +57,7 @@
    void                           GenericDispatch(Environment *,Defgeneric *,Defmethod *,Defmethod *,EXPRESSION *,CLIPSValue *);
    void                           UnboundMethodErr(Environment *);
    bool                           IsMethodApplicable(Environment *,Defmethod *);
+   void                           FlushDispatchCache(Environment *,Defgeneric *);
 
    bool                           NextMethodP(Environment *);
    void                           NextMethodPCommand(Environment *,UDFContext *,CLIPSValue *);
@@ -54,6 +54,9 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Dispatch caches are flushed when methods       */
+/*            are changed or removed.                        */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -221,6 +224,7 @@ bool RemoveAllExplicitMethods(
 
    if (MethodsExecuting(gfunc) == false)
      {
+      FlushDispatchCache(theEnv,gfunc);
       for (i = 0 ; i < gfunc->mcnt ; i++)
         {
          if (gfunc->methods[i].system)
@@ -272,6 +276,7 @@ void RemoveDefgeneric(
   {
    long i;
 
+   FlushDispatchCache(theEnv,theDefgeneric);
    for (i = 0 ; i < theDefgeneric->mcnt ; i++)
      DeleteMethodInfo(theEnv,theDefgeneric,&theDefgeneric->methods[i]);
 
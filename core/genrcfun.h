@@ -53,6 +53,8 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added dispatch caches to generic functions.    */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_genrcfun
@@ -65,6 +67,9 @@ typedef struct defgenericModule DEFGENERIC_MODULE;
 typedef struct restriction RESTRICTION;
 typedef struct defmethod Defmethod;
 typedef struct defgeneric Defgeneric;
+typedef struct dispatchKey DISPATCH_KEY;
+typedef struct dispatchEntry DISPATCH_ENTRY;
+typedef struct dispatchCache DISPATCH_CACHE;
 
 #include <stdio.h>
 
@@ -79,6 +84,13 @@ typedef struct defgeneric Defgeneric;
 #include "object.h"
 #endif
 
+#ifndef DISPATCH_CACHE_SIZE
+#define DISPATCH_CACHE_SIZE      16
+#endif
+
+#define DISPATCH_CACHE_ENTRIES   64
+#define DISPATCH_CACHE_ARGUMENTS 16
+
 struct defgenericModule
   {
    struct defmoduleItemHeader header;
@@ -115,6 +127,35 @@ struct defgeneric
    Defmethod *methods;
    short mcnt;
    short new_index;
+   DISPATCH_CACHE *dispatchCache;
+  };
+
+struct dispatchKey
+  {
+#if OBJECT_SYSTEM
+   Defclass *cls;
+#endif
+   unsigned short type;
+  };
+
+struct dispatchEntry
+  {
+   unsigned long hashValue;
+   short argCount;
+   short methodCount;
+   DISPATCH_KEY *keys;
+   short *methods;
+   DISPATCH_ENTRY *nxt;
+  };
+
+struct dispatchCache
+  {
+   bool enabled;
+#if OBJECT_SYSTEM
+   unsigned long classTableChanges;
+#endif
+   short entryCount;
+   DISPATCH_ENTRY *table[DISPATCH_CACHE_SIZE];
   };
 
 #define DEFGENERIC_DATA 27
@@ -53,6 +53,9 @@
 /*            Removed use of void pointers for specific      */
 /*            data structures.                               */
 /*                                                           */
+/*            Dispatch caches are flushed when methods       */
+/*            are changed or removed.                        */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -81,6 +84,7 @@
 #include "envrnmnt.h"
 #include "exprnpsr.h"
 #include "genrccom.h"
+#include "genrcexe.h"
 #include "immthpsr.h"
 #include "memalloc.h"
 #include "modulutl.h"
@@ -450,6 +454,7 @@ Defmethod *AddMethod(
    int i,j;
    int mai;
 
+   FlushDispatchCache(theEnv,gfunc);
    SaveBusyCount(gfunc);
    if (meth == NULL)
      {
@@ -1574,6 +1579,7 @@ static Defgeneric *NewGeneric(
    ngen->new_index = 1;
    ngen->methods = NULL;
    ngen->mcnt = 0;
+   ngen->dispatchCache = NULL;
 #if DEBUGGING_FUNCTIONS
    ngen->trace = DefgenericData(theEnv)->WatchGenerics;
 #endif
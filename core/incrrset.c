@@ -326,7 +326,7 @@ static void PrimeJoinFromLeftMemory(
            {
             if (listOfHashNodes->alphaMemory != NULL)
               { 
-               AddBlockedLink(notParent,listOfHashNodes->alphaMemory);
+               AddBlockedLink(theEnv,notParent,listOfHashNodes->alphaMemory);
                return; 
               }
            }
@@ -382,7 +382,7 @@ static void PrimeJoinFromLeftMemory(
            theList != NULL;
            theList = theList->nextInMemory)
         {
-         linker = CopyPartialMatch(theEnv,theList);
+         linker = CopyPartialMatch(theEnv,theList,joinPtr,LHS);
                                    
          if (joinPtr->leftHash != NULL)
            { hashValue = BetaMemoryHashValue(theEnv,joinPtr->leftHash,linker,NULL,joinPtr); }
@@ -473,7 +473,7 @@ static void PrimeJoinFromRightMemory(
            theList != NULL;
            theList = theList->nextInMemory)
         {
-         linker = CopyPartialMatch(theEnv,theList);
+         linker = CopyPartialMatch(theEnv,theList,joinPtr,RHS);
                                    
          if (joinPtr->rightHash != NULL)
            { hashValue = BetaMemoryHashValue(theEnv,joinPtr->rightHash,linker,NULL,joinPtr); }
@@ -62,6 +62,8 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added create-instance-index command.           */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -116,6 +118,7 @@
 
    static void                    PrintInstance(Environment *,const char *,Instance *,const char *);
    static INSTANCE_SLOT          *FindISlotByName(Environment *,Instance *,const char *);
+   static void                    IndexClassSlot(Environment *,Defclass *,SYMBOL_HN *,int);
    static void                    DeallocateInstanceData(Environment *);
 
 /* =========================================
@@ -161,7 +164,8 @@ void SetupInstances(
    Instance dummyInstance = { { NULL, NULL, 0, 0L },
                               NULL, NULL, 0, 1, 0, 0, 0,
                               NULL,  0, 0, NULL, NULL, NULL, NULL,
-                              NULL, NULL, NULL, NULL, NULL };
+                              NULL, NULL, NULL, NULL, NULL,
+                              0, NULL, NULL };
 
    AllocateEnvironmentData(theEnv,INSTANCE_DATA,sizeof(struct instanceData),DeallocateInstanceData);
    
@@ -211,6 +215,7 @@ void SetupInstances(
    EnvAddUDF(theEnv,"instancep","b",1,1,NULL,InstancePCommand,"InstancePCommand",NULL);
    EnvAddUDF(theEnv,"instance-existp","b",1,1,"niy",InstanceExistPCommand,"InstanceExistPCommand",NULL);
    EnvAddUDF(theEnv,"class","*",1,1,NULL,ClassCommand,"ClassCommand",NULL);
+   EnvAddUDF(theEnv,"create-instance-index","b",2,2,"y",CreateInstanceIndexCommand,"CreateInstanceIndexCommand",NULL);
 
    SetupInstanceModDupCommands(theEnv);
    /* SetupInstanceFileCommands(theEnv); DR0866 */
@@ -241,8 +246,7 @@ static void DeallocateInstanceData(
    /* Remove the instance hash table. */
    /*=================================*/
    
-   rm(theEnv,InstanceData(theEnv)->InstanceTable,
-      (int) (sizeof(Instance *) * INSTANCE_TABLE_HASH_SIZE));
+   ReturnInstanceTable(theEnv);
       
    /*=======================*/
    /* Return all instances. */
@@ -1455,6 +1459,86 @@ void InstanceExistPCommand(
    mCVSetBoolean(returnValue,false);
   }
 
+/*******************************************************************
+  NAME         : CreateInstanceIndexCommand
+  DESCRIPTION  : Indexes the instances of a class and its
+                   subclasses by the value of a slot
+  INPUTS       : Caller's result buffer
+  RETURNS      : True if the slot is indexed, false otherwise
+  SIDE EFFECTS : Slot indexes created
+  NOTES        : H/L Syntax : (create-instance-index <class> <slot>)
+ *******************************************************************/
+void CreateInstanceIndexCommand(
+  Environment *theEnv,
+  UDFContext *context,
+  CLIPSValue *returnValue)
+  {
+   Defclass *cls;
+   SYMBOL_HN *ssym;
+
+   ssym = CheckClassAndSlot(context,"create-instance-index",&cls);
+   if (ssym == NULL)
+     {
+      mCVSetBoolean(returnValue,false);
+      return;
+     }
+   mCVSetBoolean(returnValue,EnvCreateInstanceIndex(theEnv,cls,ValueToString(ssym)));
+  }
+
+/*******************************************************************
+  NAME         : EnvCreateInstanceIndex
+  DESCRIPTION  : Indexes the direct instances of a class and of
+                   each of its subclasses by the value of a
+                   single field slot, so that instance-set queries
+                   testing the slot with eq can look them up
+                   rather than examine every instance
+  INPUTS       : 1) The class
+                 2) The name of the slot
+  RETURNS      : True if the slot is indexed, false otherwise
+  SIDE EFFECTS : Slot indexes created
+  NOTES        : Subclasses which do not have the slot, or in
+                   which it is a shared or multifield slot, are
+                   not indexed. Neither are subclasses defined
+                   after the index is created.
+ *******************************************************************/
+bool EnvCreateInstanceIndex(
+  Environment *theEnv,
+  Defclass *cls,
+  const char *slotName)
+  {
+   SYMBOL_HN *ssym;
+   SlotDescriptor *sd;
+   int slotIndex = -1,id;
+
+   ssym = FindSymbolHN(theEnv,slotName);
+   if (ssym != NULL)
+     slotIndex = FindInstanceTemplateSlot(theEnv,cls,ssym);
+   if (slotIndex == -1)
+     {
+      SlotExistError(theEnv,slotName,"create-instance-index");
+      return false;
+     }
+
+   sd = cls->instanceTemplate[slotIndex];
+   if (sd->multiple || sd->shared)
+     {
+      PrintErrorID(theEnv,"INSCOM",2,false);
+      EnvPrintRouter(theEnv,WERROR,(sd->multiple ? "The multifield slot " : "The shared slot "));
+      EnvPrintRouter(theEnv,WERROR,slotName);
+      EnvPrintRouter(theEnv,WERROR," of class ");
+      PrintClassName(theEnv,WERROR,cls,false);
+      EnvPrintRouter(theEnv,WERROR," cannot be indexed.\n");
+      EnvSetEvaluationError(theEnv,true);
+      return false;
+     }
+
+   if ((id = GetTraversalID(theEnv)) == -1)
+     return false;
+   IndexClassSlot(theEnv,cls,ssym,id);
+   ReleaseTraversalID(theEnv);
+   return true;
+  }
+
 /* =========================================
    *****************************************
           INTERNALLY VISIBLE FUNCTIONS
@@ -1674,5 +1758,43 @@ static INSTANCE_SLOT *FindISlotByName(
    return FindInstanceSlot(theEnv,theInstance,ssym);
   }
 
+/*****************************************************
+  NAME         : IndexClassSlot
+  DESCRIPTION  : Indexes the direct instances of a
+                   class and its subclasses by a slot
+  INPUTS       : 1) The class
+                 2) The slot name
+                 3) Traversal id
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Slot indexes created
+  NOTES        : Classes in which the slot is missing,
+                   shared or multifield are skipped
+ *****************************************************/
+static void IndexClassSlot(
+  Environment *theEnv,
+  Defclass *cls,
+  SYMBOL_HN *ssym,
+  int id)
+  {
+   SlotDescriptor *sd;
+   int slotIndex;
+   long i;
+
+   if (TestTraversalID(cls->traversalRecord,id))
+     return;
+   SetTraversalID(cls->traversalRecord,id);
+
+   slotIndex = FindInstanceTemplateSlot(theEnv,cls,ssym);
+   if (slotIndex != -1)
+     {
+      sd = cls->instanceTemplate[slotIndex];
+      if ((sd->multiple == 0) && (sd->shared == 0))
+        CreateInstanceSlotIndex(theEnv,cls,ssym,slotIndex);
+     }
+
+   for (i = 0 ; i < cls->directSubclasses.classCount ; i++)
+     IndexClassSlot(theEnv,cls->directSubclasses.classArray[i],ssym,id);
+  }
+
 #endif /* OBJECT_SYSTEM */
 
@@ -57,6 +57,8 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added create-instance-index command.           */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_inscom
@@ -74,6 +76,11 @@ struct instanceData
   { 
    Instance DummyInstance;
    Instance **InstanceTable;
+   unsigned long InstanceTableSize;
+   unsigned long InstanceTableCount;
+   Instance **OldInstanceTable;
+   unsigned long OldInstanceTableSize;
+   unsigned long InstanceRehashIndex;
    bool MaintainGarbageInstances;
    bool MkInsMsgPass;
    bool ChangesToInstances;
@@ -84,6 +91,8 @@ struct instanceData
    Instance *CurrentInstance;
    Instance *InstanceListBottom;
    bool ObjectModDupMsgValid;
+   unsigned long long NextCreationIndex;
+   unsigned long SlotIndexChanges;
   };
 
 #define InstanceData(theEnv) ((struct instanceData *) GetEnvironmentData(theEnv,INSTANCE_DATA))
@@ -122,6 +131,8 @@ struct instanceData
    void                           InstancePCommand(Environment *,UDFContext *,CLIPSValue *);
    void                           InstanceExistPCommand(Environment *,UDFContext *,CLIPSValue *);
    void                           CreateInstanceHandler(Environment *,UDFContext *,CLIPSValue *);
+   void                           CreateInstanceIndexCommand(Environment *,UDFContext *,CLIPSValue *);
+   bool                           EnvCreateInstanceIndex(Environment *,Defclass *,const char *);
 
 #endif /* _H_inscom */
 
@@ -73,6 +73,15 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added slot indexes for looking up the direct   */
+/*            instances of a class by the value of a slot.   */
+/*                                                           */
+/*            The instance hash table grows with the number  */
+/*            of instances and is rehashed incrementally.    */
+/*                                                           */
+/*            Added FindInstanceSlotByID for slot references */
+/*            resolved to a slot name id when parsed.        */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -82,6 +91,7 @@
    ***************************************** */
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "setup.h"
 
@@ -104,6 +114,7 @@
 #include "msgcom.h"
 #include "msgfun.h"
 #include "prccode.h"
+#include "reteutil.h"
 #include "router.h"
 #include "utility.h"
 
@@ -114,13 +125,23 @@
                    CONSTANTS
    =========================================
    ***************************************** */
-#define BIG_PRIME    11329
+#define INSTANCE_REHASH_STEP 4
 
 /***************************************/
 /* LOCAL INTERNAL FUNCTION DEFINITIONS */
 /***************************************/
 
    static Instance               *FindImportedInstance(Environment *,Defmodule *,Defmodule *,Instance *);
+   static Instance              **InstanceTableChain(Environment *,unsigned long);
+   static void                    GrowInstanceTable(Environment *);
+   static void                    RehashInstanceTable(Environment *,unsigned long);
+   static unsigned long           HashSlotIndexValue(unsigned short,void *);
+   static void                    AddInstanceSlotIndexEntry(Environment *,INSTANCE_SLOT_INDEX *,Instance *);
+   static void                    LinkInstanceSlotIndexEntry(INSTANCE_SLOT_INDEX *,INSTANCE_SLOT_INDEX_ENTRY *);
+   static void                    UnlinkInstanceSlotIndexEntry(INSTANCE_SLOT_INDEX *,INSTANCE_SLOT_INDEX_ENTRY *);
+   static void                    UpdateInstanceSlotIndexEntries(Environment *,Instance *,INSTANCE_SLOT *);
+   static void                    ResizeInstanceSlotIndex(Environment *,INSTANCE_SLOT_INDEX *);
+   static int                     CompareCreationIndexes(const void *,const void *);
 
 #if DEFRULE_CONSTRUCT
    static void                    NetworkModifyForSharedSlot(Environment *,int,Defclass *,SlotDescriptor *);
@@ -179,19 +200,51 @@ void EnvDecrementInstanceCount(
   INPUTS       : None
   RETURNS      : Nothing useful
   SIDE EFFECTS : Hash table initialized
-  NOTES        : None
+  NOTES        : The table starts with
+                 INSTANCE_TABLE_HASH_SIZE buckets
+                 and grows with the number of
+                 instances
  ***************************************************/
 void InitializeInstanceTable(
   Environment *theEnv)
   {
-   int i;
+   unsigned long i;
 
+   InstanceData(theEnv)->InstanceTableSize = INSTANCE_TABLE_HASH_SIZE;
+   InstanceData(theEnv)->InstanceTableCount = 0;
+   InstanceData(theEnv)->OldInstanceTable = NULL;
+   InstanceData(theEnv)->OldInstanceTableSize = 0;
+   InstanceData(theEnv)->InstanceRehashIndex = 0;
    InstanceData(theEnv)->InstanceTable = (Instance **)
-                    gm2(theEnv,(int) (sizeof(Instance *) * INSTANCE_TABLE_HASH_SIZE));
+                    gm3(theEnv,(sizeof(Instance *) * INSTANCE_TABLE_HASH_SIZE));
    for (i = 0 ; i < INSTANCE_TABLE_HASH_SIZE ; i++)
      InstanceData(theEnv)->InstanceTable[i] = NULL;
   }
 
+/***************************************************
+  NAME         : ReturnInstanceTable
+  DESCRIPTION  : Deallocates the instance hash
+                  table
+  INPUTS       : None
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Hash table (and the table being
+                 rehashed, if any) deallocated
+  NOTES        : The instances are not deallocated
+ ***************************************************/
+void ReturnInstanceTable(
+  Environment *theEnv)
+  {
+   if (InstanceData(theEnv)->OldInstanceTable != NULL)
+     {
+      rm3(theEnv,InstanceData(theEnv)->OldInstanceTable,
+          (sizeof(Instance *) * InstanceData(theEnv)->OldInstanceTableSize));
+      InstanceData(theEnv)->OldInstanceTable = NULL;
+     }
+   rm3(theEnv,InstanceData(theEnv)->InstanceTable,
+       (sizeof(Instance *) * InstanceData(theEnv)->InstanceTableSize));
+   InstanceData(theEnv)->InstanceTable = NULL;
+  }
+
 /*******************************************************
   NAME         : CleanupInstances
   DESCRIPTION  : Iterates through instance garbage
@@ -241,23 +294,128 @@ void CleanupInstances(
 
 /*******************************************************
   NAME         : HashInstance
-  DESCRIPTION  : Generates a hash index for a given
+  DESCRIPTION  : Generates a hash value for a given
                  instance name
   INPUTS       : The address of the instance name SYMBOL_HN
-  RETURNS      : The hash index value
+  RETURNS      : The hash value
   SIDE EFFECTS : None
   NOTES        : Counts on the fact that the symbol
                  has already been hashed into the
-                 symbol table - uses that hash value
-                 multiplied by a prime for a new hash
+                 symbol table - each name has exactly
+                 one symbol, so its address is mixed
+                 for the hash value. The symbol
+                 table's bucket has too few distinct
+                 values for a large instance table.
  *******************************************************/
-unsigned HashInstance(
+unsigned long HashInstance(
   SYMBOL_HN *cname)
   {
-   unsigned long tally;
+   union
+     {
+      SYMBOL_HN *hv;
+      unsigned long long liv;
+     } fis;
 
-   tally = ((unsigned long) cname->bucket) * BIG_PRIME;
-   return((unsigned) (tally % INSTANCE_TABLE_HASH_SIZE));
+   fis.liv = 0;
+   fis.hv = cname;
+   return((unsigned long) FoldJoinHashValue(fis.liv));
+  }
+
+/*******************************************************
+  NAME         : FindInstanceInTable
+  DESCRIPTION  : Finds the first instance of a given
+                 name in the instance hash table
+  INPUTS       : The instance name (no module)
+  RETURNS      : The instance, NULL if not found
+  SIDE EFFECTS : None
+  NOTES        : Instances of the same name are
+                 adjacent in their hash chain
+ *******************************************************/
+Instance *FindInstanceInTable(
+  Environment *theEnv,
+  SYMBOL_HN *instanceName)
+  {
+   Instance *ins;
+
+   ins = *InstanceTableChain(theEnv,HashInstance(instanceName));
+   while (ins != NULL)
+     {
+      if (ins->name == instanceName)
+        return(ins);
+      ins = ins->nxtHash;
+     }
+   return NULL;
+  }
+
+/*******************************************************
+  NAME         : AddInstanceToTable
+  DESCRIPTION  : Puts an instance in the instance
+                 hash table
+  INPUTS       : The instance
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Instance linked at the top of its
+                 hash chain
+                 The table is grown once it holds
+                 more instances than buckets
+  NOTES        : The instance must not be in the
+                 table already
+ *******************************************************/
+void AddInstanceToTable(
+  Environment *theEnv,
+  Instance *ins)
+  {
+   Instance **chain;
+
+   if (InstanceData(theEnv)->OldInstanceTable != NULL)
+     RehashInstanceTable(theEnv,INSTANCE_REHASH_STEP);
+   else if (InstanceData(theEnv)->InstanceTableCount >= InstanceData(theEnv)->InstanceTableSize)
+     GrowInstanceTable(theEnv);
+
+   ins->hashValue = HashInstance(ins->name);
+   chain = InstanceTableChain(theEnv,ins->hashValue);
+   ins->prvHash = NULL;
+   ins->nxtHash = *chain;
+   if (*chain != NULL)
+     (*chain)->prvHash = ins;
+   *chain = ins;
+   InstanceData(theEnv)->InstanceTableCount++;
+  }
+
+/*******************************************************
+  NAME         : RemoveInstanceFromTable
+  DESCRIPTION  : Takes an instance out of the
+                 instance hash table
+  INPUTS       : The instance
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Instance unlinked from its chain
+                 The table returns to its initial
+                 size once it is empty
+  NOTES        : None
+ *******************************************************/
+void RemoveInstanceFromTable(
+  Environment *theEnv,
+  Instance *ins)
+  {
+   if (ins->prvHash != NULL)
+     ins->prvHash->nxtHash = ins->nxtHash;
+   else
+     *InstanceTableChain(theEnv,ins->hashValue) = ins->nxtHash;
+   if (ins->nxtHash != NULL)
+     ins->nxtHash->prvHash = ins->prvHash;
+   ins->prvHash = NULL;
+   ins->nxtHash = NULL;
+
+   InstanceData(theEnv)->InstanceTableCount--;
+   if (InstanceData(theEnv)->InstanceTableCount == 0)
+     {
+      if (InstanceData(theEnv)->InstanceTableSize != INSTANCE_TABLE_HASH_SIZE)
+        {
+         ReturnInstanceTable(theEnv);
+         InitializeInstanceTable(theEnv);
+        }
+     }
+   else if (InstanceData(theEnv)->OldInstanceTable != NULL)
+     RehashInstanceTable(theEnv,INSTANCE_REHASH_STEP);
   }
 
 /***************************************************
@@ -377,16 +535,7 @@ Instance *FindInstanceBySymbol(
       instanceName = moduleAndInstanceName;
       searchImports = false;
       */
-      Instance *ins;
-
-      ins = InstanceData(theEnv)->InstanceTable[HashInstance(moduleAndInstanceName)];
-      while (ins != NULL)
-        {
-         if (ins->name == moduleAndInstanceName)
-           { return ins; }
-         ins = ins->nxtHash;
-        }
-      return NULL;
+      return(FindInstanceInTable(theEnv,moduleAndInstanceName));
      }
 
    /* =========================================
@@ -449,14 +598,7 @@ Instance *FindInstanceInModule(
       Find the first instance of the
       correct name in the hash chain
       =============================== */
-   startInstance = InstanceData(theEnv)->InstanceTable[HashInstance(instanceName)];
-   while (startInstance != NULL)
-     {
-      if (startInstance->name == instanceName)
-        break;
-      startInstance = startInstance->nxtHash;
-     }
-
+   startInstance = FindInstanceInTable(theEnv,instanceName);
    if (startInstance == NULL)
      return NULL;
 
@@ -504,6 +646,43 @@ INSTANCE_SLOT *FindInstanceSlot(
    return((i != -1) ? ins->slotAddresses[i] : NULL);
   }
 
+/********************************************************************
+  NAME         : FindInstanceSlotByID
+  DESCRIPTION  : Finds an instance slot by the id its name
+                   was given when a reference to it was parsed
+  INPUTS       : 1) The address of the instance
+                 2) The symbolic name of the slot
+                 3) The slot name id
+  RETURNS      : The address of the slot, NULL if not found
+  SIDE EFFECTS : None
+  NOTES        : Slot name ids are reused once no class has
+                   the name any more, so the slot must still
+                   have the name. Otherwise (e.g. the class
+                   has been redefined) the slot is looked up
+                   by name.
+ ********************************************************************/
+INSTANCE_SLOT *FindInstanceSlotByID(
+  Environment *theEnv,
+  Instance *ins,
+  SYMBOL_HN *sname,
+  int sid)
+  {
+   unsigned i;
+   INSTANCE_SLOT *sp;
+
+   if ((sid >= 0) && (sid <= (int) ins->cls->maxSlotNameID))
+     {
+      i = ins->cls->slotNameMap[sid];
+      if (i != 0)
+        {
+         sp = ins->slotAddresses[i - 1];
+         if (sp->desc->slotName->name == sname)
+           return(sp);
+        }
+     }
+   return(FindInstanceSlot(theEnv,ins,sname));
+  }
+
 /********************************************************************
   NAME         : FindInstanceTemplateSlot
   DESCRIPTION  : Performs a search on an class's instance
@@ -679,6 +858,8 @@ bool DirectPutSlotValue(
       AtomInstall(theEnv,(int) sp->type,sp->value);
       SetpType(setVal,sp->type);
       SetpValue(setVal,sp->value);
+      if (ins->slotIndexEntries != NULL)
+        UpdateInstanceSlotIndexEntries(theEnv,ins,sp);
      }
    else
      {
@@ -1262,12 +1443,338 @@ bool InstanceIsDeleted(
   }
 #endif
 
+/*******************************************************************
+  NAME         : CreateInstanceSlotIndex
+  DESCRIPTION  : Creates an index of the direct instances of a
+                   class by the value of one of its single field
+                   slots and adds the existing instances to it
+  INPUTS       : 1) The class
+                 2) The slot name
+                 3) The position of the slot in the instance
+                      template of the class
+  RETURNS      : The index (the slot's existing index if it
+                   already has one)
+  SIDE EFFECTS : Index allocated
+  NOTES        : The index is maintained as instances are
+                   created and deleted and as the slot is
+                   changed by DirectPutSlotValue
+ *******************************************************************/
+INSTANCE_SLOT_INDEX *CreateInstanceSlotIndex(
+  Environment *theEnv,
+  Defclass *cls,
+  SYMBOL_HN *slotName,
+  int slotPosition)
+  {
+   INSTANCE_SLOT_INDEX *theIndex;
+   Instance *ins;
+
+   theIndex = FindInstanceSlotIndex(cls,slotName);
+   if (theIndex != NULL)
+     return(theIndex);
+
+   /* =========================================
+      The slot name symbol is held by the class
+      for as long as the index exists
+      ========================================= */
+   theIndex = get_struct(theEnv,instanceSlotIndex);
+   theIndex->slotName = slotName;
+   theIndex->slotPosition = slotPosition;
+   theIndex->count = 0;
+   theIndex->size = SIZE_INSTANCE_SLOT_INDEX_HASH;
+   theIndex->table = (INSTANCE_SLOT_INDEX_ENTRY **)
+                     gm2(theEnv,(sizeof(INSTANCE_SLOT_INDEX_ENTRY *) * theIndex->size));
+   memset(theIndex->table,0,(sizeof(INSTANCE_SLOT_INDEX_ENTRY *) * theIndex->size));
+   theIndex->nxt = cls->slotIndexes;
+   cls->slotIndexes = theIndex;
+
+   for (ins = cls->instanceList ; ins != NULL ; ins = ins->nxtClass)
+     AddInstanceSlotIndexEntry(theEnv,theIndex,ins);
+
+   InstanceData(theEnv)->SlotIndexChanges++;
+   return(theIndex);
+  }
+
+/***************************************************
+  NAME         : FindInstanceSlotIndex
+  DESCRIPTION  : Finds the index of a slot of a
+                   class
+  INPUTS       : 1) The class
+                 2) The slot name
+  RETURNS      : The index, NULL if the slot has
+                   no index in the class
+  SIDE EFFECTS : None
+  NOTES        : None
+ ***************************************************/
+INSTANCE_SLOT_INDEX *FindInstanceSlotIndex(
+  Defclass *cls,
+  SYMBOL_HN *slotName)
+  {
+   INSTANCE_SLOT_INDEX *theIndex;
+
+   for (theIndex = cls->slotIndexes ; theIndex != NULL ; theIndex = theIndex->nxt)
+     {
+      if (theIndex->slotName == slotName)
+        return(theIndex);
+     }
+   return NULL;
+  }
+
+/*******************************************************************
+  NAME         : FindIndexedInstances
+  DESCRIPTION  : Looks up the instances whose indexed slot holds
+                   a value which is eq to a specified value
+  INPUTS       : 1) The index
+                 2) The type of the value
+                 3) The value
+                 4) Caller's buffer for the instance array
+  RETURNS      : The number of instances found
+  SIDE EFFECTS : Array allocated with gm2 (NULL if there are
+                   no instances)
+  NOTES        : The instances are returned in the order of
+                   their class's instance list
+ *******************************************************************/
+unsigned long FindIndexedInstances(
+  Environment *theEnv,
+  INSTANCE_SLOT_INDEX *theIndex,
+  unsigned short type,
+  void *value,
+  Instance ***theInstances)
+  {
+   INSTANCE_SLOT_INDEX_ENTRY *theEntry,*bucket;
+   INSTANCE_SLOT *sp;
+   unsigned long hashValue,count = 0;
+
+   *theInstances = NULL;
+   if (type == MULTIFIELD)
+     return(0L);
+
+   hashValue = HashSlotIndexValue(type,value);
+   bucket = theIndex->table[hashValue & (theIndex->size - 1)];
+
+   for (theEntry = bucket ; theEntry != NULL ; theEntry = theEntry->nxt)
+     {
+      sp = theEntry->ins->slotAddresses[theIndex->slotPosition];
+      if ((theEntry->hashValue == hashValue) && (sp->type == type) && (sp->value == value))
+        count++;
+     }
+   if (count == 0)
+     return(0L);
+
+   /* ==========================================
+      A bucket holds its entries in no order, so
+      the matches are sorted by creation index
+      ========================================== */
+   *theInstances = (Instance **) gm2(theEnv,(sizeof(Instance *) * count));
+   count = 0;
+   for (theEntry = bucket ; theEntry != NULL ; theEntry = theEntry->nxt)
+     {
+      sp = theEntry->ins->slotAddresses[theIndex->slotPosition];
+      if ((theEntry->hashValue == hashValue) && (sp->type == type) && (sp->value == value))
+        (*theInstances)[count++] = theEntry->ins;
+     }
+   if (count > 1)
+     qsort(*theInstances,count,sizeof(Instance *),CompareCreationIndexes);
+   return(count);
+  }
+
+/***************************************************
+  NAME         : AddInstanceSlotIndexEntries
+  DESCRIPTION  : Adds a new instance to the slot
+                   indexes of its class
+  INPUTS       : The instance
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Index entries allocated
+  NOTES        : Called once the instance is on
+                   its class's instance list
+ ***************************************************/
+void AddInstanceSlotIndexEntries(
+  Environment *theEnv,
+  Instance *ins)
+  {
+   INSTANCE_SLOT_INDEX *theIndex;
+
+   ins->slotIndexEntries = NULL;
+   if (ins->cls->slotIndexes == NULL)
+     return;
+   for (theIndex = ins->cls->slotIndexes ; theIndex != NULL ; theIndex = theIndex->nxt)
+     AddInstanceSlotIndexEntry(theEnv,theIndex,ins);
+   InstanceData(theEnv)->SlotIndexChanges++;
+  }
+
+/***************************************************
+  NAME         : RemoveInstanceSlotIndexEntries
+  DESCRIPTION  : Removes an instance being deleted
+                   from the slot indexes it is in
+  INPUTS       : The instance
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Index entries deallocated
+  NOTES        : None
+ ***************************************************/
+void RemoveInstanceSlotIndexEntries(
+  Environment *theEnv,
+  Instance *ins)
+  {
+   INSTANCE_SLOT_INDEX_ENTRY *theEntry,*nxtEntry;
+
+   if (ins->slotIndexEntries == NULL)
+     return;
+   for (theEntry = ins->slotIndexEntries ; theEntry != NULL ; theEntry = nxtEntry)
+     {
+      nxtEntry = theEntry->nxtForInstance;
+      UnlinkInstanceSlotIndexEntry(theEntry->index,theEntry);
+      theEntry->index->count--;
+      rtn_struct(theEnv,instanceSlotIndexEntry,theEntry);
+     }
+   ins->slotIndexEntries = NULL;
+   InstanceData(theEnv)->SlotIndexChanges++;
+  }
+
+/***************************************************
+  NAME         : ReturnInstanceSlotIndexes
+  DESCRIPTION  : Deallocates the slot indexes of
+                   a class
+  INPUTS       : The class
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Indexes and any entries left in
+                   them deallocated
+  NOTES        : Entries are only left when the
+                   environment is being destroyed
+ ***************************************************/
+void ReturnInstanceSlotIndexes(
+  Environment *theEnv,
+  Defclass *cls)
+  {
+   INSTANCE_SLOT_INDEX *theIndex,*nxtIndex;
+   INSTANCE_SLOT_INDEX_ENTRY *theEntry,*nxtEntry;
+   unsigned long i;
+
+   for (theIndex = cls->slotIndexes ; theIndex != NULL ; theIndex = nxtIndex)
+     {
+      nxtIndex = theIndex->nxt;
+      for (i = 0 ; i < theIndex->size ; i++)
+        {
+         for (theEntry = theIndex->table[i] ; theEntry != NULL ; theEntry = nxtEntry)
+           {
+            nxtEntry = theEntry->nxt;
+            rtn_struct(theEnv,instanceSlotIndexEntry,theEntry);
+           }
+        }
+      rm(theEnv,theIndex->table,(sizeof(INSTANCE_SLOT_INDEX_ENTRY *) * theIndex->size));
+      rtn_struct(theEnv,instanceSlotIndex,theIndex);
+     }
+   cls->slotIndexes = NULL;
+  }
+
 /* =========================================
    *****************************************
           INTERNALLY VISIBLE FUNCTIONS
    =========================================
    ***************************************** */
 
+/*******************************************************
+  NAME         : InstanceTableChain
+  DESCRIPTION  : Determines which hash chain holds
+                 the instances with a given hash value
+  INPUTS       : The hash value
+  RETURNS      : The address of the top of the chain
+  SIDE EFFECTS : None
+  NOTES        : While the table is being rehashed,
+                 the chains of the old table which
+                 have not been moved yet are used
+ *******************************************************/
+static Instance **InstanceTableChain(
+  Environment *theEnv,
+  unsigned long hashValue)
+  {
+   unsigned long oldBucket;
+
+   if (InstanceData(theEnv)->OldInstanceTable != NULL)
+     {
+      oldBucket = hashValue & (InstanceData(theEnv)->OldInstanceTableSize - 1);
+      if (oldBucket >= InstanceData(theEnv)->InstanceRehashIndex)
+        return(&InstanceData(theEnv)->OldInstanceTable[oldBucket]);
+     }
+   return(&InstanceData(theEnv)->InstanceTable[hashValue & (InstanceData(theEnv)->InstanceTableSize - 1)]);
+  }
+
+/*******************************************************
+  NAME         : GrowInstanceTable
+  DESCRIPTION  : Starts moving the instances to a
+                 hash table twice the size
+  INPUTS       : None
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : New table allocated and the current
+                 one kept as the table being rehashed
+  NOTES        : The chains of the old table are moved
+                 a few at a time as instances are added
+                 and removed, so no single operation
+                 pays for moving every instance
+ *******************************************************/
+static void GrowInstanceTable(
+  Environment *theEnv)
+  {
+   unsigned long i,newSize;
+
+   newSize = InstanceData(theEnv)->InstanceTableSize * 2;
+
+   InstanceData(theEnv)->OldInstanceTable = InstanceData(theEnv)->InstanceTable;
+   InstanceData(theEnv)->OldInstanceTableSize = InstanceData(theEnv)->InstanceTableSize;
+   InstanceData(theEnv)->InstanceRehashIndex = 0;
+
+   InstanceData(theEnv)->InstanceTable = (Instance **) gm3(theEnv,(sizeof(Instance *) * newSize));
+   for (i = 0 ; i < newSize ; i++)
+     InstanceData(theEnv)->InstanceTable[i] = NULL;
+   InstanceData(theEnv)->InstanceTableSize = newSize;
+  }
+
+/*******************************************************
+  NAME         : RehashInstanceTable
+  DESCRIPTION  : Moves the instances in some of the
+                 chains of the old table to the new
+                 table
+  INPUTS       : The number of old chains to move
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Instances moved and the old table
+                 deallocated once it is empty
+  NOTES        : Instances of the same name are moved
+                 together and stay adjacent in their
+                 new chain
+ *******************************************************/
+static void RehashInstanceTable(
+  Environment *theEnv,
+  unsigned long count)
+  {
+   Instance *ins,*nxt,**chain;
+
+   while ((count-- > 0) &&
+          (InstanceData(theEnv)->InstanceRehashIndex < InstanceData(theEnv)->OldInstanceTableSize))
+     {
+      ins = InstanceData(theEnv)->OldInstanceTable[InstanceData(theEnv)->InstanceRehashIndex];
+      InstanceData(theEnv)->OldInstanceTable[InstanceData(theEnv)->InstanceRehashIndex] = NULL;
+      InstanceData(theEnv)->InstanceRehashIndex++;
+      while (ins != NULL)
+        {
+         nxt = ins->nxtHash;
+         chain = &InstanceData(theEnv)->InstanceTable[ins->hashValue & (InstanceData(theEnv)->InstanceTableSize - 1)];
+         ins->prvHash = NULL;
+         ins->nxtHash = *chain;
+         if (*chain != NULL)
+           (*chain)->prvHash = ins;
+         *chain = ins;
+         ins = nxt;
+        }
+     }
+
+   if (InstanceData(theEnv)->InstanceRehashIndex >= InstanceData(theEnv)->OldInstanceTableSize)
+     {
+      rm3(theEnv,InstanceData(theEnv)->OldInstanceTable,
+          (sizeof(Instance *) * InstanceData(theEnv)->OldInstanceTableSize));
+      InstanceData(theEnv)->OldInstanceTable = NULL;
+      InstanceData(theEnv)->OldInstanceTableSize = 0;
+      InstanceData(theEnv)->InstanceRehashIndex = 0;
+     }
+  }
+
 /*****************************************************
   NAME         : FindImportedInstance
   DESCRIPTION  : Searches imported modules for an
@@ -1325,6 +1832,197 @@ static Instance *FindImportedInstance(
    return NULL;
   }
 
+/***************************************************
+  NAME         : HashSlotIndexValue
+  DESCRIPTION  : Computes the hash value of a slot
+                   value for a slot index
+  INPUTS       : 1) The type of the value
+                 2) The value
+  RETURNS      : The hash value
+  SIDE EFFECTS : None
+  NOTES        : Values are hashed as they are in
+                   the join network, so values which
+                   are eq have the same hash value
+ ***************************************************/
+static unsigned long HashSlotIndexValue(
+  unsigned short type,
+  void *value)
+  {
+   CLIPSValue theValue;
+
+   theValue.type = type;
+   theValue.value = value;
+   return(FoldJoinHashValue(AddJoinHashValue(0,&theValue)));
+  }
+
+/***************************************************
+  NAME         : AddInstanceSlotIndexEntry
+  DESCRIPTION  : Adds an instance to a slot index
+  INPUTS       : 1) The index
+                 2) The instance
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Entry allocated
+                 The table is doubled in size when
+                   it holds as many entries as it
+                   has buckets
+  NOTES        : None
+ ***************************************************/
+static void AddInstanceSlotIndexEntry(
+  Environment *theEnv,
+  INSTANCE_SLOT_INDEX *theIndex,
+  Instance *ins)
+  {
+   INSTANCE_SLOT_INDEX_ENTRY *theEntry;
+   INSTANCE_SLOT *sp;
+
+   if (theIndex->count >= theIndex->size)
+     ResizeInstanceSlotIndex(theEnv,theIndex);
+
+   sp = ins->slotAddresses[theIndex->slotPosition];
+   theEntry = get_struct(theEnv,instanceSlotIndexEntry);
+   theEntry->ins = ins;
+   theEntry->index = theIndex;
+   theEntry->hashValue = HashSlotIndexValue(sp->type,sp->value);
+   LinkInstanceSlotIndexEntry(theIndex,theEntry);
+   theEntry->nxtForInstance = ins->slotIndexEntries;
+   ins->slotIndexEntries = theEntry;
+   theIndex->count++;
+  }
+
+/***************************************************
+  NAME         : LinkInstanceSlotIndexEntry
+  DESCRIPTION  : Puts an entry at the head of the
+                   bucket for its hash value
+  INPUTS       : 1) The index
+                 2) The entry
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Bucket chain updated
+  NOTES        : None
+ ***************************************************/
+static void LinkInstanceSlotIndexEntry(
+  INSTANCE_SLOT_INDEX *theIndex,
+  INSTANCE_SLOT_INDEX_ENTRY *theEntry)
+  {
+   INSTANCE_SLOT_INDEX_ENTRY **bucket;
+
+   bucket = &theIndex->table[theEntry->hashValue & (theIndex->size - 1)];
+   theEntry->prv = NULL;
+   theEntry->nxt = *bucket;
+   if (*bucket != NULL)
+     (*bucket)->prv = theEntry;
+   *bucket = theEntry;
+  }
+
+/***************************************************
+  NAME         : UnlinkInstanceSlotIndexEntry
+  DESCRIPTION  : Removes an entry from its bucket
+  INPUTS       : 1) The index
+                 2) The entry
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Bucket chain updated
+  NOTES        : None
+ ***************************************************/
+static void UnlinkInstanceSlotIndexEntry(
+  INSTANCE_SLOT_INDEX *theIndex,
+  INSTANCE_SLOT_INDEX_ENTRY *theEntry)
+  {
+   if (theEntry->prv == NULL)
+     theIndex->table[theEntry->hashValue & (theIndex->size - 1)] = theEntry->nxt;
+   else
+     theEntry->prv->nxt = theEntry->nxt;
+   if (theEntry->nxt != NULL)
+     theEntry->nxt->prv = theEntry->prv;
+  }
+
+/*****************************************************
+  NAME         : UpdateInstanceSlotIndexEntries
+  DESCRIPTION  : Moves an instance to the bucket for
+                   the new value of a slot in the
+                   index of that slot
+  INPUTS       : 1) The instance
+                 2) The slot which has been changed
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Entry moved
+  NOTES        : Shared and multifield slots are
+                   never indexed
+ *****************************************************/
+static void UpdateInstanceSlotIndexEntries(
+  Environment *theEnv,
+  Instance *ins,
+  INSTANCE_SLOT *sp)
+  {
+   INSTANCE_SLOT_INDEX_ENTRY *theEntry;
+
+   for (theEntry = ins->slotIndexEntries ; theEntry != NULL ; theEntry = theEntry->nxtForInstance)
+     {
+      if (ins->slotAddresses[theEntry->index->slotPosition] != sp)
+        continue;
+      UnlinkInstanceSlotIndexEntry(theEntry->index,theEntry);
+      theEntry->hashValue = HashSlotIndexValue(sp->type,sp->value);
+      LinkInstanceSlotIndexEntry(theEntry->index,theEntry);
+      InstanceData(theEnv)->SlotIndexChanges++;
+     }
+  }
+
+/***************************************************
+  NAME         : ResizeInstanceSlotIndex
+  DESCRIPTION  : Doubles the number of buckets in a
+                   slot index
+  INPUTS       : The index
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Table reallocated and each entry
+                   moved to its new bucket
+  NOTES        : None
+ ***************************************************/
+static void ResizeInstanceSlotIndex(
+  Environment *theEnv,
+  INSTANCE_SLOT_INDEX *theIndex)
+  {
+   INSTANCE_SLOT_INDEX_ENTRY **oldTable,*theEntry,*nxtEntry;
+   unsigned long i,oldSize;
+
+   oldTable = theIndex->table;
+   oldSize = theIndex->size;
+   theIndex->size = oldSize * 2;
+   theIndex->table = (INSTANCE_SLOT_INDEX_ENTRY **)
+                     gm2(theEnv,(sizeof(INSTANCE_SLOT_INDEX_ENTRY *) * theIndex->size));
+   memset(theIndex->table,0,(sizeof(INSTANCE_SLOT_INDEX_ENTRY *) * theIndex->size));
+
+   for (i = 0 ; i < oldSize ; i++)
+     {
+      for (theEntry = oldTable[i] ; theEntry != NULL ; theEntry = nxtEntry)
+        {
+         nxtEntry = theEntry->nxt;
+         LinkInstanceSlotIndexEntry(theIndex,theEntry);
+        }
+     }
+   rm(theEnv,oldTable,(sizeof(INSTANCE_SLOT_INDEX_ENTRY *) * oldSize));
+  }
+
+/***************************************************
+  NAME         : CompareCreationIndexes
+  DESCRIPTION  : Orders instances by the order in
+                   which they were created
+  INPUTS       : The addresses of the two instances
+  RETURNS      : <0, 0 or >0 as for qsort
+  SIDE EFFECTS : None
+  NOTES        : Instances are appended to their
+                   class's instance list when created
+ ***************************************************/
+static int CompareCreationIndexes(
+  const void *i1,
+  const void *i2)
+  {
+   unsigned long long c1 = (*(Instance * const *) i1)->creationIndex;
+   unsigned long long c2 = (*(Instance * const *) i2)->creationIndex;
+
+   if (c1 < c2)
+     return -1;
+   if (c1 > c2)
+     return 1;
+   return 0;
+  }
+
 #if DEFRULE_CONSTRUCT
 
 /*****************************************************
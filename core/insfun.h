@@ -68,6 +68,15 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added slot indexes for looking up the direct   */
+/*            instances of a class by the value of a slot.   */
+/*                                                           */
+/*            The instance hash table grows with the number  */
+/*            of instances and is rehashed incrementally.    */
+/*                                                           */
+/*            Added FindInstanceSlotByID for slot references */
+/*            resolved to a slot name id when parsed.        */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_insfun
@@ -87,20 +96,32 @@ typedef struct igarbage
    struct igarbage *nxt;
   } IGARBAGE;
 
-#define INSTANCE_TABLE_HASH_SIZE 8191
+#ifndef INSTANCE_TABLE_HASH_SIZE
+#define INSTANCE_TABLE_HASH_SIZE 8192
+#endif
+
 #define InstanceSizeHeuristic(ins)      sizeof(Instance)
 
+#ifndef SIZE_INSTANCE_SLOT_INDEX_HASH
+#define SIZE_INSTANCE_SLOT_INDEX_HASH 16
+#endif
+
    void                           EnvIncrementInstanceCount(Environment *,Instance *);
    void                           EnvDecrementInstanceCount(Environment *,Instance *);
    void                           InitializeInstanceTable(Environment *);
+   void                           ReturnInstanceTable(Environment *);
    void                           CleanupInstances(Environment *);
-   unsigned                       HashInstance(SYMBOL_HN *);
+   unsigned long                  HashInstance(SYMBOL_HN *);
+   Instance                      *FindInstanceInTable(Environment *,SYMBOL_HN *);
+   void                           AddInstanceToTable(Environment *,Instance *);
+   void                           RemoveInstanceFromTable(Environment *,Instance *);
    void                           DestroyAllInstances(Environment *);
    void                           RemoveInstanceData(Environment *,Instance *);
    Instance                      *FindInstanceBySymbol(Environment *,SYMBOL_HN *);
    Instance                      *FindInstanceInModule(Environment *,SYMBOL_HN *,Defmodule *,
                                                        Defmodule *,bool);
    INSTANCE_SLOT                 *FindInstanceSlot(Environment *,Instance *,SYMBOL_HN *);
+   INSTANCE_SLOT                 *FindInstanceSlotByID(Environment *,Instance *,SYMBOL_HN *,int);
    int                            FindInstanceTemplateSlot(Environment *,Defclass *,SYMBOL_HN *);
    bool                           PutSlotValue(Environment *,Instance *,INSTANCE_SLOT *,CLIPSValue *,CLIPSValue *,const char *);
    bool                           DirectPutSlotValue(Environment *,Instance *,INSTANCE_SLOT *,CLIPSValue *,CLIPSValue *);
@@ -121,6 +142,12 @@ typedef struct igarbage
    bool                           NetworkSynchronized(Environment *,Instance *);
    bool                           InstanceIsDeleted(Environment *,Instance *);
 #endif
+   INSTANCE_SLOT_INDEX           *CreateInstanceSlotIndex(Environment *,Defclass *,SYMBOL_HN *,int);
+   INSTANCE_SLOT_INDEX           *FindInstanceSlotIndex(Defclass *,SYMBOL_HN *);
+   unsigned long                  FindIndexedInstances(Environment *,INSTANCE_SLOT_INDEX *,unsigned short,void *,Instance ***);
+   void                           AddInstanceSlotIndexEntries(Environment *,Instance *);
+   void                           RemoveInstanceSlotIndexEntries(Environment *,Instance *);
+   void                           ReturnInstanceSlotIndexes(Environment *,Defclass *);
 
 #endif /* _H_insfun */
 
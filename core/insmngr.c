@@ -51,6 +51,12 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Instances are added to and removed from the    */
+/*            slot indexes of their class.                   */
+/*                                                           */
+/*            Removed InstanceLocationInfo. The instance     */
+/*            hash table is updated through insfun.c.        */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -102,8 +108,6 @@
 /***************************************/
 
    static Instance               *NewInstance(Environment *);
-   static Instance               *InstanceLocationInfo(Environment *,Defclass *,SYMBOL_HN *,Instance **,
-                                                       unsigned *);
    static void                    InstallInstance(Environment *,Instance *,bool);
    static void                    BuildDefaultSlots(Environment *,bool);
    static bool                    CoreInitializeInstance(Environment *,Instance *,EXPRESSION *);
@@ -293,8 +297,7 @@ Instance *BuildInstance(
   Defclass *cls,
   bool initMessage)
   {
-   Instance *ins,*iprv;
-   unsigned hashTableIndex;
+   Instance *ins;
    unsigned modulePosition;
    SYMBOL_HN *moduleName;
    CLIPSValue temp;
@@ -332,7 +335,7 @@ Instance *BuildInstance(
         }
       iname = ExtractConstructName(theEnv,modulePosition,ValueToString(iname));
      }
-   ins = InstanceLocationInfo(theEnv,cls,iname,&iprv,&hashTableIndex);
+   ins = FindInstanceInTable(theEnv,iname);
       
    if (ins != NULL)
      {
@@ -408,22 +411,7 @@ Instance *BuildInstance(
       Put the instance in the instance hash table and put it on its
         class's instance list
       ============================================================ */
-   InstanceData(theEnv)->CurrentInstance->hashTableIndex = hashTableIndex;
-   if (iprv == NULL)
-     {
-      InstanceData(theEnv)->CurrentInstance->nxtHash = InstanceData(theEnv)->InstanceTable[hashTableIndex];
-      if (InstanceData(theEnv)->InstanceTable[hashTableIndex] != NULL)
-        InstanceData(theEnv)->InstanceTable[hashTableIndex]->prvHash = InstanceData(theEnv)->CurrentInstance;
-      InstanceData(theEnv)->InstanceTable[hashTableIndex] = InstanceData(theEnv)->CurrentInstance;
-     }
-   else
-     {
-      InstanceData(theEnv)->CurrentInstance->nxtHash = iprv->nxtHash;
-      if (iprv->nxtHash != NULL)
-        iprv->nxtHash->prvHash = InstanceData(theEnv)->CurrentInstance;
-      iprv->nxtHash = InstanceData(theEnv)->CurrentInstance;
-      InstanceData(theEnv)->CurrentInstance->prvHash = iprv;
-     }
+   AddInstanceToTable(theEnv,InstanceData(theEnv)->CurrentInstance);
 
    /* ======================================
       Put instance in global and class lists
@@ -442,6 +430,8 @@ Instance *BuildInstance(
    InstanceData(theEnv)->CurrentInstance->prvList = InstanceData(theEnv)->InstanceListBottom;
    InstanceData(theEnv)->InstanceListBottom = InstanceData(theEnv)->CurrentInstance;
    InstanceData(theEnv)->ChangesToInstances = true;
+   InstanceData(theEnv)->CurrentInstance->creationIndex = InstanceData(theEnv)->NextCreationIndex++;
+   AddInstanceSlotIndexEntries(theEnv,InstanceData(theEnv)->CurrentInstance);
 
    /* ==============================================================================
       Install the instance's name and slot-value symbols (prevent them from becoming
@@ -555,12 +545,7 @@ bool QuashInstance(
      ObjectNetworkAction(theEnv,OBJECT_RETRACT,(Instance *) ins,-1);
 #endif
 
-   if (ins->prvHash != NULL)
-     ins->prvHash->nxtHash = ins->nxtHash;
-   else
-     InstanceData(theEnv)->InstanceTable[ins->hashTableIndex] = ins->nxtHash;
-   if (ins->nxtHash != NULL)
-     ins->nxtHash->prvHash = ins->prvHash;
+   RemoveInstanceFromTable(theEnv,ins);
 
    if (ins->prvClass != NULL)
      ins->prvClass->nxtClass = ins->nxtClass;
@@ -570,6 +555,7 @@ bool QuashInstance(
      ins->nxtClass->prvClass = ins->prvClass;
    else
      ins->cls->instanceListBottom = ins->prvClass;
+   RemoveInstanceSlotIndexEntries(theEnv,ins);
 
    if (ins->prvList != NULL)
      ins->prvList->nxtList = ins->nxtList;
@@ -711,7 +697,7 @@ static Instance *NewInstance(
    instance->initSlotsCalled = 0;
    instance->initializeInProgress = 0;
    instance->name = NULL;
-   instance->hashTableIndex = 0;
+   instance->hashValue = 0;
    instance->cls = NULL;
    instance->slots = NULL;
    instance->slotAddresses = NULL;
@@ -721,68 +707,12 @@ static Instance *NewInstance(
    instance->nxtHash = NULL;
    instance->prvList = NULL;
    instance->nxtList = NULL;
+   instance->creationIndex = 0;
+   instance->slotIndexEntries = NULL;
+   instance->matchAction = NULL;
    return(instance);
   }
 
-/*****************************************************************
-  NAME         : InstanceLocationInfo
-  DESCRIPTION  : Determines where a specified instance belongs
-                   in the instance hash table
-  INPUTS       : 1) The class of the new instance
-                 2) The symbol for the name of the instance
-                 3) Caller's buffer for previous node address
-                 4) Caller's buffer for hash value
-  RETURNS      : The address of the found instance, NULL otherwise
-  SIDE EFFECTS : None
-  NOTES        : Instance names only have to be unique within
-                 a module.
-                 Change: instance names must be unique regardless
-                 of module.
- *****************************************************************/
-static Instance *InstanceLocationInfo(
-  Environment *theEnv,
-  Defclass *cls,
-  SYMBOL_HN *iname,
-  Instance **prv,
-  unsigned *hashTableIndex)
-  {
-   Instance *ins;
-
-   *hashTableIndex = HashInstance(iname);
-   ins = InstanceData(theEnv)->InstanceTable[*hashTableIndex];
-
-   /* ========================================
-      Make sure all instances of the same name
-      are grouped together regardless of what
-      module their classes are in
-      ======================================== */
-   *prv = NULL;
-   while (ins != NULL)
-     {
-      if (ins->name == iname)
-        { return(ins); }
-      *prv = ins;
-      ins = ins->nxtHash;
-     }
-      
-   /*
-   while ((ins != NULL) ? (ins->name != iname) : false)
-     {
-      *prv = ins;
-      ins = ins->nxtHash;
-     }
-   while ((ins != NULL) ? (ins->name == iname) : false)
-     {
-      if (ins->cls->header.whichModule->theModule ==
-          cls->header.whichModule->theModule)
-        return(ins);
-      *prv = ins;
-      ins = ins->nxtHash;
-     }
-   */
-   return NULL;
-  }
-
 /********************************************************
   NAME         : InstallInstance
   DESCRIPTION  : Prevent name and slot value symbols
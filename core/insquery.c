@@ -43,6 +43,13 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Eq tests on slots in the query look up the     */
+/*            instances of each class through the slot       */
+/*            indexes created with create-instance-index.    */
+/*                                                           */
+/*            Slot references find the slot by the id of the */
+/*            slot name given when they were parsed.         */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -59,11 +66,13 @@
 #include "classfun.h"
 #include "envrnmnt.h"
 #include "exprnpsr.h"
+#include "inscom.h"
 #include "insfun.h"
 #include "insmngr.h"
 #include "insqypsr.h"
 #include "memalloc.h"
 #include "prcdrfun.h"
+#include "prdctfun.h"
 #include "router.h"
 #include "utility.h"
 
@@ -85,6 +94,16 @@
    static void                    TestEntireClass(Environment *,Defmodule *,int,Defclass *,QUERY_CLASS *,int);
    static void                    AddSolution(Environment *);
    static void                    PopQuerySoln(Environment *);
+   static QUERY_KEY              *DetermineQueryKeys(Environment *,EXPRESSION *,unsigned);
+   static void                    ExtractQueryKeys(QUERY_KEY *,EXPRESSION *);
+   static SYMBOL_HN              *QuerySlotReference(EXPRESSION *,int *);
+   static bool                    IsQueryKeyExpression(EXPRESSION *,int);
+   static void                    ReturnQueryKeys(Environment *,QUERY_KEY *,unsigned);
+   static bool                    EvaluateQueryKey(Environment *,EXPRESSION *,CLIPSValue *);
+   static Instance               *FirstQueryInstance(Environment *,Defclass *,int,QUERY_CURSOR *);
+   static Instance               *NextQueryInstance(Environment *,QUERY_CURSOR *);
+   static Instance               *NextQueryCandidate(QUERY_CURSOR *);
+   static void                    ReleaseQueryCursor(Environment *,QUERY_CURSOR *);
 
 /****************************************************
   NAME         : SetupQuery
@@ -155,7 +174,8 @@ void GetQueryInstance(
   INPUTS       : The caller's result buffer
   RETURNS      : Nothing useful
   SIDE EFFECTS : Caller's result buffer set appropriately
-  NOTES        : H/L Syntax : ((query-instance-slot) <index> <slot-name>)
+  NOTES        : H/L Syntax : ((query-instance-slot) <index> <slot-name>
+                                 [<slot-name-id>])
  **************************************************************************/
 void GetQueryInstanceSlot(
   Environment *theEnv,
@@ -166,19 +186,25 @@ void GetQueryInstanceSlot(
    INSTANCE_SLOT *sp;
    CLIPSValue temp;
    QUERY_CORE *core;
+   EXPRESSION *slotExp;
 
    mCVSetBoolean(returnValue,false);
 
    core = FindQueryCore(theEnv,ValueToInteger(GetpValue(GetFirstArgument())));
    ins = core->solns[ValueToInteger(GetpValue(GetFirstArgument()->nextArg))];
-   EvaluateExpression(theEnv,GetFirstArgument()->nextArg->nextArg,&temp);
+   slotExp = GetFirstArgument()->nextArg->nextArg;
+   EvaluateExpression(theEnv,slotExp,&temp);
    if (temp.type != SYMBOL)
      {
       ExpectedTypeError1(theEnv,"get",1,"symbol");
       EnvSetEvaluationError(theEnv,true);
       return;
      }
-   sp = FindInstanceSlot(theEnv,ins,(SYMBOL_HN *) temp.value);
+   if (slotExp->nextArg != NULL)
+     sp = FindInstanceSlotByID(theEnv,ins,(SYMBOL_HN *) temp.value,
+                               (int) ValueToLong(slotExp->nextArg->value));
+   else
+     sp = FindInstanceSlot(theEnv,ins,(SYMBOL_HN *) temp.value);
    if (sp == NULL)
      {
       SlotExistError(theEnv,ValueToString(temp.value),"instance-set query");
@@ -242,6 +268,25 @@ void GetQueryInstanceSlot(
      (b1 c1),(b1 c2),(b2 c1),(b2 c2),(d1 c1),(d1 c2),(d2 c1),(d2 c2)
 
      Notice the duplication because d is a subclass of both and a and b.
+
+     Instance candidate lookup :
+
+     When the query is a conjunction (or a single test) of eq tests and one
+       of them compares a slot of an instance variable with a constant or
+       with a slot of (or the instance bound to) a variable to its left,
+       the instances of a class examined for that variable are looked up
+       in the slot index created for the class with create-instance-index
+       instead of being visited one by one. Classes without an index on
+       the slot are visited as usual. The candidates are still visited in
+       the order given above and the whole query is still evaluated for
+       each instance set, so the index only changes which instance sets
+       the query is evaluated for, not the result.
+
+     The index is kept up to date as instances are created, deleted and
+       have their slots changed. If that happens while a variable's
+       candidates are being visited (from a query action, for example), or
+       the key's value changes, the remaining instances of the class are
+       visited in order as if no index had been used.
    =============================================================================
    ============================================================================= */
 
@@ -278,8 +323,10 @@ void AnyInstances(
    InstanceQueryData(theEnv)->QueryCore = get_struct(theEnv,query_core);
    InstanceQueryData(theEnv)->QueryCore->solns = (Instance **) gm2(theEnv,(sizeof(Instance *) * rcnt));
    InstanceQueryData(theEnv)->QueryCore->query = GetFirstArgument();
+   InstanceQueryData(theEnv)->QueryCore->keys = DetermineQueryKeys(theEnv,GetFirstArgument(),rcnt);
    testResult = TestForFirstInChain(theEnv,qclasses,0);
    InstanceQueryData(theEnv)->AbortQuery = false;
+   ReturnQueryKeys(theEnv,InstanceQueryData(theEnv)->QueryCore->keys,rcnt);
    rm(theEnv,InstanceQueryData(theEnv)->QueryCore->solns,(sizeof(Instance *) * rcnt));
    rtn_struct(theEnv,query_core,InstanceQueryData(theEnv)->QueryCore);
    PopQueryCore(theEnv);
@@ -323,6 +370,7 @@ void QueryFindInstance(
    InstanceQueryData(theEnv)->QueryCore->solns = (Instance **)
                       gm2(theEnv,(sizeof(Instance *) * rcnt));
    InstanceQueryData(theEnv)->QueryCore->query = GetFirstArgument();
+   InstanceQueryData(theEnv)->QueryCore->keys = DetermineQueryKeys(theEnv,GetFirstArgument(),rcnt);
    if (TestForFirstInChain(theEnv,qclasses,0) == true)
      {
       returnValue->value = EnvCreateMultifield(theEnv,rcnt);
@@ -336,6 +384,7 @@ void QueryFindInstance(
    else
       returnValue->value = EnvCreateMultifield(theEnv,0L);
    InstanceQueryData(theEnv)->AbortQuery = false;
+   ReturnQueryKeys(theEnv,InstanceQueryData(theEnv)->QueryCore->keys,rcnt);
    rm(theEnv,InstanceQueryData(theEnv)->QueryCore->solns,(sizeof(Instance *) * rcnt));
    rtn_struct(theEnv,query_core,InstanceQueryData(theEnv)->QueryCore);
    PopQueryCore(theEnv);
@@ -383,6 +432,7 @@ void QueryFindAllInstances(
    InstanceQueryData(theEnv)->QueryCore = get_struct(theEnv,query_core);
    InstanceQueryData(theEnv)->QueryCore->solns = (Instance **) gm2(theEnv,(sizeof(Instance *) * rcnt));
    InstanceQueryData(theEnv)->QueryCore->query = GetFirstArgument();
+   InstanceQueryData(theEnv)->QueryCore->keys = DetermineQueryKeys(theEnv,GetFirstArgument(),rcnt);
    InstanceQueryData(theEnv)->QueryCore->action = NULL;
    InstanceQueryData(theEnv)->QueryCore->soln_set = NULL;
    InstanceQueryData(theEnv)->QueryCore->soln_size = rcnt;
@@ -400,6 +450,7 @@ void QueryFindAllInstances(
       returnValue->end = (long) j-2;
       PopQuerySoln(theEnv);
      }
+   ReturnQueryKeys(theEnv,InstanceQueryData(theEnv)->QueryCore->keys,rcnt);
    rm(theEnv,InstanceQueryData(theEnv)->QueryCore->solns,(sizeof(Instance *) * rcnt));
    rtn_struct(theEnv,query_core,InstanceQueryData(theEnv)->QueryCore);
    PopQueryCore(theEnv);
@@ -437,11 +488,13 @@ void QueryDoForInstance(
    InstanceQueryData(theEnv)->QueryCore = get_struct(theEnv,query_core);
    InstanceQueryData(theEnv)->QueryCore->solns = (Instance **) gm2(theEnv,(sizeof(Instance *) * rcnt));
    InstanceQueryData(theEnv)->QueryCore->query = GetFirstArgument();
+   InstanceQueryData(theEnv)->QueryCore->keys = DetermineQueryKeys(theEnv,GetFirstArgument(),rcnt);
    InstanceQueryData(theEnv)->QueryCore->action = GetFirstArgument()->nextArg;
    if (TestForFirstInChain(theEnv,qclasses,0) == true)
      EvaluateExpression(theEnv,InstanceQueryData(theEnv)->QueryCore->action,returnValue);
    InstanceQueryData(theEnv)->AbortQuery = false;
    ProcedureFunctionData(theEnv)->BreakFlag = false;
+   ReturnQueryKeys(theEnv,InstanceQueryData(theEnv)->QueryCore->keys,rcnt);
    rm(theEnv,InstanceQueryData(theEnv)->QueryCore->solns,(sizeof(Instance *) * rcnt));
    rtn_struct(theEnv,query_core,InstanceQueryData(theEnv)->QueryCore);
    PopQueryCore(theEnv);
@@ -479,6 +532,7 @@ void QueryDoForAllInstances(
    InstanceQueryData(theEnv)->QueryCore = get_struct(theEnv,query_core);
    InstanceQueryData(theEnv)->QueryCore->solns = (Instance **) gm2(theEnv,(sizeof(Instance *) * rcnt));
    InstanceQueryData(theEnv)->QueryCore->query = GetFirstArgument();
+   InstanceQueryData(theEnv)->QueryCore->keys = DetermineQueryKeys(theEnv,GetFirstArgument(),rcnt);
    InstanceQueryData(theEnv)->QueryCore->action = GetFirstArgument()->nextArg;
    InstanceQueryData(theEnv)->QueryCore->result = returnValue;
    ValueInstall(theEnv,InstanceQueryData(theEnv)->QueryCore->result);
@@ -487,6 +541,7 @@ void QueryDoForAllInstances(
       
    InstanceQueryData(theEnv)->AbortQuery = false;
    ProcedureFunctionData(theEnv)->BreakFlag = false;
+   ReturnQueryKeys(theEnv,InstanceQueryData(theEnv)->QueryCore->keys,rcnt);
    rm(theEnv,InstanceQueryData(theEnv)->QueryCore->solns,(sizeof(Instance *) * rcnt));
    rtn_struct(theEnv,query_core,InstanceQueryData(theEnv)->QueryCore);
    PopQueryCore(theEnv);
@@ -530,6 +585,7 @@ void DelayedQueryDoForAllInstances(
    InstanceQueryData(theEnv)->QueryCore = get_struct(theEnv,query_core);
    InstanceQueryData(theEnv)->QueryCore->solns = (Instance **) gm2(theEnv,(sizeof(Instance *) * rcnt));
    InstanceQueryData(theEnv)->QueryCore->query = GetFirstArgument();
+   InstanceQueryData(theEnv)->QueryCore->keys = DetermineQueryKeys(theEnv,GetFirstArgument(),rcnt);
    InstanceQueryData(theEnv)->QueryCore->action = NULL;
    InstanceQueryData(theEnv)->QueryCore->soln_set = NULL;
    InstanceQueryData(theEnv)->QueryCore->soln_size = rcnt;
@@ -562,6 +618,7 @@ void DelayedQueryDoForAllInstances(
    CallPeriodicTasks(theEnv);
 
    ProcedureFunctionData(theEnv)->BreakFlag = false;
+   ReturnQueryKeys(theEnv,InstanceQueryData(theEnv)->QueryCore->keys,rcnt);
    rm(theEnv,InstanceQueryData(theEnv)->QueryCore->solns,(sizeof(Instance *) * rcnt));
    rtn_struct(theEnv,query_core,InstanceQueryData(theEnv)->QueryCore);
    PopQueryCore(theEnv);
@@ -912,6 +969,7 @@ static bool TestForFirstInstanceInClass(
    Instance *ins;
    CLIPSValue temp;
    struct CLIPSBlock gcBlock;
+   QUERY_CURSOR cursor;
    
    if (TestTraversalID(cls->traversalRecord,id))
      return false;
@@ -921,7 +979,7 @@ static bool TestForFirstInstanceInClass(
      
    CLIPSBlockStart(theEnv,&gcBlock);
    
-   ins = cls->instanceList;
+   ins = FirstQueryInstance(theEnv,cls,indx,&cursor);
    while (ins != NULL)
      {
       InstanceQueryData(theEnv)->QueryCore->solns[indx] = ins;
@@ -952,11 +1010,10 @@ static bool TestForFirstInstanceInClass(
       CleanCurrentGarbageFrame(theEnv,NULL);
       CallPeriodicTasks(theEnv);
        
-      ins = ins->nxtClass;
-      while ((ins != NULL) ? (ins->garbage == 1) : false)
-        ins = ins->nxtClass;
+      ins = NextQueryInstance(theEnv,&cursor);
      }
 
+   ReleaseQueryCursor(theEnv,&cursor);
    CLIPSBlockEnd(theEnv,&gcBlock,NULL);
    CallPeriodicTasks(theEnv);
 
@@ -1035,6 +1092,7 @@ static void TestEntireClass(
    Instance *ins;
    CLIPSValue temp;
    struct CLIPSBlock gcBlock;
+   QUERY_CURSOR cursor;
    
    if (TestTraversalID(cls->traversalRecord,id))
      return;
@@ -1044,7 +1102,7 @@ static void TestEntireClass(
      
    CLIPSBlockStart(theEnv,&gcBlock);
 
-   ins = cls->instanceList;
+   ins = FirstQueryInstance(theEnv,cls,indx,&cursor);
    while (ins != NULL)
      {
       InstanceQueryData(theEnv)->QueryCore->solns[indx] = ins;
@@ -1090,14 +1148,13 @@ static void TestEntireClass(
            }
         }
          
-      ins = ins->nxtClass;
-      while ((ins != NULL) ? (ins->garbage == 1) : false)
-        ins = ins->nxtClass;
+      ins = NextQueryInstance(theEnv,&cursor);
 
       CleanCurrentGarbageFrame(theEnv,NULL);
       CallPeriodicTasks(theEnv);
      }
    
+   ReleaseQueryCursor(theEnv,&cursor);
    CLIPSBlockEnd(theEnv,&gcBlock,NULL);
    CallPeriodicTasks(theEnv);
 
@@ -1159,6 +1216,393 @@ static void PopQuerySoln(
    rm(theEnv,InstanceQueryData(theEnv)->QueryCore->soln_bottom,sizeof(QUERY_SOLN));
   }
 
+/***************************************************************
+  NAME         : DetermineQueryKeys
+  DESCRIPTION  : Finds the tests in a query which can be used
+                   to look up the instances for each instance
+                   variable instead of visiting every instance
+                   of its classes
+  INPUTS       : 1) The query expression
+                 2) The number of instance variables
+  RETURNS      : An array with a key for each instance
+                   variable, or NULL if no test can be used
+  SIDE EFFECTS : Array allocated
+  NOTES        : Only tests which are the query or one of the
+                   conjuncts of a top level and are used. The
+                   tests are still evaluated with the rest of
+                   the query, so a key only has to select a
+                   superset of the instances which satisfy it.
+ ***************************************************************/
+static QUERY_KEY *DetermineQueryKeys(
+  Environment *theEnv,
+  EXPRESSION *query,
+  unsigned rcnt)
+  {
+   QUERY_KEY *keys;
+   unsigned i;
+
+   keys = (QUERY_KEY *) gm2(theEnv,(sizeof(QUERY_KEY) * rcnt));
+   for (i = 0 ; i < rcnt ; i++)
+     {
+      keys[i].slotName = NULL;
+      keys[i].key = NULL;
+     }
+
+   ExtractQueryKeys(keys,query);
+
+   for (i = 0 ; i < rcnt ; i++)
+     {
+      if (keys[i].slotName != NULL)
+        return(keys);
+     }
+
+   rm(theEnv,keys,(sizeof(QUERY_KEY) * rcnt));
+   return NULL;
+  }
+
+/***************************************************************
+  NAME         : ExtractQueryKeys
+  DESCRIPTION  : Records the eq tests of a query conjunct in
+                   the keys of the instance variables they
+                   constrain
+  INPUTS       : 1) The key array
+                 2) The conjunct
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Keys updated
+  NOTES        : A test is usable when it compares a slot of an
+                   instance variable with a constant, or with a
+                   slot of (or the instance bound to) a variable
+                   to its left. The first such test found for a
+                   variable is used.
+ ***************************************************************/
+static void ExtractQueryKeys(
+  QUERY_KEY *keys,
+  EXPRESSION *theExp)
+  {
+   void (*fptr)(Environment *,UDFContext *,CLIPSValue *);
+   EXPRESSION *target,*other;
+   SYMBOL_HN *slotName;
+   int posn;
+
+   if (theExp->type != FCALL)
+     return;
+   fptr = ExpressionFunctionPointer(theExp);
+
+   if (fptr == AndFunction)
+     {
+      for (theExp = theExp->argList ; theExp != NULL ; theExp = theExp->nextArg)
+        ExtractQueryKeys(keys,theExp);
+      return;
+     }
+
+   if (fptr != EqFunction)
+     return;
+
+   if ((theExp->argList == NULL) || (theExp->argList->nextArg == NULL) ||
+       (theExp->argList->nextArg->nextArg != NULL))
+     return;
+
+   /* ===========================================
+      The constrained slot is the one belonging
+      to the rightmost instance variable in the
+      test
+      =========================================== */
+   target = theExp->argList;
+   other = target->nextArg;
+   slotName = QuerySlotReference(target,&posn);
+   if ((slotName == NULL) || (IsQueryKeyExpression(other,posn) == false))
+     {
+      target = other;
+      other = theExp->argList;
+      slotName = QuerySlotReference(target,&posn);
+      if ((slotName == NULL) || (IsQueryKeyExpression(other,posn) == false))
+        return;
+     }
+
+   if (keys[posn].slotName == NULL)
+     {
+      keys[posn].slotName = slotName;
+      keys[posn].key = other;
+     }
+  }
+
+/***************************************************************
+  NAME         : QuerySlotReference
+  DESCRIPTION  : Determines if an expression is a reference to
+                   a slot of one of the instance variables of
+                   the query being evaluated
+  INPUTS       : 1) The expression
+                 2) Caller's buffer for the variable position
+  RETURNS      : The slot name, or NULL if the expression is
+                   not such a reference
+  SIDE EFFECTS : Caller's buffer set
+  NOTES        : References to the variables of enclosing
+                   queries have a non-zero depth
+ ***************************************************************/
+static SYMBOL_HN *QuerySlotReference(
+  EXPRESSION *theExp,
+  int *posn)
+  {
+   EXPRESSION *depth;
+
+   if (theExp->type != FCALL)
+     return NULL;
+   if (ExpressionFunctionPointer(theExp) != GetQueryInstanceSlot)
+     return NULL;
+
+   depth = theExp->argList;
+   if ((ValueToLong(depth->value) != 0) || (depth->nextArg->nextArg->type != SYMBOL))
+     return NULL;
+
+   *posn = (int) ValueToLong(depth->nextArg->value);
+   return((SYMBOL_HN *) depth->nextArg->nextArg->value);
+  }
+
+/***************************************************************
+  NAME         : IsQueryKeyExpression
+  DESCRIPTION  : Determines if an expression can be used as the
+                   key for an instance variable
+  INPUTS       : 1) The expression
+                 2) The position of the instance variable
+  RETURNS      : True if the expression is a constant or refers
+                   only to the variables left of the position,
+                   false otherwise
+  SIDE EFFECTS : None
+  NOTES        : Function calls are not allowed because a key
+                   is evaluated once for all of the instances
+                   it selects
+ ***************************************************************/
+static bool IsQueryKeyExpression(
+  EXPRESSION *theExp,
+  int posn)
+  {
+   int keyPosn;
+
+   switch (theExp->type)
+     {
+      case SYMBOL:
+      case STRING:
+      case INTEGER:
+      case FLOAT:
+      case INSTANCE_NAME:
+        return true;
+
+      case FCALL:
+        if (QuerySlotReference(theExp,&keyPosn) != NULL)
+          return(keyPosn < posn);
+        if ((ExpressionFunctionPointer(theExp) == GetQueryInstance) &&
+            (ValueToLong(theExp->argList->value) == 0))
+          return(ValueToLong(theExp->argList->nextArg->value) < posn);
+        break;
+     }
+
+   return false;
+  }
+
+/***************************************************
+  NAME         : ReturnQueryKeys
+  DESCRIPTION  : Deallocates the keys of a query
+  INPUTS       : 1) The key array (can be NULL)
+                 2) The number of instance variables
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Array deallocated
+  NOTES        : The key expressions belong to the
+                   query and are not deallocated
+ ***************************************************/
+static void ReturnQueryKeys(
+  Environment *theEnv,
+  QUERY_KEY *keys,
+  unsigned rcnt)
+  {
+   if (keys != NULL)
+     rm(theEnv,keys,(sizeof(QUERY_KEY) * rcnt));
+  }
+
+/***************************************************************
+  NAME         : EvaluateQueryKey
+  DESCRIPTION  : Determines the value of a key expression for
+                   the instances bound to the variables on its
+                   left
+  INPUTS       : 1) The key expression
+                 2) Caller's result buffer
+  RETURNS      : True if the key has a single field value,
+                   false otherwise
+  SIDE EFFECTS : Caller's buffer set
+  NOTES        : A deleted instance, a slot the bound instance
+                   does not have or a multifield slot gives no
+                   key. The instances are then visited one by
+                   one and the query reports any error itself.
+ ***************************************************************/
+static bool EvaluateQueryKey(
+  Environment *theEnv,
+  EXPRESSION *theExp,
+  CLIPSValue *returnValue)
+  {
+   Instance *ins;
+   INSTANCE_SLOT *sp;
+   EXPRESSION *slotExp;
+
+   if (theExp->type != FCALL)
+     {
+      returnValue->type = theExp->type;
+      returnValue->value = theExp->value;
+      return true;
+     }
+
+   ins = InstanceQueryData(theEnv)->QueryCore->solns[ValueToLong(theExp->argList->nextArg->value)];
+   if (ExpressionFunctionPointer(theExp) == GetQueryInstance)
+     {
+      returnValue->type = INSTANCE_NAME;
+      returnValue->value = GetFullInstanceName(theEnv,ins);
+      return true;
+     }
+
+   if (ins->garbage)
+     return false;
+
+   slotExp = theExp->argList->nextArg->nextArg;
+   if (slotExp->nextArg != NULL)
+     sp = FindInstanceSlotByID(theEnv,ins,(SYMBOL_HN *) slotExp->value,
+                               (int) ValueToLong(slotExp->nextArg->value));
+   else
+     sp = FindInstanceSlot(theEnv,ins,(SYMBOL_HN *) slotExp->value);
+   if ((sp == NULL) || (sp->type == MULTIFIELD))
+     return false;
+
+   returnValue->type = sp->type;
+   returnValue->value = sp->value;
+   return true;
+  }
+
+/***************************************************************
+  NAME         : FirstQueryInstance
+  DESCRIPTION  : Starts visiting the direct instances of a
+                   class for an instance variable
+  INPUTS       : 1) The class
+                 2) The index of the instance variable
+                 3) Caller's cursor
+  RETURNS      : The first instance to visit, or NULL if none
+  SIDE EFFECTS : Cursor initialized
+  NOTES        : The instances are looked up in a slot index of
+                   the class when the variable has a key and
+                   the slot of the key has been indexed with
+                   create-instance-index. Otherwise every
+                   instance of the class is visited.
+ ***************************************************************/
+static Instance *FirstQueryInstance(
+  Environment *theEnv,
+  Defclass *cls,
+  int indx,
+  QUERY_CURSOR *cursor)
+  {
+   QUERY_KEY *theKey;
+   INSTANCE_SLOT_INDEX *theIndex;
+   CLIPSValue keyValue;
+
+   cursor->indexed = false;
+   cursor->candidates = NULL;
+   cursor->count = 0;
+   cursor->ins = cls->instanceList;
+
+   if ((InstanceQueryData(theEnv)->QueryCore->keys == NULL) || (cursor->ins == NULL))
+     return(cursor->ins);
+
+   theKey = &InstanceQueryData(theEnv)->QueryCore->keys[indx];
+   if (theKey->slotName == NULL)
+     return(cursor->ins);
+
+   theIndex = FindInstanceSlotIndex(cls,theKey->slotName);
+   if (theIndex == NULL)
+     return(cursor->ins);
+
+   if (EvaluateQueryKey(theEnv,theKey->key,&keyValue) == false)
+     return(cursor->ins);
+
+   cursor->count = FindIndexedInstances(theEnv,theIndex,keyValue.type,keyValue.value,&cursor->candidates);
+   cursor->indexed = true;
+   cursor->next = 0;
+   cursor->changes = InstanceData(theEnv)->SlotIndexChanges;
+   cursor->key = (theKey->key->type == FCALL) ? theKey->key : NULL;
+   cursor->keyType = keyValue.type;
+   cursor->keyValue = keyValue.value;
+   return(NextQueryCandidate(cursor));
+  }
+
+/***************************************************************
+  NAME         : NextQueryInstance
+  DESCRIPTION  : Determines the next instance to visit for an
+                   instance variable
+  INPUTS       : The cursor
+  RETURNS      : The next instance, or NULL if there are no more
+  SIDE EFFECTS : Cursor advanced
+  NOTES        : Once an indexed slot has changed or the key no
+                   longer has the value the candidates were
+                   looked up with, the rest of the class's
+                   instance list after the current instance is
+                   visited as it would be without an index
+ ***************************************************************/
+static Instance *NextQueryInstance(
+  Environment *theEnv,
+  QUERY_CURSOR *cursor)
+  {
+   Instance *ins;
+   CLIPSValue keyValue;
+
+   if (cursor->indexed)
+     {
+      if ((cursor->changes == InstanceData(theEnv)->SlotIndexChanges) &&
+          ((cursor->key == NULL) ||
+           ((EvaluateQueryKey(theEnv,cursor->key,&keyValue) == true) &&
+            (keyValue.type == cursor->keyType) && (keyValue.value == cursor->keyValue))))
+        return(NextQueryCandidate(cursor));
+      cursor->indexed = false;
+     }
+
+   ins = cursor->ins->nxtClass;
+   while ((ins != NULL) ? (ins->garbage == 1) : false)
+     ins = ins->nxtClass;
+
+   cursor->ins = ins;
+   return(ins);
+  }
+
+/***************************************************
+  NAME         : NextQueryCandidate
+  DESCRIPTION  : Finds the next instance looked up
+                   in a slot index
+  INPUTS       : The cursor
+  RETURNS      : The candidate, or NULL if there
+                   are no more
+  SIDE EFFECTS : Cursor advanced
+  NOTES        : None
+ ***************************************************/
+static Instance *NextQueryCandidate(
+  QUERY_CURSOR *cursor)
+  {
+   if (cursor->next < cursor->count)
+     cursor->ins = cursor->candidates[cursor->next++];
+   else
+     cursor->ins = NULL;
+   return(cursor->ins);
+  }
+
+/***************************************************
+  NAME         : ReleaseQueryCursor
+  DESCRIPTION  : Deallocates the candidates held
+                   by a cursor
+  INPUTS       : The cursor
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Candidates deallocated
+  NOTES        : None
+ ***************************************************/
+static void ReleaseQueryCursor(
+  Environment *theEnv,
+  QUERY_CURSOR *cursor)
+  {
+   if (cursor->candidates != NULL)
+     rm(theEnv,cursor->candidates,(sizeof(Instance *) * cursor->count));
+  }
+
 #endif
 
 
@@ -41,6 +41,10 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Eq tests on slots in the query look up the     */
+/*            instances of each class through the slot       */
+/*            indexes created with create-instance-index.    */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_insquery
@@ -60,6 +64,24 @@ typedef struct query_class
    struct query_class *chain,*nxt;
   } QUERY_CLASS;
 
+typedef struct query_key
+  {
+   SYMBOL_HN *slotName;
+   EXPRESSION *key;
+  } QUERY_KEY;
+
+typedef struct query_cursor
+  {
+   Instance *ins;
+   Instance **candidates;
+   unsigned long next,count;
+   unsigned long changes;
+   EXPRESSION *key;
+   unsigned short keyType;
+   void *keyValue;
+   bool indexed;
+  } QUERY_CURSOR;
+
 typedef struct query_soln
   {
    Instance **soln;
@@ -70,6 +92,7 @@ typedef struct query_core
   {
    Instance **solns;
    EXPRESSION *query,*action;
+   QUERY_KEY *keys;
    QUERY_SOLN *soln_set,*soln_bottom;
    unsigned soln_size,soln_cnt;
    CLIPSValue *result;
@@ -43,6 +43,9 @@
 /*            Removed use of void pointers for specific      */
 /*            data structures.                               */
 /*                                                           */
+/*            Slot references of instance-set variables also */
+/*            carry the id of the slot name.                 */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -57,6 +60,7 @@
 #include <string.h>
 
 #include "classcom.h"
+#include "classfun.h"
 #include "envrnmnt.h"
 #include "exprnpsr.h"
 #include "insquery.h"
@@ -593,7 +597,9 @@ static void ReplaceInstanceVariables(
   RETURNS      : Nothing useful
   SIDE EFFECTS : If the variable is a slot reference, then it is replaced
                    with the appropriate function-call.
-  NOTES        : None
+  NOTES        : The id of a known slot name is added as a fourth
+                   argument so the slot can usually be found without
+                   looking up the name (see FindInstanceSlotByID)
  *************************************************************************/
 static void ReplaceSlotReference(
   Environment *theEnv,
@@ -604,6 +610,7 @@ static void ReplaceSlotReference(
   {
    size_t len;
    int posn;
+   short sid;
    bool oldpp;
    size_t i;
    const char *str;
@@ -641,6 +648,13 @@ static void ReplaceSlotReference(
             theExp->argList->nextArg =
               GenConstant(theEnv,INTEGER,EnvAddLong(theEnv,(long long) posn));
             theExp->argList->nextArg->nextArg = GenConstant(theEnv,itkn.type,itkn.value);
+            if (itkn.type == SYMBOL)
+              {
+               sid = FindSlotNameID(theEnv,(SYMBOL_HN *) itkn.value);
+               if (sid != -1)
+                 theExp->argList->nextArg->nextArg->nextArg =
+                   GenConstant(theEnv,INTEGER,EnvAddLong(theEnv,(long long) sid));
+              }
             break;
            }
         }
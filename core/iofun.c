@@ -87,6 +87,9 @@
 /*                                                           */
 /*            Added print and println functions.             */
 /*                                                           */
+/*      6.50: The format function builds its result with a   */
+/*            StringBuilder.                                 */
+/*                                                           */
 /*************************************************************/
 
 #include "setup.h"
@@ -836,9 +839,7 @@ void FormatFunction(
    int  f_cur_arg = 3;
    size_t form_pos = 0;
    char percentBuffer[FLAG_MAX];
-   char *fstr = NULL;
-   size_t fmaxm = 0;
-   size_t fpos = 0;
+   StringBuilder *theSB;
    void *hptr;
    const char *theString;
 
@@ -889,6 +890,8 @@ void FormatFunction(
       return;
      }
 
+   theSB = CreateStringBuilder(theEnv,strlen(formatString));
+
    /*========================================*/
    /* Search the format string, printing the */
    /* format flags as they are encountered.  */
@@ -902,7 +905,7 @@ void FormatFunction(
          while ((formatString[form_pos] != '%') &&
                 (formatString[form_pos] != '\0'))
            { form_pos++; }
-         fstr = AppendNToString(theEnv,&formatString[start_pos],fstr,form_pos-start_pos,&fpos,&fmaxm);
+         SBAppendN(theSB,&formatString[start_pos],form_pos-start_pos);
         }
       else
         {
@@ -912,38 +915,23 @@ void FormatFunction(
            {
             if ((theString = PrintFormatFlag(context,percentBuffer,f_cur_arg,formatFlagType)) == NULL)
               {
-               if (fstr != NULL) rm(theEnv,fstr,fmaxm);
-               CVSetCLIPSString(returnValue,hptr);
-               return;
-              }
-            fstr = AppendToString(theEnv,theString,fstr,&fpos,&fmaxm);
-            if (fstr == NULL)
-              {
+               SBDispose(theSB);
                CVSetCLIPSString(returnValue,hptr);
                return;
               }
+            SBAppend(theSB,theString);
             f_cur_arg++;
            }
          else
-           {
-            fstr = AppendToString(theEnv,percentBuffer,fstr,&fpos,&fmaxm);
-            if (fstr == NULL)
-              {
-               CVSetCLIPSString(returnValue,hptr);
-               return;
-              }
-           }
+           { SBAppend(theSB,percentBuffer); }
         }
      }
 
-   if (fstr != NULL)
-     {
-      hptr = EnvAddSymbol(theEnv,fstr);
-      if (strcmp(logicalName,"nil") != 0) EnvPrintRouter(theEnv,logicalName,fstr);
-      rm(theEnv,fstr,fmaxm);
-     }
-   else
-     { hptr = EnvAddSymbol(theEnv,""); }
+   hptr = SBAddSymbol(theSB);
+   SBDispose(theSB);
+
+   if (strcmp(logicalName,"nil") != 0)
+     { EnvPrintRouter(theEnv,logicalName,ValueToString(hptr)); }
 
    CVSetCLIPSString(returnValue,hptr);
   }
@@ -38,6 +38,13 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            The dependencies of a partial match are stored */
+/*            in its links structure.                        */
+/*                                                           */
+/*            A dependency link is removed in constant time  */
+/*            using the link which points back to it rather  */
+/*            than by searching the list which contains it.  */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
@@ -62,7 +69,7 @@
 /* LOCAL INTERNAL FUNCTION DEFINITIONS */
 /***************************************/
 
-   static struct dependency      *DetachAssociatedDependencies(Environment *,struct dependency *,void *);
+   static void                   *DetachAssociatedDependency(Environment *,void *,struct dependency *);
 
 /***********************************************************************/
 /* AddLogicalDependencies: Adds the logical dependency links between a */
@@ -85,7 +92,7 @@ bool AddLogicalDependencies(
   bool existingEntity)
   {
    struct partialMatch *theBinds;
-   struct dependency *newDependency;
+   struct dependency *newDependency, *pmDependency;
 
    /*==============================================*/
    /* If the rule has no logical patterns, then no */
@@ -123,8 +130,12 @@ bool AddLogicalDependencies(
 
    newDependency = get_struct(theEnv,dependency);
    newDependency->dPtr = theEntity;
-   newDependency->next = (struct dependency *) theBinds->dependents;
-   theBinds->dependents = newDependency;
+   newDependency->previous = NULL;
+   newDependency->next = (struct dependency *) PMDependents(theBinds);
+   if (newDependency->next != NULL)
+     { newDependency->next->previous = newDependency; }
+   GetPartialMatchLinks(theEnv,theBinds)->dependents = newDependency;
+   pmDependency = newDependency;
 
    /*================================================================*/
    /* Add a dependency link between the entity and the partialMatch. */
@@ -132,9 +143,20 @@ bool AddLogicalDependencies(
 
    newDependency = get_struct(theEnv,dependency);
    newDependency->dPtr = theBinds;
+   newDependency->previous = NULL;
    newDependency->next = (struct dependency *) theEntity->dependents;
+   if (newDependency->next != NULL)
+     { newDependency->next->previous = newDependency; }
    theEntity->dependents = newDependency;
 
+   /*=====================================================*/
+   /* Each link points to the link in the other direction */
+   /* so that the pair can be removed in constant time.   */
+   /*=====================================================*/
+
+   newDependency->associate = pmDependency;
+   pmDependency->associate = newDependency;
+
    /*==================================================================*/
    /* Return true to indicate that the data entity should be asserted. */
    /*==================================================================*/
@@ -184,7 +206,7 @@ void RemoveEntityDependencies(
   Environment *theEnv,
   struct patternEntity *theEntity)
   {
-   struct dependency *fdPtr, *nextPtr, *theList;
+   struct dependency *fdPtr, *nextPtr;
    struct partialMatch *theBinds;
 
    /*===============================*/
@@ -210,9 +232,8 @@ void RemoveEntityDependencies(
       /*================================================================*/
 
       theBinds = (struct partialMatch *) fdPtr->dPtr;
-      theList = (struct dependency *) theBinds->dependents;
-      theList = DetachAssociatedDependencies(theEnv,theList,theEntity);
-      theBinds->dependents = theList;
+      theBinds->links->dependents =
+         DetachAssociatedDependency(theEnv,theBinds->links->dependents,fdPtr);
 
       /*========================*/
       /* Return the dependency. */
@@ -258,39 +279,32 @@ void ReturnEntityDependencies(
   }
 
 /*******************************************************************/
-/* DetachAssociatedDependencies: Removes all logical support links */
-/*   which pointer to a pattern entity from a list of dependencies */
-/*   (which may be associated with either a partial match or       */
-/*   another pattern entity). Does not remove links which point in */
-/*   the other direction.                                          */
+/* DetachAssociatedDependency: Removes the logical support link    */
+/*   associated with a dependency (the link which points in the    */
+/*   other direction) from the list of dependencies containing it  */
+/*   (which may be associated with either a partial match or a     */
+/*   pattern entity) and returns the updated list. The link is     */
+/*   unlinked directly rather than searched for, so the time taken */
+/*   doesn't depend on the length of the list.                     */
 /*******************************************************************/
-static struct dependency *DetachAssociatedDependencies(
+static void *DetachAssociatedDependency(
   Environment *theEnv,
-  struct dependency *theList,
-  void *theEntity)
+  void *theList,
+  struct dependency *theDependency)
   {
-   struct dependency *fdPtr, *nextPtr, *lastPtr = NULL;
+   struct dependency *theAssociate = theDependency->associate;
 
-   fdPtr = theList;
+   if (theAssociate->previous == NULL)
+     { theList = theAssociate->next; }
+   else
+     { theAssociate->previous->next = theAssociate->next; }
 
-   while (fdPtr != NULL)
-     {
-      if (fdPtr->dPtr == theEntity)
-        {
-         nextPtr = fdPtr->next;
-         if (lastPtr == NULL) theList = nextPtr;
-         else lastPtr->next = nextPtr;
-         rtn_struct(theEnv,dependency,fdPtr);
-         fdPtr = nextPtr;
-        }
-      else
-        {
-         lastPtr = fdPtr;
-         fdPtr = fdPtr->next;
-        }
-     }
+   if (theAssociate->next != NULL)
+     { theAssociate->next->previous = theAssociate->previous; }
 
-   return(theList);
+   rtn_struct(theEnv,dependency,theAssociate);
+
+   return theList;
   }
 
 /**************************************************************************/
@@ -302,26 +316,25 @@ void RemovePMDependencies(
   Environment *theEnv,
   struct partialMatch *theBinds)
   {
-   struct dependency *fdPtr, *nextPtr, *theList;
+   struct dependency *fdPtr, *nextPtr;
    struct patternEntity *theEntity;
 
-   fdPtr = (struct dependency *) theBinds->dependents;
+   fdPtr = (struct dependency *) PMDependents(theBinds);
 
    while (fdPtr != NULL)
      {
       nextPtr = fdPtr->next;
 
       theEntity = (struct patternEntity *) fdPtr->dPtr;
-
-      theList = (struct dependency *) theEntity->dependents;
-      theList = DetachAssociatedDependencies(theEnv,theList,theBinds);
-      theEntity->dependents = theList;
+      theEntity->dependents =
+         DetachAssociatedDependency(theEnv,theEntity->dependents,fdPtr);
 
       rtn_struct(theEnv,dependency,fdPtr);
       fdPtr = nextPtr;
      }
 
-   theBinds->dependents = NULL;
+   if (theBinds->links != NULL)
+     { theBinds->links->dependents = NULL; }
   }
 
 /************************************************************/
@@ -334,7 +347,7 @@ void DestroyPMDependencies(
   {
    struct dependency *fdPtr, *nextPtr;
 
-   fdPtr = (struct dependency *) theBinds->dependents;
+   fdPtr = (struct dependency *) PMDependents(theBinds);
 
    while (fdPtr != NULL)
      {
@@ -344,14 +357,15 @@ void DestroyPMDependencies(
       fdPtr = nextPtr;
      }
 
-   theBinds->dependents = NULL;
+   if (theBinds->links != NULL)
+     { theBinds->links->dependents = NULL; }
   }
 
 /************************************************************************/
 /* RemoveLogicalSupport: Removes the dependency links between a partial */
 /*   match and the data entities it logically supports. Also removes    */
 /*   the associated links from the data entities which point back to    */
-/*   the partial match by calling DetachAssociatedEntityDependencies.   */
+/*   the partial match by calling DetachAssociatedDependency.           */
 /*   If an entity has all of its logical support removed as a result of */
 /*   this procedure, the dependency link from the partial match is      */
 /*   added to the list of unsupported data entities so that the entity  */
@@ -361,7 +375,7 @@ void RemoveLogicalSupport(
   Environment *theEnv,
   struct partialMatch *theBinds)
   {
-   struct dependency *dlPtr, *tempPtr, *theList;
+   struct dependency *dlPtr, *tempPtr;
    struct patternEntity *theEntity;
 
    /*========================================*/
@@ -369,14 +383,14 @@ void RemoveLogicalSupport(
    /* dependencies, then return.             */
    /*========================================*/
 
-   if (theBinds->dependents == NULL) return;
+   if (PMDependents(theBinds) == NULL) return;
 
    /*=======================================*/
    /* Loop through each of the dependencies */
    /* attached to the partial match.        */
    /*=======================================*/
 
-   dlPtr = (struct dependency *) theBinds->dependents;
+   dlPtr = (struct dependency *) PMDependents(theBinds);
 
    while (dlPtr != NULL)
      {
@@ -393,10 +407,8 @@ void RemoveLogicalSupport(
       /*==========================================================*/
 
       theEntity = (struct patternEntity *) dlPtr->dPtr;
-
-      theList = (struct dependency *) theEntity->dependents;
-      theList = DetachAssociatedDependencies(theEnv,theList,theBinds);
-      theEntity->dependents = theList;
+      theEntity->dependents =
+         DetachAssociatedDependency(theEnv,theEntity->dependents,dlPtr);
 
       /*==============================================================*/
       /* If the data entity has lost all of its logical support, then */
@@ -408,6 +420,7 @@ void RemoveLogicalSupport(
       if (theEntity->dependents == NULL)
         {
          (*theEntity->theInfo->base.incrementBusyCount)(theEnv,theEntity);
+         dlPtr->associate = NULL;
          dlPtr->next = EngineData(theEnv)->UnsupportedDataEntities;
          EngineData(theEnv)->UnsupportedDataEntities = dlPtr;
         }
@@ -426,7 +439,8 @@ void RemoveLogicalSupport(
    /* dependencies associated with it.    */
    /*=====================================*/
 
-   theBinds->dependents = NULL;
+   if (theBinds->links != NULL)
+     { theBinds->links->dependents = NULL; }
   }
 
 /********************************************************************/
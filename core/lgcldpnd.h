@@ -37,6 +37,11 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Dependency links are doubly linked and point   */
+/*            to their associated link in the other          */
+/*            direction so they can be removed in constant   */
+/*            time.                                          */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_lgcldpnd
@@ -49,6 +54,8 @@ struct dependency
   {
    void *dPtr;
    struct dependency *next;
+   struct dependency *previous;
+   struct dependency *associate;
   };
 
 #include "match.h"
@@ -26,6 +26,12 @@
 /*            Removed use of void pointers for specific      */
 /*            data structures.                               */
 /*                                                           */
+/*            Added fromArena flag to partial matches.       */
+/*                                                           */
+/*            Moved the blocking and dependency links of a   */
+/*            partial match to a structure which is          */
+/*            allocated when the links are first needed.     */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_match
@@ -37,6 +43,7 @@
 struct genericMatch;
 struct patternMatch;
 typedef struct partialMatch PartialMatch;
+struct partialMatchLinks;
 struct alphaMatch;
 struct multifieldMarker;
 
@@ -74,11 +81,11 @@ struct partialMatch
    unsigned int betaMemory  :  1;
    unsigned int busy        :  1;
    unsigned int rhsMemory   :  1;
+   unsigned int fromArena   :  1;
    unsigned short bcount; 
-   unsigned long hashValue;
+   unsigned int hashValue;
    void *owner;
    void *marker;
-   void *dependents;
    struct partialMatch *nextInMemory;
    struct partialMatch *prevInMemory;
    struct partialMatch *children;
@@ -88,10 +95,24 @@ struct partialMatch
    struct partialMatch *leftParent;
    struct partialMatch *nextLeftChild;
    struct partialMatch *prevLeftChild;
+   struct partialMatchLinks *links;
+   struct genericMatch binds[1];
+  };
+
+/************************************************************/
+/* PARTIALMATCHLINKS STRUCTURE: The links of a partial      */
+/*   match which only some partial matches use: the list of */
+/*   partial matches it blocks in a not or exists CE, its   */
+/*   position in the block list of its own blocker, and its */
+/*   logical dependencies. The structure is allocated when  */
+/*   a link is first set.                                   */
+/************************************************************/
+struct partialMatchLinks
+  {
    struct partialMatch *blockList;
    struct partialMatch *nextBlocked;
    struct partialMatch *prevBlocked;
-   struct genericMatch binds[1];
+   void *dependents;
   };
 
 /************************************************************/
@@ -130,6 +151,11 @@ struct multifieldMarker
 #define set_nth_pm_value(thePM,thePos,theVal) (thePM->binds[thePos].gm.theValue = (void *) theVal)
 #define set_nth_pm_match(thePM,thePos,theVal) (thePM->binds[thePos].gm.theMatch = theVal)
 
+#define PMBlockList(thePM) (((thePM)->links == NULL) ? NULL : (thePM)->links->blockList)
+#define PMNextBlocked(thePM) (((thePM)->links == NULL) ? NULL : (thePM)->links->nextBlocked)
+#define PMPrevBlocked(thePM) (((thePM)->links == NULL) ? NULL : (thePM)->links->prevBlocked)
+#define PMDependents(thePM) (((thePM)->links == NULL) ? NULL : (thePM)->links->dependents)
+
 #endif /* _H_match */
 
 
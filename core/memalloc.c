@@ -49,6 +49,17 @@
 /*                                                           */
 /*            ALLOW_ENVIRONMENT_GLOBALS no longer supported. */
 /*                                                           */
+/*            Replaced the free lists indexed by block size  */
+/*            with size classed slab pages. Empty pages and  */
+/*            segments are returned to the system.           */
+/*                                                           */
+/*            Added slab arenas for blocks which share a     */
+/*            common owner.                                  */
+/*                                                           */
+/*            Added ArenaOwnsBlock function.                 */
+/*                                                           */
+/*            Added AbandonSlabArena function.               */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
@@ -72,6 +83,23 @@
 #define SpecialMalloc(sz) malloc((STD_SIZE) sz)
 #define SpecialFree(ptr) free(ptr)
 
+/***************************************/
+/* LOCAL INTERNAL FUNCTION DEFINITIONS */
+/***************************************/
+
+   static void                   *SystemAllocate(Environment *,size_t);
+   static void                    SystemFree(Environment *,void *,size_t);
+#if (MEM_TABLE_SIZE > 0)
+   static struct slabPage        *AllocateSlabPage(Environment *,unsigned int);
+   static void                    ReleaseSlabPage(Environment *,struct slabPage *);
+   static struct slabPage        *TakeSegmentPage(Environment *,unsigned int);
+   static void                    ReturnSegmentPage(Environment *,struct slabPage *);
+   static void                    ArenaFree(Environment *,struct slabPage *,struct memoryPtr *);
+   static void                    ReturnArenaPages(Environment *,struct slabArena *);
+   static struct slabSegment     *AllocateSlabSegment(Environment *);
+   static void                    ReleaseSlabSegment(Environment *,struct slabSegment *);
+#endif
+
 /********************************************/
 /* InitializeMemory: Sets up memory tables. */
 /********************************************/
@@ -82,25 +110,10 @@ void InitializeMemory(
 
    MemoryData(theEnv)->OutOfMemoryCallback = DefaultOutOfMemoryFunction;
 
-#if (MEM_TABLE_SIZE > 0)
-   MemoryData(theEnv)->MemoryTable = (struct memoryPtr **)
-                 malloc((STD_SIZE) (sizeof(struct memoryPtr *) * MEM_TABLE_SIZE));
-
-   if (MemoryData(theEnv)->MemoryTable == NULL)
-     {
-      PrintErrorID(theEnv,"MEMORY",1,true);
-      EnvPrintRouter(theEnv,WERROR,"Out of memory.\n");
-      EnvExitRouter(theEnv,EXIT_FAILURE);
-     }
-   else
-     {
-      int i;
-      
-      for (i = 0; i < MEM_TABLE_SIZE; i++) MemoryData(theEnv)->MemoryTable[i] = NULL;
-     }
-#else // MEM_TABLE_SIZE == 0
-      MemoryData(theEnv)->MemoryTable = NULL;
-#endif 
+   /*=================================================*/
+   /* The slab classes and segment lists start out    */
+   /* empty (environment data is zero initialized).   */
+   /*=================================================*/
   }
 
 /***************************************************/
@@ -110,6 +123,23 @@ void *genalloc(
   Environment *theEnv,
   size_t size)
   {
+#if (MEM_TABLE_SIZE > 0)
+   if (size < MEM_TABLE_SIZE)
+     { return(SlabAllocate(theEnv,size)); }
+#endif
+
+   return(SystemAllocate(theEnv,size));
+  }
+
+/***************************************************/
+/* SystemAllocate: Allocates memory from the       */
+/*   system, releasing pooled memory and calling   */
+/*   the out of memory function if necessary.      */
+/***************************************************/
+static void *SystemAllocate(
+  Environment *theEnv,
+  size_t size)
+  {
    void *memPtr;
       
    memPtr = malloc(size);
@@ -178,6 +208,26 @@ void genfree(
   void *waste,
   size_t size)
   {   
+#if (MEM_TABLE_SIZE > 0)
+   if (size < MEM_TABLE_SIZE)
+     {
+      SlabFree(theEnv,waste);
+      return;
+     }
+#endif
+
+   SystemFree(theEnv,waste,size);
+  }
+
+/***************************************************/
+/* SystemFree: Returns memory to the system which  */
+/*   was allocated using SystemAllocate.           */
+/***************************************************/
+static void SystemFree(
+  Environment *theEnv,
+  void *waste,
+  size_t size)
+  {
    free(waste);
 
    MemoryData(theEnv)->MemoryAmount -= (long) size;
@@ -264,30 +314,58 @@ long int EnvReleaseMem(
   Environment *theEnv,
   long int maximum)
   {
-   struct memoryPtr *tmpPtr, *memPtr;
-   int i;
-   long int returns = 0;
    long int amount = 0;
+#if (MEM_TABLE_SIZE > 0)
+   struct slabPage *thePage, *nextPage;
+   struct slabSegment *theSegment, *nextSegment;
+   unsigned long segmentCount;
+   unsigned int i;
+
+   /*=====================================================*/
+   /* Each size class may hold on to one empty page to    */
+   /* avoid repeatedly acquiring and releasing a page. So */
+   /* that their segments can be released, these pages    */
+   /* are given back first.                               */
+   /*=====================================================*/
+
+   segmentCount = MemoryData(theEnv)->SegmentCount;
 
-   for (i = (MEM_TABLE_SIZE - 1) ; i >= (int) sizeof(char *) ; i--)
+   for (i = 1 ; i <= SLAB_CLASS_COUNT ; i++)
      {
-      YieldTime(theEnv);
-      memPtr = MemoryData(theEnv)->MemoryTable[i];
-      while (memPtr != NULL)
+      for (thePage = MemoryData(theEnv)->SlabClasses[i].available;
+           thePage != NULL;
+           thePage = nextPage)
         {
-         tmpPtr = memPtr->next;
-         genfree(theEnv,memPtr,(unsigned) i);
-         memPtr = tmpPtr;
-         amount += i;
-         returns++;
-         if ((returns % 100) == 0)
-           { YieldTime(theEnv); }
+         nextPage = thePage->next;
+         if (thePage->used == 0)
+           { ReleaseSlabPage(theEnv,thePage); }
         }
-      MemoryData(theEnv)->MemoryTable[i] = NULL;
-      if ((amount > maximum) && (maximum > 0))
-        { return(amount); }
      }
 
+   amount = (long) ((segmentCount - MemoryData(theEnv)->SegmentCount) * SLAB_SEGMENT_SIZE);
+
+   /*==================================================*/
+   /* Return the segments whose pages are all unused   */
+   /* to the system, including the one segment which   */
+   /* is otherwise retained for reuse.                 */
+   /*==================================================*/
+
+   for (theSegment = MemoryData(theEnv)->SlabSegments;
+        theSegment != NULL;
+        theSegment = nextSegment)
+     {
+      nextSegment = theSegment->next;
+      if (theSegment->freePageCount == SLAB_SEGMENT_PAGES)
+        {
+         YieldTime(theEnv);
+         ReleaseSlabSegment(theEnv,theSegment);
+         amount += (long) SLAB_SEGMENT_SIZE;
+         if ((amount > maximum) && (maximum > 0))
+           { return(amount); }
+        }
+     }
+#endif
+
    return(amount);
   }
 
@@ -298,36 +376,14 @@ void *gm1(
   Environment *theEnv,
   size_t size)
   {
-   struct memoryPtr *memPtr;
    char *tmpPtr;
-   size_t i;
 
    if (size < (long) sizeof(char *)) size = sizeof(char *);
 
-   if (size >= MEM_TABLE_SIZE)
-     {
-      tmpPtr = (char *) genalloc(theEnv,(unsigned) size);
-      for (i = 0 ; i < size ; i++)
-        { tmpPtr[i] = '\0'; }
-      return((void *) tmpPtr);
-     }
+   tmpPtr = (char *) genalloc(theEnv,size);
+   memset(tmpPtr,0,size);
 
-   memPtr = (struct memoryPtr *) MemoryData(theEnv)->MemoryTable[size];
-   if (memPtr == NULL)
-     {
-      tmpPtr = (char *) genalloc(theEnv,(unsigned) size);
-      for (i = 0 ; i < size ; i++)
-        { tmpPtr[i] = '\0'; }
-      return((void *) tmpPtr);
-     }
-
-   MemoryData(theEnv)->MemoryTable[size] = memPtr->next;
-
-   tmpPtr = (char *) memPtr;
-   for (i = 0 ; i < size ; i++)
-     { tmpPtr[i] = '\0'; }
-
-   return ((void *) tmpPtr);
+   return((void *) tmpPtr);
   }
 
 /*****************************************************/
@@ -337,27 +393,9 @@ void *gm2(
   Environment *theEnv,
   size_t size)
   {
-#if (MEM_TABLE_SIZE > 0)
-   struct memoryPtr *memPtr;
-#endif
-
    if (size < sizeof(char *)) size = sizeof(char *);
 
-#if (MEM_TABLE_SIZE > 0)
-   if (size >= MEM_TABLE_SIZE) return(genalloc(theEnv,(unsigned) size));
-
-   memPtr = (struct memoryPtr *) MemoryData(theEnv)->MemoryTable[size];
-   if (memPtr == NULL)
-     {
-      return(genalloc(theEnv,size));
-     }
-
-   MemoryData(theEnv)->MemoryTable[size] = memPtr->next;
-
-   return ((void *) memPtr);
-#else
    return(genalloc(theEnv,size));
-#endif
   }
 
 /*****************************************************/
@@ -367,25 +405,9 @@ void *gm3(
   Environment *theEnv,
   size_t size)
   {
-#if (MEM_TABLE_SIZE > 0)
-   struct memoryPtr *memPtr;
-#endif
-
    if (size < (long) sizeof(char *)) size = sizeof(char *);
 
-#if (MEM_TABLE_SIZE > 0)
-   if (size >= MEM_TABLE_SIZE) return(genalloc(theEnv,size));
-
-   memPtr = (struct memoryPtr *) MemoryData(theEnv)->MemoryTable[(int) size];
-   if (memPtr == NULL)
-     { return(genalloc(theEnv,size)); }
-
-   MemoryData(theEnv)->MemoryTable[(int) size] = memPtr->next;
-
-   return ((void *) memPtr);
-#else
    return(genalloc(theEnv,size));
-#endif
   }
 
 /****************************************/
@@ -397,10 +419,6 @@ void rm(
   void *str,
   size_t size)
   {
-#if (MEM_TABLE_SIZE > 0)
-   struct memoryPtr *memPtr;
-#endif
-
    if (size == 0)
      {
       SystemError(theEnv,"MEMORY",1);
@@ -410,19 +428,7 @@ void rm(
 
    if (size < sizeof(char *)) size = sizeof(char *);
 
-#if (MEM_TABLE_SIZE > 0)
-   if (size >= MEM_TABLE_SIZE)
-     {
-      genfree(theEnv,str,size);
-      return;
-     }
-
-   memPtr = (struct memoryPtr *) str;
-   memPtr->next = MemoryData(theEnv)->MemoryTable[size];
-   MemoryData(theEnv)->MemoryTable[size] = memPtr;
-#else
-   genfree(theEnv,str,size));
-#endif
+   genfree(theEnv,str,size);
   }
 
 /********************************************/
@@ -435,10 +441,6 @@ void rm3(
   void *str,
   size_t size)
   {
-#if (MEM_TABLE_SIZE > 0)
-   struct memoryPtr *memPtr;
-#endif
-
    if (size == 0)
      {
       SystemError(theEnv,"MEMORY",1);
@@ -448,19 +450,7 @@ void rm3(
 
    if (size < (long) sizeof(char *)) size = sizeof(char *);
    
-#if (MEM_TABLE_SIZE > 0)
-   if (size >= MEM_TABLE_SIZE)
-     {
-      genfree(theEnv,str,size);
-      return;
-     }
-
-   memPtr = (struct memoryPtr *) str;
-   memPtr->next = MemoryData(theEnv)->MemoryTable[(int) size];
-   MemoryData(theEnv)->MemoryTable[(int) size] = memPtr;
-#else
    genfree(theEnv,str,size);
-#endif
   }
 
 /***************************************************/
@@ -472,16 +462,21 @@ unsigned long PoolSize(
    unsigned long cnt = 0;
 
 #if (MEM_TABLE_SIZE > 0)
-   int i;
-   struct memoryPtr *memPtr;
+   struct slabSegment *theSegment;
+   struct slabPage *thePage;
+   unsigned int i;
 
-   for (i = sizeof(char *) ; i < MEM_TABLE_SIZE ; i++)
+   for (theSegment = MemoryData(theEnv)->SlabSegments;
+        theSegment != NULL;
+        theSegment = theSegment->next)
      {
-      memPtr = MemoryData(theEnv)->MemoryTable[i];
-      while (memPtr != NULL)
+      for (i = 0 ; i < SLAB_SEGMENT_PAGES ; i++)
         {
-         cnt += (unsigned long) i;
-         memPtr = memPtr->next;
+         thePage = (struct slabPage *) (theSegment->firstPage + (i * SLAB_PAGE_SIZE));
+         if (thePage->sizeClass == 0)
+           { cnt += SLAB_PAGE_SIZE; }
+         else
+           { cnt += (thePage->capacity - thePage->used) * (thePage->sizeClass * SLAB_GRANULE); }
         }
      }
 #endif
@@ -538,3 +533,710 @@ void genmemcpy(
    for (i = 0L ; i < size ; i++)
      dst[i] = src[i];
   }
+
+#if (MEM_TABLE_SIZE > 0)
+
+#define SLAB_PAGE_HEADER_SIZE \
+   ((sizeof(struct slabPage) + (2 * STRICT_ALIGN_SIZE) - 1) & ~((2 * STRICT_ALIGN_SIZE) - 1))
+
+/*******************************************************/
+/* SlabAllocate: Allocates a block from a page of the  */
+/*   size class for the block. Blocks are taken from   */
+/*   the free list of the page or from its unused      */
+/*   space. The size must be less than MEM_TABLE_SIZE. */
+/*******************************************************/
+void *SlabAllocate(
+  Environment *theEnv,
+  size_t size)
+  {
+   struct slabClass *theClass;
+   struct slabPage *thePage;
+   struct memoryPtr *theBlock;
+   unsigned int sizeClass;
+
+   if (size < sizeof(char *)) size = sizeof(char *);
+
+   sizeClass = (unsigned int) SlabClassIndex(size);
+   theClass = &MemoryData(theEnv)->SlabClasses[sizeClass];
+
+   thePage = theClass->available;
+   if (thePage == NULL)
+     {
+      thePage = AllocateSlabPage(theEnv,sizeClass);
+      if (thePage == NULL) return NULL;
+     }
+
+   if (thePage->freeBlocks != NULL)
+     {
+      theBlock = thePage->freeBlocks;
+      thePage->freeBlocks = theBlock->next;
+     }
+   else
+     {
+      theBlock = (struct memoryPtr *) thePage->nextUnused;
+      thePage->nextUnused += sizeClass * SLAB_GRANULE;
+     }
+
+   thePage->used++;
+
+   /*==================================================*/
+   /* A full page is removed from the list of pages of */
+   /* the class which have blocks available.           */
+   /*==================================================*/
+
+   if (thePage->used == thePage->capacity)
+     {
+      theClass->available = thePage->next;
+      if (thePage->next != NULL)
+        { thePage->next->prev = NULL; }
+      thePage->next = NULL;
+     }
+
+   theClass->liveBlocks++;
+   theClass->allocations++;
+
+   return((void *) theBlock);
+  }
+
+/*********************************************************/
+/* SlabFree: Returns a block to the page from which it   */
+/*   was allocated. A page which becomes empty is given  */
+/*   back to its segment unless it's the only page of    */
+/*   the class with blocks available.                    */
+/*********************************************************/
+void SlabFree(
+  Environment *theEnv,
+  void *waste)
+  {
+   struct slabClass *theClass;
+   struct slabPage *thePage;
+   struct memoryPtr *theBlock;
+
+   thePage = SlabPageOf(waste);
+   theBlock = (struct memoryPtr *) waste;
+
+   if (thePage->arena != NULL)
+     {
+      ArenaFree(theEnv,thePage,theBlock);
+      return;
+     }
+
+   theClass = &MemoryData(theEnv)->SlabClasses[thePage->sizeClass];
+
+   theBlock->next = thePage->freeBlocks;
+   thePage->freeBlocks = theBlock;
+
+   /*==============================================*/
+   /* A page which was full has blocks available   */
+   /* again, so add it to the list for the class.  */
+   /*==============================================*/
+
+   if (thePage->used == thePage->capacity)
+     {
+      thePage->prev = NULL;
+      thePage->next = theClass->available;
+      if (theClass->available != NULL)
+        { theClass->available->prev = thePage; }
+      theClass->available = thePage;
+     }
+
+   thePage->used--;
+   theClass->liveBlocks--;
+
+   if ((thePage->used == 0) &&
+       ((theClass->available != thePage) || (thePage->next != NULL)))
+     { ReleaseSlabPage(theEnv,thePage); }
+  }
+
+/*****************************************************************/
+/* CreateSlabArena: Creates an arena from which blocks of a      */
+/*   single size are allocated on pages private to the arena.    */
+/*   Keeping related blocks together improves their locality     */
+/*   and allows all of them to be released a page at a time.     */
+/*****************************************************************/
+struct slabArena *CreateSlabArena(
+  Environment *theEnv,
+  size_t size)
+  {
+   struct slabArena *theArena;
+
+   if (size >= MEM_TABLE_SIZE) return NULL;
+   if (size < sizeof(char *)) size = sizeof(char *);
+
+   theArena = get_struct(theEnv,slabArena);
+   theArena->available = NULL;
+   theArena->full = NULL;
+   theArena->pageCount = 0;
+   theArena->liveBlocks = 0;
+   theArena->sizeClass = (unsigned int) SlabClassIndex(size);
+   theArena->released = false;
+
+   MemoryData(theEnv)->ArenaCount++;
+
+   return(theArena);
+  }
+
+/*************************************************************/
+/* ArenaAllocate: Allocates a block from an arena. Blocks    */
+/*   of a size other than that of the arena (or requested    */
+/*   when there is no arena) are allocated normally.         */
+/*************************************************************/
+void *ArenaAllocate(
+  Environment *theEnv,
+  struct slabArena *theArena,
+  size_t size)
+  {
+   struct slabPage *thePage;
+   struct memoryPtr *theBlock;
+
+   if (! ArenaHoldsSize(theArena,size))
+     { return(genalloc(theEnv,size)); }
+
+   if (size < sizeof(char *)) size = sizeof(char *);
+
+   thePage = theArena->available;
+   if (thePage == NULL)
+     {
+      thePage = TakeSegmentPage(theEnv,theArena->sizeClass);
+      if (thePage == NULL) return NULL;
+      thePage->arena = theArena;
+      theArena->available = thePage;
+      theArena->pageCount++;
+      MemoryData(theEnv)->ArenaPageCount++;
+     }
+
+   if (thePage->freeBlocks != NULL)
+     {
+      theBlock = thePage->freeBlocks;
+      thePage->freeBlocks = theBlock->next;
+     }
+   else
+     {
+      theBlock = (struct memoryPtr *) thePage->nextUnused;
+      thePage->nextUnused += theArena->sizeClass * SLAB_GRANULE;
+     }
+
+   thePage->used++;
+   theArena->liveBlocks++;
+
+   /*================================================*/
+   /* Full pages are moved to a separate list so the */
+   /* arena can still find them when it's destroyed. */
+   /*================================================*/
+
+   if (thePage->used == thePage->capacity)
+     {
+      theArena->available = thePage->next;
+      if (thePage->next != NULL)
+        { thePage->next->prev = NULL; }
+
+      thePage->prev = NULL;
+      thePage->next = theArena->full;
+      if (theArena->full != NULL)
+        { theArena->full->prev = thePage; }
+      theArena->full = thePage;
+     }
+
+   return((void *) theBlock);
+  }
+
+/*************************************************************/
+/* ArenaHoldsSize: Returns true if blocks of the specified   */
+/*   size are allocated from the arena by ArenaAllocate.     */
+/*************************************************************/
+bool ArenaHoldsSize(
+  struct slabArena *theArena,
+  size_t size)
+  {
+   if (theArena == NULL) return false;
+   if (size >= MEM_TABLE_SIZE) return false;
+   if (size < sizeof(char *)) size = sizeof(char *);
+
+   return(SlabClassIndex(size) == theArena->sizeClass);
+  }
+
+/*************************************************************/
+/* ArenaOwnsBlock: Returns true if the block was allocated   */
+/*   from the arena by ArenaAllocate. The block must have    */
+/*   been allocated from a slab page (that is, its size is   */
+/*   less than MEM_TABLE_SIZE).                              */
+/*************************************************************/
+bool ArenaOwnsBlock(
+  Environment *theEnv,
+  struct slabArena *theArena,
+  void *theBlock)
+  {
+   if (theArena == NULL) return false;
+
+   return(SlabPageOf(theBlock)->arena == theArena);
+  }
+
+/**************************************************************/
+/* ArenaFree: Returns a block to its page in an arena. Empty  */
+/*   pages other than the last page of the arena are returned */
+/*   to their segment. An arena released by its owner is      */
+/*   deleted once its last block has been returned.           */
+/**************************************************************/
+static void ArenaFree(
+  Environment *theEnv,
+  struct slabPage *thePage,
+  struct memoryPtr *theBlock)
+  {
+   struct slabArena *theArena = thePage->arena;
+
+   theBlock->next = thePage->freeBlocks;
+   thePage->freeBlocks = theBlock;
+
+   if (thePage->used == thePage->capacity)
+     {
+      if (thePage->prev == NULL)
+        { theArena->full = thePage->next; }
+      else
+        { thePage->prev->next = thePage->next; }
+
+      if (thePage->next != NULL)
+        { thePage->next->prev = thePage->prev; }
+
+      thePage->prev = NULL;
+      thePage->next = theArena->available;
+      if (theArena->available != NULL)
+        { theArena->available->prev = thePage; }
+      theArena->available = thePage;
+     }
+
+   thePage->used--;
+   theArena->liveBlocks--;
+
+   if (theArena->liveBlocks == 0)
+     {
+      if (theArena->released)
+        {
+         ReturnArenaPages(theEnv,theArena);
+         MemoryData(theEnv)->ArenaCount--;
+         rtn_struct(theEnv,slabArena,theArena);
+         return;
+        }
+     }
+
+   if ((thePage->used == 0) && (theArena->pageCount > 1))
+     {
+      if (thePage->prev == NULL)
+        { theArena->available = thePage->next; }
+      else
+        { thePage->prev->next = thePage->next; }
+
+      if (thePage->next != NULL)
+        { thePage->next->prev = thePage->prev; }
+
+      theArena->pageCount--;
+      MemoryData(theEnv)->ArenaPageCount--;
+      ReturnSegmentPage(theEnv,thePage);
+     }
+  }
+
+/****************************************************************/
+/* ReleaseSlabArena: Called by the owner of an arena when it no */
+/*   longer needs the arena. If blocks allocated from the arena */
+/*   are still in use (for example, partial matches waiting on  */
+/*   the garbage list), the arena is deleted when the last of   */
+/*   them is returned.                                          */
+/****************************************************************/
+void ReleaseSlabArena(
+  Environment *theEnv,
+  struct slabArena *theArena)
+  {
+   if (theArena == NULL) return;
+
+   if (theArena->liveBlocks != 0)
+     {
+      theArena->released = true;
+      return;
+     }
+
+   ReturnArenaPages(theEnv,theArena);
+   MemoryData(theEnv)->ArenaCount--;
+   rtn_struct(theEnv,slabArena,theArena);
+  }
+
+/****************************************************************/
+/* AbandonSlabArena: Called by the owner of an arena when it no */
+/*   longer needs the arena and won't return the specified      */
+/*   number of blocks allocated from it. The abandoned blocks   */
+/*   are returned with the arena's pages, either immediately or */
+/*   once the blocks still in use have been returned.           */
+/****************************************************************/
+void AbandonSlabArena(
+  Environment *theEnv,
+  struct slabArena *theArena,
+  unsigned long abandonedBlocks)
+  {
+   if (theArena == NULL) return;
+
+   theArena->liveBlocks -= abandonedBlocks;
+   ReleaseSlabArena(theEnv,theArena);
+  }
+
+/*******************************************************************/
+/* DestroySlabArena: Deletes an arena along with all of the blocks */
+/*   allocated from it, regardless of whether they've been         */
+/*   returned. The cost is proportional to the number of pages     */
+/*   used by the arena rather than the number of blocks.           */
+/*******************************************************************/
+void DestroySlabArena(
+  Environment *theEnv,
+  struct slabArena *theArena)
+  {
+   if (theArena == NULL) return;
+
+   ReturnArenaPages(theEnv,theArena);
+   MemoryData(theEnv)->ArenaCount--;
+   rtn_struct(theEnv,slabArena,theArena);
+  }
+
+/***************************************************************/
+/* ReturnArenaPages: Returns all of the pages used by an arena */
+/*   to their segments.                                        */
+/***************************************************************/
+static void ReturnArenaPages(
+  Environment *theEnv,
+  struct slabArena *theArena)
+  {
+   struct slabPage *thePage, *nextPage;
+
+   for (thePage = theArena->available; thePage != NULL; thePage = nextPage)
+     {
+      nextPage = thePage->next;
+      ReturnSegmentPage(theEnv,thePage);
+     }
+
+   for (thePage = theArena->full; thePage != NULL; thePage = nextPage)
+     {
+      nextPage = thePage->next;
+      ReturnSegmentPage(theEnv,thePage);
+     }
+
+   MemoryData(theEnv)->ArenaPageCount -= theArena->pageCount;
+
+   theArena->available = NULL;
+   theArena->full = NULL;
+   theArena->pageCount = 0;
+   theArena->liveBlocks = 0;
+  }
+
+/***************************************************************/
+/* AllocateSlabPage: Takes an unused page from a segment and   */
+/*   adds it to the pages of a size class.                     */
+/***************************************************************/
+static struct slabPage *AllocateSlabPage(
+  Environment *theEnv,
+  unsigned int sizeClass)
+  {
+   struct slabPage *thePage;
+   struct slabClass *theClass;
+
+   thePage = TakeSegmentPage(theEnv,sizeClass);
+   if (thePage == NULL) return NULL;
+
+   theClass = &MemoryData(theEnv)->SlabClasses[sizeClass];
+   thePage->prev = NULL;
+   thePage->next = theClass->available;
+   if (theClass->available != NULL)
+     { theClass->available->prev = thePage; }
+   theClass->available = thePage;
+   theClass->pageCount++;
+
+   return(thePage);
+  }
+
+/****************************************************************/
+/* TakeSegmentPage: Takes an unused page from a segment (or a   */
+/*   new segment) and prepares it for blocks of a size class.   */
+/****************************************************************/
+static struct slabPage *TakeSegmentPage(
+  Environment *theEnv,
+  unsigned int sizeClass)
+  {
+   struct slabSegment *theSegment;
+   struct slabPage *thePage;
+
+   theSegment = MemoryData(theEnv)->AvailableSegments;
+   if (theSegment == NULL)
+     {
+      theSegment = AllocateSlabSegment(theEnv);
+      if (theSegment == NULL) return NULL;
+     }
+
+   if (theSegment->freePageCount == SLAB_SEGMENT_PAGES)
+     { MemoryData(theEnv)->EmptySegmentCount--; }
+
+   thePage = theSegment->freePages;
+   theSegment->freePages = thePage->next;
+   theSegment->freePageCount--;
+
+   /*===================================================*/
+   /* A segment with no unused pages is removed from    */
+   /* the list of segments with pages available.        */
+   /*===================================================*/
+
+   if (theSegment->freePageCount == 0)
+     {
+      MemoryData(theEnv)->AvailableSegments = theSegment->nextAvailable;
+      if (theSegment->nextAvailable != NULL)
+        { theSegment->nextAvailable->prevAvailable = NULL; }
+      theSegment->nextAvailable = NULL;
+     }
+
+   thePage->sizeClass = sizeClass;
+   thePage->used = 0;
+   thePage->capacity = (unsigned int) ((SLAB_PAGE_SIZE - SLAB_PAGE_HEADER_SIZE) / (sizeClass * SLAB_GRANULE));
+   thePage->freeBlocks = NULL;
+   thePage->nextUnused = ((char *) thePage) + SLAB_PAGE_HEADER_SIZE;
+   thePage->arena = NULL;
+   thePage->next = NULL;
+   thePage->prev = NULL;
+
+   return(thePage);
+  }
+
+/***************************************************************/
+/* ReleaseSlabPage: Removes an empty page from the pages of    */
+/*   its size class and returns it to its segment.             */
+/***************************************************************/
+static void ReleaseSlabPage(
+  Environment *theEnv,
+  struct slabPage *thePage)
+  {
+   struct slabClass *theClass;
+
+   theClass = &MemoryData(theEnv)->SlabClasses[thePage->sizeClass];
+
+   if (thePage->prev == NULL)
+     { theClass->available = thePage->next; }
+   else
+     { thePage->prev->next = thePage->next; }
+
+   if (thePage->next != NULL)
+     { thePage->next->prev = thePage->prev; }
+
+   theClass->pageCount--;
+
+   ReturnSegmentPage(theEnv,thePage);
+  }
+
+/*****************************************************************/
+/* ReturnSegmentPage: Returns an empty page to its segment. Only */
+/*   one segment with all of its pages unused is retained; any   */
+/*   other such segment is returned to the system.               */
+/*****************************************************************/
+static void ReturnSegmentPage(
+  Environment *theEnv,
+  struct slabPage *thePage)
+  {
+   struct slabSegment *theSegment;
+
+   thePage->sizeClass = 0;
+   thePage->arena = NULL;
+   thePage->prev = NULL;
+
+   theSegment = thePage->segment;
+   thePage->next = theSegment->freePages;
+   theSegment->freePages = thePage;
+   theSegment->freePageCount++;
+
+   if (theSegment->freePageCount == 1)
+     {
+      theSegment->prevAvailable = NULL;
+      theSegment->nextAvailable = MemoryData(theEnv)->AvailableSegments;
+      if (MemoryData(theEnv)->AvailableSegments != NULL)
+        { MemoryData(theEnv)->AvailableSegments->prevAvailable = theSegment; }
+      MemoryData(theEnv)->AvailableSegments = theSegment;
+     }
+
+   if (theSegment->freePageCount == SLAB_SEGMENT_PAGES)
+     {
+      if (MemoryData(theEnv)->EmptySegmentCount > 0)
+        { ReleaseSlabSegment(theEnv,theSegment); }
+      else
+        { MemoryData(theEnv)->EmptySegmentCount++; }
+     }
+  }
+
+/*****************************************************************/
+/* AllocateSlabSegment: Allocates a segment of pages from the    */
+/*   system. The segment header is placed at the start of the    */
+/*   allocation and the pages follow on a page size boundary.    */
+/*****************************************************************/
+static struct slabSegment *AllocateSlabSegment(
+  Environment *theEnv)
+  {
+   char *rawMemory;
+   struct slabSegment *theSegment;
+   struct slabPage *thePage;
+   size_t firstPage;
+   int i;
+
+   rawMemory = (char *) SystemAllocate(theEnv,SLAB_SEGMENT_SIZE);
+   if (rawMemory == NULL) return NULL;
+
+   theSegment = (struct slabSegment *) rawMemory;
+
+   firstPage = ((size_t) rawMemory) + sizeof(struct slabSegment);
+   firstPage = (firstPage + SLAB_PAGE_SIZE - 1) & ~((size_t) SLAB_PAGE_SIZE - 1);
+   theSegment->firstPage = (char *) firstPage;
+
+   /*=====================================================*/
+   /* Link the pages into the free page list in address   */
+   /* order.                                              */
+   /*=====================================================*/
+
+   theSegment->freePages = NULL;
+   for (i = SLAB_SEGMENT_PAGES - 1 ; i >= 0 ; i--)
+     {
+      thePage = (struct slabPage *) (theSegment->firstPage + (i * SLAB_PAGE_SIZE));
+      thePage->segment = theSegment;
+      thePage->sizeClass = 0;
+      thePage->arena = NULL;
+      thePage->used = 0;
+      thePage->capacity = 0;
+      thePage->prev = NULL;
+      thePage->next = theSegment->freePages;
+      theSegment->freePages = thePage;
+     }
+
+   theSegment->freePageCount = SLAB_SEGMENT_PAGES;
+   MemoryData(theEnv)->EmptySegmentCount++;
+
+   theSegment->prev = NULL;
+   theSegment->next = MemoryData(theEnv)->SlabSegments;
+   if (theSegment->next != NULL)
+     { theSegment->next->prev = theSegment; }
+   MemoryData(theEnv)->SlabSegments = theSegment;
+
+   theSegment->prevAvailable = NULL;
+   theSegment->nextAvailable = MemoryData(theEnv)->AvailableSegments;
+   if (theSegment->nextAvailable != NULL)
+     { theSegment->nextAvailable->prevAvailable = theSegment; }
+   MemoryData(theEnv)->AvailableSegments = theSegment;
+
+   MemoryData(theEnv)->SegmentCount++;
+
+   return(theSegment);
+  }
+
+/******************************************************************/
+/* ReleaseSlabSegment: Returns a segment whose pages are all      */
+/*   unused to the system.                                        */
+/******************************************************************/
+static void ReleaseSlabSegment(
+  Environment *theEnv,
+  struct slabSegment *theSegment)
+  {
+   if (theSegment->prev == NULL)
+     { MemoryData(theEnv)->SlabSegments = theSegment->next; }
+   else
+     { theSegment->prev->next = theSegment->next; }
+
+   if (theSegment->next != NULL)
+     { theSegment->next->prev = theSegment->prev; }
+
+   if (theSegment->prevAvailable == NULL)
+     { MemoryData(theEnv)->AvailableSegments = theSegment->nextAvailable; }
+   else
+     { theSegment->prevAvailable->nextAvailable = theSegment->nextAvailable; }
+
+   if (theSegment->nextAvailable != NULL)
+     { theSegment->nextAvailable->prevAvailable = theSegment->prevAvailable; }
+
+   MemoryData(theEnv)->SegmentCount--;
+   MemoryData(theEnv)->EmptySegmentCount--;
+
+   SystemFree(theEnv,theSegment,SLAB_SEGMENT_SIZE);
+  }
+
+#else /* MEM_TABLE_SIZE == 0 */
+
+/*************************************************/
+/* CreateSlabArena: Arenas require the small     */
+/*   block allocator, so none can be created.    */
+/*************************************************/
+struct slabArena *CreateSlabArena(
+  Environment *theEnv,
+  size_t size)
+  {
+#if MAC_XCD
+#pragma unused(theEnv,size)
+#endif
+   return NULL;
+  }
+
+/*****************************************/
+/* ArenaAllocate: Allocates the block    */
+/*   normally since there are no arenas. */
+/*****************************************/
+void *ArenaAllocate(
+  Environment *theEnv,
+  struct slabArena *theArena,
+  size_t size)
+  {
+#if MAC_XCD
+#pragma unused(theArena)
+#endif
+   return(genalloc(theEnv,size));
+  }
+
+/*****************************************/
+/* ArenaHoldsSize: Returns false since   */
+/*   there are no arenas.                */
+/*****************************************/
+bool ArenaHoldsSize(
+  struct slabArena *theArena,
+  size_t size)
+  {
+#if MAC_XCD
+#pragma unused(theArena,size)
+#endif
+   return false;
+  }
+
+/*****************************************/
+/* ArenaOwnsBlock: Returns false since   */
+/*   there are no arenas.                */
+/*****************************************/
+bool ArenaOwnsBlock(
+  Environment *theEnv,
+  struct slabArena *theArena,
+  void *theBlock)
+  {
+#if MAC_XCD
+#pragma unused(theEnv,theArena,theBlock)
+#endif
+   return false;
+  }
+
+/************************************/
+/* ReleaseSlabArena: Does nothing   */
+/*   since there are no arenas.     */
+/************************************/
+void ReleaseSlabArena(
+  Environment *theEnv,
+  struct slabArena *theArena)
+  {
+#if MAC_XCD
+#pragma unused(theEnv,theArena)
+#endif
+  }
+
+/************************************/
+/* DestroySlabArena: Does nothing   */
+/*   since there are no arenas.     */
+/************************************/
+void DestroySlabArena(
+  Environment *theEnv,
+  struct slabArena *theArena)
+  {
+#if MAC_XCD
+#pragma unused(theEnv,theArena)
+#endif
+  }
+
+#endif /* MEM_TABLE_SIZE > 0 */
@@ -52,6 +52,18 @@
 /*                                                           */
 /*            ALLOW_ENVIRONMENT_GLOBALS no longer supported. */
 /*                                                           */
+/*            Small blocks are allocated from size classed   */
+/*            slab pages which are returned to the system    */
+/*            when they are no longer in use.                */
+/*                                                           */
+/*            Added slab arenas for blocks which share a     */
+/*            common owner.                                  */
+/*                                                           */
+/*            The struct macros allocate and return blocks   */
+/*            inline when a page doesn't fill or empty.      */
+/*                                                           */
+/*            Added AbandonSlabArena function.               */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_memalloc
@@ -65,6 +77,9 @@
 struct chunkInfo;
 struct blockInfo;
 struct memoryPtr;
+struct slabPage;
+struct slabSegment;
+struct slabArena;
 
 typedef bool OutOfMemoryFunction(Environment *,size_t);
 
@@ -72,6 +87,38 @@ typedef bool OutOfMemoryFunction(Environment *,size_t);
 #define MEM_TABLE_SIZE 500
 #endif
 
+/*=================================================*/
+/* Blocks smaller than MEM_TABLE_SIZE are rounded  */
+/* up to a multiple of SLAB_GRANULE and allocated  */
+/* from pages dedicated to that size class. Pages  */
+/* are carved from segments of SLAB_SEGMENT_PAGES  */
+/* pages obtained from the system. SLAB_PAGE_SIZE  */
+/* must be a power of two.                         */
+/*=================================================*/
+
+#define SLAB_GRANULE 8
+
+#ifndef SLAB_PAGE_SIZE
+#define SLAB_PAGE_SIZE 16384
+#endif
+
+#ifndef SLAB_SEGMENT_PAGES
+#define SLAB_SEGMENT_PAGES 16
+#endif
+
+/*=================================================*/
+/* A segment is allocated with room for its header */
+/* and the slack needed to align its first page on */
+/* a SLAB_PAGE_SIZE boundary.                      */
+/*=================================================*/
+
+#define SLAB_SEGMENT_SIZE \
+   ((SLAB_PAGE_SIZE * (SLAB_SEGMENT_PAGES + 1)) + sizeof(struct slabSegment))
+
+#define SLAB_CLASS_COUNT ((MEM_TABLE_SIZE + SLAB_GRANULE - 1) / SLAB_GRANULE)
+
+#define SlabClassIndex(size) (((size) + SLAB_GRANULE - 1) / SLAB_GRANULE)
+
 struct chunkInfo
   {
    struct chunkInfo *prevChunk;
@@ -93,59 +140,109 @@ struct memoryPtr
    struct memoryPtr *next;
   };
 
+struct slabPage
+  {
+   struct slabPage *next;
+   struct slabPage *prev;
+   struct slabSegment *segment;
+   struct slabArena *arena;
+   struct memoryPtr *freeBlocks;
+   char *nextUnused;
+   unsigned int used;
+   unsigned int capacity;
+   unsigned int sizeClass;
+  };
+
+struct slabSegment
+  {
+   struct slabSegment *next;
+   struct slabSegment *prev;
+   struct slabSegment *nextAvailable;
+   struct slabSegment *prevAvailable;
+   struct slabPage *freePages;
+   char *firstPage;
+   unsigned int freePageCount;
+  };
+
+struct slabClass
+  {
+   struct slabPage *available;
+   unsigned long pageCount;
+   unsigned long liveBlocks;
+   unsigned long allocations;
+  };
+
+struct slabArena
+  {
+   struct slabPage *available;
+   struct slabPage *full;
+   unsigned long pageCount;
+   unsigned long liveBlocks;
+   unsigned int sizeClass;
+   bool released;
+  };
+
 #if (MEM_TABLE_SIZE > 0)
 /*
  * Normal memory management case
  */
 
+/*=================================================*/
+/* The struct macros take a block from, or return  */
+/* a block to, the free list of a page inline when */
+/* the page neither fills nor empties as a result. */
+/* Otherwise SlabAllocate or SlabFree is called to */
+/* update the pages of the size class.             */
+/*=================================================*/
+
+#define SlabPageOf(ptr) \
+   ((struct slabPage *) (((size_t) (ptr)) & ~((size_t) SLAB_PAGE_SIZE - 1)))
+
+#define SlabStructClass(theEnv,size) \
+   (MemoryData(theEnv)->SlabClasses[SlabClassIndex(size)])
+
+#define get_sized_struct(theEnv,size) \
+  ((((MemoryData(theEnv)->TempSlabPage = SlabStructClass(theEnv,size).available) == NULL) || \
+    (MemoryData(theEnv)->TempSlabPage->freeBlocks == NULL) || \
+    ((MemoryData(theEnv)->TempSlabPage->used + 1) >= MemoryData(theEnv)->TempSlabPage->capacity)) ? \
+   SlabAllocate(theEnv,size) : \
+   ((MemoryData(theEnv)->TempMemoryPtr = MemoryData(theEnv)->TempSlabPage->freeBlocks), \
+    MemoryData(theEnv)->TempSlabPage->freeBlocks = MemoryData(theEnv)->TempMemoryPtr->next, \
+    MemoryData(theEnv)->TempSlabPage->used++, \
+    SlabStructClass(theEnv,size).liveBlocks++, \
+    SlabStructClass(theEnv,size).allocations++, \
+    ((void *) MemoryData(theEnv)->TempMemoryPtr)))
+
 #define get_struct(theEnv,type) \
-  ((MemoryData(theEnv)->MemoryTable[sizeof(struct type)] == NULL) ? \
-   ((struct type *) genalloc(theEnv,sizeof(struct type))) :\
-   ((MemoryData(theEnv)->TempMemoryPtr = MemoryData(theEnv)->MemoryTable[sizeof(struct type)]),\
-    MemoryData(theEnv)->MemoryTable[sizeof(struct type)] = MemoryData(theEnv)->TempMemoryPtr->next,\
-    ((struct type *) MemoryData(theEnv)->TempMemoryPtr)))
+  ((struct type *) get_sized_struct(theEnv,sizeof(struct type)))
 
 #define rtn_struct(theEnv,type,struct_ptr) \
-  (MemoryData(theEnv)->TempMemoryPtr = (struct memoryPtr *) struct_ptr,\
-   MemoryData(theEnv)->TempMemoryPtr->next = MemoryData(theEnv)->MemoryTable[sizeof(struct type)], \
-   MemoryData(theEnv)->MemoryTable[sizeof(struct type)] = MemoryData(theEnv)->TempMemoryPtr)
+  rtn_sized_struct(theEnv,sizeof(struct type),struct_ptr)
 
 #define rtn_sized_struct(theEnv,size,struct_ptr) \
-  (MemoryData(theEnv)->TempMemoryPtr = (struct memoryPtr *) struct_ptr,\
-   MemoryData(theEnv)->TempMemoryPtr->next = MemoryData(theEnv)->MemoryTable[size], \
-   MemoryData(theEnv)->MemoryTable[size] = MemoryData(theEnv)->TempMemoryPtr)
+  ((MemoryData(theEnv)->TempSlabPage = SlabPageOf(struct_ptr)), \
+   (((MemoryData(theEnv)->TempSlabPage->arena != NULL) || \
+     (MemoryData(theEnv)->TempSlabPage->used <= 1) || \
+     (MemoryData(theEnv)->TempSlabPage->used >= MemoryData(theEnv)->TempSlabPage->capacity)) ? \
+    SlabFree(theEnv,(void *) (struct_ptr)) : \
+    ((MemoryData(theEnv)->TempMemoryPtr = (struct memoryPtr *) (struct_ptr)), \
+     MemoryData(theEnv)->TempMemoryPtr->next = MemoryData(theEnv)->TempSlabPage->freeBlocks, \
+     MemoryData(theEnv)->TempSlabPage->freeBlocks = MemoryData(theEnv)->TempMemoryPtr, \
+     MemoryData(theEnv)->TempSlabPage->used--, \
+     MemoryData(theEnv)->SlabClasses[MemoryData(theEnv)->TempSlabPage->sizeClass].liveBlocks--, \
+     (void) 0)))
 
 #define get_var_struct(theEnv,type,vsize) \
-  ((((sizeof(struct type) + vsize) <  MEM_TABLE_SIZE) ? \
-    (MemoryData(theEnv)->MemoryTable[sizeof(struct type) + vsize] == NULL) : 1) ? \
-   ((struct type *) genalloc(theEnv,(sizeof(struct type) + vsize))) :\
-   ((MemoryData(theEnv)->TempMemoryPtr = MemoryData(theEnv)->MemoryTable[sizeof(struct type) + vsize]),\
-    MemoryData(theEnv)->MemoryTable[sizeof(struct type) + vsize] = MemoryData(theEnv)->TempMemoryPtr->next,\
-    ((struct type *) MemoryData(theEnv)->TempMemoryPtr)))
+  ((struct type *) gm2(theEnv,(sizeof(struct type) + vsize)))
 
 #define rtn_var_struct(theEnv,type,vsize,struct_ptr) \
-  (MemoryData(theEnv)->TempSize = sizeof(struct type) + vsize, \
-   ((MemoryData(theEnv)->TempSize < MEM_TABLE_SIZE) ? \
-    (MemoryData(theEnv)->TempMemoryPtr = (struct memoryPtr *) struct_ptr,\
-     MemoryData(theEnv)->TempMemoryPtr->next = MemoryData(theEnv)->MemoryTable[MemoryData(theEnv)->TempSize], \
-     MemoryData(theEnv)->MemoryTable[MemoryData(theEnv)->TempSize] =  MemoryData(theEnv)->TempMemoryPtr) : \
-    (genfree(theEnv,struct_ptr,MemoryData(theEnv)->TempSize),(struct memoryPtr *) struct_ptr)))
+  (rm(theEnv,(void *) struct_ptr,(sizeof(struct type) + vsize)))
 
 #define get_mem(theEnv,size) \
-  (((size <  MEM_TABLE_SIZE) ? \
-    (MemoryData(theEnv)->MemoryTable[size] == NULL) : 1) ? \
-   ((void *) genalloc(theEnv,(size_t) (size))) :\
-   ((MemoryData(theEnv)->TempMemoryPtr = MemoryData(theEnv)->MemoryTable[size]),\
-    MemoryData(theEnv)->MemoryTable[size] = MemoryData(theEnv)->TempMemoryPtr->next,\
-    ((void *) MemoryData(theEnv)->TempMemoryPtr)))
+  ((void *) gm2(theEnv,(size_t) (size)))
 
 #define rtn_mem(theEnv,size,ptr) \
-  (MemoryData(theEnv)->TempSize = size, \
-   ((MemoryData(theEnv)->TempSize < MEM_TABLE_SIZE) ? \
-    (MemoryData(theEnv)->TempMemoryPtr = (struct memoryPtr *) ptr,\
-     MemoryData(theEnv)->TempMemoryPtr->next = MemoryData(theEnv)->MemoryTable[MemoryData(theEnv)->TempSize], \
-     MemoryData(theEnv)->MemoryTable[MemoryData(theEnv)->TempSize] =  MemoryData(theEnv)->TempMemoryPtr) : \
-    (genfree(theEnv,ptr,MemoryData(theEnv)->TempSize),(struct memoryPtr *) ptr)))
+  (rm(theEnv,(void *) ptr,(size_t) (size)))
 
 #else // MEM_TABLE_SIZE == 0
 /*
@@ -179,9 +276,17 @@ struct memoryData
    long int MemoryCalls;
    bool ConserveMemory;
    OutOfMemoryFunction *OutOfMemoryCallback;
+#if (MEM_TABLE_SIZE > 0)
+   struct slabClass SlabClasses[SLAB_CLASS_COUNT + 1];
+   struct slabSegment *SlabSegments;
+   struct slabSegment *AvailableSegments;
+   unsigned long SegmentCount;
+   unsigned long EmptySegmentCount;
+   struct slabPage *TempSlabPage;
    struct memoryPtr *TempMemoryPtr;
-   struct memoryPtr **MemoryTable;
-   size_t TempSize;
+   unsigned long ArenaCount;
+   unsigned long ArenaPageCount;
+#endif
   };
 
 #define MemoryData(theEnv) ((struct memoryData *) GetEnvironmentData(theEnv,MEMORY_DATA))
@@ -209,6 +314,17 @@ struct memoryData
    bool                           EnvSetConserveMemory(Environment *,bool);
    bool                           EnvGetConserveMemory(Environment *);
    void                           genmemcpy(char *,char *,unsigned long);
+#if (MEM_TABLE_SIZE > 0)
+   void                          *SlabAllocate(Environment *,size_t);
+   void                           SlabFree(Environment *,void *);
+#endif
+   struct slabArena              *CreateSlabArena(Environment *,size_t);
+   void                          *ArenaAllocate(Environment *,struct slabArena *,size_t);
+   bool                           ArenaHoldsSize(struct slabArena *,size_t);
+   bool                           ArenaOwnsBlock(Environment *,struct slabArena *,void *);
+   void                           ReleaseSlabArena(Environment *,struct slabArena *);
+   void                           AbandonSlabArena(Environment *,struct slabArena *,unsigned long);
+   void                           DestroySlabArena(Environment *,struct slabArena *);
 
 #endif /* _H_memalloc */
 
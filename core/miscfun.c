@@ -94,6 +94,9 @@
 /*                                                           */
 /*      6.50: Fact ?var:slot reference support.              */
 /*                                                           */
+/*            length$ uses the length kept in the symbol     */
+/*            table entry of a string or symbol.             */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
@@ -421,7 +424,7 @@ void LengthFunction(
 
    if (mCVIsType(&theArg,LEXEME_TYPES))
      {
-      mCVSetInteger(returnValue,strlen(mCVToString(&theArg)));
+      mCVSetInteger(returnValue,((SYMBOL_HN *) theArg.value)->length);
       return;
      }
 
@@ -54,6 +54,9 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            The handler core cache replaces the stack of   */
+/*            cores in deallocating environment data.        */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -227,29 +230,7 @@ void SetupMessageHandlers(
 static void DeallocateMessageHandlerData(
   Environment *theEnv)
   {
-   HANDLER_LINK *tmp, *mhead, *chead;
-    
-   mhead = MessageHandlerData(theEnv)->TopOfCore;
-   while (mhead != NULL)
-     { 
-      tmp = mhead;
-      mhead = mhead->nxt;
-      rtn_struct(theEnv,messageHandlerLink,tmp);
-     }
-     
-   chead = MessageHandlerData(theEnv)->OldCore;
-   while (chead != NULL)
-     { 
-      mhead = chead;
-      chead = chead->nxtInStack;
-      
-      while (mhead != NULL)
-        {
-         tmp = mhead;
-         mhead = mhead->nxt;
-         rtn_struct(theEnv,messageHandlerLink,tmp);
-        }
-     }
+   ReturnHandlerCores(theEnv);
   }
 
 /*****************************************************
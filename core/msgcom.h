@@ -53,6 +53,8 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added the handler core cache.                  */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_msgcom
@@ -83,7 +85,10 @@ struct messageHandlerData
    HANDLER_LINK *CurrentCore;
    HANDLER_LINK *TopOfCore;
    HANDLER_LINK *NextInCore;
-   HANDLER_LINK *OldCore;
+   HANDLER_CORE *HandlerCoreCache[HANDLER_CORE_CACHE_SIZE];
+   unsigned long HandlerChanges;
+   unsigned long CachedHandlerChanges;
+   unsigned long CachedClassTableChanges;
   };
 
 #define MessageHandlerData(theEnv) ((struct messageHandlerData *) GetEnvironmentData(theEnv,MESSAGE_HANDLER_DATA))
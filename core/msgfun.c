@@ -47,6 +47,9 @@
 /*      6.50: Option printing of carriage return for the     */
 /*            SlotVisibilityViolationError function.         */
 /*                                                           */
+/*            Changes to handlers invalidate the handler     */
+/*            core cache.                                    */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -276,6 +279,7 @@ void NewSystemHandler(
                    header, NULL on errors
   SIDE EFFECTS : Class handler array reallocated
                    and resorted
+                 Cached handler cores invalidated
   NOTES        : Assumes handler does not exist
  ***************************************************/
 DefmessageHandler *InsertHandlerHeader(
@@ -333,6 +337,7 @@ DefmessageHandler *InsertHandlerHeader(
    cls->handlers = nhnd;
    cls->handlerOrderMap = narr;
    cls->handlerCount++;
+   MessageHandlerData(theEnv)->HandlerChanges++;
    return(&nhnd[cls->handlerCount-1]);
   }
 
@@ -475,6 +480,7 @@ bool DeleteHandler(
   INPUTS       : The class
   RETURNS      : Nothing useful
   SIDE EFFECTS : Marked handlers are deleted
+                 Cached handler cores invalidated
   NOTES        : Assumes none of the handlers are
                    currently executing or have a
                    busy count != 0 for any reason
@@ -511,6 +517,7 @@ void DeallocateMarkedHandlers(
      }
    if (count == 0)
      return;
+   MessageHandlerData(theEnv)->HandlerChanges++;
    if (count == cls->handlerCount)
      {
       rm(theEnv,cls->handlers,(sizeof(DefmessageHandler) * cls->handlerCount));
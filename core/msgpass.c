@@ -58,6 +58,14 @@
 /*      6.50: Option printing of carriage return for the     */
 /*            SlotVisibilityViolationError function.         */
 /*                                                           */
+/*            The applicable handlers for a class and        */
+/*            message are cached and reused by later         */
+/*            sends until handlers or classes change.        */
+/*                                                           */
+/*            A send of a get- or put- message whose only    */
+/*            applicable handler is a slot accessor reads or */
+/*            writes the slot directly.                      */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -71,12 +79,15 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "argacces.h"
 #include "classcom.h"
 #include "classfun.h"
 #include "commline.h"
 #include "constrct.h"
+#include "cstrnchk.h"
+#include "engine.h"
 #include "envrnmnt.h"
 #include "exprnpsr.h"
 #include "inscom.h"
@@ -99,7 +110,20 @@
 /***************************************/
 
    static bool                    PerformMessage(Environment *,CLIPSValue *,EXPRESSION *,SYMBOL_HN *);
-   static HANDLER_LINK           *FindApplicableHandlers(Environment *,Defclass *,SYMBOL_HN *);
+   static HANDLER_CORE           *FindApplicableHandlers(Environment *,Defclass *,SYMBOL_HN *);
+   static bool                    IsSlotAccessorMessage(SYMBOL_HN *,EXPRESSION *);
+   static void                    SendSlotAccessorMessage(Environment *,CLIPSValue *,EXPRESSION *,SYMBOL_HN *);
+   static bool                    EvaluateMessageArgument(Environment *,EXPRESSION *,CLIPSValue *,SYMBOL_HN *);
+   static void                    SetMessageArgument(EXPRESSION *,CLIPSValue *,EXPRESSION *);
+   static bool                    SlotValueAccepted(Environment *,Instance *,INSTANCE_SLOT *,CLIPSValue *);
+   static bool                    HandlerCoreWatched(Environment *,HANDLER_CORE *);
+   static HANDLER_CORE           *FindCachedHandlerCore(Environment *,Defclass *,SYMBOL_HN *);
+   static HANDLER_CORE           *MakeHandlerCore(Environment *,Defclass *,SYMBOL_HN *);
+   static void                    ResolveHandlerCoreSlot(Environment *,HANDLER_CORE *);
+   static void                    ReleaseHandlerCore(Environment *,HANDLER_CORE *);
+   static void                    InvalidateHandlerCores(Environment *);
+   static void                    RemoveHandlerCore(Environment *,HANDLER_CORE *);
+   static unsigned                HashHandlerCore(Defclass *,SYMBOL_HN *);
    static void                    CallHandlers(Environment *,CLIPSValue *);
    static void                    EarlySlotBindError(Environment *,Instance *,Defclass *,unsigned);
 
@@ -222,6 +246,35 @@ void DestroyHandlerLinks(
      }
   }
 
+/*****************************************************
+  NAME         : ReturnHandlerCores
+  DESCRIPTION  : Deletes all the cores in the handler
+                   core cache
+  INPUTS       : None
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Cores deallocated
+  NOTES        : Busy counts are not adjusted - only
+                   used when the environment is being
+                   deallocated
+ *****************************************************/
+void ReturnHandlerCores(
+  Environment *theEnv)
+  {
+   HANDLER_CORE *core;
+   int i;
+
+   for (i = 0 ; i < HANDLER_CORE_CACHE_SIZE ; i++)
+     {
+      while (MessageHandlerData(theEnv)->HandlerCoreCache[i] != NULL)
+        {
+         core = MessageHandlerData(theEnv)->HandlerCoreCache[i];
+         MessageHandlerData(theEnv)->HandlerCoreCache[i] = core->nxt;
+         rm(theEnv,core->links,(sizeof(HANDLER_LINK) * core->linkCount));
+         rtn_struct(theEnv,handlerCore,core);
+        }
+     }
+  }
+
 /***********************************************************************
   NAME         : SendCommand
   DESCRIPTION  : Determines the applicable handler(s) and sets up the
@@ -254,6 +307,12 @@ void SendCommand(
    args.argList = GetFirstArgument()->argList;
    args.nextArg = GetFirstArgument()->nextArg->nextArg;
 
+   if (IsSlotAccessorMessage(msg,args.nextArg))
+     {
+      SendSlotAccessorMessage(theEnv,returnValue,&args,msg);
+      return;
+     }
+
    PerformMessage(theEnv,returnValue,&args,msg);
   }
 
@@ -969,6 +1028,262 @@ void DynamicHandlerPutSlot(
    =========================================
    ***************************************** */
 
+/*****************************************************
+  NAME         : IsSlotAccessorMessage
+  DESCRIPTION  : Determines if a send could be handled
+                   by a slot accessor handler
+  INPUTS       : 1) The message name
+                 2) The message argument expressions
+                    (not including the object)
+  RETURNS      : True for a get- message with no
+                   arguments or a put- message with
+                   one argument, false otherwise
+  SIDE EFFECTS : None
+  NOTES        : None
+ *****************************************************/
+static bool IsSlotAccessorMessage(
+  SYMBOL_HN *msg,
+  EXPRESSION *msgArgs)
+  {
+   const char *name = ValueToString(msg);
+
+   if (strncmp(name,"get-",4) == 0)
+     return(msgArgs == NULL);
+   if (strncmp(name,"put-",4) == 0)
+     return((msgArgs != NULL) && (msgArgs->nextArg == NULL));
+   return false;
+  }
+
+/*****************************************************
+  NAME         : SendSlotAccessorMessage
+  DESCRIPTION  : Sends a get- or put- message. If the
+                   only applicable handler is a slot
+                   accessor, the slot of the instance
+                   is read or written directly without
+                   forming a message frame. Otherwise
+                   the message is performed as usual.
+  INPUTS       : 1) Caller's result buffer
+                 2) Message argument expressions
+                    (including implicit object)
+                 3) Message name
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Slot read or written, or any side
+                   effects of message execution
+  NOTES        : The direct access is only taken when
+                   the core for the class and message
+                   has already been formed by a prior
+                   send, and not when messages or the
+                   handler are watched or constructs
+                   are profiled. The arguments are
+                   evaluated only once: if the message
+                   is performed, their values are
+                   passed as constants.
+ *****************************************************/
+static void SendSlotAccessorMessage(
+  Environment *theEnv,
+  CLIPSValue *returnValue,
+  EXPRESSION *args,
+  SYMBOL_HN *msg)
+  {
+   CLIPSValue theObject,theValue;
+   EXPRESSION objectArg,valueArg;
+   Instance *ins = NULL;
+   HANDLER_CORE *core = NULL;
+   INSTANCE_SLOT *sp;
+
+   if (EvaluationData(theEnv)->HaltExecution)
+     return;
+   EvaluationData(theEnv)->EvaluationError = false;
+
+   if (! EvaluateMessageArgument(theEnv,args,&theObject,msg))
+     return;
+   SetMessageArgument(&objectArg,&theObject,args->nextArg);
+
+   if (theObject.type == INSTANCE_ADDRESS)
+     {
+      ins = (Instance *) theObject.value;
+      if (ins->garbage)
+        ins = NULL;
+     }
+   else if (theObject.type == INSTANCE_NAME)
+     ins = FindInstanceBySymbol(theEnv,(SYMBOL_HN *) theObject.value);
+
+   if (ins != NULL)
+     core = FindCachedHandlerCore(theEnv,ins->cls,msg);
+
+   if ((core == NULL) || (core->slotAccess == 0) || HandlerCoreWatched(theEnv,core))
+     {
+      PerformMessage(theEnv,returnValue,&objectArg,msg);
+      return;
+     }
+
+   sp = ins->slotAddresses[core->slotIndex];
+
+   if (core->slotAccess == HANDLER_GET)
+     {
+      returnValue->type = (unsigned short) sp->type;
+      returnValue->value = sp->value;
+      if (sp->type == MULTIFIELD)
+        {
+         returnValue->begin = 0;
+         SetpDOEnd(returnValue,GetInstanceSlotLength(sp));
+        }
+      return;
+     }
+
+   /*=================================================*/
+   /* Evaluating the value can delete the instance, so */
+   /* it's kept from being released until afterwards.  */
+   /*=================================================*/
+
+   ins->busy++;
+   if (! EvaluateMessageArgument(theEnv,args->nextArg,&theValue,msg))
+     {
+      ins->busy--;
+      return;
+     }
+   ins->busy--;
+   SetMessageArgument(&valueArg,&theValue,NULL);
+   objectArg.nextArg = &valueArg;
+
+   if (ins->garbage || (! SlotValueAccepted(theEnv,ins,sp,&theValue)))
+     {
+      PerformMessage(theEnv,returnValue,&objectArg,msg);
+      return;
+     }
+
+   DirectPutSlotValue(theEnv,ins,sp,&theValue,returnValue);
+  }
+
+/*****************************************************
+  NAME         : EvaluateMessageArgument
+  DESCRIPTION  : Evaluates an argument of a message
+  INPUTS       : 1) The argument expression
+                 2) Buffer for the argument value
+                 3) The message name
+  RETURNS      : False on errors, true otherwise
+  SIDE EFFECTS : Error messages printed on errors
+  NOTES        : The errors are reported in the same
+                   way as for the arguments evaluated
+                   by PushProcParameters
+ *****************************************************/
+static bool EvaluateMessageArgument(
+  Environment *theEnv,
+  EXPRESSION *theExp,
+  CLIPSValue *theValue,
+  SYMBOL_HN *msg)
+  {
+   if ((EvaluateExpression(theEnv,theExp,theValue) == false) &&
+       (theValue->type != RVOID))
+     return true;
+
+   if (theValue->type == RVOID)
+     {
+      PrintErrorID(theEnv,"PRCCODE",2,false);
+      EnvPrintRouter(theEnv,WERROR,"Functions without a return value are illegal as ");
+      EnvPrintRouter(theEnv,WERROR,"message");
+      EnvPrintRouter(theEnv,WERROR," arguments.\n");
+      EnvSetEvaluationError(theEnv,true);
+     }
+   PrintErrorID(theEnv,"PRCCODE",6,false);
+   EnvPrintRouter(theEnv,WERROR,"This error occurred while evaluating arguments ");
+   EnvPrintRouter(theEnv,WERROR,"for the ");
+   EnvPrintRouter(theEnv,WERROR,"message");
+   EnvPrintRouter(theEnv,WERROR," ");
+   EnvPrintRouter(theEnv,WERROR,ValueToString(msg));
+   EnvPrintRouter(theEnv,WERROR,".\n");
+   return false;
+  }
+
+/*****************************************************
+  NAME         : SetMessageArgument
+  DESCRIPTION  : Makes a constant argument expression
+                   for an evaluated message argument
+  INPUTS       : 1) The expression
+                 2) The argument value
+                 3) The next argument expression
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Expression set
+  NOTES        : A multifield constant refers to the
+                   value buffer, so the buffer must
+                   outlive the expression
+ *****************************************************/
+static void SetMessageArgument(
+  EXPRESSION *theExp,
+  CLIPSValue *theValue,
+  EXPRESSION *nextArg)
+  {
+   theExp->type = theValue->type;
+   theExp->value = (theValue->type == MULTIFIELD) ? (void *) theValue : theValue->value;
+   theExp->argList = NULL;
+   theExp->nextArg = nextArg;
+  }
+
+/*****************************************************
+  NAME         : SlotValueAccepted
+  DESCRIPTION  : Determines if a slot can be set to a
+                   value by a slot accessor without an
+                   error
+  INPUTS       : 1) The instance
+                 2) The instance slot
+                 3) The value
+  RETURNS      : True if the value would be accepted,
+                   false otherwise
+  SIDE EFFECTS : None
+  NOTES        : Makes the checks of
+                   HandlerSlotPutFunction and
+                   PutSlotValue without printing error
+                   messages, so that a rejected value
+                   is reported by performing the
+                   message
+ *****************************************************/
+static bool SlotValueAccepted(
+  Environment *theEnv,
+  Instance *ins,
+  INSTANCE_SLOT *sp,
+  CLIPSValue *theValue)
+  {
+   if (sp->desc->initializeOnly && (! ins->initializeInProgress))
+     return false;
+#if DEFRULE_CONSTRUCT
+   if (EngineData(theEnv)->JoinOperationInProgress)
+     return false;
+#endif
+   if ((sp->desc->multiple == 0) && (theValue->type == MULTIFIELD) &&
+       (GetpDOLength(theValue) != 1))
+     return false;
+   if (EnvGetDynamicConstraintChecking(theEnv) &&
+       (ConstraintCheckDataObject(theEnv,theValue,sp->desc->constraint) != NO_VIOLATION))
+     return false;
+   return true;
+  }
+
+/*****************************************************
+  NAME         : HandlerCoreWatched
+  DESCRIPTION  : Determines if the execution of a core
+                   is traced or profiled
+  INPUTS       : The core
+  RETURNS      : True if messages or the handler of
+                   the core are watched or constructs
+                   are profiled, false otherwise
+  SIDE EFFECTS : None
+  NOTES        : None
+ *****************************************************/
+static bool HandlerCoreWatched(
+  Environment *theEnv,
+  HANDLER_CORE *core)
+  {
+#if DEBUGGING_FUNCTIONS
+   if (MessageHandlerData(theEnv)->WatchMessages || core->links[0].hnd->trace)
+     return true;
+#endif
+#if PROFILING_FUNCTIONS
+   if (ProfileFunctionData(theEnv)->ProfileConstructs)
+     return true;
+#endif
+   return false;
+  }
+
 /*****************************************************
   NAME         : PerformMessage
   DESCRIPTION  : Calls core framework for a message
@@ -991,7 +1306,8 @@ static bool PerformMessage(
   SYMBOL_HN *mname)
   {
    int oldce;
-   /* HANDLER_LINK *oldCore; */
+   HANDLER_LINK *oldTop;
+   HANDLER_CORE *core;
    Defclass *cls = NULL;
    Instance *ins = NULL;
    SYMBOL_HN *oldName;
@@ -1084,13 +1400,10 @@ static bool PerformMessage(
       return false;
      }
 
-   /* oldCore = MessageHandlerData(theEnv)->TopOfCore; */
+   oldTop = MessageHandlerData(theEnv)->TopOfCore;
 
-   if (MessageHandlerData(theEnv)->TopOfCore != NULL)
-     { MessageHandlerData(theEnv)->TopOfCore->nxtInStack = MessageHandlerData(theEnv)->OldCore; }
-   MessageHandlerData(theEnv)->OldCore = MessageHandlerData(theEnv)->TopOfCore;
-   
-   MessageHandlerData(theEnv)->TopOfCore = FindApplicableHandlers(theEnv,cls,mname);
+   core = FindApplicableHandlers(theEnv,cls,mname);
+   MessageHandlerData(theEnv)->TopOfCore = (core != NULL) ? core->links : NULL;
 
    if (MessageHandlerData(theEnv)->TopOfCore != NULL)
      {
@@ -1151,15 +1464,12 @@ static bool PerformMessage(
 #endif
         }
 
-      DestroyHandlerLinks(theEnv,MessageHandlerData(theEnv)->TopOfCore);
+      ReleaseHandlerCore(theEnv,core);
       MessageHandlerData(theEnv)->CurrentCore = oldCurrent;
       MessageHandlerData(theEnv)->NextInCore = oldNext;
      }
 
-   /* MessageHandlerData(theEnv)->TopOfCore = oldCore; */
-   MessageHandlerData(theEnv)->TopOfCore = MessageHandlerData(theEnv)->OldCore;
-   if (MessageHandlerData(theEnv)->OldCore != NULL)
-     { MessageHandlerData(theEnv)->OldCore = MessageHandlerData(theEnv)->OldCore->nxtInStack; }
+   MessageHandlerData(theEnv)->TopOfCore = oldTop;
 
    ProcedureFunctionData(theEnv)->ReturnFlag = false;
 
@@ -1202,28 +1512,331 @@ static bool PerformMessage(
                    All primary handlers (from most specific to most general)
                    All after handlers (from most general to most specific)
 
+                 The core for a class and message is only formed once and
+                   then kept in the handler core cache, so later sends of the
+                   message to the class do not allocate any links.
   INPUTS       : 1) The class of the instance (or primitive) for the message
                  2) The message name
   RETURNS      : NULL if no applicable handlers or errors,
-                   the list of handlers otherwise
-  SIDE EFFECTS : Links are allocated for the list
+                   the core otherwise
+  SIDE EFFECTS : Core formed and cached if not already present
+                 Busy counts of the core, its handlers and their classes
+                   incremented (see ReleaseHandlerCore)
   NOTES        : The instance is the first thing on the ProcParamArray
                  The number of arguments is in ProcParamArraySize
  *****************************************************************************/
-static HANDLER_LINK *FindApplicableHandlers(
+static HANDLER_CORE *FindApplicableHandlers(
+  Environment *theEnv,
+  Defclass *cls,
+  SYMBOL_HN *mname)
+  {
+   HANDLER_CORE *core;
+   short i;
+
+   core = FindCachedHandlerCore(theEnv,cls,mname);
+   if (core == NULL)
+     {
+      core = MakeHandlerCore(theEnv,cls,mname);
+      if (core == NULL)
+        return NULL;
+     }
+
+   core->busy++;
+   for (i = 0 ; i < core->linkCount ; i++)
+     {
+      core->links[i].hnd->busy++;
+      IncrementDefclassBusyCount(theEnv,core->links[i].hnd->cls);
+     }
+   return(core);
+  }
+
+/*****************************************************
+  NAME         : FindCachedHandlerCore
+  DESCRIPTION  : Looks up the core of a class and
+                   message in the handler core cache
+  INPUTS       : 1) The class
+                 2) The message name
+  RETURNS      : The cached core, NULL if the core
+                   has not been formed yet
+  SIDE EFFECTS : The cache is emptied first if any
+                   handlers or classes have changed
+  NOTES        : The busy counts are not incremented
+ *****************************************************/
+static HANDLER_CORE *FindCachedHandlerCore(
+  Environment *theEnv,
+  Defclass *cls,
+  SYMBOL_HN *mname)
+  {
+   HANDLER_CORE *core;
+
+   InvalidateHandlerCores(theEnv);
+
+   for (core = MessageHandlerData(theEnv)->HandlerCoreCache[HashHandlerCore(cls,mname)] ;
+        core != NULL ;
+        core = core->nxt)
+     {
+      if ((core->cls == cls) && (core->name == mname) && (core->stale == false))
+        return(core);
+     }
+   return NULL;
+  }
+
+/*****************************************************************
+  NAME         : MakeHandlerCore
+  DESCRIPTION  : Forms the core frame of applicable handlers for
+                   a class and message and adds it to the handler
+                   core cache
+  INPUTS       : 1) The class
+                 2) The message name
+  RETURNS      : The new core, NULL if there are no applicable
+                   primary handlers
+  SIDE EFFECTS : Core added to the cache
+                 Error message printed if no primary handlers
+  NOTES        : The links are kept in one array, each linked to
+                   the next so that the core can be walked in the
+                   same way as the lists formed by
+                   FindApplicableOfName and JoinHandlerLinks
+ *****************************************************************/
+static HANDLER_CORE *MakeHandlerCore(
   Environment *theEnv,
   Defclass *cls,
   SYMBOL_HN *mname)
   {
    int i;
-   HANDLER_LINK *tops[4],*bots[4];
+   HANDLER_LINK *tops[4],*bots[4],*mlink,*tmp;
+   HANDLER_CORE *core;
+   unsigned hashValue;
 
    for (i = MAROUND ; i <= MAFTER ; i++)
      tops[i] = bots[i] = NULL;
 
    for (i = 0 ; i < cls->allSuperclasses.classCount ; i++)
      FindApplicableOfName(theEnv,cls->allSuperclasses.classArray[i],tops,bots,mname);
-   return(JoinHandlerLinks(theEnv,tops,bots,mname));
+   mlink = JoinHandlerLinks(theEnv,tops,bots,mname);
+   if (mlink == NULL)
+     return NULL;
+
+   core = get_struct(theEnv,handlerCore);
+   core->cls = cls;
+   core->name = mname;
+   core->busy = 0;
+   core->stale = false;
+   core->linkCount = 0;
+   for (tmp = mlink ; tmp != NULL ; tmp = tmp->nxt)
+     core->linkCount++;
+   core->links = (HANDLER_LINK *) gm2(theEnv,(sizeof(HANDLER_LINK) * core->linkCount));
+   for (i = 0 , tmp = mlink ; tmp != NULL ; i++ , tmp = tmp->nxt)
+     {
+      core->links[i].hnd = tmp->hnd;
+      core->links[i].nxt = (tmp->nxt != NULL) ? &core->links[i+1] : NULL;
+     }
+   DestroyHandlerLinks(theEnv,mlink);
+   ResolveHandlerCoreSlot(theEnv,core);
+
+   hashValue = HashHandlerCore(cls,mname);
+   core->bucket = hashValue;
+   core->nxt = MessageHandlerData(theEnv)->HandlerCoreCache[hashValue];
+   MessageHandlerData(theEnv)->HandlerCoreCache[hashValue] = core;
+   return(core);
+  }
+
+/*****************************************************************
+  NAME         : ResolveHandlerCoreSlot
+  DESCRIPTION  : Determines if the only handler of a core is a
+                   slot accessor, i.e. a primary handler whose
+                   sole action is ?self:<slot> (with no arguments)
+                   or (bind ?self:<slot> ?<wildcard>) (with only
+                   a wildcard argument), and if so records the
+                   position of the slot in the instances of the
+                   core's class
+  INPUTS       : The core
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : slotAccess and slotIndex of the core set
+  NOTES        : The default get- and put- handlers created for
+                   slots have this form. The slot is resolved
+                   the same way as by HandlerSlotGetFunction and
+                   HandlerSlotPutFunction, and the core isn't
+                   marked if the reference would be an error.
+                   The core is formed again whenever classes or
+                   handlers are redefined.
+ *****************************************************************/
+static void ResolveHandlerCoreSlot(
+  Environment *theEnv,
+  HANDLER_CORE *core)
+  {
+   DefmessageHandler *hnd;
+   HANDLER_SLOT_REFERENCE *theReference;
+   Defclass *cls;
+   unsigned instanceSlotIndex;
+
+   core->slotAccess = 0;
+   core->slotIndex = 0;
+
+   if (core->linkCount != 1)
+     return;
+   hnd = core->links[0].hnd;
+   if ((hnd->type != MPRIMARY) || (hnd->actions == NULL) ||
+       (hnd->actions->nextArg != NULL) || (hnd->localVarCount != 0))
+     return;
+
+   if (hnd->actions->type == HANDLER_GET)
+     {
+      if ((hnd->minParams != 1) || (hnd->maxParams != 1))
+        return;
+     }
+   else if (hnd->actions->type == HANDLER_PUT)
+     {
+      if ((hnd->minParams != 1) || (hnd->maxParams != -1) ||
+          (hnd->actions->argList == NULL) ||
+          (hnd->actions->argList->type != PROC_WILD_PARAM) ||
+          (hnd->actions->argList->nextArg != NULL))
+        return;
+     }
+   else
+     return;
+
+   cls = core->cls;
+   theReference = (HANDLER_SLOT_REFERENCE *) ValueToBitMap(hnd->actions->value);
+   if ((cls->slotNameMap == NULL) || (theReference->slotID > cls->maxSlotNameID))
+     return;
+   instanceSlotIndex = cls->slotNameMap[theReference->slotID];
+   if (instanceSlotIndex == 0)
+     return;
+   instanceSlotIndex--;
+   if (cls->instanceTemplate[instanceSlotIndex]->cls !=
+       DefclassData(theEnv)->ClassIDMap[theReference->classID])
+     return;
+
+   core->slotAccess = hnd->actions->type;
+   core->slotIndex = instanceSlotIndex;
+  }
+
+/*****************************************************
+  NAME         : ReleaseHandlerCore
+  DESCRIPTION  : Releases a core obtained from
+                   FindApplicableHandlers once the
+                   message is done with it
+  INPUTS       : The core
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Busy counts of the core, its handlers
+                   and their classes decremented
+                 The core is deleted if it was
+                   invalidated while it was in use
+  NOTES        : None
+ *****************************************************/
+static void ReleaseHandlerCore(
+  Environment *theEnv,
+  HANDLER_CORE *core)
+  {
+   short i;
+
+   for (i = 0 ; i < core->linkCount ; i++)
+     {
+      core->links[i].hnd->busy--;
+      DecrementDefclassBusyCount(theEnv,core->links[i].hnd->cls);
+     }
+   core->busy--;
+   if (core->stale && (core->busy == 0))
+     RemoveHandlerCore(theEnv,core);
+  }
+
+/*****************************************************
+  NAME         : InvalidateHandlerCores
+  DESCRIPTION  : Empties the handler core cache if
+                   any handlers or classes have been
+                   added or removed since the cores
+                   were formed
+  INPUTS       : None
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Cores deleted
+  NOTES        : Cores which are in use by messages
+                   being executed are only marked
+                   stale - ReleaseHandlerCore deletes
+                   them once the messages are done
+ *****************************************************/
+static void InvalidateHandlerCores(
+  Environment *theEnv)
+  {
+   HANDLER_CORE *core,*nxt;
+   int i;
+
+   if ((MessageHandlerData(theEnv)->CachedHandlerChanges == MessageHandlerData(theEnv)->HandlerChanges) &&
+       (MessageHandlerData(theEnv)->CachedClassTableChanges == DefclassData(theEnv)->ClassTableChanges))
+     return;
+
+   MessageHandlerData(theEnv)->CachedHandlerChanges = MessageHandlerData(theEnv)->HandlerChanges;
+   MessageHandlerData(theEnv)->CachedClassTableChanges = DefclassData(theEnv)->ClassTableChanges;
+
+   for (i = 0 ; i < HANDLER_CORE_CACHE_SIZE ; i++)
+     {
+      for (core = MessageHandlerData(theEnv)->HandlerCoreCache[i] ; core != NULL ; core = nxt)
+        {
+         nxt = core->nxt;
+         if (core->busy == 0)
+           RemoveHandlerCore(theEnv,core);
+         else
+           core->stale = true;
+        }
+     }
+  }
+
+/*****************************************************
+  NAME         : RemoveHandlerCore
+  DESCRIPTION  : Removes a core from the handler core
+                   cache and deletes it
+  INPUTS       : The core
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Core deallocated
+  NOTES        : The core's class, handlers and
+                   message name may already have been
+                   deleted, so the bucket recorded
+                   when the core was formed is used
+ *****************************************************/
+static void RemoveHandlerCore(
+  Environment *theEnv,
+  HANDLER_CORE *core)
+  {
+   HANDLER_CORE *prv,*tmp;
+
+   prv = NULL;
+   tmp = MessageHandlerData(theEnv)->HandlerCoreCache[core->bucket];
+   while (tmp != core)
+     {
+      prv = tmp;
+      tmp = tmp->nxt;
+     }
+   if (prv == NULL)
+     MessageHandlerData(theEnv)->HandlerCoreCache[core->bucket] = core->nxt;
+   else
+     prv->nxt = core->nxt;
+
+   rm(theEnv,core->links,(sizeof(HANDLER_LINK) * core->linkCount));
+   rtn_struct(theEnv,handlerCore,core);
+  }
+
+/*****************************************************
+  NAME         : HashHandlerCore
+  DESCRIPTION  : Computes the handler core cache
+                   bucket of a class and message
+  INPUTS       : 1) The class
+                 2) The message name
+  RETURNS      : The bucket index
+  SIDE EFFECTS : None
+  NOTES        : None
+ *****************************************************/
+static unsigned HashHandlerCore(
+  Defclass *cls,
+  SYMBOL_HN *mname)
+  {
+   union
+     {
+      void *vv;
+      unsigned long long liv;
+     } fis;
+
+   fis.liv = 0;
+   fis.vv = cls;
+   return((unsigned) (((fis.liv >> 3) + mname->bucket) % HANDLER_CORE_CACHE_SIZE));
   }
 
 /***************************************************************
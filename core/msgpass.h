@@ -50,6 +50,11 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added the handler core cache.                  */
+/*                                                           */
+/*            Handler cores record the slot read or written  */
+/*            by a lone get- or put- accessor handler.       */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_msgpass
@@ -66,13 +71,31 @@ typedef struct messageHandlerLink
   {
    DefmessageHandler *hnd;
    struct messageHandlerLink *nxt;
-   struct messageHandlerLink *nxtInStack;
   } HANDLER_LINK;
 
+typedef struct handlerCore
+  {
+   Defclass *cls;
+   SYMBOL_HN *name;
+   HANDLER_LINK *links;
+   short linkCount;
+   unsigned bucket;
+   unsigned busy;
+   bool stale;
+   unsigned short slotAccess;
+   unsigned slotIndex;
+   struct handlerCore *nxt;
+  } HANDLER_CORE;
+
+#ifndef HANDLER_CORE_CACHE_SIZE
+#define HANDLER_CORE_CACHE_SIZE 127
+#endif
+
    bool             DirectMessage(Environment *,SYMBOL_HN *,Instance *,
                                   CLIPSValue *,EXPRESSION *);
    void             EnvSend(Environment *,CLIPSValue *,const char *,const char *,CLIPSValue *);
    void             DestroyHandlerLinks(Environment *,HANDLER_LINK *);
+   void             ReturnHandlerCores(Environment *);
    void             SendCommand(Environment *,UDFContext *,CLIPSValue *);
    CLIPSValue      *GetNthMessageArgument(Environment *,int);
 
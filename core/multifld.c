@@ -54,6 +54,17 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Symbols are hashed and measured with the hash  */
+/*            value and length kept in the symbol table      */
+/*            entry.                                         */
+/*                                                           */
+/*            ImplodeMultifield builds its string in a       */
+/*            single pass with a StringBuilder.              */
+/*                                                           */
+/*            Added HashMultifieldField so that the hash     */
+/*            value of a fact can be updated when only some  */
+/*            of its slots are modified.                     */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
@@ -618,15 +629,8 @@ unsigned long HashMultifield(
   unsigned long theRange)
   {
    unsigned long length, i;
-   unsigned long tvalue;
    unsigned long count;
    struct field *fieldPtr;
-   union
-     {
-      double fv;
-      void *vv;
-      unsigned long liv;
-     } fis;
      
    /*================================================*/
    /* Initialize variables for computing hash value. */
@@ -644,50 +648,7 @@ unsigned long HashMultifield(
    for (i = 0;
         i < length;
         i++)
-     {
-      switch(fieldPtr[i].type)
-         {
-          case MULTIFIELD:
-            count += HashMultifield((struct multifield *) fieldPtr[i].value,theRange);
-            break;
-
-          case FLOAT:
-            fis.liv = 0;
-            fis.fv = ValueToDouble(fieldPtr[i].value);
-            count += (fis.liv * (i + 29))  +
-                     (unsigned long) ValueToDouble(fieldPtr[i].value);
-            break;
-
-          case INTEGER:
-            count += (((unsigned long) ValueToLong(fieldPtr[i].value)) * (i + 29)) +
-                      ((unsigned long) ValueToLong(fieldPtr[i].value));
-            break;
-
-          case FACT_ADDRESS:
-#if OBJECT_SYSTEM
-          case INSTANCE_ADDRESS:
-#endif
-            fis.liv = 0;
-            fis.vv = fieldPtr[i].value;
-            count += (unsigned long) (fis.liv * (i + 29));
-            break;
-
-          case EXTERNAL_ADDRESS:
-            fis.liv = 0;
-            fis.vv = ValueToExternalAddress(fieldPtr[i].value);
-            count += (unsigned long) (fis.liv * (i + 29));
-            break;
-
-          case SYMBOL:
-          case STRING:
-#if OBJECT_SYSTEM
-          case INSTANCE_NAME:
-#endif
-            tvalue = (unsigned long) HashSymbol(ValueToString(fieldPtr[i].value),theRange);
-            count += (unsigned long) (tvalue * (i + 29));
-            break;
-         }
-     }
+     { count += HashMultifieldField(fieldPtr[i].type,fieldPtr[i].value,i,theRange); }
 
    /*========================*/
    /* Return the hash value. */
@@ -696,6 +657,68 @@ unsigned long HashMultifield(
    return(count);
   }
 
+/*****************************************************************/
+/* HashMultifieldField: Returns the amount a single field at the */
+/*   specified position adds to the hash value of a multifield.  */
+/*   Since the hash value of a multifield is the sum of these    */
+/*   amounts, it can be updated when only some fields change.    */
+/*****************************************************************/
+unsigned long HashMultifieldField(
+  unsigned short type,
+  void *value,
+  unsigned long position,
+  unsigned long theRange)
+  {
+   unsigned long tvalue;
+   union
+     {
+      double fv;
+      void *vv;
+      unsigned long liv;
+     } fis;
+
+   switch(type)
+      {
+       case MULTIFIELD:
+         return HashMultifield((struct multifield *) value,theRange);
+
+       case FLOAT:
+         fis.liv = 0;
+         fis.fv = ValueToDouble(value);
+         return (fis.liv * (position + 29))  +
+                (unsigned long) ValueToDouble(value);
+
+       case INTEGER:
+         return (((unsigned long) ValueToLong(value)) * (position + 29)) +
+                 ((unsigned long) ValueToLong(value));
+
+       case FACT_ADDRESS:
+#if OBJECT_SYSTEM
+       case INSTANCE_ADDRESS:
+#endif
+         fis.liv = 0;
+         fis.vv = value;
+         return (unsigned long) (fis.liv * (position + 29));
+
+       case EXTERNAL_ADDRESS:
+         fis.liv = 0;
+         fis.vv = ValueToExternalAddress(value);
+         return (unsigned long) (fis.liv * (position + 29));
+
+       case SYMBOL:
+       case STRING:
+#if OBJECT_SYSTEM
+       case INSTANCE_NAME:
+#endif
+         tvalue = ((SYMBOL_HN *) value)->hashValue;
+         if (theRange != 0)
+           { tvalue = tvalue % theRange; }
+         return (unsigned long) (tvalue * (position + 29));
+      }
+
+   return 0;
+  }
+
 /**********************/
 /* GetMultifieldList: */
 /**********************/
@@ -713,91 +736,35 @@ void *ImplodeMultifield(
   Environment *theEnv,
   CLIPSValue *value)
   {
-   size_t strsize = 0;
-   long i, j;
-   const char *tmp_str;
-   char *ret_str;
+   long i;
+   const char *tmp_str, *segment;
    void *rv;
    struct multifield *theMultifield;
    CLIPSValue tempDO;
+   StringBuilder *theSB;
 
-   /*===================================================*/
-   /* Determine the size of the string to be allocated. */
-   /*===================================================*/
+   /*==============================================*/
+   /* Build the string in a single pass. Each      */
+   /* field is converted to a string only once and */
+   /* the builder enlarges its buffer as needed.   */
+   /*==============================================*/
 
    theMultifield = (struct multifield *) GetpValue(value);
+   theSB = CreateStringBuilder(theEnv,(size_t) (GetpDOLength(value) * 8));
+
    for (i = GetpDOBegin(value) ; i <= GetpDOEnd(value) ; i++)
      {
-      if (GetMFType(theMultifield,i) == FLOAT)
-        {
-         tmp_str = FloatToString(theEnv,ValueToDouble(GetMFValue(theMultifield,i)));
-         strsize += strlen(tmp_str) + 1;
-        }
-      else if (GetMFType(theMultifield,i) == INTEGER)
-        {
-         tmp_str = LongIntegerToString(theEnv,ValueToLong(GetMFValue(theMultifield,i)));
-         strsize += strlen(tmp_str) + 1;
-        }
-      else if (GetMFType(theMultifield,i) == STRING)
-        {
-         strsize += strlen(ValueToString(GetMFValue(theMultifield,i))) + 3;
-         tmp_str = ValueToString(GetMFValue(theMultifield,i));
-         while(*tmp_str)
-           {
-            if (*tmp_str == '"')
-              { strsize++; }
-            else if (*tmp_str == '\\') /* GDR 111599 #835 */
-              { strsize++; }           /* GDR 111599 #835 */
-            tmp_str++;
-           }
-        }
-#if OBJECT_SYSTEM
-      else if (GetMFType(theMultifield,i) == INSTANCE_NAME)
-        { strsize += strlen(ValueToString(GetMFValue(theMultifield,i))) + 3; }
-      else if (GetMFType(theMultifield,i) == INSTANCE_ADDRESS)
-        { strsize += strlen(ValueToString(((Instance *)
-                            GetMFValue(theMultifield,i))->name)) + 3; }
-#endif
-
-      else
-        { 
-         SetType(tempDO,GetMFType(theMultifield,i));
-         SetValue(tempDO,GetMFValue(theMultifield,i));
-         strsize += strlen(DataObjectToString(theEnv,&tempDO)) + 1; 
-        }
-     }
+      if (i != GetpDOBegin(value))
+        { SBAddChar(theSB,' '); }
 
-   /*=============================================*/
-   /* Allocate the string and copy all components */
-   /* of the MULTIFIELD variable to it.           */
-   /*=============================================*/
-
-   if (strsize == 0) return(EnvAddSymbol(theEnv,""));
-   ret_str = (char *) gm2(theEnv,strsize);
-   for(j=0, i=GetpDOBegin(value); i <= GetpDOEnd(value) ; i++)
-     {
       /*============================*/
       /* Convert numbers to strings */
       /*============================*/
 
       if (GetMFType(theMultifield,i) == FLOAT)
-        {
-         tmp_str = FloatToString(theEnv,ValueToDouble(GetMFValue(theMultifield,i)));
-         while(*tmp_str)
-           {
-            *(ret_str+j) = *tmp_str;
-            j++, tmp_str++;
-           }
-        }
+        { SBAppend(theSB,FloatToString(theEnv,ValueToDouble(GetMFValue(theMultifield,i)))); }
       else if (GetMFType(theMultifield,i) == INTEGER)
-        {
-         tmp_str = LongIntegerToString(theEnv,ValueToLong(GetMFValue(theMultifield,i)));
-         while(*tmp_str)
-           {
-            *(ret_str+j) = *tmp_str;
-            j++, tmp_str++;
-           }
-        }
+        { SBAppend(theSB,LongIntegerToString(theEnv,ValueToLong(GetMFValue(theMultifield,i)))); }
 
       /*=======================================*/
       /* Enclose strings in quotes and preceed */
@@ -807,73 +774,61 @@ void *ImplodeMultifield(
       else if (GetMFType(theMultifield,i) == STRING)
         {
          tmp_str = ValueToString(GetMFValue(theMultifield,i));
-         *(ret_str+j) = '"';
-         j++;
-         while(*tmp_str)
+         SBAddChar(theSB,'"');
+         while (*tmp_str)
            {
-            if (*tmp_str == '"')
+            segment = tmp_str;
+            while ((*tmp_str != EOS) &&
+                   (*tmp_str != '"') &&
+                   (*tmp_str != '\\')) /* GDR 111599 #835 */
+              { tmp_str++; }
+
+            SBAppendN(theSB,segment,(size_t) (tmp_str - segment));
+
+            if (*tmp_str != EOS)
               {
-               *(ret_str+j) = '\\';
-               j++;
+               SBAddChar(theSB,'\\');
+               SBAddChar(theSB,*tmp_str);
+               tmp_str++;
               }
-            else if (*tmp_str == '\\') /* GDR 111599 #835 */
-              {                        /* GDR 111599 #835 */
-               *(ret_str+j) = '\\';    /* GDR 111599 #835 */
-               j++;                    /* GDR 111599 #835 */
-              }                        /* GDR 111599 #835 */
-              
-            *(ret_str+j) = *tmp_str;
-            j++, tmp_str++;
            }
-         *(ret_str+j) = '"';
-         j++;
+         SBAddChar(theSB,'"');
         }
 #if OBJECT_SYSTEM
       else if (GetMFType(theMultifield,i) == INSTANCE_NAME)
         {
-         tmp_str = ValueToString(GetMFValue(theMultifield,i));
-         *(ret_str + j++) = '[';
-         while(*tmp_str)
-           {
-            *(ret_str+j) = *tmp_str;
-            j++, tmp_str++;
-           }
-         *(ret_str + j++) = ']';
+         SBAddChar(theSB,'[');
+         SBAppendN(theSB,ValueToString(GetMFValue(theMultifield,i)),
+                   ((SYMBOL_HN *) GetMFValue(theMultifield,i))->length);
+         SBAddChar(theSB,']');
         }
       else if (GetMFType(theMultifield,i) == INSTANCE_ADDRESS)
         {
-         tmp_str = ValueToString(((Instance *) GetMFValue(theMultifield,i))->name);
-         *(ret_str + j++) = '[';
-         while(*tmp_str)
-           {
-            *(ret_str+j) = *tmp_str;
-            j++, tmp_str++;
-           }
-         *(ret_str + j++) = ']';
+         SBAddChar(theSB,'[');
+         SBAppendN(theSB,ValueToString(((Instance *) GetMFValue(theMultifield,i))->name),
+                   ((Instance *) GetMFValue(theMultifield,i))->name->length);
+         SBAddChar(theSB,']');
         }
 #endif
+      else if (GetMFType(theMultifield,i) == SYMBOL)
+        {
+         SBAppendN(theSB,ValueToString(GetMFValue(theMultifield,i)),
+                   ((SYMBOL_HN *) GetMFValue(theMultifield,i))->length);
+        }
       else
         {
          SetType(tempDO,GetMFType(theMultifield,i));
          SetValue(tempDO,GetMFValue(theMultifield,i));
-         tmp_str = DataObjectToString(theEnv,&tempDO);
-         while(*tmp_str)
-           {
-            *(ret_str+j) = *tmp_str;
-            j++, tmp_str++;
-           }
-         }
-      *(ret_str+j) = ' ';
-      j++;
+         SBAppend(theSB,DataObjectToString(theEnv,&tempDO));
+        }
      }
-   *(ret_str+j-1) = '\0';
 
    /*====================*/
    /* Return the string. */
    /*====================*/
 
-   rv = EnvAddSymbol(theEnv,ret_str);
-   rm(theEnv,ret_str,strsize);
+   rv = SBAddSymbol(theSB);
+   SBDispose(theSB);
    return(rv);
   }
 
@@ -56,6 +56,8 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added HashMultifieldField.                     */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_multifld
@@ -119,6 +121,7 @@ typedef struct field * FIELD_PTR;
    bool                           MultifieldsEqual(struct multifield *,struct multifield *);
    Multifield                    *DOToMultifield(Environment *,CLIPSValue *);
    unsigned long                  HashMultifield(struct multifield *,unsigned long);
+   unsigned long                  HashMultifieldField(unsigned short,void *,unsigned long,unsigned long);
    Multifield                    *GetMultifieldList(Environment *);
    void                          *ImplodeMultifield(Environment *,CLIPSValue *);
    void                           EphemerateMultifield(Environment *,struct multifield *);
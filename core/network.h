@@ -23,6 +23,12 @@
 /*            Removed use of void pointers for specific      */
 /*            data structures.                               */
 /*                                                           */
+/*            Beta memories allocate their partial matches   */
+/*            from an arena once they've grown.              */
+/*                                                           */
+/*            Hashed beta memories keep their size across a  */
+/*            reset.                                         */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_network
@@ -87,7 +93,26 @@ typedef struct alphaMemoryHash ALPHA_MEMORY_HASH;
 #include "ruledef.h"
 #endif
 
+/*==================================================*/
+/* A hashed beta memory grows by a factor of        */
+/* BETA_HASH_GROW_LOAD when it holds more than that */
+/* many partial matches per bucket. It returns to   */
+/* its initial size once it's empty.                */
+/*==================================================*/
+
 #define INITIAL_BETA_HASH_SIZE 17
+#define BETA_HASH_GROW_LOAD 11
+
+/*==================================================*/
+/* A beta memory allocates its partial matches from */
+/* an arena of its own once it holds this many      */
+/* partial matches. Smaller memories share pages    */
+/* with the rest of the system.                     */
+/*==================================================*/
+
+#ifndef BETA_ARENA_THRESHOLD
+#define BETA_ARENA_THRESHOLD 32
+#endif
 
 struct betaMemory
   {
@@ -95,6 +120,29 @@ struct betaMemory
    unsigned long count;
    struct partialMatch **beta;
    struct partialMatch **last;
+   struct betaMemoryArena *arena;
+  };
+
+/*=================================================*/
+/* The partial matches in a beta memory which were */
+/* not allocated from its arena (such as those     */
+/* stored before the arena was created) are kept   */
+/* track of so that the memory can be destroyed by */
+/* releasing the arena rather than visiting every  */
+/* partial match. Once there are too many of them  */
+/* to track, the memory is marked as overflowed.   */
+/* The links structures of the partial matches     */
+/* allocated from the arena come from a second     */
+/* arena so they're released along with them.      */
+/*=================================================*/
+
+struct betaMemoryArena
+  {
+   struct slabArena *blocks;
+   struct slabArena *links;
+   unsigned int foreignCount;
+   bool overflow;
+   struct partialMatch *foreign[BETA_ARENA_THRESHOLD];
   };
 
 struct joinLink
@@ -35,6 +35,8 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added instance slot indexes to classes.        */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -256,6 +258,9 @@ static void DeallocateObjectBinaryData(
       if (DefclassData(theEnv)->ClassIDMap != NULL)
         { rm(theEnv,DefclassData(theEnv)->ClassIDMap,(sizeof(Defclass *) * DefclassData(theEnv)->AvailClassID)); }
 
+      for (i = 0L ; i < ObjectBinaryData(theEnv)->ClassCount ; i++)
+        { ReturnInstanceSlotIndexes(theEnv,&ObjectBinaryData(theEnv)->DefclassArray[i]); }
+
       for (i = 0L ; i < ObjectBinaryData(theEnv)->SlotCount ; i++)
         {
          if ((ObjectBinaryData(theEnv)->SlotArray[i].defaultValue != NULL) && (ObjectBinaryData(theEnv)->SlotArray[i].dynamicDefault == 0))
@@ -1229,6 +1234,7 @@ static void UpdateDefclass(
    cls->busy = 0;
    cls->instanceList = NULL;
    cls->instanceListBottom = NULL;
+   cls->slotIndexes = NULL;
 #if DEFMODULE_CONSTRUCT
    cls->scopeMap = BitMapPointer(bcls->scopeMap);
    IncrementBitMapCount(cls->scopeMap);
@@ -1392,6 +1398,7 @@ static void ClearBloadObjects(
          DecrementBitMapCount(theEnv,ObjectBinaryData(theEnv)->DefclassArray[i].scopeMap);
 #endif
          RemoveClassFromTable(theEnv,&ObjectBinaryData(theEnv)->DefclassArray[i]);
+         ReturnInstanceSlotIndexes(theEnv,&ObjectBinaryData(theEnv)->DefclassArray[i]);
         }
       for (i = 0L ; i < ObjectBinaryData(theEnv)->SlotCount ; i++)
         {
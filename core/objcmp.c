@@ -41,6 +41,8 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added instance slot indexes to classes.        */
+/*                                                           */
 /*************************************************************/
 
 /* =========================================
@@ -954,7 +956,7 @@ static void SingleDefclassToCode(
    PrintClassReference(theEnv,theFile,theDefclass->nxtHash,imageID,maxIndices);
    fprintf(theFile,",");
    PrintBitMapReference(theEnv,theFile,theDefclass->scopeMap);
-   fprintf(theFile,",\"\"}");
+   fprintf(theFile,",\"\",NULL}");
   }
 
 /***********************************************************
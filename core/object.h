@@ -26,6 +26,14 @@
 /*            Removed use of void pointers for specific      */
 /*            data structures.                               */
 /*                                                           */
+/*            Added slot indexes for looking up the direct   */
+/*            instances of a class by the value of a slot.   */
+/*                                                           */
+/*            Instances point to their queued object         */
+/*            pattern-matching action.                       */
+/*                                                           */
+/*            Instances store the hash value of their name.  */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_object
@@ -44,6 +52,8 @@ typedef struct defmessageHandler DefmessageHandler;
 typedef struct instance Instance;
 
 typedef struct instanceSlot INSTANCE_SLOT;
+typedef struct instanceSlotIndex INSTANCE_SLOT_INDEX;
+typedef struct instanceSlotIndexEntry INSTANCE_SLOT_INDEX_ENTRY;
 
 /* Maximum # of simultaneous class hierarchy traversals
    should be a multiple of BITS_PER_BYTE and less than MAX_INT      */
@@ -127,6 +137,7 @@ struct defclass
    Defclass *nxtHash;
    BITMAP_HN *scopeMap;
    char traversalRecord[TRAVERSAL_BYTES];
+   INSTANCE_SLOT_INDEX *slotIndexes;
   };
 
 struct classLink
@@ -192,7 +203,7 @@ struct instance
    unsigned initializeInProgress : 1;
    unsigned reteSynchronized     : 1;
    SYMBOL_HN *name;
-   unsigned hashTableIndex;
+   unsigned long hashValue;
    unsigned busy;
    Defclass *cls;
    Instance *prvClass,*nxtClass,
@@ -200,6 +211,29 @@ struct instance
                  *prvList,*nxtList;
    INSTANCE_SLOT **slotAddresses,
                  *slots;
+   unsigned long long creationIndex;
+   INSTANCE_SLOT_INDEX_ENTRY *slotIndexEntries;
+   struct objectMatchAction *matchAction;
+  };
+
+struct instanceSlotIndex
+  {
+   SYMBOL_HN *slotName;
+   int slotPosition;
+   unsigned long count,
+                 size;
+   INSTANCE_SLOT_INDEX_ENTRY **table;
+   INSTANCE_SLOT_INDEX *nxt;
+  };
+
+struct instanceSlotIndexEntry
+  {
+   Instance *ins;
+   INSTANCE_SLOT_INDEX *index;
+   unsigned long hashValue;
+   INSTANCE_SLOT_INDEX_ENTRY *prv,
+                             *nxt,
+                             *nxtForInstance;
   };
 
 struct defmessageHandler
@@ -196,6 +196,8 @@ struct objectReteData
    struct entityRecord JNSimpleCompareInfo2; 
    struct entityRecord JNSimpleCompareInfo3; 
    OBJECT_MATCH_ACTION *ObjectMatchActionQueue;
+   OBJECT_MATCH_ACTION *ObjectMatchActionQueueBottom;
+   OBJECT_MATCH_ACTION *LastObjectRetractAction;
    OBJECT_PATTERN_NODE *ObjectPatternNetworkPointer;
    OBJECT_ALPHA_NODE *ObjectPatternNetworkTerminalPointer;
    bool DelayObjectPatternMatching;
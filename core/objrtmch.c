@@ -56,6 +56,10 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            An instance points to its queued pattern-      */
+/*            matching action, so queueing an action for     */
+/*            an instance takes constant time.               */
+/*                                                           */
 /**************************************************************/
 /* =========================================
    *****************************************
@@ -92,6 +96,9 @@
 
    static void                    QueueObjectMatchAction(Environment *,int,Instance *,int);
    static SLOT_BITMAP            *QueueModifySlotMap(Environment *,SLOT_BITMAP *,int);
+   static void                    LinkObjectMatchAction(Environment *,OBJECT_MATCH_ACTION *,OBJECT_MATCH_ACTION *);
+   static void                    UnlinkObjectMatchAction(Environment *,OBJECT_MATCH_ACTION *);
+   static void                    MarkLastObjectRetractAction(Environment *,OBJECT_MATCH_ACTION *);
    static void                    ReturnObjectMatchAction(Environment *,OBJECT_MATCH_ACTION *);
    static void                    ProcessObjectMatchQueue(Environment *);
    static void                    MarkObjectPatternNetwork(Environment *,SLOT_BITMAP *);
@@ -420,16 +427,18 @@ static void QueueObjectMatchAction(
   Instance *ins,
   int slotNameID)
   {
-   OBJECT_MATCH_ACTION *prv,*cur,*newMatch;
-   OBJECT_MATCH_ACTION *prvRetract = NULL; /* DR0873 */
-   
-   prv = NULL;
-   cur = ObjectReteData(theEnv)->ObjectMatchActionQueue;
-   while (cur != NULL)
+   OBJECT_MATCH_ACTION *cur,*newMatch;
+
+   /* ===========================================================
+      An instance has at most one action on the queue, and the
+      instance points to it directly
+      =========================================================== */
+   cur = ins->matchAction;
+   if (cur != NULL)
      {
       /* ===========================================================
-         Here are the possibilities for the first Rete event already
-         on the queue as compared with the new event for an object:
+         Here are the possibilities for the Rete event already on
+         the queue as compared with the new event for an object:
 
          Assert/Retract  -->  Delete assert event
                               Ignore retract event
@@ -438,65 +447,56 @@ static void QueueObjectMatchAction(
          Modify/Retract  -->  Delete modify event
                               Queue the retract event
          =========================================================== */
-      if (cur->ins == ins)
+
+      /* ===================================================
+         An action for initially asserting the newly created
+         object to all applicable patterns
+         =================================================== */
+      if (cur->type == OBJECT_ASSERT)
         {
-         /* ===================================================
-            An action for initially asserting the newly created
-            object to all applicable patterns
-            =================================================== */
-         if (cur->type == OBJECT_ASSERT)
+         if (type == OBJECT_RETRACT)
            {
-            if (type == OBJECT_RETRACT)
-              {
-               /* ===================================================
-                  If we are retracting the entire object, then we can
-                  remove the assert action (and all modifies as well)
-                  and ignore the retract action
-                  (basically the object came and went before the Rete
-                  network had a chance to see it)
-                  =================================================== */
-               if (prv == NULL)
-                 ObjectReteData(theEnv)->ObjectMatchActionQueue = cur->nxt;
-               else
-                 prv->nxt = cur->nxt;
-               cur->ins->busy--;
-               ReturnObjectMatchAction(theEnv,cur);
-              }
-
-            /* =================================================
-               If this is a modify action, then we can ignore it
-               since the assert action will encompass it
-               ================================================= */
+            /* ===================================================
+               If we are retracting the entire object, then we can
+               remove the assert action (and all modifies as well)
+               and ignore the retract action
+               (basically the object came and went before the Rete
+               network had a chance to see it)
+               =================================================== */
+            UnlinkObjectMatchAction(theEnv,cur);
+            cur->ins->busy--;
+            ReturnObjectMatchAction(theEnv,cur);
            }
 
-         /* ===================================================
-            If the object is being deleted after a slot modify,
-            drop the modify event and replace with the retract
-            =================================================== */
-         else if (type == OBJECT_RETRACT)
+         /* =================================================
+            If this is a modify action, then we can ignore it
+            since the assert action will encompass it
+            ================================================= */
+        }
+
+      /* ===================================================
+         If the object is being deleted after a slot modify,
+         drop the modify event and replace with the retract
+         =================================================== */
+      else if (type == OBJECT_RETRACT)
+        {
+         cur->type = OBJECT_RETRACT;
+         if (cur->slotNameIDs != NULL)
            {
-            cur->type = OBJECT_RETRACT;
-            if (cur->slotNameIDs != NULL)
-              {
-               rm(theEnv,cur->slotNameIDs,SlotBitMapSize(cur->slotNameIDs));
-               cur->slotNameIDs = NULL;
-              }
+            rm(theEnv,cur->slotNameIDs,SlotBitMapSize(cur->slotNameIDs));
+            cur->slotNameIDs = NULL;
            }
+         MarkLastObjectRetractAction(theEnv,cur);
+        }
 
-         /* ====================================================
-            If a modify event for this slot is already on the
-            queue, ignore this one. Otherwise, merge the slot id
-            ==================================================== */
-         else
-            cur->slotNameIDs = QueueModifySlotMap(theEnv,cur->slotNameIDs,slotNameID);
+      /* ====================================================
+         If a modify event for this slot is already on the
+         queue, ignore this one. Otherwise, merge the slot id
+         ==================================================== */
+      else
+         cur->slotNameIDs = QueueModifySlotMap(theEnv,cur->slotNameIDs,slotNameID);
 
-         return;
-        }
-        
-      if (cur->type == OBJECT_RETRACT) /* DR0873 */ 
-        { prvRetract = cur; }          /* DR0873 */
-      prv = cur;
-      cur = cur->nxt;
+      return;
      }
 
    /* ================================================
@@ -505,11 +505,11 @@ static void QueueObjectMatchAction(
       ================================================ */
    newMatch = get_struct(theEnv,objectMatchAction);
    newMatch->type = type;
-   newMatch->nxt = NULL; /* If we get here, cur should be NULL */
    newMatch->slotNameIDs = (type != OBJECT_MODIFY) ? NULL :
                        QueueModifySlotMap(theEnv,NULL,slotNameID);
    newMatch->ins = ins;
    newMatch->ins->busy++;
+   ins->matchAction = newMatch;
    
    /* DR0873 Begin */
    /* Retract operations must be processed before assert and   */
@@ -518,24 +518,116 @@ static void QueueObjectMatchAction(
 
    if (type == OBJECT_RETRACT)
      {
-      if (prvRetract == NULL)
-        {
-         newMatch->nxt = ObjectReteData(theEnv)->ObjectMatchActionQueue;
-         ObjectReteData(theEnv)->ObjectMatchActionQueue = newMatch;
-        }
-      else
-        {
-         newMatch->nxt = prvRetract->nxt;
-         prvRetract->nxt = newMatch;
-        }
+      LinkObjectMatchAction(theEnv,newMatch,ObjectReteData(theEnv)->LastObjectRetractAction);
+      newMatch->beforeLastRetract = true;
+      ObjectReteData(theEnv)->LastObjectRetractAction = newMatch;
      }
    else
    /* DR0873 End */
-   
-   if (prv == NULL)
-     ObjectReteData(theEnv)->ObjectMatchActionQueue = newMatch;
+     {
+      LinkObjectMatchAction(theEnv,newMatch,ObjectReteData(theEnv)->ObjectMatchActionQueueBottom);
+      newMatch->beforeLastRetract = false;
+     }
+  }
+
+/***************************************************
+  NAME         : LinkObjectMatchAction
+  DESCRIPTION  : Inserts an action in the object
+                 match action queue
+  INPUTS       : 1) The action
+                 2) The action to insert it after
+                    (NULL to insert it at the top)
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Queue updated
+  NOTES        : None
+ ***************************************************/
+static void LinkObjectMatchAction(
+  Environment *theEnv,
+  OBJECT_MATCH_ACTION *theMatch,
+  OBJECT_MATCH_ACTION *prvMatch)
+  {
+   theMatch->prv = prvMatch;
+   if (prvMatch == NULL)
+     {
+      theMatch->nxt = ObjectReteData(theEnv)->ObjectMatchActionQueue;
+      ObjectReteData(theEnv)->ObjectMatchActionQueue = theMatch;
+     }
+   else
+     {
+      theMatch->nxt = prvMatch->nxt;
+      prvMatch->nxt = theMatch;
+     }
+   if (theMatch->nxt == NULL)
+     ObjectReteData(theEnv)->ObjectMatchActionQueueBottom = theMatch;
+   else
+     theMatch->nxt->prv = theMatch;
+  }
+
+/***************************************************
+  NAME         : UnlinkObjectMatchAction
+  DESCRIPTION  : Removes an action from the object
+                 match action queue
+  INPUTS       : The action
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : Queue updated and the instance's
+                 pointer to the action cleared
+  NOTES        : The action is not deallocated
+ ***************************************************/
+static void UnlinkObjectMatchAction(
+  Environment *theEnv,
+  OBJECT_MATCH_ACTION *theMatch)
+  {
+   if (theMatch->prv == NULL)
+     ObjectReteData(theEnv)->ObjectMatchActionQueue = theMatch->nxt;
    else
-     prv->nxt = newMatch;
+     theMatch->prv->nxt = theMatch->nxt;
+   if (theMatch->nxt == NULL)
+     ObjectReteData(theEnv)->ObjectMatchActionQueueBottom = theMatch->prv;
+   else
+     theMatch->nxt->prv = theMatch->prv;
+   if (ObjectReteData(theEnv)->LastObjectRetractAction == theMatch)
+     ObjectReteData(theEnv)->LastObjectRetractAction = theMatch->prv;
+   theMatch->ins->matchAction = NULL;
+  }
+
+/***************************************************
+  NAME         : MarkLastObjectRetractAction
+  DESCRIPTION  : Records that a queued action has
+                 become a retract action
+  INPUTS       : The action
+  RETURNS      : Nothing useful
+  SIDE EFFECTS : The action becomes the last retract
+                 on the queue if it follows the
+                 previous one
+  NOTES        : New retract actions are inserted
+                 after the last retract on the queue.
+                 Every action up to that one is
+                 flagged, so an action is only ever
+                 flagged once and finding whether it
+                 follows the last retract takes
+                 constant amortized time.
+ ***************************************************/
+static void MarkLastObjectRetractAction(
+  Environment *theEnv,
+  OBJECT_MATCH_ACTION *theMatch)
+  {
+   OBJECT_MATCH_ACTION *cur;
+
+   if (theMatch->beforeLastRetract)
+     return;
+
+   if (ObjectReteData(theEnv)->LastObjectRetractAction == NULL)
+     cur = ObjectReteData(theEnv)->ObjectMatchActionQueue;
+   else
+     cur = ObjectReteData(theEnv)->LastObjectRetractAction->nxt;
+
+   while (cur != theMatch)
+     {
+      cur->beforeLastRetract = true;
+      cur = cur->nxt;
+     }
+   theMatch->beforeLastRetract = true;
+   ObjectReteData(theEnv)->LastObjectRetractAction = theMatch;
   }
 
 /****************************************************
@@ -619,7 +711,7 @@ static void ProcessObjectMatchQueue(
           (ObjectReteData(theEnv)->DelayObjectPatternMatching == false))
      {
       cur = ObjectReteData(theEnv)->ObjectMatchActionQueue;
-      ObjectReteData(theEnv)->ObjectMatchActionQueue = cur->nxt;
+      UnlinkObjectMatchAction(theEnv,cur);
 
       switch(cur->type)
         {
@@ -52,6 +52,8 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Object match actions are doubly linked.        */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_objrtmch
@@ -128,7 +130,9 @@ typedef struct objectMatchAction
    int type;
    Instance *ins;
    SLOT_BITMAP *slotNameIDs;
-   struct objectMatchAction *nxt;
+   bool beforeLastRetract;
+   struct objectMatchAction *prv,
+                            *nxt;
   } OBJECT_MATCH_ACTION;
 
    void                  ObjectMatchDelay(Environment *,UDFContext *,CLIPSValue *);
@@ -41,6 +41,9 @@
 /*      6.50: Removed initial-fact and initial-object        */
 /*            support.                                       */
 /*                                                           */
+/*            Added GlobalSlotSensitive for the              */
+/*            slot-sensitive rule property.                  */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_pattern
@@ -147,6 +150,7 @@ struct patternData
    bool WithinNotCE;
    int GlobalSalience;
    bool GlobalAutoFocus;
+   bool GlobalSlotSensitive;
    struct expr *SalienceExpression;
    struct patternNodeHashEntry **PatternHashTable;
    unsigned long PatternHashTableSize;
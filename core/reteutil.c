@@ -56,6 +56,26 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Partial matches are allocated from the arena   */
+/*            of the beta memory in which they're stored.    */
+/*            Alpha matches are allocated together with      */
+/*            their partial match.                           */
+/*                                                           */
+/*            The blocking and dependency links of a partial */
+/*            match are allocated on demand.                 */
+/*                                                           */
+/*            Hashed beta memories keep their size across a  */
+/*            reset.                                         */
+/*                                                           */
+/*            Join hash values are computed from the fact    */
+/*            index and instance name of facts and instances */
+/*            rather than their address.                     */
+/*                                                           */
+/*            Flushing a beta memory with an arena abandons  */
+/*            the arena rather than returning its partial    */
+/*            matches one at a time. The arena of a logical  */
+/*            join is destroyed with the join.               */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
@@ -64,10 +84,15 @@
 
 #if DEFRULE_CONSTRUCT
 
+#include "constrct.h"
 #include "drive.h"
 #include "engine.h"
 #include "envrnmnt.h"
 #include "incrrset.h"
+#if DEFTEMPLATE_CONSTRUCT
+#include "factmngr.h"
+#endif
+#include "lgcldpnd.h"
 #include "match.h"
 #include "memalloc.h"
 #include "moduldef.h"
@@ -75,6 +100,9 @@
 #include "retract.h"
 #include "router.h"
 #include "rulecom.h"
+#if OBJECT_SYSTEM
+#include "object.h"
+#endif
 
 #include "reteutil.h"
 
@@ -88,9 +116,18 @@
    static void                        UnlinkAlphaMemory(Environment *,struct patternNodeHeader *,struct alphaMemoryHash *);
    static void                        UnlinkAlphaMemoryBucketSiblings(Environment *,struct alphaMemoryHash *);
    static void                        InitializePMLinks(struct partialMatch *);
+   static struct slabArena           *PartialMatchLinksArena(Environment *,struct partialMatch *);
+   static struct partialMatch        *AllocateBetaPartialMatch(Environment *,struct joinNode *,int,unsigned short,bool *);
+   static void                        CreateBetaMemoryArena(Environment *,struct betaMemory *,size_t);
+   static void                        ReturnBetaMemoryArena(Environment *,struct betaMemory *);
+   static void                        AddForeignPartialMatch(struct betaMemoryArena *,struct partialMatch *);
+   static void                        RemoveForeignPartialMatch(struct betaMemoryArena *,struct partialMatch *);
    static void                        UnlinkBetaPartialMatchfromAlphaAndBetaLineage(struct partialMatch *);
+   static void                        FlushArenaBetaMemory(Environment *,struct betaMemory *);
+   static void                        DestroyBetaMemoryDependencies(Environment *,struct betaMemory *);
    static int                         CountPriorPatterns(struct joinNode *);
-   static void                        ResizeBetaMemory(Environment *,struct betaMemory *);
+   static unsigned long               BetaMemoryBucket(struct betaMemory *,unsigned long);
+   static void                        ResizeBetaMemory(Environment *,struct betaMemory *,unsigned long);
    static void                        ResetBetaMemory(Environment *,struct betaMemory *);
 #if (CONSTRUCT_COMPILER || BLOAD_AND_BSAVE) && (! RUN_TIME)
    static void                        TagNetworkTraverseJoins(Environment *,long int *,long int *,struct joinNode *);
@@ -129,18 +166,21 @@ void PrintPartialMatch(
 /**********************************************/
 struct partialMatch *CopyPartialMatch(
   Environment *theEnv,
-  struct partialMatch *list)
+  struct partialMatch *list,
+  struct joinNode *theJoin,
+  int side)
   {
    struct partialMatch *linker;
    unsigned short i;
+   bool fromArena;
 
-   linker = get_var_struct(theEnv,partialMatch,sizeof(struct genericMatch) *
-                                        (list->bcount - 1));
+   linker = AllocateBetaPartialMatch(theEnv,theJoin,side,list->bcount,&fromArena);
 
    InitializePMLinks(linker);
    linker->betaMemory = true;
    linker->busy = false;
    linker->rhsMemory = false;
+   linker->fromArena = fromArena;
    linker->bcount = list->bcount;
    linker->hashValue = 0;
 
@@ -163,6 +203,7 @@ struct partialMatch *CreateEmptyPartialMatch(
    linker->betaMemory = true;
    linker->busy = false;
    linker->rhsMemory = false;
+   linker->fromArena = false;
    linker->bcount = 1;
    linker->hashValue = 0;
    linker->binds[0].gm.theValue = NULL;
@@ -170,6 +211,143 @@ struct partialMatch *CreateEmptyPartialMatch(
    return(linker);
   }
 
+/***************************************************************/
+/* AllocateBetaPartialMatch: Allocates a partial match with    */
+/*   the specified number of bindings which will be stored in  */
+/*   the left or right beta memory of a join. Once the memory  */
+/*   has grown large enough, its partial matches are allocated */
+/*   from an arena belonging to the memory.                    */
+/***************************************************************/
+static struct partialMatch *AllocateBetaPartialMatch(
+  Environment *theEnv,
+  struct joinNode *theJoin,
+  int side,
+  unsigned short bcount,
+  bool *fromArena)
+  {
+   struct betaMemory *theMemory;
+   size_t size;
+
+   size = sizeof(struct partialMatch) + (sizeof(struct genericMatch) * (bcount - 1));
+
+   if (side == LHS)
+     { theMemory = theJoin->leftMemory; }
+   else
+     { theMemory = theJoin->rightMemory; }
+
+   if ((theMemory->arena == NULL) &&
+       (theMemory->count >= BETA_ARENA_THRESHOLD))
+     { CreateBetaMemoryArena(theEnv,theMemory,size); }
+
+   if (theMemory->arena == NULL)
+     {
+      *fromArena = false;
+      return((struct partialMatch *) gm2(theEnv,size));
+     }
+
+   *fromArena = ArenaHoldsSize(theMemory->arena->blocks,size);
+
+   return((struct partialMatch *) ArenaAllocate(theEnv,theMemory->arena->blocks,size));
+  }
+
+/***************************************************************/
+/* CreateBetaMemoryArena: Creates the arena for a beta memory. */
+/*   The partial matches already stored in the memory are      */
+/*   recorded as not having been allocated from the arena.     */
+/***************************************************************/
+static void CreateBetaMemoryArena(
+  Environment *theEnv,
+  struct betaMemory *theMemory,
+  size_t size)
+  {
+   struct slabArena *theBlocks, *theLinks;
+   struct betaMemoryArena *theArena;
+   struct partialMatch *thePM;
+   unsigned long i;
+
+   theBlocks = CreateSlabArena(theEnv,size);
+   if (theBlocks == NULL) return;
+
+   theLinks = CreateSlabArena(theEnv,sizeof(struct partialMatchLinks));
+   if (theLinks == NULL)
+     {
+      ReleaseSlabArena(theEnv,theBlocks);
+      return;
+     }
+
+   theArena = get_struct(theEnv,betaMemoryArena);
+   theArena->blocks = theBlocks;
+   theArena->links = theLinks;
+   theArena->foreignCount = 0;
+   theArena->overflow = false;
+
+   for (i = 0; i < theMemory->size; i++)
+     {
+      for (thePM = theMemory->beta[i];
+           thePM != NULL;
+           thePM = thePM->nextInMemory)
+        { AddForeignPartialMatch(theArena,thePM); }
+     }
+
+   theMemory->arena = theArena;
+  }
+
+/**************************************************************/
+/* ReturnBetaMemoryArena: Releases the arena of a beta memory */
+/*   which is no longer needed. Partial matches from the      */
+/*   arena which are still in use keep the arena's pages      */
+/*   until they have been returned.                           */
+/**************************************************************/
+static void ReturnBetaMemoryArena(
+  Environment *theEnv,
+  struct betaMemory *theMemory)
+  {
+   if (theMemory->arena == NULL) return;
+
+   ReleaseSlabArena(theEnv,theMemory->arena->blocks);
+   ReleaseSlabArena(theEnv,theMemory->arena->links);
+   rtn_struct(theEnv,betaMemoryArena,theMemory->arena);
+   theMemory->arena = NULL;
+  }
+
+/*****************************************************/
+/* AddForeignPartialMatch: Records a partial match   */
+/*   stored in a beta memory which wasn't allocated  */
+/*   from the memory's arena.                        */
+/*****************************************************/
+static void AddForeignPartialMatch(
+  struct betaMemoryArena *theArena,
+  struct partialMatch *thePM)
+  {
+   if (theArena->foreignCount < BETA_ARENA_THRESHOLD)
+     { theArena->foreign[theArena->foreignCount++] = thePM; }
+   else
+     { theArena->overflow = true; }
+  }
+
+/*********************************************************/
+/* RemoveForeignPartialMatch: Removes the record of a    */
+/*   partial match which wasn't allocated from the arena */
+/*   of the beta memory from which it's being removed.   */
+/*********************************************************/
+static void RemoveForeignPartialMatch(
+  struct betaMemoryArena *theArena,
+  struct partialMatch *thePM)
+  {
+   unsigned int i;
+
+   if (theArena->overflow) return;
+
+   for (i = 0; i < theArena->foreignCount; i++)
+     {
+      if (theArena->foreign[i] == thePM)
+        {
+         theArena->foreign[i] = theArena->foreign[--theArena->foreignCount];
+         return;
+        }
+     }
+  }
+
 /**********************/
 /* InitializePMLinks: */
 /**********************/
@@ -182,14 +360,77 @@ static void InitializePMLinks(
    theMatch->prevRightChild = NULL;
    theMatch->nextLeftChild = NULL;
    theMatch->prevLeftChild = NULL;
-   theMatch->children = NULL;
    theMatch->rightParent = NULL;
    theMatch->leftParent = NULL;
-   theMatch->blockList = NULL;
-   theMatch->nextBlocked = NULL;
-   theMatch->prevBlocked = NULL;
+   theMatch->owner = NULL;
    theMatch->marker = NULL;
-   theMatch->dependents = NULL;
+   theMatch->children = NULL;
+   theMatch->links = NULL;
+  }
+
+/****************************************************************/
+/* GetPartialMatchLinks: Returns the links structure of a       */
+/*   partial match, allocating it if the partial match doesn't  */
+/*   have one yet. Most partial matches never have logical      */
+/*   dependencies and never take part in blocking, so these     */
+/*   links aren't stored inline.                                */
+/****************************************************************/
+struct partialMatchLinks *GetPartialMatchLinks(
+  Environment *theEnv,
+  struct partialMatch *thePM)
+  {
+   struct partialMatchLinks *theLinks;
+   struct slabArena *theArena;
+
+   if (thePM->links != NULL)
+     { return thePM->links; }
+
+   theArena = PartialMatchLinksArena(theEnv,thePM);
+   if (theArena != NULL)
+     { theLinks = (struct partialMatchLinks *) ArenaAllocate(theEnv,theArena,sizeof(struct partialMatchLinks)); }
+   else
+     { theLinks = get_struct(theEnv,partialMatchLinks); }
+
+   theLinks->blockList = NULL;
+   theLinks->nextBlocked = NULL;
+   theLinks->prevBlocked = NULL;
+   theLinks->dependents = NULL;
+
+   thePM->links = theLinks;
+
+   return theLinks;
+  }
+
+/****************************************************************/
+/* PartialMatchLinksArena: Returns the arena from which the     */
+/*   links of a partial match are allocated. The links of a     */
+/*   partial match allocated from the arena of a beta memory    */
+/*   come from the memory's arena for links so that both can    */
+/*   be released together when the memory is destroyed.         */
+/****************************************************************/
+static struct slabArena *PartialMatchLinksArena(
+  Environment *theEnv,
+  struct partialMatch *thePM)
+  {
+   struct joinNode *theJoin;
+   struct betaMemory *theMemory;
+
+   if ((! thePM->fromArena) || (thePM->owner == NULL))
+     { return NULL; }
+
+   theJoin = (struct joinNode *) thePM->owner;
+   if (thePM->rhsMemory)
+     { theMemory = theJoin->rightMemory; }
+   else
+     { theMemory = theJoin->leftMemory; }
+
+   if ((theMemory == NULL) || (theMemory->arena == NULL))
+     { return NULL; }
+
+   if (! ArenaOwnsBlock(theEnv,theMemory->arena->blocks,thePM))
+     { return NULL; }
+
+   return theMemory->arena->links;
   }
   
 /**********************/
@@ -224,7 +465,7 @@ void UpdateBetaPMLinks(
    /* Update the node's linked list. */
    /*================================*/
 
-   betaLocation = hashValue % theMemory->size;
+   betaLocation = BetaMemoryBucket(theMemory,hashValue);
    
    if (side == LHS)
      {
@@ -247,6 +488,8 @@ void UpdateBetaPMLinks(
      }
      
    theMemory->count++;
+   if ((theMemory->arena != NULL) && (! thePM->fromArena))
+     { AddForeignPartialMatch(theMemory->arena,thePM); }
    if (side == LHS)
     { join->memoryLeftAdds++; }
    else
@@ -284,8 +527,8 @@ void UpdateBetaPMLinks(
      { return; }
 
    if ((theMemory->size > 1) &&
-       (theMemory->count > (theMemory->size * 11)))
-     { ResizeBetaMemory(theEnv,theMemory); }
+       (theMemory->count > (theMemory->size * BETA_HASH_GROW_LOAD)))
+     { ResizeBetaMemory(theEnv,theMemory,theMemory->size * BETA_HASH_GROW_LOAD); }
   }
 
 /**********************************************************/
@@ -296,14 +539,20 @@ void UpdateBetaPMLinks(
 /*   the next join in the rule.                           */
 /**********************************************************/
 void AddBlockedLink(
+  Environment *theEnv,
   struct partialMatch *thePM,
   struct partialMatch *rhsBinds)
   {
+   struct partialMatchLinks *theLinks, *blockerLinks;
+
+   theLinks = GetPartialMatchLinks(theEnv,thePM);
+   blockerLinks = GetPartialMatchLinks(theEnv,rhsBinds);
+
    thePM->marker = rhsBinds;
-   thePM->nextBlocked = rhsBinds->blockList;
-   if (rhsBinds->blockList != NULL)
-     { rhsBinds->blockList->prevBlocked = thePM; }
-   rhsBinds->blockList = thePM;
+   theLinks->nextBlocked = blockerLinks->blockList;
+   if (blockerLinks->blockList != NULL)
+     { blockerLinks->blockList->links->prevBlocked = thePM; }
+   blockerLinks->blockList = thePM;
   }
 
 /*************************************************************/
@@ -317,20 +566,29 @@ void RemoveBlockedLink(
   struct partialMatch *thePM)
   {
    struct partialMatch *blocker;
+   struct partialMatchLinks *theLinks;
    
-   if (thePM->prevBlocked == NULL)
+   theLinks = thePM->links;
+   if (theLinks == NULL)
+     {
+      thePM->marker = NULL;
+      return;
+     }
+
+   if (theLinks->prevBlocked == NULL)
      { 
       blocker = (struct partialMatch *) thePM->marker;
-      blocker->blockList = thePM->nextBlocked; 
+      if (blocker->links != NULL)
+        { blocker->links->blockList = theLinks->nextBlocked; }
      } 
    else
-     { thePM->prevBlocked->nextBlocked = thePM->nextBlocked; }
+     { theLinks->prevBlocked->links->nextBlocked = theLinks->nextBlocked; }
 
-   if (thePM->nextBlocked != NULL)
-     { thePM->nextBlocked->prevBlocked = thePM->prevBlocked; }
+   if (theLinks->nextBlocked != NULL)
+     { theLinks->nextBlocked->links->prevBlocked = theLinks->prevBlocked; }
 
-   thePM->nextBlocked = NULL;
-   thePM->prevBlocked = NULL;
+   theLinks->nextBlocked = NULL;
+   theLinks->prevBlocked = NULL;
    thePM->marker = NULL;
   }
          
@@ -356,23 +614,22 @@ void UnlinkBetaPMFromNodeAndLineage(
    /*=============================================*/
    
    theMemory->count--;
+   if ((theMemory->arena != NULL) && (! thePM->fromArena))
+     { RemoveForeignPartialMatch(theMemory->arena,thePM); }
 
    if (side == LHS)
     { join->memoryLeftDeletes++; }
    else
     { join->memoryRightDeletes++; }
 
-   betaLocation = thePM->hashValue % theMemory->size;
+   betaLocation = BetaMemoryBucket(theMemory,thePM->hashValue);
    
    if ((side == RHS) &&
        (theMemory->last[betaLocation] == thePM))
      { theMemory->last[betaLocation] = thePM->prevInMemory; }
      
    if (thePM->prevInMemory == NULL)
-     { 
-      betaLocation = thePM->hashValue % theMemory->size;
-      theMemory->beta[betaLocation] = thePM->nextInMemory; 
-     }
+     { theMemory->beta[betaLocation] = thePM->nextInMemory; }
    else
      { thePM->prevInMemory->nextInMemory = thePM->nextInMemory; }
 
@@ -403,6 +660,7 @@ void UnlinkNonLeftLineage(
    unsigned long betaLocation;
    struct betaMemory *theMemory;
    struct partialMatch *tempPM;
+   struct partialMatchLinks *theLinks;
 
    if (side == LHS)
      { theMemory = join->leftMemory; }
@@ -414,23 +672,22 @@ void UnlinkNonLeftLineage(
    /*=============================================*/
    
    theMemory->count--;
+   if ((theMemory->arena != NULL) && (! thePM->fromArena))
+     { RemoveForeignPartialMatch(theMemory->arena,thePM); }
 
    if (side == LHS)
     { join->memoryLeftDeletes++; }
    else
     { join->memoryRightDeletes++; }
 
-   betaLocation = thePM->hashValue % theMemory->size;
+   betaLocation = BetaMemoryBucket(theMemory,thePM->hashValue);
    
    if ((side == RHS) &&
        (theMemory->last[betaLocation] == thePM))
      { theMemory->last[betaLocation] = thePM->prevInMemory; }
      
    if (thePM->prevInMemory == NULL)
-     { 
-      betaLocation = thePM->hashValue % theMemory->size;
-      theMemory->beta[betaLocation] = thePM->nextInMemory; 
-     }
+     { theMemory->beta[betaLocation] = thePM->nextInMemory; }
    else
      { thePM->prevInMemory->nextInMemory = thePM->nextInMemory; }
 
@@ -463,18 +720,22 @@ void UnlinkNonLeftLineage(
    /* Update the blocked lists. */
    /*===========================*/
 
-   if (thePM->prevBlocked == NULL)
-     { 
-      tempPM = (struct partialMatch *) thePM->marker;
+   theLinks = thePM->links;
+   if (theLinks != NULL)
+     {
+      if (theLinks->prevBlocked == NULL)
+        { 
+         tempPM = (struct partialMatch *) thePM->marker;
       
-      if (tempPM != NULL)
-        { tempPM->blockList = thePM->nextBlocked; } 
-     }
-   else
-     { thePM->prevBlocked->nextBlocked = thePM->nextBlocked; }
+         if ((tempPM != NULL) && (tempPM->links != NULL))
+           { tempPM->links->blockList = theLinks->nextBlocked; } 
+        }
+      else
+        { theLinks->prevBlocked->links->nextBlocked = theLinks->nextBlocked; }
 
-   if (thePM->nextBlocked != NULL)
-     { thePM->nextBlocked->prevBlocked = thePM->prevBlocked; }
+      if (theLinks->nextBlocked != NULL)
+        { theLinks->nextBlocked->links->prevBlocked = theLinks->prevBlocked; }
+     }
 
    if (! DefruleData(theEnv)->BetaMemoryResizingFlag)
      { return; }
@@ -494,6 +755,7 @@ static void UnlinkBetaPartialMatchfromAlphaAndBetaLineage(
   struct partialMatch *thePM)
   {
    struct partialMatch *tempPM;
+   struct partialMatchLinks *theLinks;
    
    /*=========================*/
    /* Update the alpha lists. */
@@ -537,22 +799,27 @@ static void UnlinkBetaPartialMatchfromAlphaAndBetaLineage(
    /* Update the blocked lists. */
    /*===========================*/
 
-   if (thePM->prevBlocked == NULL)
-     { 
-      tempPM = (struct partialMatch *) thePM->marker;
+   theLinks = thePM->links;
+   if (theLinks != NULL)
+     {
+      if (theLinks->prevBlocked == NULL)
+        { 
+         tempPM = (struct partialMatch *) thePM->marker;
       
-      if (tempPM != NULL)
-        { tempPM->blockList = thePM->nextBlocked; } 
-     }
-   else
-     { thePM->prevBlocked->nextBlocked = thePM->nextBlocked; }
+         if ((tempPM != NULL) && (tempPM->links != NULL))
+           { tempPM->links->blockList = theLinks->nextBlocked; } 
+        }
+      else
+        { theLinks->prevBlocked->links->nextBlocked = theLinks->nextBlocked; }
+
+      if (theLinks->nextBlocked != NULL)
+        { theLinks->nextBlocked->links->prevBlocked = theLinks->prevBlocked; }
 
-   if (thePM->nextBlocked != NULL)
-     { thePM->nextBlocked->prevBlocked = thePM->prevBlocked; }
+      theLinks->nextBlocked = NULL;
+      theLinks->prevBlocked = NULL;
+     }
 
    thePM->marker = NULL;
-   thePM->nextBlocked = NULL;
-   thePM->prevBlocked = NULL;
       
    /*===============================================*/
    /* Remove parent reference from the child links. */
@@ -583,16 +850,19 @@ static void UnlinkBetaPartialMatchfromAlphaAndBetaLineage(
 struct partialMatch *MergePartialMatches(
   Environment *theEnv,
   struct partialMatch *lhsBind,
-  struct partialMatch *rhsBind)
+  struct partialMatch *rhsBind,
+  struct joinNode *theJoin,
+  int side)
   {
    struct partialMatch *linker;
    static struct partialMatch mergeTemplate = { 1 }; /* betaMemory is true, remainder are 0 or NULL */
+   bool fromArena;
   
    /*=================================*/
    /* Allocate the new partial match. */
    /*=================================*/
    
-   linker = get_var_struct(theEnv,partialMatch,sizeof(struct genericMatch) * lhsBind->bcount);
+   linker = AllocateBetaPartialMatch(theEnv,theJoin,side,(unsigned short) (lhsBind->bcount + 1),&fromArena);
 
    /*============================================*/
    /* Set the flags to their appropriate values. */
@@ -600,6 +870,7 @@ struct partialMatch *MergePartialMatches(
    
    memcpy(linker,&mergeTemplate,sizeof(struct partialMatch) - sizeof(struct genericMatch));
    
+   linker->fromArena = fromArena;
    linker->bcount = (unsigned short) (lhsBind->bcount + 1);
    
    /*========================================================*/
@@ -671,16 +942,19 @@ struct partialMatch *CreateAlphaMatch(
 
    /*==================================================*/
    /* Create the alpha match and intialize its values. */
+   /* The alphaMatch is allocated in the same block as */
+   /* the partial match which refers to it.            */
    /*==================================================*/
 
-   theMatch = get_struct(theEnv,partialMatch);
+   theMatch = (struct partialMatch *) gm2(theEnv,sizeof(struct partialMatch) + sizeof(struct alphaMatch));
    InitializePMLinks(theMatch);
    theMatch->betaMemory = false;
    theMatch->busy = false;
+   theMatch->fromArena = false;
    theMatch->bcount = 1;
    theMatch->hashValue = hashOffset;
 
-   afbtemp = get_struct(theEnv,alphaMatch);
+   afbtemp = (struct alphaMatch *) (theMatch + 1);
    afbtemp->next = NULL;
    afbtemp->matchingItem = (struct patternEntity *) theEntity;
 
@@ -1066,7 +1340,7 @@ struct partialMatch *GetLeftBetaMemory(
   {
    unsigned long betaLocation;
    
-   betaLocation = hashValue % theJoin->leftMemory->size;
+   betaLocation = BetaMemoryBucket(theJoin->leftMemory,hashValue);
 
    return theJoin->leftMemory->beta[betaLocation];
   }
@@ -1081,7 +1355,7 @@ struct partialMatch *GetRightBetaMemory(
   {
    unsigned long betaLocation;
    
-   betaLocation = hashValue % theJoin->rightMemory->size;
+   betaLocation = BetaMemoryBucket(theJoin->rightMemory,hashValue);
 
    return theJoin->rightMemory->beta[betaLocation];
   }
@@ -1095,6 +1369,7 @@ void ReturnLeftMemory(
   struct joinNode *theJoin)
   {
    if (theJoin->leftMemory == NULL) return;
+   ReturnBetaMemoryArena(theEnv,theJoin->leftMemory);
    genfree(theEnv,theJoin->leftMemory->beta,sizeof(struct partialMatch *) * theJoin->leftMemory->size);
    rtn_struct(theEnv,betaMemory,theJoin->leftMemory);
    theJoin->leftMemory = NULL;
@@ -1109,6 +1384,7 @@ void ReturnRightMemory(
   struct joinNode *theJoin)
   {
    if (theJoin->rightMemory == NULL) return;
+   ReturnBetaMemoryArena(theEnv,theJoin->rightMemory);
    genfree(theEnv,theJoin->rightMemory->beta,sizeof(struct partialMatch *) * theJoin->rightMemory->size);
    genfree(theEnv,theJoin->rightMemory->last,sizeof(struct partialMatch *) * theJoin->rightMemory->size);
    rtn_struct(theEnv,betaMemory,theJoin->rightMemory);
@@ -1129,21 +1405,45 @@ void DestroyBetaMemory(
   int side)
   {  
    unsigned long i;
+   struct betaMemory *theMemory;
+   struct betaMemoryArena *theArena;
        
    if (side == LHS)
-     {
-      if (theJoin->leftMemory == NULL) return;
-   
-      for (i = 0; i < theJoin->leftMemory->size; i++)
-        { DestroyAlphaBetaMemory(theEnv,theJoin->leftMemory->beta[i]); }
-     }
+     { theMemory = theJoin->leftMemory; }
    else
+     { theMemory = theJoin->rightMemory; }
+
+   if (theMemory == NULL) return;
+
+   /*=========================================================*/
+   /* If the partial matches from the arena of the memory are */
+   /* all stored in the memory and the other partial matches  */
+   /* in the memory are known, the arena can be destroyed     */
+   /* without returning the partial matches allocated from    */
+   /* it. The partial matches of a logical join may have      */
+   /* dependencies, so they're visited to return those first. */
+   /*=========================================================*/
+
+   theArena = theMemory->arena;
+   if ((theArena != NULL) &&
+       (! theArena->overflow) &&
+       ((theArena->blocks->liveBlocks + theArena->foreignCount) == theMemory->count))
      {
-      if (theJoin->rightMemory == NULL) return;
-   
-      for (i = 0; i < theJoin->rightMemory->size; i++)
-        { DestroyAlphaBetaMemory(theEnv,theJoin->rightMemory->beta[i]); }
+      if (theJoin->logicalJoin)
+        { DestroyBetaMemoryDependencies(theEnv,theMemory); }
+
+      for (i = 0; i < theArena->foreignCount; i++)
+        { DestroyPartialMatch(theEnv,theArena->foreign[i]); }
+
+      DestroySlabArena(theEnv,theArena->blocks);
+      DestroySlabArena(theEnv,theArena->links);
+      rtn_struct(theEnv,betaMemoryArena,theArena);
+      theMemory->arena = NULL;
+      return;
      }
+
+   for (i = 0; i < theMemory->size; i++)
+     { DestroyAlphaBetaMemory(theEnv,theMemory->beta[i]); }
   }
     
 /*************************************************************/
@@ -1159,22 +1459,102 @@ void FlushBetaMemory(
   int side)
   {
    unsigned long i;
+   struct betaMemory *theMemory;
    
    if (side == LHS)
-     {
-      if (theJoin->leftMemory == NULL) return;
+     { theMemory = theJoin->leftMemory; }
+   else
+     { theMemory = theJoin->rightMemory; }
+
+   if (theMemory == NULL) return;
 
-      for (i = 0; i < theJoin->leftMemory->size; i++)
-        { FlushAlphaBetaMemory(theEnv,theJoin->leftMemory->beta[i]); }
+   if (theMemory->arena != NULL)
+     {
+      FlushArenaBetaMemory(theEnv,theMemory);
+      return;
      }
-   else
+
+   for (i = 0; i < theMemory->size; i++)
+     { FlushAlphaBetaMemory(theEnv,theMemory->beta[i]); }
+ }
+
+/******************************************************************/
+/* FlushArenaBetaMemory: Flushes a beta memory with an arena. The */
+/*   partial matches must still be unlinked from their parents,   */
+/*   which may belong to joins that are being kept, but those     */
+/*   allocated from the arena (and their links) aren't returned   */
+/*   one at a time. The arena is abandoned instead. Its pages are */
+/*   returned once any partial matches from it that are in use    */
+/*   have been returned from the list of garbage partial matches. */
+/******************************************************************/
+static void FlushArenaBetaMemory(
+  Environment *theEnv,
+  struct betaMemory *theMemory)
+  {
+   unsigned long i;
+   unsigned long abandonedBlocks = 0, abandonedLinks = 0;
+   struct partialMatch *thePM, *nextPM;
+   struct betaMemoryArena *theArena = theMemory->arena;
+
+   for (i = 0; i < theMemory->size; i++)
      {
-      if (theJoin->rightMemory == NULL) return;
+      for (thePM = theMemory->beta[i];
+           thePM != NULL;
+           thePM = nextPM)
+        {
+         nextPM = thePM->nextInMemory;
+
+         UnlinkBetaPartialMatchfromAlphaAndBetaLineage(thePM);
 
-      for (i = 0; i < theJoin->rightMemory->size; i++)
-        { FlushAlphaBetaMemory(theEnv,theJoin->rightMemory->beta[i]); }
+         if ((! thePM->fromArena) || thePM->busy)
+           {
+            ReturnPartialMatch(theEnv,thePM);
+            continue;
+           }
+
+         if (PMDependents(thePM) != NULL) RemovePMDependencies(theEnv,thePM);
+
+         if (thePM->links != NULL)
+           {
+            if (ArenaOwnsBlock(theEnv,theArena->links,thePM->links))
+              { abandonedLinks++; }
+            else
+              { rtn_struct(theEnv,partialMatchLinks,thePM->links); }
+           }
+
+         abandonedBlocks++;
+        }
      }
- }
+
+   AbandonSlabArena(theEnv,theArena->blocks,abandonedBlocks);
+   AbandonSlabArena(theEnv,theArena->links,abandonedLinks);
+   rtn_struct(theEnv,betaMemoryArena,theArena);
+   theMemory->arena = NULL;
+  }
+
+/******************************************************************/
+/* DestroyBetaMemoryDependencies: Returns the dependencies of the */
+/*   partial matches in the beta memory of a logical join before  */
+/*   the memory's arena is destroyed.                             */
+/******************************************************************/
+static void DestroyBetaMemoryDependencies(
+  Environment *theEnv,
+  struct betaMemory *theMemory)
+  {
+   unsigned long i;
+   struct partialMatch *thePM;
+
+   for (i = 0; i < theMemory->size; i++)
+     {
+      for (thePM = theMemory->beta[i];
+           thePM != NULL;
+           thePM = thePM->nextInMemory)
+        {
+         if (PMDependents(thePM) != NULL)
+           { DestroyPMDependencies(theEnv,thePM); }
+        }
+     }
+  }
   
 /***********************/
 /* BetaMemoryNotEmpty: */
@@ -1308,9 +1688,14 @@ static struct alphaMemoryHash *FindAlphaMemory(
    return theAlphaMemory;
   }   
 
-/*************************/
-/* AlphaMemoryHashValue: */
-/*************************/
+/*************************************************************/
+/* AlphaMemoryHashValue: The memories of a pattern node are  */
+/*   found by bucket rather than by right hash value, so the */
+/*   pattern node address is added to the hash value rather  */
+/*   than mixed with it. Whether two memories of the same    */
+/*   node share a bucket then depends only on their hash     */
+/*   values and not on where the node was allocated.         */
+/*************************************************************/
 static unsigned long AlphaMemoryHashValue(
   struct patternNodeHeader *theHeader,
   unsigned long hashOffset)
@@ -1387,25 +1772,19 @@ static void UnlinkAlphaMemoryBucketSiblings(
 /**************************/
 /* ComputeRightHashValue: */
 /**************************/
-unsigned long ComputeRightHashValue(
+unsigned int ComputeRightHashValue(
   Environment *theEnv,
   struct patternNodeHeader *theHeader)
   {
    struct expr *tempExpr;
-   unsigned long hashValue = 0;
-   unsigned long multiplier = 1;
-   union
-     {
-      void *vv;
-      unsigned long liv;
-     } fis;
+   unsigned long long hashValue = 0;
       
    if (theHeader->rightHash == NULL)
-     { return hashValue; }
+     { return 0; }
      
    for (tempExpr = theHeader->rightHash; 
         tempExpr != NULL; 
-        tempExpr = tempExpr->nextArg, multiplier = multiplier * 509)
+        tempExpr = tempExpr->nextArg)
       {
        CLIPSValue theResult;
        struct expr *oldArgument;
@@ -1415,48 +1794,104 @@ unsigned long ComputeRightHashValue(
        (*EvaluationData(theEnv)->PrimitivesArray[tempExpr->type]->evaluateFunction)(theEnv,tempExpr->value,&theResult);
        EvaluationData(theEnv)->CurrentExpression = oldArgument;
         
-       switch (theResult.type)
-         {
-          case STRING:
-          case SYMBOL:
-          case INSTANCE_NAME:
-            hashValue += (((SYMBOL_HN *) theResult.value)->bucket * multiplier);
-            break;
+       hashValue = AddJoinHashValue(hashValue,&theResult);
+       }
+       
+     return (unsigned int) hashValue;
+    }
+
+/**************************************************************/
+/* AddJoinHashValue: Adds the hash of the next field of a     */
+/*   join hash expression to the hash value computed for the  */
+/*   preceding fields. Facts and instances are hashed by      */
+/*   their fact index and instance name rather than their     */
+/*   address, so the distribution of partial matches doesn't  */
+/*   vary from run to run. The left and right hash values of  */
+/*   a join must be computed the same way.                    */
+/**************************************************************/
+unsigned long long AddJoinHashValue(
+  unsigned long long hashValue,
+  CLIPSValue *theValue)
+  {
+   unsigned long long fieldHash;
+
+   switch (theValue->type)
+     {
+      case STRING:
+      case SYMBOL:
+      case INSTANCE_NAME:
+        fieldHash = ((SYMBOL_HN *) theValue->value)->bucket;
+        break;
              
-          case INTEGER:
-            hashValue += (((INTEGER_HN *) theResult.value)->bucket * multiplier);
-            break;
+      case INTEGER:
+        fieldHash = ((INTEGER_HN *) theValue->value)->bucket;
+        break;
              
-          case FLOAT:
-            hashValue += (((FLOAT_HN *) theResult.value)->bucket * multiplier);
-            break;
+      case FLOAT:
+        fieldHash = ((FLOAT_HN *) theValue->value)->bucket;
+        break;
             
-          case FACT_ADDRESS:
+#if DEFTEMPLATE_CONSTRUCT
+      case FACT_ADDRESS:
+        fieldHash = (unsigned long long) ((Fact *) theValue->value)->factIndex;
+        break;
+#endif
+
 #if OBJECT_SYSTEM
-          case INSTANCE_ADDRESS:
+      case INSTANCE_ADDRESS:
+        fieldHash = ((Instance *) theValue->value)->name->bucket;
+        break;
 #endif
-            fis.liv = 0;
-            fis.vv = theResult.value;
-            hashValue += (unsigned long) (fis.liv * multiplier);
-            break;
-
-          case EXTERNAL_ADDRESS:
-            fis.liv = 0;
-            fis.vv = ValueToExternalAddress(theResult.value);
-            hashValue += (unsigned long) (fis.liv * multiplier);
-            break;
-          }
-       }
-       
-     return hashValue;
-    }
 
-/*********************/
-/* ResizeBetaMemory: */
-/*********************/
-void ResizeBetaMemory(
+      case EXTERNAL_ADDRESS:
+        fieldHash = ((EXTERNAL_ADDRESS_HN *) theValue->value)->bucket;
+        break;
+        
+      default:
+        fieldHash = 0;
+        break;
+     }
+
+   return (hashValue * JOIN_HASH_MULTIPLIER) + fieldHash;
+  }
+
+/**************************************************************/
+/* FoldJoinHashValue: Reduces a 64 bit hash value to 32 bits. */
+/*   A round of mixing is applied first so that the low order */
+/*   bits of the result can be used directly to index a hash  */
+/*   table whose size is a power of two.                      */
+/**************************************************************/
+unsigned int FoldJoinHashValue(
+  unsigned long long hashValue)
+  {
+   hashValue ^= hashValue >> 33;
+   hashValue *= 0xFF51AFD7ED558CCDULL;
+   hashValue ^= hashValue >> 33;
+
+   return (unsigned int) hashValue;
+  }
+
+/*****************************************************************/
+/* BetaMemoryBucket: Returns the bucket of a beta memory in      */
+/*   which partial matches with the specified hash value are     */
+/*   stored.                                                     */
+/*****************************************************************/
+static unsigned long BetaMemoryBucket(
+  struct betaMemory *theMemory,
+  unsigned long hashValue)
+  {
+   return(hashValue % theMemory->size);
+  }
+
+/*****************************************************************/
+/* ResizeBetaMemory: Rehashes the partial matches of a beta      */
+/*   memory into a table of the specified size. The order of the */
+/*   partial matches within each bucket is preserved.            */
+/*****************************************************************/
+static void ResizeBetaMemory(
   Environment *theEnv,
-  struct betaMemory *theMemory)
+  struct betaMemory *theMemory,
+  unsigned long newSize)
   {
    struct partialMatch **oldArray, **lastAdd, *thePM, *nextPM;
    unsigned long i, oldSize, betaLocation;
@@ -1464,7 +1899,7 @@ void ResizeBetaMemory(
    oldSize = theMemory->size;
    oldArray = theMemory->beta;
    
-   theMemory->size = oldSize * 11;
+   theMemory->size = newSize;
    theMemory->beta = (struct partialMatch **) genalloc(theEnv,sizeof(struct partialMatch *) * theMemory->size);
      
    lastAdd = (struct partialMatch **) genalloc(theEnv,sizeof(struct partialMatch *) * theMemory->size);
@@ -1480,7 +1915,7 @@ void ResizeBetaMemory(
          
          thePM->nextInMemory = NULL;
          
-         betaLocation = thePM->hashValue % theMemory->size;
+         betaLocation = BetaMemoryBucket(theMemory,thePM->hashValue);
          thePM->prevInMemory = lastAdd[betaLocation];
          
          if (lastAdd[betaLocation] != NULL)
@@ -1505,9 +1940,13 @@ void ResizeBetaMemory(
    genfree(theEnv,oldArray,sizeof(struct partialMatch *) * oldSize);
   }
 
-/********************/
-/* ResetBetaMemory: */
-/********************/
+/*****************************************************************/
+/* ResetBetaMemory: Returns the table of a hashed beta memory    */
+/*   which no longer holds any partial matches to its initial    */
+/*   size. While a reset is in progress, the memory keeps the    */
+/*   size it grew to so that the next run doesn't have to grow   */
+/*   it through the same sizes again.                            */
+/*****************************************************************/
 static void ResetBetaMemory(
   Environment *theEnv,
   struct betaMemory *theMemory)
@@ -1519,6 +1958,9 @@ static void ResetBetaMemory(
        (theMemory->size == INITIAL_BETA_HASH_SIZE))
      { return; }
 
+   if (ConstructData(theEnv)->ResetInProgress)
+     { return; }
+
    oldSize = theMemory->size;
    oldArray = theMemory->beta;
    
@@ -51,6 +51,13 @@
 /*            Removed use of void pointers for specific      */
 /*            data structures.                               */
 /*                                                           */
+/*            Partial matches are allocated from the arena   */
+/*            of the beta memory in which they're stored.    */
+/*                                                           */
+/*            Join hash values are computed from the fact    */
+/*            index and instance name of facts and instances */
+/*            rather than their address.                     */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_reteutil
@@ -66,9 +73,18 @@
 #define NETWORK_ASSERT  0
 #define NETWORK_RETRACT 1
 
+/*=================================================*/
+/* Multiplier by which the fields of a join hash   */
+/* value are weighted.                             */
+/*=================================================*/
+
+#define JOIN_HASH_MULTIPLIER 509
+
    void                           PrintPartialMatch(Environment *,const char *,struct partialMatch *);
-   struct partialMatch           *CopyPartialMatch(Environment *,struct partialMatch *);
-   struct partialMatch           *MergePartialMatches(Environment *,struct partialMatch *,struct partialMatch *);
+   struct partialMatch           *CopyPartialMatch(Environment *,struct partialMatch *,struct joinNode *,int);
+   struct partialMatchLinks      *GetPartialMatchLinks(Environment *,struct partialMatch *);
+   struct partialMatch           *MergePartialMatches(Environment *,struct partialMatch *,struct partialMatch *,
+                                                          struct joinNode *,int);
    long int                       IncrementPseudoFactIndex(void);
    struct partialMatch           *GetAlphaMemory(Environment *,struct patternNodeHeader *,unsigned long);
    struct partialMatch           *GetLeftBetaMemory(struct joinNode *,unsigned long);
@@ -93,14 +109,16 @@
    void                           MarkRuleNetwork(Environment *,int);
    void                           TagRuleNetwork(Environment *,long *,long *,long *,long *);
    bool                           FindEntityInPartialMatch(struct patternEntity *,struct partialMatch *);
-   unsigned long                  ComputeRightHashValue(Environment *,struct patternNodeHeader *);
+   unsigned int                   ComputeRightHashValue(Environment *,struct patternNodeHeader *);
+   unsigned long long             AddJoinHashValue(unsigned long long,CLIPSValue *);
+   unsigned int                   FoldJoinHashValue(unsigned long long);
    void                           UpdateBetaPMLinks(Environment *,struct partialMatch *,struct partialMatch *,struct partialMatch *,
                                                        struct joinNode *,unsigned long,int);
    void                           UnlinkBetaPMFromNodeAndLineage(Environment *,struct joinNode *,struct partialMatch *,int);
    void                           UnlinkNonLeftLineage(Environment *,struct joinNode *,struct partialMatch *,int);
    struct partialMatch           *CreateEmptyPartialMatch(Environment *);
    void                           MarkRuleJoins(struct joinNode *,int);
-   void                           AddBlockedLink(struct partialMatch *,struct partialMatch *);
+   void                           AddBlockedLink(Environment *,struct partialMatch *,struct partialMatch *);
    void                           RemoveBlockedLink(struct partialMatch *);
    unsigned long                  PrintBetaMemory(Environment *,const char *,struct betaMemory *,bool,const char *,int);
 
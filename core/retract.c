@@ -39,6 +39,12 @@
 /*            Removed use of void pointers for specific      */
 /*            data structures.                               */
 /*                                                           */
+/*            The alphaMatch of an alpha memory partial      */
+/*            match is returned with the partial match.      */
+/*                                                           */
+/*            The links structure of a partial match is      */
+/*            returned with the partial match.               */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
@@ -69,6 +75,7 @@
 /***************************************/
 
    static void                    ReturnMarkers(Environment *,struct multifieldMarker *);
+   static size_t                  PartialMatchSize(struct partialMatch *);
    static bool                    FindNextConflictingMatch(Environment *,struct partialMatch *,
                                                            struct partialMatch *,
                                                            struct joinNode *,struct partialMatch *,int);
@@ -97,7 +104,7 @@ void NetworkRetract(
       if (tempMatch->theMatch->children != NULL)
         { PosEntryRetractAlpha(theEnv,tempMatch->theMatch,NETWORK_RETRACT); }
 
-      if (tempMatch->theMatch->blockList != NULL)
+      if (PMBlockList(tempMatch->theMatch) != NULL)
         { NegEntryRetractAlpha(theEnv,tempMatch->theMatch,NETWORK_RETRACT); }
       
       /*===================================================*/
@@ -166,7 +173,7 @@ static void NegEntryRetractAlpha(
    struct partialMatch *betaMatch;
    struct joinNode *joinPtr;
    
-   betaMatch = alphaMatch->blockList;
+   betaMatch = PMBlockList(alphaMatch);
    while (betaMatch != NULL)
      {
       joinPtr = (struct joinNode *) betaMatch->owner;
@@ -176,12 +183,12 @@ static void NegEntryRetractAlpha(
           (! joinPtr->joinFromTheRight))
         {               
          SystemError(theEnv,"RETRACT",117);
-         betaMatch = betaMatch->nextBlocked;
+         betaMatch = PMNextBlocked(betaMatch);
          continue;
         }
 
       NegEntryRetractBeta(theEnv,joinPtr,alphaMatch,betaMatch,operation);
-      betaMatch = alphaMatch->blockList;
+      betaMatch = PMBlockList(alphaMatch);
      }
   }
 
@@ -273,7 +280,7 @@ void PosEntryRetractBeta(
          betaMatch->leftParent->children = NULL; 
         }
 
-      if (betaMatch->blockList != NULL)
+      if (PMBlockList(betaMatch) != NULL)
         { NegEntryRetractAlpha(theEnv,betaMatch,operation); }
       else if ((((struct joinNode *) betaMatch->owner)->ruleToActivate != NULL) ?
                (betaMatch->marker != NULL) : false)
@@ -284,7 +291,7 @@ void PosEntryRetractBeta(
       else
         { UnlinkNonLeftLineage(theEnv,(struct joinNode *) betaMatch->owner,betaMatch,LHS); } 
 
-      if (betaMatch->dependents != NULL) RemoveLogicalSupport(theEnv,betaMatch);
+      if (PMDependents(betaMatch) != NULL) RemoveLogicalSupport(theEnv,betaMatch);
       ReturnPartialMatch(theEnv,betaMatch);
     
       if (tempMatch == parentMatch) return;
@@ -412,7 +419,7 @@ static bool FindNextConflictingMatch(
 
       if (result != false)
         {
-         AddBlockedLink(theBind,possibleConflicts);
+         AddBlockedLink(theEnv,theBind,possibleConflicts);
          EngineData(theEnv)->GlobalLHSBinds = oldLHSBinds;
          EngineData(theEnv)->GlobalRHSBinds = oldRHSBinds;
          EngineData(theEnv)->GlobalJoin = oldJoin;
@@ -511,7 +518,7 @@ void DeletePartialMatches(
       /* result of a logical CE.                        */
       /*================================================*/
 
-      if (listOfPMs->dependents != NULL) RemoveLogicalSupport(theEnv,listOfPMs);
+      if (PMDependents(listOfPMs) != NULL) RemoveLogicalSupport(theEnv,listOfPMs);
 
       /*==========================================================*/
       /* If the partial match is being deleted from a beta memory */
@@ -568,7 +575,6 @@ void ReturnPartialMatch(
      {
       if (waste->binds[0].gm.theMatch->markers != NULL)
         { ReturnMarkers(theEnv,waste->binds[0].gm.theMatch->markers); }
-      rm(theEnv,waste->binds[0].gm.theMatch,(int) sizeof(struct alphaMatch));
      }
 
    /*=================================================*/
@@ -577,15 +583,20 @@ void ReturnPartialMatch(
    /* the logical CE.                                 */
    /*=================================================*/
 
-   if (waste->dependents != NULL) RemovePMDependencies(theEnv,waste);
+   if (PMDependents(waste) != NULL) RemovePMDependencies(theEnv,waste);
+
+   /*========================================*/
+   /* Return the links of the partial match, */
+   /* if they were allocated.                */
+   /*========================================*/
+
+   if (waste->links != NULL) rtn_struct(theEnv,partialMatchLinks,waste->links);
 
    /*======================================================*/
    /* Return the partial match to the pool of free memory. */
    /*======================================================*/
 
-   rtn_var_struct(theEnv,partialMatch,(int) sizeof(struct genericMatch *) *
-                  (waste->bcount - 1),
-                  waste);
+   rm(theEnv,waste,PartialMatchSize(waste));
   }
 
 /***************************************************************/
@@ -607,7 +618,6 @@ void DestroyPartialMatch(
      {
       if (waste->binds[0].gm.theMatch->markers != NULL)
         { ReturnMarkers(theEnv,waste->binds[0].gm.theMatch->markers); }
-      rm(theEnv,waste->binds[0].gm.theMatch,(int) sizeof(struct alphaMatch));
      }
      
    /*=================================================*/
@@ -616,15 +626,34 @@ void DestroyPartialMatch(
    /* the logical CE.                                 */
    /*=================================================*/
 
-   if (waste->dependents != NULL) DestroyPMDependencies(theEnv,waste);
+   if (PMDependents(waste) != NULL) DestroyPMDependencies(theEnv,waste);
+
+   /*========================================*/
+   /* Return the links of the partial match, */
+   /* if they were allocated.                */
+   /*========================================*/
+
+   if (waste->links != NULL) rtn_struct(theEnv,partialMatchLinks,waste->links);
 
    /*======================================================*/
    /* Return the partial match to the pool of free memory. */
    /*======================================================*/
 
-   rtn_var_struct(theEnv,partialMatch,(int) sizeof(struct genericMatch *) *
-                  (waste->bcount - 1),
-                  waste);
+   rm(theEnv,waste,PartialMatchSize(waste));
+  }
+
+/***************************************************************/
+/* PartialMatchSize: Returns the size of the block allocated   */
+/*   for a partial match. The alphaMatch of a partial match    */
+/*   stored in an alpha memory is part of the same block.      */
+/***************************************************************/
+static size_t PartialMatchSize(
+  struct partialMatch *thePM)
+  {
+   if (thePM->betaMemory == false)
+     { return(sizeof(struct partialMatch) + sizeof(struct alphaMatch)); }
+
+   return(sizeof(struct partialMatch) + (sizeof(struct genericMatch) * (thePM->bcount - 1)));
   }
 
 /******************************************************/
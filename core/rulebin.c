@@ -120,8 +120,6 @@ static void DeallocateDefruleBloadData(
    size_t space;
    long i;
    struct defruleModule *theModuleItem;
-   struct activation *theActivation, *tmpActivation;
-   struct salienceGroup *theGroup, *tmpGroup;
 
    for (i = 0; i < DefruleBinaryData(theEnv)->NumberOfJoins; i++)
      { 
@@ -135,25 +133,7 @@ static void DeallocateDefruleBloadData(
      {
       theModuleItem = &DefruleBinaryData(theEnv)->ModuleArray[i];
       
-      theActivation = theModuleItem->agenda;
-      while (theActivation != NULL)
-        {
-         tmpActivation = theActivation->next;
-         
-         rtn_struct(theEnv,activation,theActivation);
-         
-         theActivation = tmpActivation;
-        }
-
-      theGroup = theModuleItem->groupings;
-      while (theGroup != NULL)
-        {
-         tmpGroup = theGroup->next;
-         
-         rtn_struct(theEnv,salienceGroup,theGroup);
-         
-         theGroup = tmpGroup;
-        }
+      ReturnModuleAgenda(theEnv,theModuleItem);
      }
      
    space = DefruleBinaryData(theEnv)->NumberOfDefruleModules * sizeof(struct defruleModule);
@@ -905,6 +885,9 @@ static void UpdateDefruleModule(
                              (void *) DefruleBinaryData(theEnv)->DefruleArray);
    DefruleBinaryData(theEnv)->ModuleArray[obji].agenda = NULL;
    DefruleBinaryData(theEnv)->ModuleArray[obji].groupings = NULL;
+   DefruleBinaryData(theEnv)->ModuleArray[obji].groupIndex = NULL;
+   DefruleBinaryData(theEnv)->ModuleArray[obji].groupCount = 0;
+   DefruleBinaryData(theEnv)->ModuleArray[obji].groupIndexSize = 0;
 
   }
 
@@ -1116,6 +1116,7 @@ static struct joinNode *CreateNewJoin(
          newJoin->leftMemory->last = NULL;
          newJoin->leftMemory->size = 1;
          newJoin->leftMemory->count = 0;
+         newJoin->leftMemory->arena = NULL;
          }
       else
         {
@@ -1125,6 +1126,7 @@ static struct joinNode *CreateNewJoin(
          newJoin->leftMemory->last = NULL;
          newJoin->leftMemory->size = INITIAL_BETA_HASH_SIZE;
          newJoin->leftMemory->count = 0;
+         newJoin->leftMemory->arena = NULL;
         }
       
       /*===========================================================*/
@@ -1155,6 +1157,7 @@ static struct joinNode *CreateNewJoin(
          newJoin->rightMemory->last[0] = NULL;
          newJoin->rightMemory->size = 1;
          newJoin->rightMemory->count = 0;
+         newJoin->rightMemory->arena = NULL;
          }
       else
         {
@@ -1165,6 +1168,7 @@ static struct joinNode *CreateNewJoin(
          memset(newJoin->rightMemory->last,0,sizeof(struct partialMatch *) * INITIAL_BETA_HASH_SIZE);
          newJoin->rightMemory->size = INITIAL_BETA_HASH_SIZE;
          newJoin->rightMemory->count = 0;
+         newJoin->rightMemory->arena = NULL;
         }     
      }
    else if (rhsEntryStruct == NULL)
@@ -1178,6 +1182,7 @@ static struct joinNode *CreateNewJoin(
       newJoin->rightMemory->last[0] = newJoin->rightMemory->beta[0];
       newJoin->rightMemory->size = 1;
       newJoin->rightMemory->count = 1;    
+      newJoin->rightMemory->arena = NULL;
      }
    else
      { newJoin->rightMemory = NULL; }
@@ -180,7 +180,7 @@ static void ResetDefrules(
          if (notParent->children != NULL)
            { PosEntryRetractBeta(theEnv,notParent,notParent->children,NETWORK_ASSERT); }
            /*
-         if (notParent->dependents != NULL) 
+         if (PMDependents(notParent) != NULL) 
            { RemoveLogicalSupport(theEnv,notParent); } */
         }
      }
@@ -69,6 +69,8 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added show-join-hashes command.                */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
@@ -109,6 +111,9 @@
 
 #if DEVELOPER
    static void                    ShowJoins(Environment *,Defrule *);
+   static int                     GetRuleJoins(Defrule *,struct joinNode **);
+   static void                    ShowJoinHashes(Environment *,Defrule *);
+   static void                    ShowChainLengths(Environment *,const char *,struct betaMemory *);
 #endif
 #if DEBUGGING_FUNCTIONS
    static long long               ListAlphaMatches(Environment *,struct joinInformation *,int);
@@ -161,6 +166,7 @@ void DefruleCommands(
 #if DEVELOPER && (! BLOAD_ONLY)
    EnvAddUDF(theEnv,"rule-complexity","l",1,1,"y",RuleComplexityCommand,"RuleComplexityCommand",NULL);
    EnvAddUDF(theEnv,"show-joins","v",1,1,"y",ShowJoinsCommand,"ShowJoinsCommand",NULL);
+   EnvAddUDF(theEnv,"show-join-hashes","v",1,1,"y",ShowJoinHashesCommand,"ShowJoinHashesCommand",NULL);
    EnvAddUDF(theEnv,"show-aht","v",0,0,NULL,ShowAlphaHashTable,"ShowAlphaHashTable",NULL);
 #if DEBUGGING_FUNCTIONS
    AddWatchItem(theEnv,"rule-analysis",0,&DefruleData(theEnv)->WatchRuleAnalysis,0,NULL,NULL);
@@ -1362,7 +1368,6 @@ static void ShowJoins(
   Defrule *theRule)
   {
    Defrule *rulePtr;
-   struct joinNode *theJoin;
    struct joinNode *joinList[MAXIMUM_NUMBER_OF_PATTERNS];
    int numberOfJoins;
    char rhsType;
@@ -1391,23 +1396,7 @@ static void ShowJoins(
       /* Determine the number of join nodes. */
       /*=====================================*/
 
-      numberOfJoins = -1;
-      theJoin = rulePtr->lastJoin;
-      while (theJoin != NULL)
-        {
-         if (theJoin->joinFromTheRight)
-           {
-            numberOfJoins++;
-            joinList[numberOfJoins] = theJoin;
-            theJoin = (struct joinNode *) theJoin->rightSideEntryStructure;
-           }
-         else
-           {
-            numberOfJoins++;
-            joinList[numberOfJoins] = theJoin;
-            theJoin = theJoin->lastLevel;
-           }
-        }
+      numberOfJoins = GetRuleJoins(rulePtr,joinList);
 
       /*====================*/
       /* Display the joins. */
@@ -1499,6 +1488,170 @@ static void ShowJoins(
      }
   }
 
+/****************************************************************/
+/* GetRuleJoins: Stores the join nodes of a rule in the array   */
+/*   from the last join to the first. Returns the index of the  */
+/*   first join (one less than the number of joins stored).     */
+/****************************************************************/
+static int GetRuleJoins(
+  Defrule *theRule,
+  struct joinNode **joinList)
+  {
+   struct joinNode *theJoin;
+   int numberOfJoins = -1;
+
+   theJoin = theRule->lastJoin;
+   while (theJoin != NULL)
+     {
+      numberOfJoins++;
+      joinList[numberOfJoins] = theJoin;
+
+      if (theJoin->joinFromTheRight)
+        { theJoin = (struct joinNode *) theJoin->rightSideEntryStructure; }
+      else
+        { theJoin = theJoin->lastLevel; }
+     }
+
+   return numberOfJoins;
+  }
+
+/************************************************/
+/* ShowJoinHashesCommand: H/L access routine    */
+/*   for the show-join-hashes command.          */
+/************************************************/
+void ShowJoinHashesCommand(
+  Environment *theEnv,
+  UDFContext *context,
+  CLIPSValue *returnValue)
+  {
+   const char *ruleName;
+   Defrule *rulePtr;
+   
+   ruleName = GetConstructName(context,"show-join-hashes","rule name");
+   if (ruleName == NULL) return;
+
+   rulePtr = EnvFindDefrule(theEnv,ruleName);
+   if (rulePtr == NULL)
+     {
+      CantFindItemErrorMessage(theEnv,"defrule",ruleName);
+      return;
+     }
+
+   ShowJoinHashes(theEnv,rulePtr);
+  }
+
+/***************************************************************/
+/* ShowJoinHashes: Displays the size of each hashed beta       */
+/*   memory of a rule along with a histogram of the lengths of */
+/*   the chains in its buckets. Used to check the distribution */
+/*   of the join hash values.                                  */
+/***************************************************************/
+static void ShowJoinHashes(
+  Environment *theEnv,
+  Defrule *theRule)
+  {
+   Defrule *rulePtr;
+   struct joinNode *joinList[MAXIMUM_NUMBER_OF_PATTERNS];
+   int numberOfJoins;
+   int disjunct = 0;
+   char buffer[20];
+
+   if (theRule->disjunct != NULL)
+     { disjunct = 1; }
+     
+   for (rulePtr = theRule; rulePtr != NULL; rulePtr = rulePtr->disjunct)
+     {
+      if (disjunct > 0)
+        {
+         EnvPrintRouter(theEnv,WDISPLAY,"Disjunct #");
+         PrintLongInteger(theEnv, WDISPLAY, (long long) disjunct++);
+         EnvPrintRouter(theEnv,WDISPLAY,"\n");
+        }
+
+      for (numberOfJoins = GetRuleJoins(rulePtr,joinList);
+           numberOfJoins >= 0;
+           numberOfJoins--)
+        {
+         gensprintf(buffer,"%2d : ",(int) joinList[numberOfJoins]->depth);
+         EnvPrintRouter(theEnv,WDISPLAY,buffer);
+         PrintExpression(theEnv,WDISPLAY,joinList[numberOfJoins]->networkTest);
+         EnvPrintRouter(theEnv,WDISPLAY,"\n");
+
+         if (! joinList[numberOfJoins]->firstJoin)
+           { ShowChainLengths(theEnv,"LM",joinList[numberOfJoins]->leftMemory); }
+
+         if (joinList[numberOfJoins]->joinFromTheRight)
+           { ShowChainLengths(theEnv,"RM",joinList[numberOfJoins]->rightMemory); }
+        }
+     }
+  }
+
+/****************************************************************/
+/* ShowChainLengths: Displays the number of buckets and partial */
+/*   matches in a beta memory followed by the number of buckets */
+/*   holding chains of each length. Chains longer than the last */
+/*   entry of the histogram are counted with that entry.        */
+/****************************************************************/
+static void ShowChainLengths(
+  Environment *theEnv,
+  const char *memoryName,
+  struct betaMemory *theMemory)
+  {
+   unsigned long histogram[CHAIN_HISTOGRAM_SIZE];
+   unsigned long b, length, longest = 0;
+   struct partialMatch *theMatch;
+   int i;
+   char buffer[60];
+
+   EnvPrintRouter(theEnv,WDISPLAY,"    ");
+   EnvPrintRouter(theEnv,WDISPLAY,memoryName);
+   EnvPrintRouter(theEnv,WDISPLAY," : ");
+
+   if (theMemory == NULL)
+     {
+      EnvPrintRouter(theEnv,WDISPLAY,"None\n");
+      return;
+     }
+
+   for (i = 0; i < CHAIN_HISTOGRAM_SIZE; i++)
+     { histogram[i] = 0; }
+
+   for (b = 0; b < theMemory->size; b++)
+     {
+      length = 0;
+      for (theMatch = theMemory->beta[b];
+           theMatch != NULL;
+           theMatch = theMatch->nextInMemory)
+        { length++; }
+
+      if (length > longest)
+        { longest = length; }
+
+      if (length >= CHAIN_HISTOGRAM_SIZE)
+        { histogram[CHAIN_HISTOGRAM_SIZE - 1]++; }
+      else
+        { histogram[length]++; }
+     }
+
+   gensprintf(buffer,"%lu buckets, %lu matches, longest %lu\n",
+              theMemory->size,theMemory->count,longest);
+   EnvPrintRouter(theEnv,WDISPLAY,buffer);
+
+   if (theMemory->size == 1)
+     { return; }
+
+   EnvPrintRouter(theEnv,WDISPLAY,"        ");
+   for (i = 0; i < CHAIN_HISTOGRAM_SIZE; i++)
+     {
+      if (histogram[i] == 0)
+        { continue; }
+
+      gensprintf(buffer,"%d%s:%lu ",i,(i == (CHAIN_HISTOGRAM_SIZE - 1)) ? "+" : "",histogram[i]);
+      EnvPrintRouter(theEnv,WDISPLAY,buffer);
+     }
+   EnvPrintRouter(theEnv,WDISPLAY,"\n");
+  }
+
 /******************************************************/
 /* ShowAlphaHashTable: Displays the number of entries */
 /*   in each slot of the alpha hash table.            */
@@ -60,6 +60,8 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added show-join-hashes command.                */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_rulecom
@@ -85,6 +87,8 @@ struct joinInformation
 #define SUCCINCT 1
 #define TERSE    2
 
+#define CHAIN_HISTOGRAM_SIZE 8
+
    bool                           EnvGetBetaMemoryResizing(Environment *);
    bool                           EnvSetBetaMemoryResizing(Environment *,bool);
    void                           GetBetaMemoryResizingCommand(Environment *,UDFContext *,CLIPSValue *);
@@ -104,6 +108,7 @@ struct joinInformation
    void                           JoinActivityResetCommand(Environment *,UDFContext *,CLIPSValue *);
 #if DEVELOPER
    void                           ShowJoinsCommand(Environment *,UDFContext *,CLIPSValue *);
+   void                           ShowJoinHashesCommand(Environment *,UDFContext *,CLIPSValue *);
    void                           RuleComplexityCommand(Environment *,UDFContext *,CLIPSValue *);
    void                           ShowAlphaHashTable(Environment *,UDFContext *,CLIPSValue *);
 #endif
@@ -167,8 +167,6 @@ static void DeallocateDefruleData(
   {
    struct defruleModule *theModuleItem;
    Defmodule *theModule;
-   Activation *theActivation, *tmpActivation;
-   struct salienceGroup *theGroup, *tmpGroup;
 
 #if BLOAD || BLOAD_AND_BSAVE
    if (Bloaded(theEnv))
@@ -186,25 +184,7 @@ static void DeallocateDefruleData(
                       GetModuleItem(theEnv,theModule,
                                     DefruleData(theEnv)->DefruleModuleIndex);
                                     
-      theActivation = theModuleItem->agenda;
-      while (theActivation != NULL)
-        {
-         tmpActivation = theActivation->next;
-         
-         rtn_struct(theEnv,activation,theActivation);
-         
-         theActivation = tmpActivation;
-        }
-        
-      theGroup = theModuleItem->groupings;
-      while (theGroup != NULL)
-        {
-         tmpGroup = theGroup->next;
-         
-         rtn_struct(theEnv,salienceGroup,theGroup);
-         
-         theGroup = tmpGroup;
-        }        
+      ReturnModuleAgenda(theEnv,theModuleItem);
 
 #if ! RUN_TIME                                    
       rtn_struct(theEnv,defruleModule,theModuleItem);
@@ -265,6 +245,9 @@ static void *AllocateModule(
    theItem = get_struct(theEnv,defruleModule);
    theItem->agenda = NULL;
    theItem->groupings = NULL;
+   theItem->groupIndex = NULL;
+   theItem->groupCount = 0;
+   theItem->groupIndexSize = 0;
    return((void *) theItem);
   }
 
@@ -276,6 +259,7 @@ static void ReturnModule(
   void *theItem)
   {
    FreeConstructHeaderModule(theEnv,(struct defmoduleItemHeader *) theItem,DefruleData(theEnv)->DefruleConstruct);
+   ReturnModuleAgenda(theEnv,(struct defruleModule *) theItem);
    rtn_struct(theEnv,defruleModule,theItem);
   }
 
@@ -466,6 +450,7 @@ void AddBetaMemoriesToJoin(
          theNode->leftMemory->beta[0] = NULL;
          theNode->leftMemory->size = 1;
          theNode->leftMemory->count = 0;
+         theNode->leftMemory->arena = NULL;
          theNode->leftMemory->last = NULL;
         }
       else
@@ -475,6 +460,7 @@ void AddBetaMemoriesToJoin(
          memset(theNode->leftMemory->beta,0,sizeof(struct partialMatch *) * INITIAL_BETA_HASH_SIZE);
          theNode->leftMemory->size = INITIAL_BETA_HASH_SIZE;
          theNode->leftMemory->count = 0;
+         theNode->leftMemory->arena = NULL;
          theNode->leftMemory->last = NULL;
         }
 
@@ -498,6 +484,7 @@ void AddBetaMemoriesToJoin(
          theNode->rightMemory->last[0] = NULL;
          theNode->rightMemory->size = 1;
          theNode->rightMemory->count = 0;
+         theNode->rightMemory->arena = NULL;
         }
       else
         {
@@ -508,6 +495,7 @@ void AddBetaMemoriesToJoin(
          memset(theNode->rightMemory->last,0,sizeof(struct partialMatch **) * INITIAL_BETA_HASH_SIZE);
          theNode->rightMemory->size = INITIAL_BETA_HASH_SIZE;
          theNode->rightMemory->count = 0;
+         theNode->rightMemory->arena = NULL;
         }
      }
    else if (theNode->rightSideEntryStructure == NULL)
@@ -521,6 +509,7 @@ void AddBetaMemoriesToJoin(
       theNode->rightMemory->last[0] = theNode->rightMemory->beta[0];
       theNode->rightMemory->size = 1;
       theNode->rightMemory->count = 1;    
+      theNode->rightMemory->arena = NULL;
      }
    else
      { theNode->rightMemory = NULL; }
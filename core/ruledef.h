@@ -115,6 +115,9 @@ struct defruleModule
    struct defmoduleItemHeader header;
    struct salienceGroup *groupings;
    struct activation *agenda;
+   struct salienceGroup **groupIndex;
+   unsigned int groupCount;
+   unsigned int groupIndexSize;
   };
 
 #ifndef ALPHA_MEMORY_HASH_SIZE
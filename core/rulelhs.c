@@ -32,6 +32,8 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Added the slot-sensitive rule property.        */
+/*                                                           */
 /*************************************************************/
 
 #include "setup.h"
@@ -75,6 +77,7 @@
    static struct lhsParseNode    *SimplePatternParse(Environment *,const char *,struct token *,bool *);
    static void                    ParseSalience(Environment *,const char *,const char *,bool *);
    static void                    ParseAutoFocus(Environment *,const char *,bool *);
+   static void                    ParseSlotSensitive(Environment *,const char *,bool *);
 
 /*******************************************************************/
 /* ParseRuleLHS: Coordinates all the actions necessary for parsing */
@@ -99,6 +102,7 @@ struct lhsParseNode *ParseRuleLHS(
 
    PatternData(theEnv)->GlobalSalience = 0;
    PatternData(theEnv)->GlobalAutoFocus = false;
+   PatternData(theEnv)->GlobalSlotSensitive = false;
    PatternData(theEnv)->SalienceExpression = NULL;
 
    /*============================*/
@@ -214,6 +218,7 @@ static struct lhsParseNode *RuleBodyParse(
 /*                                                      */
 /* <rule-property> ::= (salience <integer-expression>)  */
 /* <rule-property> ::= (auto-focus TRUE | FALSE)        */
+/* <rule-property> ::= (slot-sensitive TRUE | FALSE)    */
 /********************************************************/
 static void DeclarationParse(
   Environment *theEnv,
@@ -225,6 +230,7 @@ static void DeclarationParse(
    struct expr *packPtr;
    bool notDone = true;
    bool salienceParsed = false, autoFocusParsed = false;
+   bool slotSensitiveParsed = false;
 
    /*===========================*/
    /* Next token must be a '('. */
@@ -296,6 +302,27 @@ static void DeclarationParse(
            }
         }
 
+      /*=====================================================*/
+      /* Parse a slot-sensitive declaration if encountered.  */
+      /* A global flag is used to indicate if the patterns   */
+      /* of a rule are only rematched by a modify when slots */
+      /* referenced by the patterns are changed.             */
+      /*=====================================================*/
+
+      else if (strcmp(ValueToString(theToken.value),"slot-sensitive") == 0)
+        {
+         if (slotSensitiveParsed)
+           {
+            AlreadyParsedErrorMessage(theEnv,"slot-sensitive declaration",NULL);
+            *error = true;
+           }
+         else
+           {
+            ParseSlotSensitive(theEnv,readSource,error);
+            slotSensitiveParsed = true;
+           }
+        }
+
       /*==========================================*/
       /* Otherwise the symbol does not correspond */
       /* to a valid rule property.                */
@@ -318,10 +345,9 @@ static void DeclarationParse(
          return;
         }
 
-      /*=======================================*/
-      /* Both the salience and auto-focus rule */
-      /* properties are closed with a ')'.     */
-      /*=======================================*/
+      /*==========================================*/
+      /* Each rule property is closed with a ')'. */
+      /*==========================================*/
 
       GetToken(theEnv,readSource,&theToken);
       if (theToken.type != RPAREN)
@@ -482,6 +508,49 @@ static void ParseAutoFocus(
      }
   }
 
+/**********************************************************/
+/* ParseSlotSensitive: Parses the rest of a defrule       */
+/*   slot-sensitive declaration once the slot-sensitive   */
+/*   keyword has been parsed.                             */
+/**********************************************************/
+static void ParseSlotSensitive(
+  Environment *theEnv,
+  const char *readSource,
+  bool *error)
+  {
+   struct token theToken;
+
+   /*============================================*/
+   /* The slot-sensitive value must be a symbol. */
+   /*============================================*/
+
+   SavePPBuffer(theEnv," ");
+
+   GetToken(theEnv,readSource,&theToken);
+   if (theToken.type != SYMBOL)
+     {
+      SyntaxErrorMessage(theEnv,"slot-sensitive statement");
+      *error = true;
+      return;
+     }
+
+   /*========================================================*/
+   /* The slot-sensitive value must be either TRUE or FALSE. */
+   /* If a valid value is parsed, then set the value of the  */
+   /* global variable GlobalSlotSensitive.                   */
+   /*========================================================*/
+
+   if (strcmp(ValueToString(theToken.value),"TRUE") == 0)
+     { PatternData(theEnv)->GlobalSlotSensitive = true; }
+   else if (strcmp(ValueToString(theToken.value),"FALSE") == 0)
+     { PatternData(theEnv)->GlobalSlotSensitive = false; }
+   else
+     {
+      SyntaxErrorMessage(theEnv,"slot-sensitive statement");
+      *error = true;
+     }
+  }
+
 /*****************************************************************/
 /* LHSPattern: Parses a single conditional element found on the  */
 /*   LHS of a rule. Conditonal element types include pattern CEs */
@@ -68,6 +68,12 @@
 /*      6.50: The eval function can now access any local     */
 /*            variables that have been defined.              */
 /*                                                           */
+/*            String functions use the length kept in the    */
+/*            symbol table entry instead of strlen.          */
+/*                                                           */
+/*            The str-cat and sym-cat functions hand their   */
+/*            result buffer over to the symbol table.        */
+/*                                                           */
 /*************************************************************/
 
 #include "setup.h"
@@ -92,6 +98,7 @@
 #include "strngrtr.h"
 #include "scanner.h"
 #include "sysdep.h"
+#include "utility.h"
 
 #if DEFRULE_CONSTRUCT
 #include "drive.h"
@@ -165,8 +172,8 @@ static void StrOrSymCatFunction(
   unsigned short returnType)
   {
    CLIPSValue theArg;
-   int numArgs, i, total, j;
-   char *theString;
+   int numArgs, i, total;
+   StringBuilder *theSB;
    SYMBOL_HN **arrayOfStrings;
    SYMBOL_HN *hashPtr;
    Environment *theEnv = context->environment;
@@ -242,23 +249,19 @@ static void StrOrSymCatFunction(
          return;
         }
 
-      total += (int) strlen(ValueToString(arrayOfStrings[i - 1]));
+      total += (int) arrayOfStrings[i - 1]->length;
      }
 
-   /*=========================================================*/
-   /* Allocate the memory to store the concatenated string or */
-   /* symbol, then copy the values in the string array to the */
-   /* memory just allocated.                                  */
-   /*=========================================================*/
+   /*======================================================*/
+   /* Build the concatenated string or symbol in a buffer  */
+   /* of exactly the right size so that the buffer can be  */
+   /* handed over to the symbol table rather than copied.  */
+   /*======================================================*/
 
-   theString = (char *) gm2(theEnv,(sizeof(char) * total));
+   theSB = CreateStringBuilder(theEnv,(size_t) (total - 1));
 
-   j = 0;
    for (i = 0 ; i < numArgs ; i++)
-     {
-      gensprintf(&theString[j],"%s",ValueToString(arrayOfStrings[i]));
-      j += (int) strlen(ValueToString(arrayOfStrings[i]));
-     }
+     { SBAppendN(theSB,ValueToString(arrayOfStrings[i]),arrayOfStrings[i]->length); }
 
    /*=========================================*/
    /* Return the concatenated value and clean */
@@ -266,8 +269,8 @@ static void StrOrSymCatFunction(
    /*=========================================*/
 
    SetpType(returnValue,returnType);
-   SetpValue(returnValue,EnvAddSymbol(theEnv,theString));
-   rm(theEnv,theString,sizeof(char) * total);
+   SetpValue(returnValue,SBAddSymbol(theSB));
+   SBDispose(theSB);
 
    for (i = 0; i < numArgs; i++)
      {
@@ -332,7 +335,7 @@ void UpcaseFunction(
    /*======================================================*/
 
    osptr = mCVToString(&theArg);
-   slen = strlen(osptr) + 1;
+   slen = ((SYMBOL_HN *) theArg.value)->length + 1;
    nsptr = (char *) gm2(theEnv,slen);
 
    for (i = 0  ; i < slen ; i++)
@@ -383,7 +386,7 @@ void LowcaseFunction(
    /*======================================================*/
 
    osptr = mCVToString(&theArg);
-   slen = strlen(osptr) + 1;
+   slen = ((SYMBOL_HN *) theArg.value)->length + 1;
    nsptr = (char *) gm2(theEnv,slen);
 
    for (i = 0  ; i < slen ; i++)
@@ -437,9 +440,16 @@ void StrCompareFunction(
       if (! UDFNextArgument(context,INTEGER_TYPE,&arg3))
         { return; }
 
-      compareResult = strncmp(mCVToString(&arg1),mCVToString(&arg2),
-                            (STD_SIZE) mCVToInteger(&arg3));
+      if (arg1.value == arg2.value)
+        { compareResult = 0; }
+      else
+        {
+         compareResult = strncmp(mCVToString(&arg1),mCVToString(&arg2),
+                               (STD_SIZE) mCVToInteger(&arg3));
+        }
      }
+   else if (arg1.value == arg2.value)
+     { compareResult = 0; }
    else
      { compareResult = strcmp(mCVToString(&arg1),mCVToString(&arg2)); }
 
@@ -578,7 +588,7 @@ void StrIndexFunction(
    /* string1 (counting from 1).      */
    /*=================================*/
 
-   if (strlen(strg1) == 0)
+   if (((SYMBOL_HN *) theArg1.value)->length == 0)
      {
       mCVSetInteger(returnValue,(long long) UTF8Length(strg2) + 1LL);
       return;
@@ -93,7 +93,7 @@ void InitAtomicValueNeededFlags(
 
    symbolArray = GetSymbolTable(theEnv);
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < GetSymbolTableSize(theEnv); i++)
      {
       symbolPtr = symbolArray[i];
       while (symbolPtr != NULL)
@@ -109,7 +109,7 @@ void InitAtomicValueNeededFlags(
 
    floatArray = GetFloatTable(theEnv);
 
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < GetFloatTableSize(theEnv); i++)
      {
       floatPtr = floatArray[i];
       while (floatPtr != NULL)
@@ -125,7 +125,7 @@ void InitAtomicValueNeededFlags(
 
    integerArray = GetIntegerTable(theEnv);
 
-   for (i = 0; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < GetIntegerTableSize(theEnv); i++)
      {
       integerPtr = integerArray[i];
       while (integerPtr != NULL)
@@ -141,7 +141,7 @@ void InitAtomicValueNeededFlags(
 
    bitMapArray = GetBitMapTable(theEnv);
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < GetBitMapTableSize(theEnv); i++)
      {
       bitMapPtr = bitMapArray[i];
       while (bitMapPtr != NULL)
@@ -177,7 +177,7 @@ void WriteNeededSymbols(
    /* Get the number of symbols and the total string size. */
    /*======================================================*/
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < GetSymbolTableSize(theEnv); i++)
      {
       for (symbolPtr = symbolArray[i];
            symbolPtr != NULL;
@@ -198,7 +198,7 @@ void WriteNeededSymbols(
    GenWrite(&numberOfUsedSymbols,(unsigned long) sizeof(unsigned long int),fp);
    GenWrite(&size,(unsigned long) sizeof(unsigned long int),fp);
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < GetSymbolTableSize(theEnv); i++)
      {
       for (symbolPtr = symbolArray[i];
            symbolPtr != NULL;
@@ -236,7 +236,7 @@ void WriteNeededFloats(
    /* Get the number of floats. */
    /*===========================*/
 
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < GetFloatTableSize(theEnv); i++)
      {
       for (floatPtr = floatArray[i];
            floatPtr != NULL;
@@ -250,7 +250,7 @@ void WriteNeededFloats(
 
    GenWrite(&numberOfUsedFloats,(unsigned long) sizeof(unsigned long int),fp);
 
-   for (i = 0 ; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < GetFloatTableSize(theEnv); i++)
      {
       for (floatPtr = floatArray[i];
            floatPtr != NULL;
@@ -286,7 +286,7 @@ void WriteNeededIntegers(
    /* Get the number of integers. */
    /*=============================*/
 
-   for (i = 0 ; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < GetIntegerTableSize(theEnv); i++)
      {
       for (integerPtr = integerArray[i];
            integerPtr != NULL;
@@ -302,7 +302,7 @@ void WriteNeededIntegers(
 
    GenWrite(&numberOfUsedIntegers,(unsigned long) sizeof(unsigned long int),fp);
 
-   for (i = 0 ; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < GetIntegerTableSize(theEnv); i++)
      {
       for (integerPtr = integerArray[i];
            integerPtr != NULL;
@@ -341,7 +341,7 @@ static void WriteNeededBitMaps(
    /* Get the number of bitmaps and the total bitmap size. */
    /*======================================================*/
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < GetBitMapTableSize(theEnv); i++)
      {
       for (bitMapPtr = bitMapArray[i];
            bitMapPtr != NULL;
@@ -362,7 +362,7 @@ static void WriteNeededBitMaps(
    GenWrite(&numberOfUsedBitMaps,(unsigned long) sizeof(unsigned long int),fp);
    GenWrite(&size,(unsigned long) sizeof(unsigned long int),fp);
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < GetBitMapTableSize(theEnv); i++)
      {
       for (bitMapPtr = bitMapArray[i];
            bitMapPtr != NULL;
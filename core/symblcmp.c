@@ -39,6 +39,9 @@
 /*            Removed use of void pointers for specific      */
 /*            data structures.                               */
 /*                                                           */
+/*            Symbol entries include their length and hash   */
+/*            value.                                         */
+/*                                                           */
 /*************************************************************/
 
 #include "setup.h"
@@ -127,7 +130,7 @@ static int SymbolHashNodesToCode(
    symbolTable = GetSymbolTable(theEnv);
    count = numberOfEntries = 0;
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < GetSymbolTableSize(theEnv); i++)
      {
       for (hashPtr = symbolTable[i];
            hashPtr != NULL;
@@ -152,7 +155,7 @@ static int SymbolHashNodesToCode(
 
    j = 0;
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < GetSymbolTableSize(theEnv); i++)
      {
       for (hashPtr = symbolTable[i];
            hashPtr != NULL;
@@ -174,8 +177,9 @@ static int SymbolHashNodesToCode(
               { fprintf(fp,"{&S%d_%d[%ld],",ConstructCompilerData(theEnv)->ImageID,arrayVersion,j + 1); }
            }
 
-         fprintf(fp,"%ld,1,0,0,%ld,",hashPtr->count + 1,i);
+         fprintf(fp,"%ld,1,0,0,%lu,",hashPtr->count + 1,hashPtr->hashValue & ATOM_HASH_MASK);
          PrintCString(fp,hashPtr->contents);
+         fprintf(fp,",%lu,%luUL",(unsigned long) hashPtr->length,hashPtr->hashValue);
 
          count++;
          j++;
@@ -231,7 +235,7 @@ static int BitMapHashNodesToCode(
    bitMapTable = GetBitMapTable(theEnv);
    count = numberOfEntries = 0;
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < GetBitMapTableSize(theEnv); i++)
      {
       for (hashPtr = bitMapTable[i];
            hashPtr != NULL;
@@ -256,7 +260,7 @@ static int BitMapHashNodesToCode(
 
    j = 0;
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < GetBitMapTableSize(theEnv); i++)
      {
       for (hashPtr = bitMapTable[i];
            hashPtr != NULL;
@@ -278,8 +282,8 @@ static int BitMapHashNodesToCode(
               { fprintf(fp,"{&B%d_%d[%d],",ConstructCompilerData(theEnv)->ImageID,arrayVersion,j + 1); }
            }
 
-         fprintf(fp,"%ld,1,0,0,%d,(char *) &L%d_%d[%d],%d",
-                     hashPtr->count + 1,i,
+         fprintf(fp,"%ld,1,0,0,%lu,(char *) &L%d_%d[%d],%d",
+                     hashPtr->count + 1,HashBitMap(hashPtr->contents,0,hashPtr->size) & ATOM_HASH_MASK,
                      ConstructCompilerData(theEnv)->ImageID,longsReqdPartition,longsReqdPartitionCount,
                      hashPtr->size);
 
@@ -348,7 +352,7 @@ static int BitMapValuesToCode(
    bitMapTable = GetBitMapTable(theEnv);
    count = numberOfEntries = 0;
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < GetBitMapTableSize(theEnv); i++)
      {
       for (hashPtr = bitMapTable[i];
            hashPtr != NULL;
@@ -377,7 +381,7 @@ static int BitMapValuesToCode(
 
    j = 0;
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < GetBitMapTableSize(theEnv); i++)
      {
       for (hashPtr = bitMapTable[i];
            hashPtr != NULL;
@@ -459,7 +463,7 @@ static int FloatHashNodesToCode(
    floatTable = GetFloatTable(theEnv);
    count = numberOfEntries = 0;
 
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < GetFloatTableSize(theEnv); i++)
      {
       for (hashPtr = floatTable[i];
            hashPtr != NULL;
@@ -484,7 +488,7 @@ static int FloatHashNodesToCode(
 
    j = 0;
 
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < GetFloatTableSize(theEnv); i++)
      {
       for (hashPtr = floatTable[i];
            hashPtr != NULL;
@@ -506,7 +510,7 @@ static int FloatHashNodesToCode(
               { fprintf(fp,"{&F%d_%d[%d],",ConstructCompilerData(theEnv)->ImageID,arrayVersion,j + 1); }
            }
 
-         fprintf(fp,"%ld,1,0,0,%d,",hashPtr->count + 1,i);
+         fprintf(fp,"%ld,1,0,0,%lu,",hashPtr->count + 1,HashFloat(hashPtr->contents,0) & ATOM_HASH_MASK);
          fprintf(fp,"%s",FloatToString(theEnv,hashPtr->contents));
 
          count++;
@@ -562,7 +566,7 @@ static int IntegerHashNodesToCode(
    integerTable = GetIntegerTable(theEnv);
    count = numberOfEntries = 0;
 
-   for (i = 0; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < GetIntegerTableSize(theEnv); i++)
      {
       for (hashPtr = integerTable[i];
            hashPtr != NULL;
@@ -587,7 +591,7 @@ static int IntegerHashNodesToCode(
 
    j = 0;
 
-   for (i = 0; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < GetIntegerTableSize(theEnv); i++)
      {
       for (hashPtr = integerTable[i];
            hashPtr != NULL;
@@ -609,7 +613,7 @@ static int IntegerHashNodesToCode(
               { fprintf(fp,"{&I%d_%d[%d],",ConstructCompilerData(theEnv)->ImageID,arrayVersion,j + 1); }
            }
 
-         fprintf(fp,"%ld,1,0,0,%d,",hashPtr->count + 1,i);
+         fprintf(fp,"%ld,1,0,0,%lu,",hashPtr->count + 1,HashInteger(hashPtr->contents,0) & ATOM_HASH_MASK);
          fprintf(fp,"%lldLL",hashPtr->contents);
 
          count++;
@@ -665,13 +669,13 @@ static int HashTablesToCode(
      { return 0; }
 
    fprintf(ConstructCompilerData(theEnv)->HeaderFP,"extern struct symbolHashNode *sht%d[];\n",ConstructCompilerData(theEnv)->ImageID);
-   fprintf(fp,"struct symbolHashNode *sht%d[%ld] = {\n",ConstructCompilerData(theEnv)->ImageID,SYMBOL_HASH_SIZE);
+   fprintf(fp,"struct symbolHashNode *sht%d[%lu] = {\n",ConstructCompilerData(theEnv)->ImageID,GetSymbolTableSize(theEnv));
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < GetSymbolTableSize(theEnv); i++)
       {
        PrintSymbolReference(theEnv,fp,symbolTable[i]);
 
-       if (i + 1 != SYMBOL_HASH_SIZE) fprintf(fp,",\n");
+       if (i + 1 != GetSymbolTableSize(theEnv)) fprintf(fp,",\n");
       }
 
     fprintf(fp,"};\n");
@@ -688,14 +692,14 @@ static int HashTablesToCode(
      { return 0; }
 
    fprintf(ConstructCompilerData(theEnv)->HeaderFP,"extern struct floatHashNode *fht%d[];\n",ConstructCompilerData(theEnv)->ImageID);
-   fprintf(fp,"struct floatHashNode *fht%d[%d] = {\n",ConstructCompilerData(theEnv)->ImageID,FLOAT_HASH_SIZE);
+   fprintf(fp,"struct floatHashNode *fht%d[%lu] = {\n",ConstructCompilerData(theEnv)->ImageID,GetFloatTableSize(theEnv));
 
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < GetFloatTableSize(theEnv); i++)
       {
        if (floatTable[i] == NULL) { fprintf(fp,"NULL"); }
        else PrintFloatReference(theEnv,fp,floatTable[i]);
 
-       if (i + 1 != FLOAT_HASH_SIZE) fprintf(fp,",\n");
+       if (i + 1 != GetFloatTableSize(theEnv)) fprintf(fp,",\n");
       }
 
     fprintf(fp,"};\n");
@@ -712,14 +716,14 @@ static int HashTablesToCode(
      { return 0; }
 
    fprintf(ConstructCompilerData(theEnv)->HeaderFP,"extern struct integerHashNode *iht%d[];\n",ConstructCompilerData(theEnv)->ImageID);
-   fprintf(fp,"struct integerHashNode *iht%d[%d] = {\n",ConstructCompilerData(theEnv)->ImageID,INTEGER_HASH_SIZE);
+   fprintf(fp,"struct integerHashNode *iht%d[%lu] = {\n",ConstructCompilerData(theEnv)->ImageID,GetIntegerTableSize(theEnv));
 
-   for (i = 0; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < GetIntegerTableSize(theEnv); i++)
       {
        if (integerTable[i] == NULL) { fprintf(fp,"NULL"); }
        else PrintIntegerReference(theEnv,fp,integerTable[i]);
 
-       if (i + 1 != INTEGER_HASH_SIZE) fprintf(fp,",\n");
+       if (i + 1 != GetIntegerTableSize(theEnv)) fprintf(fp,",\n");
       }
 
     fprintf(fp,"};\n");
@@ -736,13 +740,13 @@ static int HashTablesToCode(
      { return 0; }
 
    fprintf(ConstructCompilerData(theEnv)->HeaderFP,"extern struct bitMapHashNode *bmht%d[];\n",ConstructCompilerData(theEnv)->ImageID);
-   fprintf(fp,"struct bitMapHashNode *bmht%d[%d] = {\n",ConstructCompilerData(theEnv)->ImageID,BITMAP_HASH_SIZE);
+   fprintf(fp,"struct bitMapHashNode *bmht%d[%lu] = {\n",ConstructCompilerData(theEnv)->ImageID,GetBitMapTableSize(theEnv));
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < GetBitMapTableSize(theEnv); i++)
       {
        PrintBitMapReference(theEnv,fp,bitMapTable[i]);
 
-       if (i + 1 != BITMAP_HASH_SIZE) fprintf(fp,",\n");
+       if (i + 1 != GetBitMapTableSize(theEnv)) fprintf(fp,",\n");
       }
 
     fprintf(fp,"};\n");
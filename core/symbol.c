@@ -68,6 +68,16 @@
 /*                                                           */
 /*            ALLOW_ENVIRONMENT_GLOBALS no longer supported. */
 /*                                                           */
+/*            Atomic value hash tables grow and shrink based */
+/*            on their load using incremental rehashing.     */
+/*                                                           */
+/*            Symbols hold their length in bytes and their   */
+/*            unreduced hash value. Symbol table lookups     */
+/*            compare the hash values before the strings.    */
+/*                                                           */
+/*            Added EnvAddSymbolBuffer which can take over   */
+/*            the caller's buffer for a new symbol.          */
+/*                                                           */
 /*************************************************************/
 
 #include <stdio.h>
@@ -104,15 +114,26 @@
 /* LOCAL INTERNAL FUNCTION DEFINITIONS */
 /***************************************/
 
-   static void                    RemoveHashNode(Environment *,GENERIC_HN *,GENERIC_HN **,int,int);
+   static SYMBOL_HN              *AddSymbolEntry(Environment *,const char *,char **,size_t);
+   static void                    RemoveHashNode(Environment *,GENERIC_HN *,GENERIC_HN ***,struct atomTableState *,int,int);
    static void                    AddEphemeralHashNode(Environment *,GENERIC_HN *,struct ephemeron **,
                                                        int,int,bool);
    static void                    RemoveEphemeralHashNodes(Environment *,struct ephemeron **,
-                                                           GENERIC_HN **,
+                                                           GENERIC_HN ***,struct atomTableState *,
                                                            int,int,int);
    static const char             *StringWithinString(const char *,const char *);
    static size_t                  CommonPrefixLength(const char *,const char *);
    static void                    DeallocateSymbolData(Environment *);
+   static void                    InitializeAtomTableState(struct atomTableState *,unsigned long);
+   static GENERIC_HN            **AtomTableBucket(GENERIC_HN **,struct atomTableState *,unsigned long);
+   static void                    AtomTableEntryAdded(Environment *,GENERIC_HN ***,struct atomTableState *);
+   static void                    AtomTableEntryRemoved(Environment *,GENERIC_HN ***,struct atomTableState *);
+   static void                    StartAtomTableResize(Environment *,GENERIC_HN ***,struct atomTableState *,unsigned long);
+   static void                    StepAtomTableResize(Environment *,struct atomTableState *,GENERIC_HN **,unsigned long);
+   static void                    FinishAtomTableResize(Environment *,GENERIC_HN **,struct atomTableState *);
+   static GENERIC_HN            **AllocateAtomTable(Environment *,unsigned long);
+   static void                    FreeAtomTable(Environment *,GENERIC_HN **,unsigned long);
+   static void                    DeallocateAtomTableEntries(Environment *,GENERIC_HN **,unsigned long,int);
 
 /*******************************************************/
 /* InitializeAtomTables: Initializes the SymbolTable,  */
@@ -122,20 +143,27 @@
 void InitializeAtomTables(
   Environment *theEnv,
   struct symbolHashNode **symbolTable,
+  unsigned long symbolTableSize,
   struct floatHashNode **floatTable,
+  unsigned long floatTableSize,
   struct integerHashNode **integerTable,
+  unsigned long integerTableSize,
   struct bitMapHashNode **bitmapTable,
+  unsigned long bitmapTableSize,
   struct externalAddressHashNode **externalAddressTable)
   {
 #if MAC_XCD
 #pragma unused(symbolTable)
+#pragma unused(symbolTableSize)
 #pragma unused(floatTable)
+#pragma unused(floatTableSize)
 #pragma unused(integerTable)
+#pragma unused(integerTableSize)
 #pragma unused(bitmapTable)
+#pragma unused(bitmapTableSize)
 #pragma unused(externalAddressTable)
 #endif
-   unsigned long i;
-   
+
    AllocateEnvironmentData(theEnv,SYMBOL_DATA,sizeof(struct symbolData),DeallocateSymbolData);
 
 #if ! RUN_TIME
@@ -143,30 +171,17 @@ void InitializeAtomTables(
    /* Create the hash tables. */
    /*=========================*/
 
-   SymbolData(theEnv)->SymbolTable = (SYMBOL_HN **)
-                  gm3(theEnv,sizeof (SYMBOL_HN *) * SYMBOL_HASH_SIZE);
-
-   SymbolData(theEnv)->FloatTable = (FLOAT_HN **)
-                  gm2(theEnv,(int) sizeof (FLOAT_HN *) * FLOAT_HASH_SIZE);
-
-   SymbolData(theEnv)->IntegerTable = (INTEGER_HN **)
-                   gm2(theEnv,(int) sizeof (INTEGER_HN *) * INTEGER_HASH_SIZE);
+   InitializeAtomTableState(&SymbolData(theEnv)->SymbolTableState,SYMBOL_HASH_SIZE);
+   InitializeAtomTableState(&SymbolData(theEnv)->FloatTableState,FLOAT_HASH_SIZE);
+   InitializeAtomTableState(&SymbolData(theEnv)->IntegerTableState,INTEGER_HASH_SIZE);
+   InitializeAtomTableState(&SymbolData(theEnv)->BitMapTableState,BITMAP_HASH_SIZE);
+   InitializeAtomTableState(&SymbolData(theEnv)->ExternalAddressTableState,EXTERNAL_ADDRESS_HASH_SIZE);
 
-   SymbolData(theEnv)->BitMapTable = (BITMAP_HN **)
-                   gm2(theEnv,(int) sizeof (BITMAP_HN *) * BITMAP_HASH_SIZE);
-
-   SymbolData(theEnv)->ExternalAddressTable = (EXTERNAL_ADDRESS_HN **)
-                   gm2(theEnv,(int) sizeof (EXTERNAL_ADDRESS_HN *) * EXTERNAL_ADDRESS_HASH_SIZE);
-
-   /*===================================================*/
-   /* Initialize all of the hash table entries to NULL. */
-   /*===================================================*/
-
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++) SymbolData(theEnv)->SymbolTable[i] = NULL;
-   for (i = 0; i < FLOAT_HASH_SIZE; i++) SymbolData(theEnv)->FloatTable[i] = NULL;
-   for (i = 0; i < INTEGER_HASH_SIZE; i++) SymbolData(theEnv)->IntegerTable[i] = NULL;
-   for (i = 0; i < BITMAP_HASH_SIZE; i++) SymbolData(theEnv)->BitMapTable[i] = NULL;
-   for (i = 0; i < EXTERNAL_ADDRESS_HASH_SIZE; i++) SymbolData(theEnv)->ExternalAddressTable[i] = NULL;
+   SymbolData(theEnv)->SymbolTable = (SYMBOL_HN **) AllocateAtomTable(theEnv,SYMBOL_HASH_SIZE);
+   SymbolData(theEnv)->FloatTable = (FLOAT_HN **) AllocateAtomTable(theEnv,FLOAT_HASH_SIZE);
+   SymbolData(theEnv)->IntegerTable = (INTEGER_HN **) AllocateAtomTable(theEnv,INTEGER_HASH_SIZE);
+   SymbolData(theEnv)->BitMapTable = (BITMAP_HN **) AllocateAtomTable(theEnv,BITMAP_HASH_SIZE);
+   SymbolData(theEnv)->ExternalAddressTable = (EXTERNAL_ADDRESS_HN **) AllocateAtomTable(theEnv,EXTERNAL_ADDRESS_HASH_SIZE);
 
    /*========================*/
    /* Predefine some values. */
@@ -183,15 +198,24 @@ void InitializeAtomTables(
    SymbolData(theEnv)->Zero = EnvAddLong(theEnv,0LL);
    IncrementIntegerCount(SymbolData(theEnv)->Zero);
 #else
+   /*====================================================*/
+   /* The tables of a run-time program are statically    */
+   /* allocated by the generated code and keep the size  */
+   /* with which they were generated.                    */
+   /*====================================================*/
+
+   InitializeAtomTableState(&SymbolData(theEnv)->SymbolTableState,symbolTableSize);
+   InitializeAtomTableState(&SymbolData(theEnv)->FloatTableState,floatTableSize);
+   InitializeAtomTableState(&SymbolData(theEnv)->IntegerTableState,integerTableSize);
+   InitializeAtomTableState(&SymbolData(theEnv)->BitMapTableState,bitmapTableSize);
+   InitializeAtomTableState(&SymbolData(theEnv)->ExternalAddressTableState,EXTERNAL_ADDRESS_HASH_SIZE);
+
    SetSymbolTable(theEnv,symbolTable);
    SetFloatTable(theEnv,floatTable);
    SetIntegerTable(theEnv,integerTable);
    SetBitMapTable(theEnv,bitmapTable);
-   
-   SymbolData(theEnv)->ExternalAddressTable = (EXTERNAL_ADDRESS_HN **)
-                gm2(theEnv,(int) sizeof (EXTERNAL_ADDRESS_HN *) * EXTERNAL_ADDRESS_HASH_SIZE);
 
-   for (i = 0; i < EXTERNAL_ADDRESS_HASH_SIZE; i++) SymbolData(theEnv)->ExternalAddressTable[i] = NULL;
+   SymbolData(theEnv)->ExternalAddressTable = (EXTERNAL_ADDRESS_HN **) AllocateAtomTable(theEnv,EXTERNAL_ADDRESS_HASH_SIZE);
 #endif
   }
 
@@ -202,123 +226,350 @@ void InitializeAtomTables(
 static void DeallocateSymbolData(
   Environment *theEnv)
   {
-   int i;
-   SYMBOL_HN *shPtr, *nextSHPtr;
-   INTEGER_HN *ihPtr, *nextIHPtr;
-   FLOAT_HN *fhPtr, *nextFHPtr;
-   BITMAP_HN *bmhPtr, *nextBMHPtr;
-   EXTERNAL_ADDRESS_HN *eahPtr, *nextEAHPtr;
-
-   if ((SymbolData(theEnv)->SymbolTable == NULL) ||
-       (SymbolData(theEnv)->FloatTable == NULL) ||
-       (SymbolData(theEnv)->IntegerTable == NULL) ||
-       (SymbolData(theEnv)->BitMapTable == NULL) ||
-       (SymbolData(theEnv)->ExternalAddressTable == NULL))
+   struct symbolData *theData = SymbolData(theEnv);
+
+   if ((theData->SymbolTable == NULL) ||
+       (theData->FloatTable == NULL) ||
+       (theData->IntegerTable == NULL) ||
+       (theData->BitMapTable == NULL) ||
+       (theData->ExternalAddressTable == NULL))
      { return; }
-     
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++) 
+
+   /*=========================================*/
+   /* Complete any resizing in progress so    */
+   /* that every entry is in a single table.  */
+   /*=========================================*/
+
+   FinishAtomTableResize(theEnv,(GENERIC_HN **) theData->SymbolTable,&theData->SymbolTableState);
+   FinishAtomTableResize(theEnv,(GENERIC_HN **) theData->FloatTable,&theData->FloatTableState);
+   FinishAtomTableResize(theEnv,(GENERIC_HN **) theData->IntegerTable,&theData->IntegerTableState);
+   FinishAtomTableResize(theEnv,(GENERIC_HN **) theData->BitMapTable,&theData->BitMapTableState);
+   FinishAtomTableResize(theEnv,(GENERIC_HN **) theData->ExternalAddressTable,&theData->ExternalAddressTableState);
+
+   DeallocateAtomTableEntries(theEnv,(GENERIC_HN **) theData->SymbolTable,theData->SymbolTableState.size,SYMBOL);
+   DeallocateAtomTableEntries(theEnv,(GENERIC_HN **) theData->FloatTable,theData->FloatTableState.size,FLOAT);
+   DeallocateAtomTableEntries(theEnv,(GENERIC_HN **) theData->IntegerTable,theData->IntegerTableState.size,INTEGER);
+   DeallocateAtomTableEntries(theEnv,(GENERIC_HN **) theData->BitMapTable,theData->BitMapTableState.size,BITMAPARRAY);
+   DeallocateAtomTableEntries(theEnv,(GENERIC_HN **) theData->ExternalAddressTable,theData->ExternalAddressTableState.size,EXTERNAL_ADDRESS);
+
+   /*================================*/
+   /* Remove the symbol hash tables. */
+   /*================================*/
+
+#if ! RUN_TIME
+   FreeAtomTable(theEnv,(GENERIC_HN **) theData->SymbolTable,theData->SymbolTableState.size);
+   FreeAtomTable(theEnv,(GENERIC_HN **) theData->FloatTable,theData->FloatTableState.size);
+   FreeAtomTable(theEnv,(GENERIC_HN **) theData->IntegerTable,theData->IntegerTableState.size);
+   FreeAtomTable(theEnv,(GENERIC_HN **) theData->BitMapTable,theData->BitMapTableState.size);
+#endif
+
+   FreeAtomTable(theEnv,(GENERIC_HN **) theData->ExternalAddressTable,theData->ExternalAddressTableState.size);
+
+   /*==============================*/
+   /* Remove binary symbol tables. */
+   /*==============================*/
+
+#if BLOAD || BLOAD_ONLY || BLOAD_AND_BSAVE || BLOAD_INSTANCES || BSAVE_INSTANCES
+   if (theData->SymbolArray != NULL)
+     rm3(theEnv,theData->SymbolArray,(long) sizeof(SYMBOL_HN *) * theData->NumberOfSymbols);
+   if (theData->FloatArray != NULL)
+     rm3(theEnv,theData->FloatArray,(long) sizeof(FLOAT_HN *) * theData->NumberOfFloats);
+   if (theData->IntegerArray != NULL)
+     rm3(theEnv,theData->IntegerArray,(long) sizeof(INTEGER_HN *) * theData->NumberOfIntegers);
+   if (theData->BitMapArray != NULL)
+     rm3(theEnv,theData->BitMapArray,(long) sizeof(BITMAP_HN *) * theData->NumberOfBitMaps);
+#endif
+  }
+
+/*******************************************************/
+/* DeallocateAtomTableEntries: Returns the memory used */
+/*   by the nonpermanent entries of an atomic value    */
+/*   hash table when the environment is deallocated.   */
+/*******************************************************/
+static void DeallocateAtomTableEntries(
+  Environment *theEnv,
+  GENERIC_HN **theTable,
+  unsigned long size,
+  int type)
+  {
+   unsigned long i;
+   GENERIC_HN *hnPtr, *nextHNPtr;
+
+   for (i = 0; i < size; i++)
      {
-      shPtr = SymbolData(theEnv)->SymbolTable[i];
-      
-      while (shPtr != NULL)
+      hnPtr = theTable[i];
+
+      while (hnPtr != NULL)
         {
-         nextSHPtr = shPtr->next;
-         if (! shPtr->permanent)
+         nextHNPtr = hnPtr->next;
+         if (! hnPtr->permanent)
            {
-            rm(theEnv,(void *) shPtr->contents,strlen(shPtr->contents)+1);
-            rtn_struct(theEnv,symbolHashNode,shPtr);
-           }  
-         shPtr = nextSHPtr;
-        } 
+            switch (type)
+              {
+               case SYMBOL:
+                 rm(theEnv,(void *) ((SYMBOL_HN *) hnPtr)->contents,
+                    ((SYMBOL_HN *) hnPtr)->length + 1);
+                 rtn_struct(theEnv,symbolHashNode,(SYMBOL_HN *) hnPtr);
+                 break;
+
+               case FLOAT:
+                 rtn_struct(theEnv,floatHashNode,(FLOAT_HN *) hnPtr);
+                 break;
+
+               case INTEGER:
+                 rtn_struct(theEnv,integerHashNode,(INTEGER_HN *) hnPtr);
+                 break;
+
+               case BITMAPARRAY:
+                 rm(theEnv,(void *) ((BITMAP_HN *) hnPtr)->contents,((BITMAP_HN *) hnPtr)->size);
+                 rtn_struct(theEnv,bitMapHashNode,(BITMAP_HN *) hnPtr);
+                 break;
+
+               case EXTERNAL_ADDRESS:
+                 rtn_struct(theEnv,externalAddressHashNode,(EXTERNAL_ADDRESS_HN *) hnPtr);
+                 break;
+              }
+           }
+         hnPtr = nextHNPtr;
+        }
      }
-      
-   for (i = 0; i < FLOAT_HASH_SIZE; i++) 
-     {
-      fhPtr = SymbolData(theEnv)->FloatTable[i];
+  }
 
-      while (fhPtr != NULL)
-        {
-         nextFHPtr = fhPtr->next;
-         if (! fhPtr->permanent)
-           { rtn_struct(theEnv,floatHashNode,fhPtr); }
-         fhPtr = nextFHPtr;
-        }
+/*************************************************************/
+/* InitializeAtomTableState: Sets the bookkeeping information */
+/*   for an atomic value hash table of the specified size.   */
+/*************************************************************/
+static void InitializeAtomTableState(
+  struct atomTableState *theState,
+  unsigned long size)
+  {
+   theState->size = size;
+   theState->initialSize = size;
+   theState->count = 0;
+   theState->oldTable = NULL;
+   theState->oldSize = 0;
+   theState->rehashIndex = 0;
+   theState->resizes = 0;
+  }
+
+/****************************************************/
+/* AllocateAtomTable: Allocates an atomic value hash */
+/*   table with all of its buckets set to NULL.      */
+/****************************************************/
+static GENERIC_HN **AllocateAtomTable(
+  Environment *theEnv,
+  unsigned long size)
+  {
+   GENERIC_HN **theTable;
+   unsigned long i;
+
+   theTable = (GENERIC_HN **) gm3(theEnv,sizeof(GENERIC_HN *) * size);
+
+   for (i = 0; i < size; i++)
+     { theTable[i] = NULL; }
+
+   return theTable;
+  }
+
+/******************************************************/
+/* FreeAtomTable: Returns the memory used by the array */
+/*   of buckets for an atomic value hash table.        */
+/******************************************************/
+static void FreeAtomTable(
+  Environment *theEnv,
+  GENERIC_HN **theTable,
+  unsigned long size)
+  {
+   rm3(theEnv,theTable,sizeof(GENERIC_HN *) * size);
+  }
+
+/***************************************************************/
+/* AtomTableBucket: Returns the address of the bucket in which */
+/*   an entry with the specified hash value is stored. While a */
+/*   table is being resized, buckets of the old table which    */
+/*   have not yet been moved still hold their entries.         */
+/***************************************************************/
+static GENERIC_HN **AtomTableBucket(
+  GENERIC_HN **theTable,
+  struct atomTableState *theState,
+  unsigned long hashValue)
+  {
+   unsigned long oldBucket;
+
+   if (theState->oldTable != NULL)
+     {
+      oldBucket = hashValue % theState->oldSize;
+      if (oldBucket >= theState->rehashIndex)
+        { return &theState->oldTable[oldBucket]; }
      }
-     
-   for (i = 0; i < INTEGER_HASH_SIZE; i++) 
+
+   return &theTable[hashValue % theState->size];
+  }
+
+/***************************************************************/
+/* AtomTableEntryAdded: Updates the count of entries in a hash */
+/*   table after an entry has been added. Continues a resize   */
+/*   already in progress or begins growing the table if the    */
+/*   number of entries exceeds the maximum load.               */
+/***************************************************************/
+static void AtomTableEntryAdded(
+  Environment *theEnv,
+  GENERIC_HN ***theTable,
+  struct atomTableState *theState)
+  {
+   unsigned long newSize;
+
+   theState->count++;
+
+   if (theState->oldTable != NULL)
      {
-      ihPtr = SymbolData(theEnv)->IntegerTable[i];
+      StepAtomTableResize(theEnv,theState,*theTable,ATOM_TABLE_REHASH_STEP);
+      return;
+     }
 
-      while (ihPtr != NULL)
-        {
-         nextIHPtr = ihPtr->next;
-         if (! ihPtr->permanent)
-           { rtn_struct(theEnv,integerHashNode,ihPtr); }
-         ihPtr = nextIHPtr;
-        }
+#if ! RUN_TIME
+   if ((theState->count > (theState->size * ATOM_TABLE_MAX_LOAD)) &&
+       (theState->size < MAX_ATOM_TABLE_SIZE))
+     {
+      newSize = (theState->size * 2) + 1;
+      if (newSize > MAX_ATOM_TABLE_SIZE)
+        { newSize = MAX_ATOM_TABLE_SIZE; }
+      StartAtomTableResize(theEnv,theTable,theState,newSize);
      }
-     
-   for (i = 0; i < BITMAP_HASH_SIZE; i++) 
+#else
+#if MAC_XCD
+#pragma unused(newSize)
+#endif
+#endif
+  }
+
+/*****************************************************************/
+/* AtomTableEntryRemoved: Updates the count of entries in a hash */
+/*   table after an entry has been removed. Continues a resize   */
+/*   already in progress or begins shrinking the table if it has */
+/*   grown beyond its initial size and has become sparse.        */
+/*****************************************************************/
+static void AtomTableEntryRemoved(
+  Environment *theEnv,
+  GENERIC_HN ***theTable,
+  struct atomTableState *theState)
+  {
+   unsigned long newSize;
+
+   if (theState->count > 0)
+     { theState->count--; }
+
+   if (theState->oldTable != NULL)
      {
-      bmhPtr = SymbolData(theEnv)->BitMapTable[i];
+      StepAtomTableResize(theEnv,theState,*theTable,ATOM_TABLE_REHASH_STEP);
+      return;
+     }
 
-      while (bmhPtr != NULL)
-        {
-         nextBMHPtr = bmhPtr->next;
-         if (! bmhPtr->permanent)
-           {
-            rm(theEnv,(void *) bmhPtr->contents,bmhPtr->size);
-            rtn_struct(theEnv,bitMapHashNode,bmhPtr); 
-           } 
-         bmhPtr = nextBMHPtr;
-        }
+#if ! RUN_TIME
+   if ((theState->size > theState->initialSize) &&
+       (theState->count < (theState->size / ATOM_TABLE_MIN_LOAD_DIVISOR)))
+     {
+      newSize = theState->size / 2;
+      if (newSize < theState->initialSize)
+        { newSize = theState->initialSize; }
+      StartAtomTableResize(theEnv,theTable,theState,newSize);
      }
+#else
+#if MAC_XCD
+#pragma unused(newSize)
+#endif
+#endif
+  }
+
+/****************************************************************/
+/* StartAtomTableResize: Allocates a new table for an atomic    */
+/*   value hash table. The current table becomes the old table  */
+/*   and its entries are moved to the new table incrementally   */
+/*   as entries are added and removed so that no single call    */
+/*   has to pay the cost of rehashing the entire table.         */
+/****************************************************************/
+static void StartAtomTableResize(
+  Environment *theEnv,
+  GENERIC_HN ***theTable,
+  struct atomTableState *theState,
+  unsigned long newSize)
+  {
+   if (theState->oldTable != NULL)
+     { FinishAtomTableResize(theEnv,*theTable,theState); }
+
+   theState->oldTable = *theTable;
+   theState->oldSize = theState->size;
+   theState->rehashIndex = 0;
+   theState->size = newSize;
+   theState->resizes++;
+
+   *theTable = AllocateAtomTable(theEnv,newSize);
+  }
+
+/****************************************************************/
+/* StepAtomTableResize: Moves the entries from up to the        */
+/*   specified number of nonempty buckets of the old table to   */
+/*   the new table. The old table is released once all of its  */
+/*   buckets have been moved. Since the bucket field of each    */
+/*   entry holds its hash value, no entry needs to be rehashed. */
+/****************************************************************/
+static void StepAtomTableResize(
+  Environment *theEnv,
+  struct atomTableState *theState,
+  GENERIC_HN **theTable,
+  unsigned long steps)
+  {
+   GENERIC_HN *hnPtr, *nextHNPtr, **newBucket;
+   unsigned long emptyVisits = steps * 8;
 
-   for (i = 0; i < EXTERNAL_ADDRESS_HASH_SIZE; i++) 
+   while ((theState->rehashIndex < theState->oldSize) &&
+          (steps > 0))
      {
-      eahPtr = SymbolData(theEnv)->ExternalAddressTable[i];
+      hnPtr = theState->oldTable[theState->rehashIndex];
 
-      while (eahPtr != NULL)
+      if (hnPtr == NULL)
         {
-         nextEAHPtr = eahPtr->next;
-         if (! eahPtr->permanent)
-           {
-            rtn_struct(theEnv,externalAddressHashNode,eahPtr); 
-           } 
-         eahPtr = nextEAHPtr;
+         theState->rehashIndex++;
+         if (emptyVisits-- == 0) break;
+         continue;
         }
-     }
 
-   /*================================*/
-   /* Remove the symbol hash tables. */
-   /*================================*/
-   
- #if ! RUN_TIME  
-   rm3(theEnv,SymbolData(theEnv)->SymbolTable,sizeof (SYMBOL_HN *) * SYMBOL_HASH_SIZE);
+      while (hnPtr != NULL)
+        {
+         nextHNPtr = hnPtr->next;
+         newBucket = &theTable[hnPtr->bucket % theState->size];
+         hnPtr->next = *newBucket;
+         *newBucket = hnPtr;
+         hnPtr = nextHNPtr;
+        }
 
-   genfree(theEnv,SymbolData(theEnv)->FloatTable,(int) sizeof (FLOAT_HN *) * FLOAT_HASH_SIZE);
+      theState->oldTable[theState->rehashIndex] = NULL;
+      theState->rehashIndex++;
+      steps--;
+     }
 
-   genfree(theEnv,SymbolData(theEnv)->IntegerTable,(int) sizeof (INTEGER_HN *) * INTEGER_HASH_SIZE);
+   if (theState->rehashIndex >= theState->oldSize)
+     {
+      FreeAtomTable(theEnv,theState->oldTable,theState->oldSize);
+      theState->oldTable = NULL;
+      theState->oldSize = 0;
+      theState->rehashIndex = 0;
+     }
+  }
 
-   genfree(theEnv,SymbolData(theEnv)->BitMapTable,(int) sizeof (BITMAP_HN *) * BITMAP_HASH_SIZE);
-#endif
-   
-   genfree(theEnv,SymbolData(theEnv)->ExternalAddressTable,(int) sizeof (EXTERNAL_ADDRESS_HN *) * EXTERNAL_ADDRESS_HASH_SIZE);
+/**************************************************************/
+/* FinishAtomTableResize: Completes any resizing in progress  */
+/*   for an atomic value hash table so that all of its        */
+/*   entries can be found by traversing the current table.    */
+/**************************************************************/
+static void FinishAtomTableResize(
+  Environment *theEnv,
+  GENERIC_HN **theTable,
+  struct atomTableState *theState)
+  {
+   if (theState->oldTable == NULL) return;
 
-   /*==============================*/
-   /* Remove binary symbol tables. */
-   /*==============================*/
-   
-#if BLOAD || BLOAD_ONLY || BLOAD_AND_BSAVE || BLOAD_INSTANCES || BSAVE_INSTANCES
-   if (SymbolData(theEnv)->SymbolArray != NULL)
-     rm3(theEnv,SymbolData(theEnv)->SymbolArray,(long) sizeof(SYMBOL_HN *) * SymbolData(theEnv)->NumberOfSymbols);
-   if (SymbolData(theEnv)->FloatArray != NULL)
-     rm3(theEnv,SymbolData(theEnv)->FloatArray,(long) sizeof(FLOAT_HN *) * SymbolData(theEnv)->NumberOfFloats);
-   if (SymbolData(theEnv)->IntegerArray != NULL)
-     rm3(theEnv,SymbolData(theEnv)->IntegerArray,(long) sizeof(INTEGER_HN *) * SymbolData(theEnv)->NumberOfIntegers);
-   if (SymbolData(theEnv)->BitMapArray != NULL)
-     rm3(theEnv,SymbolData(theEnv)->BitMapArray,(long) sizeof(BITMAP_HN *) * SymbolData(theEnv)->NumberOfBitMaps);
-#endif
+   StepAtomTableResize(theEnv,theState,theTable,theState->oldSize);
   }
 
 /*********************************************************************/
@@ -332,23 +583,62 @@ void *EnvAddSymbol(
   Environment *theEnv,
   const char *str)
   {
-   unsigned long tally;
+   if (str == NULL)
+     {
+      SystemError(theEnv,"SYMBOL",1);
+      EnvExitRouter(theEnv,EXIT_FAILURE);
+     }
+
+   return(AddSymbolEntry(theEnv,str,NULL,0));
+  }
+
+/*********************************************************************/
+/* EnvAddSymbolBuffer: Adds the string in a buffer allocated with    */
+/*   gm2 to the symbol table. If the string is not already in the    */
+/*   symbol table and the buffer is the exact size of the string,    */
+/*   the buffer becomes the contents of the new entry rather than    */
+/*   being copied and the caller's pointer to it is set to NULL.     */
+/*   Otherwise the buffer still belongs to the caller.               */
+/*********************************************************************/
+void *EnvAddSymbolBuffer(
+  Environment *theEnv,
+  char **buffer,
+  size_t bufferSize)
+  {
+   if ((buffer == NULL) || (*buffer == NULL))
+     {
+      SystemError(theEnv,"SYMBOL",1);
+      EnvExitRouter(theEnv,EXIT_FAILURE);
+     }
+
+   return(AddSymbolEntry(theEnv,*buffer,buffer,bufferSize));
+  }
+
+/**************************************************************/
+/* AddSymbolEntry: Driver routine for EnvAddSymbol and        */
+/*   EnvAddSymbolBuffer. The string is copied for a new entry */
+/*   unless a buffer of the exact size is given for it.       */
+/**************************************************************/
+static SYMBOL_HN *AddSymbolEntry(
+  Environment *theEnv,
+  const char *str,
+  char **buffer,
+  size_t bufferSize)
+  {
+   unsigned long hashValue, tally;
    size_t length;
-   SYMBOL_HN *past = NULL, *peek;
-   char *buffer;
+   SYMBOL_HN *past = NULL, *peek, **theBucket;
+   char *contents;
 
     /*====================================*/
     /* Get the hash value for the string. */
     /*====================================*/
 
-    if (str == NULL)
-      {
-       SystemError(theEnv,"SYMBOL",1);
-       EnvExitRouter(theEnv,EXIT_FAILURE);
-      }
-
-    tally = HashSymbol(str,SYMBOL_HASH_SIZE);
-    peek = SymbolData(theEnv)->SymbolTable[tally];
+    hashValue = HashSymbol(str,0);
+    tally = hashValue & ATOM_HASH_MASK;
+    theBucket = (SYMBOL_HN **) AtomTableBucket((GENERIC_HN **) SymbolData(theEnv)->SymbolTable,
+                                               &SymbolData(theEnv)->SymbolTableState,tally);
+    peek = *theBucket;
 
     /*==================================================*/
     /* Search for the string in the list of entries for */
@@ -358,8 +648,9 @@ void *EnvAddSymbol(
 
     while (peek != NULL)
       {
-       if (strcmp(str,peek->contents) == 0)
-         { return((void *) peek); }
+       if ((peek->hashValue == hashValue) &&
+           (strcmp(str,peek->contents) == 0))
+         { return(peek); }
        past = peek;
        peek = peek->next;
       }
@@ -371,13 +662,29 @@ void *EnvAddSymbol(
 
     peek = get_struct(theEnv,symbolHashNode);
 
-    if (past == NULL) SymbolData(theEnv)->SymbolTable[tally] = peek;
+    if (past == NULL) *theBucket = peek;
     else past->next = peek;
 
-    length = strlen(str) + 1;
-    buffer = (char *) gm2(theEnv,length);
-    genstrcpy(buffer,str);
-    peek->contents = buffer;
+    /*=============================================*/
+    /* Take over the caller's buffer if it holds   */
+    /* just the string, otherwise copy the string. */
+    /*=============================================*/
+
+    length = strlen(str);
+    if ((buffer != NULL) && (bufferSize == length + 1))
+      {
+       contents = *buffer;
+       *buffer = NULL;
+      }
+    else
+      {
+       contents = (char *) gm2(theEnv,length + 1);
+       genstrcpy(contents,str);
+      }
+
+    peek->contents = contents;
+    peek->length = length;
+    peek->hashValue = hashValue;
     peek->next = NULL;
     peek->bucket = tally;
     peek->count = 0;
@@ -391,11 +698,14 @@ void *EnvAddSymbol(
                          sizeof(SYMBOL_HN),AVERAGE_STRING_SIZE,true);
     UtilityData(theEnv)->CurrentGarbageFrame->dirty = true;
 
+    AtomTableEntryAdded(theEnv,(GENERIC_HN ***) &SymbolData(theEnv)->SymbolTable,
+                        &SymbolData(theEnv)->SymbolTableState);
+
     /*===================================*/
     /* Return the address of the symbol. */
     /*===================================*/
 
-    return((void *) peek);
+    return(peek);
    }
 
 /*****************************************************************/
@@ -406,16 +716,19 @@ SYMBOL_HN *FindSymbolHN(
   Environment *theEnv,
   const char *str)
   {
-   unsigned long tally;
+   unsigned long hashValue, tally;
    SYMBOL_HN *peek;
 
-    tally = HashSymbol(str,SYMBOL_HASH_SIZE);
+    hashValue = HashSymbol(str,0);
+    tally = hashValue & ATOM_HASH_MASK;
 
-    for (peek = SymbolData(theEnv)->SymbolTable[tally];
+    for (peek = *((SYMBOL_HN **) AtomTableBucket((GENERIC_HN **) SymbolData(theEnv)->SymbolTable,
+                                                 &SymbolData(theEnv)->SymbolTableState,tally));
          peek != NULL;
          peek = peek->next)
       { 
-       if (strcmp(str,peek->contents) == 0) 
+       if ((peek->hashValue == hashValue) &&
+           (strcmp(str,peek->contents) == 0))
          { return(peek); }
       }
 
@@ -433,14 +746,16 @@ void *EnvAddDouble(
   double number)
   {
    unsigned long tally;
-   FLOAT_HN *past = NULL, *peek;
+   FLOAT_HN *past = NULL, *peek, **theBucket;
 
     /*====================================*/
     /* Get the hash value for the double. */
     /*====================================*/
 
-    tally = HashFloat(number,FLOAT_HASH_SIZE);
-    peek = SymbolData(theEnv)->FloatTable[tally];
+    tally = HashFloat(number,0) & ATOM_HASH_MASK;
+    theBucket = (FLOAT_HN **) AtomTableBucket((GENERIC_HN **) SymbolData(theEnv)->FloatTable,
+                                              &SymbolData(theEnv)->FloatTableState,tally);
+    peek = *theBucket;
 
     /*==================================================*/
     /* Search for the double in the list of entries for */
@@ -463,7 +778,7 @@ void *EnvAddDouble(
 
     peek = get_struct(theEnv,floatHashNode);
 
-    if (past == NULL) SymbolData(theEnv)->FloatTable[tally] = peek;
+    if (past == NULL) *theBucket = peek;
     else past->next = peek;
 
     peek->contents = number;
@@ -479,6 +794,9 @@ void *EnvAddDouble(
     AddEphemeralHashNode(theEnv,(GENERIC_HN *) peek,&UtilityData(theEnv)->CurrentGarbageFrame->ephemeralFloatList,
                          sizeof(FLOAT_HN),0,true);
     UtilityData(theEnv)->CurrentGarbageFrame->dirty = true;
+
+    AtomTableEntryAdded(theEnv,(GENERIC_HN ***) &SymbolData(theEnv)->FloatTable,
+                        &SymbolData(theEnv)->FloatTableState);
     
     /*==================================*/
     /* Return the address of the float. */
@@ -498,14 +816,16 @@ void *EnvAddLong(
   long long number)
   {
    unsigned long tally;
-   INTEGER_HN *past = NULL, *peek;
+   INTEGER_HN *past = NULL, *peek, **theBucket;
 
     /*==================================*/
     /* Get the hash value for the long. */
     /*==================================*/
 
-    tally = HashInteger(number,INTEGER_HASH_SIZE);
-    peek = SymbolData(theEnv)->IntegerTable[tally];
+    tally = HashInteger(number,0) & ATOM_HASH_MASK;
+    theBucket = (INTEGER_HN **) AtomTableBucket((GENERIC_HN **) SymbolData(theEnv)->IntegerTable,
+                                                &SymbolData(theEnv)->IntegerTableState,tally);
+    peek = *theBucket;
 
     /*================================================*/
     /* Search for the long in the list of entries for */
@@ -527,7 +847,7 @@ void *EnvAddLong(
     /*================================================*/
 
     peek = get_struct(theEnv,integerHashNode);
-    if (past == NULL) SymbolData(theEnv)->IntegerTable[tally] = peek;
+    if (past == NULL) *theBucket = peek;
     else past->next = peek;
 
     peek->contents = number;
@@ -544,6 +864,9 @@ void *EnvAddLong(
                          sizeof(INTEGER_HN),0,true);
     UtilityData(theEnv)->CurrentGarbageFrame->dirty = true;
 
+    AtomTableEntryAdded(theEnv,(GENERIC_HN ***) &SymbolData(theEnv)->IntegerTable,
+                        &SymbolData(theEnv)->IntegerTableState);
+
     /*====================================*/
     /* Return the address of the integer. */
     /*====================================*/
@@ -562,9 +885,10 @@ INTEGER_HN *FindLongHN(
    unsigned long tally;
    INTEGER_HN *peek;
 
-   tally = HashInteger(theLong,INTEGER_HASH_SIZE);
+   tally = HashInteger(theLong,0) & ATOM_HASH_MASK;
 
-   for (peek = SymbolData(theEnv)->IntegerTable[tally];
+   for (peek = *((INTEGER_HN **) AtomTableBucket((GENERIC_HN **) SymbolData(theEnv)->IntegerTable,
+                                                 &SymbolData(theEnv)->IntegerTableState,tally));
         peek != NULL;
         peek = peek->next)
      { if (peek->contents == theLong) return(peek); }
@@ -586,7 +910,7 @@ void *EnvAddBitMap(
    char *theBitMap = (char *) vTheBitMap;
    unsigned long tally;
    unsigned i;
-   BITMAP_HN *past = NULL, *peek;
+   BITMAP_HN *past = NULL, *peek, **theBucket;
    char *buffer;
 
     /*====================================*/
@@ -599,8 +923,10 @@ void *EnvAddBitMap(
        EnvExitRouter(theEnv,EXIT_FAILURE);
       }
 
-    tally = HashBitMap(theBitMap,BITMAP_HASH_SIZE,size);
-    peek = SymbolData(theEnv)->BitMapTable[tally];
+    tally = HashBitMap(theBitMap,0,size) & ATOM_HASH_MASK;
+    theBucket = (BITMAP_HN **) AtomTableBucket((GENERIC_HN **) SymbolData(theEnv)->BitMapTable,
+                                               &SymbolData(theEnv)->BitMapTableState,tally);
+    peek = *theBucket;
 
     /*==================================================*/
     /* Search for the bitmap in the list of entries for */
@@ -628,7 +954,7 @@ void *EnvAddBitMap(
     /*==================================================*/
 
     peek = get_struct(theEnv,bitMapHashNode);
-    if (past == NULL) SymbolData(theEnv)->BitMapTable[tally] = peek;
+    if (past == NULL) *theBucket = peek;
     else past->next = peek;
 
     buffer = (char *) gm2(theEnv,size);
@@ -648,6 +974,9 @@ void *EnvAddBitMap(
                          sizeof(BITMAP_HN),sizeof(long),true);
     UtilityData(theEnv)->CurrentGarbageFrame->dirty = true;
 
+    AtomTableEntryAdded(theEnv,(GENERIC_HN ***) &SymbolData(theEnv)->BitMapTable,
+                        &SymbolData(theEnv)->BitMapTableState);
+
     /*===================================*/
     /* Return the address of the bitmap. */
     /*===================================*/
@@ -668,15 +997,16 @@ void *EnvAddExternalAddress(
   unsigned theType)
   {
    unsigned long tally;
-   EXTERNAL_ADDRESS_HN *past = NULL, *peek;
+   EXTERNAL_ADDRESS_HN *past = NULL, *peek, **theBucket;
 
     /*====================================*/
     /* Get the hash value for the bitmap. */
     /*====================================*/
 
-    tally = HashExternalAddress(theExternalAddress,EXTERNAL_ADDRESS_HASH_SIZE);
-
-    peek = SymbolData(theEnv)->ExternalAddressTable[tally];
+    tally = HashExternalAddress(theExternalAddress,0) & ATOM_HASH_MASK;
+    theBucket = (EXTERNAL_ADDRESS_HN **) AtomTableBucket((GENERIC_HN **) SymbolData(theEnv)->ExternalAddressTable,
+                                                         &SymbolData(theEnv)->ExternalAddressTableState,tally);
+    peek = *theBucket;
 
     /*=============================================================*/
     /* Search for the external address in the list of entries for  */
@@ -700,7 +1030,7 @@ void *EnvAddExternalAddress(
     /*=================================================*/
 
     peek = get_struct(theEnv,externalAddressHashNode);
-    if (past == NULL) SymbolData(theEnv)->ExternalAddressTable[tally] = peek;
+    if (past == NULL) *theBucket = peek;
     else past->next = peek;
 
     peek->externalAddress = theExternalAddress;
@@ -718,6 +1048,9 @@ void *EnvAddExternalAddress(
                          sizeof(EXTERNAL_ADDRESS_HN),sizeof(long),true);
     UtilityData(theEnv)->CurrentGarbageFrame->dirty = true;
 
+    AtomTableEntryAdded(theEnv,(GENERIC_HN ***) &SymbolData(theEnv)->ExternalAddressTable,
+                        &SymbolData(theEnv)->ExternalAddressTableState);
+
     /*=============================================*/
     /* Return the address of the external address. */
     /*=============================================*/
@@ -778,15 +1111,15 @@ unsigned long HashInteger(
 #if WIN_MVC
    if (number < 0)
      { number = - number; }
-   tally = (((unsigned) number) % range);
+   tally = (unsigned long) number;
 #else
-   tally = (((unsigned) llabs(number)) % range);
+   tally = (unsigned long) llabs(number);
 #endif
 
    if (range == 0)
      { return tally; }
-     
-   return(tally);
+
+   return(tally % range);
   }
 
 /****************************************/
@@ -1031,19 +1364,21 @@ void DecrementExternalAddressCount(
 static void RemoveHashNode(
   Environment *theEnv,
   GENERIC_HN *theValue,
-  GENERIC_HN **theTable,
+  GENERIC_HN ***theTable,
+  struct atomTableState *theState,
   int size,
   int type)
   {
-   GENERIC_HN *previousNode, *currentNode;
+   GENERIC_HN *previousNode, *currentNode, **theBucket;
    struct externalAddressHashNode *theAddress;
 
    /*=============================================*/
    /* Find the entry in the specified hash table. */
    /*=============================================*/
 
+   theBucket = AtomTableBucket(*theTable,theState,theValue->bucket);
    previousNode = NULL;
-   currentNode = theTable[theValue->bucket];
+   currentNode = *theBucket;
 
    while (currentNode != theValue)
      {
@@ -1063,7 +1398,7 @@ static void RemoveHashNode(
    /*===========================================*/
 
    if (previousNode == NULL)
-     { theTable[theValue->bucket] = theValue->next; }
+     { *theBucket = theValue->next; }
    else
      { previousNode->next = currentNode->next; }
 
@@ -1075,7 +1410,7 @@ static void RemoveHashNode(
    if (type == SYMBOL)
      {
       rm(theEnv,(void *) ((SYMBOL_HN *) theValue)->contents,
-         strlen(((SYMBOL_HN *) theValue)->contents) + 1);
+         ((SYMBOL_HN *) theValue)->length + 1);
      }
    else if (type == BITMAPARRAY)
      {
@@ -1097,6 +1432,12 @@ static void RemoveHashNode(
    /*===========================*/
 
    rtn_sized_struct(theEnv,size,theValue);
+
+   /*===========================================*/
+   /* Shrink the table if it has become sparse. */
+   /*===========================================*/
+
+   AtomTableEntryRemoved(theEnv,theTable,theState);
   }
 
 /***********************************************************/
@@ -1157,16 +1498,16 @@ void RemoveEphemeralAtoms(
    theGarbageFrame = UtilityData(theEnv)->CurrentGarbageFrame;
    if (! theGarbageFrame->dirty) return;
    
-   RemoveEphemeralHashNodes(theEnv,&theGarbageFrame->ephemeralSymbolList,(GENERIC_HN **) SymbolData(theEnv)->SymbolTable,
-                            sizeof(SYMBOL_HN),SYMBOL,AVERAGE_STRING_SIZE);
-   RemoveEphemeralHashNodes(theEnv,&theGarbageFrame->ephemeralFloatList,(GENERIC_HN **) SymbolData(theEnv)->FloatTable,
-                            sizeof(FLOAT_HN),FLOAT,0);
-   RemoveEphemeralHashNodes(theEnv,&theGarbageFrame->ephemeralIntegerList,(GENERIC_HN **) SymbolData(theEnv)->IntegerTable,
-                            sizeof(INTEGER_HN),INTEGER,0);
-   RemoveEphemeralHashNodes(theEnv,&theGarbageFrame->ephemeralBitMapList,(GENERIC_HN **) SymbolData(theEnv)->BitMapTable,
-                            sizeof(BITMAP_HN),BITMAPARRAY,AVERAGE_BITMAP_SIZE);
-   RemoveEphemeralHashNodes(theEnv,&theGarbageFrame->ephemeralExternalAddressList,(GENERIC_HN **) SymbolData(theEnv)->ExternalAddressTable,
-                            sizeof(EXTERNAL_ADDRESS_HN),EXTERNAL_ADDRESS,0);
+   RemoveEphemeralHashNodes(theEnv,&theGarbageFrame->ephemeralSymbolList,(GENERIC_HN ***) &SymbolData(theEnv)->SymbolTable,
+                            &SymbolData(theEnv)->SymbolTableState,sizeof(SYMBOL_HN),SYMBOL,AVERAGE_STRING_SIZE);
+   RemoveEphemeralHashNodes(theEnv,&theGarbageFrame->ephemeralFloatList,(GENERIC_HN ***) &SymbolData(theEnv)->FloatTable,
+                            &SymbolData(theEnv)->FloatTableState,sizeof(FLOAT_HN),FLOAT,0);
+   RemoveEphemeralHashNodes(theEnv,&theGarbageFrame->ephemeralIntegerList,(GENERIC_HN ***) &SymbolData(theEnv)->IntegerTable,
+                            &SymbolData(theEnv)->IntegerTableState,sizeof(INTEGER_HN),INTEGER,0);
+   RemoveEphemeralHashNodes(theEnv,&theGarbageFrame->ephemeralBitMapList,(GENERIC_HN ***) &SymbolData(theEnv)->BitMapTable,
+                            &SymbolData(theEnv)->BitMapTableState,sizeof(BITMAP_HN),BITMAPARRAY,AVERAGE_BITMAP_SIZE);
+   RemoveEphemeralHashNodes(theEnv,&theGarbageFrame->ephemeralExternalAddressList,(GENERIC_HN ***) &SymbolData(theEnv)->ExternalAddressTable,
+                            &SymbolData(theEnv)->ExternalAddressTableState,sizeof(EXTERNAL_ADDRESS_HN),EXTERNAL_ADDRESS,0);
   }
 
 /***********************************************/
@@ -1246,7 +1587,8 @@ void EphemerateValue(
 static void RemoveEphemeralHashNodes(
   Environment *theEnv,
   struct ephemeron **theEphemeralList,
-  GENERIC_HN **theTable,
+  GENERIC_HN ***theTable,
+  struct atomTableState *theState,
   int hashNodeSize,
   int hashNodeType,
   int averageContentsSize)
@@ -1273,7 +1615,7 @@ static void RemoveEphemeralHashNodes(
 
       if (edPtr->associatedValue->count == 0)
         {
-         RemoveHashNode(theEnv,edPtr->associatedValue,theTable,hashNodeSize,hashNodeType);
+         RemoveHashNode(theEnv,edPtr->associatedValue,theTable,theState,hashNodeSize,hashNodeType);
          rtn_struct(theEnv,ephemeron,edPtr);
          if (lastPtr == NULL) *theEphemeralList = nextPtr;
          else lastPtr->next = nextPtr;
@@ -1307,10 +1649,16 @@ static void RemoveEphemeralHashNodes(
 
 /*********************************************************/
 /* GetSymbolTable: Returns a pointer to the SymbolTable. */
+/*   Any resizing of the table in progress is completed  */
+/*   so that all entries can be reached by traversing    */
+/*   the returned table.                                 */
 /*********************************************************/
 SYMBOL_HN **GetSymbolTable(
   Environment *theEnv)
   {
+   FinishAtomTableResize(theEnv,(GENERIC_HN **) SymbolData(theEnv)->SymbolTable,
+                         &SymbolData(theEnv)->SymbolTableState);
+
    return(SymbolData(theEnv)->SymbolTable);
   }
 
@@ -1330,6 +1678,9 @@ void SetSymbolTable(
 FLOAT_HN **GetFloatTable(
   Environment *theEnv)
   {
+   FinishAtomTableResize(theEnv,(GENERIC_HN **) SymbolData(theEnv)->FloatTable,
+                         &SymbolData(theEnv)->FloatTableState);
+
    return(SymbolData(theEnv)->FloatTable);
   }
 
@@ -1349,6 +1700,9 @@ void SetFloatTable(
 INTEGER_HN **GetIntegerTable(
   Environment *theEnv)
   {
+   FinishAtomTableResize(theEnv,(GENERIC_HN **) SymbolData(theEnv)->IntegerTable,
+                         &SymbolData(theEnv)->IntegerTableState);
+
    return(SymbolData(theEnv)->IntegerTable);
   }
 
@@ -1368,6 +1722,9 @@ void SetIntegerTable(
 BITMAP_HN **GetBitMapTable(
   Environment *theEnv)
   {
+   FinishAtomTableResize(theEnv,(GENERIC_HN **) SymbolData(theEnv)->BitMapTable,
+                         &SymbolData(theEnv)->BitMapTableState);
+
    return(SymbolData(theEnv)->BitMapTable);
   }
 
@@ -1387,6 +1744,9 @@ void SetBitMapTable(
 EXTERNAL_ADDRESS_HN **GetExternalAddressTable(
   Environment *theEnv)
   {
+   FinishAtomTableResize(theEnv,(GENERIC_HN **) SymbolData(theEnv)->ExternalAddressTable,
+                         &SymbolData(theEnv)->ExternalAddressTableState);
+
    return(SymbolData(theEnv)->ExternalAddressTable);
   }
 
@@ -1400,6 +1760,56 @@ void SetExternalAddressTable(
    SymbolData(theEnv)->ExternalAddressTable = value;
   }
 
+/*********************************************************/
+/* GetSymbolTableSize: Returns the number of buckets in  */
+/*   the SymbolTable returned by GetSymbolTable.         */
+/*********************************************************/
+unsigned long GetSymbolTableSize(
+  Environment *theEnv)
+  {
+   return(SymbolData(theEnv)->SymbolTableState.size);
+  }
+
+/*******************************************************/
+/* GetFloatTableSize: Returns the number of buckets in */
+/*   the FloatTable returned by GetFloatTable.         */
+/*******************************************************/
+unsigned long GetFloatTableSize(
+  Environment *theEnv)
+  {
+   return(SymbolData(theEnv)->FloatTableState.size);
+  }
+
+/*********************************************************/
+/* GetIntegerTableSize: Returns the number of buckets in */
+/*   the IntegerTable returned by GetIntegerTable.       */
+/*********************************************************/
+unsigned long GetIntegerTableSize(
+  Environment *theEnv)
+  {
+   return(SymbolData(theEnv)->IntegerTableState.size);
+  }
+
+/********************************************************/
+/* GetBitMapTableSize: Returns the number of buckets in */
+/*   the BitMapTable returned by GetBitMapTable.        */
+/********************************************************/
+unsigned long GetBitMapTableSize(
+  Environment *theEnv)
+  {
+   return(SymbolData(theEnv)->BitMapTableState.size);
+  }
+
+/****************************************************************/
+/* GetExternalAddressTableSize: Returns the number of buckets   */
+/*   in the ExternalAddressTable.                               */
+/****************************************************************/
+unsigned long GetExternalAddressTableSize(
+  Environment *theEnv)
+  {
+   return(SymbolData(theEnv)->ExternalAddressTableState.size);
+  }
+
 /******************************************************/
 /* RefreshSpecialSymbols: Resets the values of the    */
 /*   TrueSymbol, FalseSymbol, Zero, PositiveInfinity, */
@@ -1509,6 +1919,9 @@ SYMBOL_HN *GetNextSymbolMatch(
    /* symbol table, the previous symbol argument is NULL.    */
    /*========================================================*/
 
+   FinishAtomTableResize(theEnv,(GENERIC_HN **) SymbolData(theEnv)->SymbolTable,
+                         &SymbolData(theEnv)->SymbolTableState);
+
    if (prevSymbol == NULL)
      {
       i = 0;
@@ -1522,7 +1935,7 @@ SYMBOL_HN *GetNextSymbolMatch(
 
    else
      {
-      i = prevSymbol->bucket;
+      i = prevSymbol->bucket % SymbolData(theEnv)->SymbolTableState.size;
       hashPtr = prevSymbol->next;
      }
 
@@ -1603,7 +2016,7 @@ SYMBOL_HN *GetNextSymbolMatch(
       /* Move on to the next bucket in the symbol table. */
       /*=================================================*/
 
-      if (++i >= SYMBOL_HASH_SIZE) flag = false;
+      if (++i >= SymbolData(theEnv)->SymbolTableState.size) flag = false;
       else hashPtr = SymbolData(theEnv)->SymbolTable[i];
      }
 
@@ -1675,7 +2088,7 @@ void SetAtomicValueIndices(
    count = 0;
    symbolArray = GetSymbolTable(theEnv);
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < GetSymbolTableSize(theEnv); i++)
      {
       for (symbolPtr = symbolArray[i];
            symbolPtr != NULL;
@@ -1697,7 +2110,7 @@ void SetAtomicValueIndices(
    count = 0;
    floatArray = GetFloatTable(theEnv);
 
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < GetFloatTableSize(theEnv); i++)
      {
       for (floatPtr = floatArray[i];
            floatPtr != NULL;
@@ -1719,7 +2132,7 @@ void SetAtomicValueIndices(
    count = 0;
    integerArray = GetIntegerTable(theEnv);
 
-   for (i = 0; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < GetIntegerTableSize(theEnv); i++)
      {
       for (integerPtr = integerArray[i];
            integerPtr != NULL;
@@ -1741,7 +2154,7 @@ void SetAtomicValueIndices(
    count = 0;
    bitMapArray = GetBitMapTable(theEnv);
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < GetBitMapTableSize(theEnv); i++)
      {
       for (bitMapPtr = bitMapArray[i];
            bitMapPtr != NULL;
@@ -1760,7 +2173,10 @@ void SetAtomicValueIndices(
 /***********************************************************************/
 /* RestoreAtomicValueBuckets: Restores the bucket values of hash table */
 /*   entries to the appropriate values. Normally called to undo the    */
-/*   effects of a call to the SetAtomicValueIndices function.          */
+/*   effects of a call to the SetAtomicValueIndices function. Since    */
+/*   the bucket value is the hash value of the entry rather than its   */
+/*   position in the table, it is recomputed from the entry contents.  */
+/*   For symbols it is taken from the hash value kept in the entry.    */
 /***********************************************************************/
 void RestoreAtomicValueBuckets(
   Environment *theEnv)
@@ -1777,12 +2193,12 @@ void RestoreAtomicValueBuckets(
 
    symbolArray = GetSymbolTable(theEnv);
 
-   for (i = 0; i < SYMBOL_HASH_SIZE; i++)
+   for (i = 0; i < GetSymbolTableSize(theEnv); i++)
      {
       for (symbolPtr = symbolArray[i];
            symbolPtr != NULL;
            symbolPtr = symbolPtr->next)
-        { symbolPtr->bucket = i; }
+        { symbolPtr->bucket = symbolPtr->hashValue & ATOM_HASH_MASK; }
      }
 
    /*===============================================*/
@@ -1791,12 +2207,12 @@ void RestoreAtomicValueBuckets(
 
    floatArray = GetFloatTable(theEnv);
 
-   for (i = 0; i < FLOAT_HASH_SIZE; i++)
+   for (i = 0; i < GetFloatTableSize(theEnv); i++)
      {
       for (floatPtr = floatArray[i];
            floatPtr != NULL;
            floatPtr = floatPtr->next)
-        { floatPtr->bucket = i; }
+        { floatPtr->bucket = HashFloat(floatPtr->contents,0) & ATOM_HASH_MASK; }
      }
 
    /*=================================================*/
@@ -1805,12 +2221,12 @@ void RestoreAtomicValueBuckets(
 
    integerArray = GetIntegerTable(theEnv);
 
-   for (i = 0; i < INTEGER_HASH_SIZE; i++)
+   for (i = 0; i < GetIntegerTableSize(theEnv); i++)
      {
       for (integerPtr = integerArray[i];
            integerPtr != NULL;
            integerPtr = integerPtr->next)
-        { integerPtr->bucket = i; }
+        { integerPtr->bucket = HashInteger(integerPtr->contents,0) & ATOM_HASH_MASK; }
      }
 
    /*================================================*/
@@ -1819,12 +2235,12 @@ void RestoreAtomicValueBuckets(
 
    bitMapArray = GetBitMapTable(theEnv);
 
-   for (i = 0; i < BITMAP_HASH_SIZE; i++)
+   for (i = 0; i < GetBitMapTableSize(theEnv); i++)
      {
       for (bitMapPtr = bitMapArray[i];
            bitMapPtr != NULL;
            bitMapPtr = bitMapPtr->next)
-        { bitMapPtr->bucket = i; }
+        { bitMapPtr->bucket = HashBitMap(bitMapPtr->contents,0,bitMapPtr->size) & ATOM_HASH_MASK; }
      }
   }
 
@@ -74,6 +74,15 @@
 /*                                                           */
 /*            UDF redesign.                                  */
 /*                                                           */
+/*            Atomic value hash tables resize dynamically    */
+/*            using incremental rehashing. The bucket field  */
+/*            now holds a stable hash value for the entry.   */
+/*                                                           */
+/*            Symbols hold their length in bytes and their   */
+/*            unreduced hash value.                          */
+/*                                                           */
+/*            Added EnvAddSymbolBuffer.                      */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_symbol
@@ -84,6 +93,12 @@
 
 #include <stdlib.h>
 
+/*==================================================*/
+/* The hash sizes are the initial number of buckets */
+/* for the atomic value tables. The tables grow and */
+/* shrink from these sizes based on their load.     */
+/*==================================================*/
+
 #ifndef SYMBOL_HASH_SIZE
 #define SYMBOL_HASH_SIZE       63559L
 #endif
@@ -104,6 +119,28 @@
 #define EXTERNAL_ADDRESS_HASH_SIZE        8191
 #endif
 
+#ifndef ATOM_TABLE_MAX_LOAD
+#define ATOM_TABLE_MAX_LOAD     2
+#endif
+
+#ifndef ATOM_TABLE_MIN_LOAD_DIVISOR
+#define ATOM_TABLE_MIN_LOAD_DIVISOR 8
+#endif
+
+#ifndef ATOM_TABLE_REHASH_STEP
+#define ATOM_TABLE_REHASH_STEP  4
+#endif
+
+/*==================================================*/
+/* The bucket field of an atomic value holds the    */
+/* value's hash reduced to the width of the field.  */
+/* It does not change when the table is resized, so */
+/* it can be used as a stable hash of the value.    */
+/*==================================================*/
+
+#define ATOM_HASH_MASK          0x1FFFFFFFUL
+#define MAX_ATOM_TABLE_SIZE     0x10000000UL
+
 /************************************************************/
 /* symbolHashNode STRUCTURE:                                */
 /************************************************************/
@@ -116,6 +153,8 @@ struct symbolHashNode
    unsigned int neededSymbol : 1;
    unsigned int bucket : 29;
    const char *contents;
+   size_t length;
+   unsigned long hashValue;
   };
 
 /************************************************************/
@@ -189,6 +228,24 @@ struct genericHashNode
    unsigned int bucket : 29;
   };
 
+/************************************************************/
+/* atomTableState STRUCTURE: Bookkeeping for a resizable    */
+/*   atomic value hash table. While a table is being        */
+/*   resized, entries in the buckets of oldTable that are   */
+/*   at or after rehashIndex have not yet been moved to     */
+/*   the new table.                                         */
+/************************************************************/
+struct atomTableState
+  {
+   unsigned long size;
+   unsigned long initialSize;
+   unsigned long count;
+   struct genericHashNode **oldTable;
+   unsigned long oldSize;
+   unsigned long rehashIndex;
+   unsigned long resizes;
+  };
+
 typedef struct symbolHashNode SYMBOL_HN;
 typedef struct floatHashNode FLOAT_HN;
 typedef struct integerHashNode INTEGER_HN;
@@ -262,6 +319,11 @@ struct symbolData
    INTEGER_HN **IntegerTable;
    BITMAP_HN **BitMapTable;
    EXTERNAL_ADDRESS_HN **ExternalAddressTable;
+   struct atomTableState SymbolTableState;
+   struct atomTableState FloatTableState;
+   struct atomTableState IntegerTableState;
+   struct atomTableState BitMapTableState;
+   struct atomTableState ExternalAddressTableState;
 #if BLOAD || BLOAD_ONLY || BLOAD_AND_BSAVE || BLOAD_INSTANCES || BSAVE_INSTANCES
    long NumberOfSymbols;
    long NumberOfFloats;
@@ -278,10 +340,13 @@ struct symbolData
 
 #define SymbolData(theEnv) ((struct symbolData *) GetEnvironmentData(theEnv,SYMBOL_DATA))
 
-   void                           InitializeAtomTables(Environment *,struct symbolHashNode **,struct floatHashNode **,
-                                                              struct integerHashNode **,struct bitMapHashNode **,
-                                                              struct externalAddressHashNode **);
+   void                           InitializeAtomTables(Environment *,struct symbolHashNode **,unsigned long,
+                                                       struct floatHashNode **,unsigned long,
+                                                       struct integerHashNode **,unsigned long,
+                                                       struct bitMapHashNode **,unsigned long,
+                                                       struct externalAddressHashNode **);
    void                          *EnvAddSymbol(Environment *,const char *);
+   void                          *EnvAddSymbolBuffer(Environment *,char **,size_t);
    SYMBOL_HN                     *FindSymbolHN(Environment *,const char *);
    void                          *EnvAddDouble(Environment *,double);
    void                          *EnvAddLong(Environment *,long long);
@@ -310,6 +375,11 @@ struct symbolData
    struct externalAddressHashNode        
                                 **GetExternalAddressTable(Environment *);
    void                           SetExternalAddressTable(Environment *,struct externalAddressHashNode **);
+   unsigned long                  GetSymbolTableSize(Environment *);
+   unsigned long                  GetFloatTableSize(Environment *);
+   unsigned long                  GetIntegerTableSize(Environment *);
+   unsigned long                  GetBitMapTableSize(Environment *);
+   unsigned long                  GetExternalAddressTableSize(Environment *);
    void                           RefreshSpecialSymbols(Environment *);
    struct symbolMatch            *FindSymbolMatches(Environment *,const char *,unsigned *,size_t *);
    void                           ReturnSymbolMatches(Environment *,struct symbolMatch *);
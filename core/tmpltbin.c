@@ -34,6 +34,9 @@
 /*                                                           */
 /*      6.50: Removed initial-fact support.                  */
 /*                                                           */
+/*            Added slot indexes for looking up the facts of */
+/*            a deftemplate by the value of a slot.          */
+/*                                                           */
 /*************************************************************/
 
 #include "setup.h"
@@ -101,6 +104,10 @@ static void DeallocateDeftemplateBloadData(
   Environment *theEnv)
   {
    size_t space;
+   long i;
+
+   for (i = 0; i < DeftemplateBinaryData(theEnv)->NumberOfDeftemplates; i++)
+     { ReturnSlotIndexes(theEnv,&DeftemplateBinaryData(theEnv)->DeftemplateArray[i]); }
 
    space =  DeftemplateBinaryData(theEnv)->NumberOfTemplateModules * sizeof(struct deftemplateModule);
    if (space != 0) genfree(theEnv,DeftemplateBinaryData(theEnv)->ModuleArray,space);
@@ -507,6 +514,7 @@ static void UpdateDeftemplate(
    theDeftemplate->numberOfSlots = (unsigned short) bdtPtr->numberOfSlots;
    theDeftemplate->factList = NULL;
    theDeftemplate->lastFact = NULL;
+   theDeftemplate->slotIndexes = NULL;
   }
 
 /************************************************/
@@ -559,6 +567,13 @@ static void ClearBload(
    for (i = 0; i < DeftemplateBinaryData(theEnv)->NumberOfDeftemplates; i++)
      { UnmarkConstructHeader(theEnv,&DeftemplateBinaryData(theEnv)->DeftemplateArray[i].header); }
 
+   /*=======================================*/
+   /* Free storage used by slot indexes.    */
+   /*=======================================*/
+
+   for (i = 0; i < DeftemplateBinaryData(theEnv)->NumberOfDeftemplates; i++)
+     { ReturnSlotIndexes(theEnv,&DeftemplateBinaryData(theEnv)->DeftemplateArray[i]); }
+
    /*=======================================*/
    /* Decrement in use counters for symbols */
    /* used as slot names.                   */
@@ -55,6 +55,9 @@
 /*                                                           */
 /*            ALLOW_ENVIRONMENT_GLOBALS no longer supported. */
 /*                                                           */
+/*            Added slot indexes for looking up the facts of */
+/*            a deftemplate by the value of a slot.          */
+/*                                                           */
 /*************************************************************/
 
 #include "setup.h"
@@ -348,6 +351,12 @@ static void ReturnDeftemplate(
 
    ReturnSlots(theEnv,theDeftemplate->slotList);
 
+   /*===========================================*/
+   /* Free storage used by the slot indexes.    */
+   /*===========================================*/
+
+   ReturnSlotIndexes(theEnv,theDeftemplate);
+
    /*==================================*/
    /* Free storage used by the header. */
    /*==================================*/
@@ -383,6 +392,7 @@ static void DestroyDeftemplate(
 #endif
 
    DestroyFactPatternNetwork(theEnv,theDeftemplate->patternNetwork);
+   ReturnSlotIndexes(theEnv,theDeftemplate);
    
    /*==================================*/
    /* Free storage used by the header. */
@@ -55,6 +55,9 @@
 /*                                                           */
 /*            ALLOW_ENVIRONMENT_GLOBALS no longer supported. */
 /*                                                           */
+/*            Added slot indexes for looking up the facts of */
+/*            a deftemplate by the value of a slot.          */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_tmpltdef
@@ -67,6 +70,7 @@ typedef struct deftemplate Deftemplate;
 
 struct templateSlot;
 struct deftemplateModule;
+struct factSlotIndex;
 
 #include "constrct.h"
 #include "factbld.h"
@@ -92,6 +96,7 @@ struct deftemplate
    struct factPatternNode *patternNetwork;
    struct fact *factList;
    struct fact *lastFact;
+   struct factSlotIndex *slotIndexes;
   };
 
 struct templateSlot
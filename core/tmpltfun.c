@@ -82,6 +82,16 @@
 /*                                                           */
 /*            Fact ?var:slot references in defrule actions.  */
 /*                                                           */
+/*            Modify and duplicate look up fact-indices in   */
+/*            the fact index table.                          */
+/*                                                           */
+/*            Added create-index and find-facts-by-slot      */
+/*            functions.                                     */
+/*                                                           */
+/*            Modify updates the fact's hash value for the   */
+/*            changed slots and passes the change map to the */
+/*            modify callback functions.                     */
+/*                                                           */
 /*************************************************************/
 
 #include "setup.h"
@@ -98,6 +108,7 @@
 #include "default.h"
 #include "envrnmnt.h"
 #include "exprnpsr.h"
+#include "facthsh.h"
 #include "factmngr.h"
 #include "factrhs.h"
 #include "memalloc.h"
@@ -121,6 +132,7 @@
 
    static void                    DuplicateModifyCommand(Environment *,int,CLIPSValue *);
    static SYMBOL_HN              *CheckDeftemplateAndSlotArguments(UDFContext *,Deftemplate **);
+   static struct templateSlot    *FindIndexableSlot(Environment *,Deftemplate *,const char *,short *);
 
 #if (! RUN_TIME) && (! BLOAD_ONLY)
    static struct expr            *ModAndDupParse(Environment *,struct expr *,const char *,const char *);
@@ -152,6 +164,9 @@ void DeftemplateFunctions(
 
    EnvAddUDF(theEnv,"deftemplate-slot-facet-value","*",3,3,"y",DeftemplateSlotFacetValueFunction,"DeftemplateSlotFacetValueFunction",NULL);
 
+   EnvAddUDF(theEnv,"create-index","b",2,2,"y",CreateIndexCommand,"CreateIndexCommand",NULL);
+   EnvAddUDF(theEnv,"find-facts-by-slot","m",3,3,"*;y;y",FindFactsBySlotFunction,"FindFactsBySlotFunction",NULL);
+
 #if (! BLOAD_ONLY)
    AddFunctionParser(theEnv,"modify",ModifyParse);
    AddFunctionParser(theEnv,"duplicate",DuplicateParse);
@@ -224,7 +239,7 @@ void ModifyCommand(
 
    /*==============================================================*/
    /* If an integer is supplied, then treat it as a fact-index and */
-   /* search the fact-list for the fact with that fact-index.      */
+   /* look up the fact with that fact-index.                       */
    /*==============================================================*/
 
    if (computeResult.type == INTEGER)
@@ -237,14 +252,7 @@ void ModifyCommand(
          return;
         }
 
-      oldFact = (struct fact *) EnvGetNextFact(theEnv,NULL);
-      while (oldFact != NULL)
-        {
-         if (oldFact->factIndex == factNum)
-           { break; }
-         else
-           { oldFact = oldFact->nextFact; }
-        }
+      oldFact = FindIndexedFact(theEnv,factNum);
 
       if (oldFact == NULL)
         {
@@ -481,7 +489,7 @@ void ModifyCommand(
            theModifyFunction = theModifyFunction->next)
         {
          SetEnvironmentCallbackContext(theEnv,theModifyFunction->context);
-         ((void (*)(void *,void *,void *))(*theModifyFunction->func))(theEnv,oldFact,NULL);
+         ((void (*)(Environment *,void *,void *,const char *))(*theModifyFunction->func))(theEnv,oldFact,NULL,changeMap);
         }
      }
      
@@ -503,14 +511,18 @@ void ModifyCommand(
    RetractDriver(theEnv,oldFact,true,changeMap);
    oldFact->garbage = false;
 
-   /*======================================*/
-   /* Copy the new values to the old fact. */
-   /*======================================*/
+   /*=====================================================*/
+   /* Copy the new values to the old fact. Only the slots */
+   /* that changed are replaced and contribute to the new */
+   /* hash value of the fact.                             */
+   /*=====================================================*/
    
    for (i = 0; i < (int) oldFact->theProposition.multifieldLength; i++)
      {
       if (theDOArray[i].type != RVOID)
         {
+         UpdateFactHash(oldFact,(unsigned long) i,theDOArray[i].type,theDOArray[i].value);
+
          if (oldFact->theProposition.theFields[i].type == MULTIFIELD)
            {
             struct multifield *theSegment = oldFact->theProposition.theFields[i].value;
@@ -557,7 +569,7 @@ void ModifyCommand(
            theModifyFunction = theModifyFunction->next)
         {
          SetEnvironmentCallbackContext(theEnv,theModifyFunction->context);
-         ((void (*)(void *,void *,void *))(*theModifyFunction->func))(theEnv,NULL,theFact);
+         ((void (*)(Environment *,void *,void *,const char *))(*theModifyFunction->func))(theEnv,NULL,theFact,changeMap);
         }
      }
      
@@ -609,7 +621,7 @@ void DuplicateCommand(
 
    /*==============================================================*/
    /* If an integer is supplied, then treat it as a fact-index and */
-   /* search the fact-list for the fact with that fact-index.      */
+   /* look up the fact with that fact-index.                       */
    /*==============================================================*/
 
    if (computeResult.type == INTEGER)
@@ -622,14 +634,7 @@ void DuplicateCommand(
          return;
         }
 
-      oldFact = EnvGetNextFact(theEnv,NULL);
-      while (oldFact != NULL)
-        {
-         if (oldFact->factIndex == factNum)
-           { break; }
-         else
-           { oldFact = oldFact->nextFact; }
-        }
+      oldFact = FindIndexedFact(theEnv,factNum);
 
       if (oldFact == NULL)
         {
@@ -2075,6 +2080,250 @@ bool EnvDeftemplateSlotFacetValue(
    return false;
   }  
   
+/*********************************************/
+/* CreateIndexCommand: H/L access routine    */
+/*   for the create-index command.           */
+/*********************************************/
+void CreateIndexCommand(
+  Environment *theEnv,
+  UDFContext *context,
+  CLIPSValue *returnValue)
+  {
+   Deftemplate *theDeftemplate;
+   SYMBOL_HN *slotName;
+
+   /*===================================================*/
+   /* Retrieve the deftemplate and slot name arguments. */
+   /*===================================================*/
+   
+   slotName = CheckDeftemplateAndSlotArguments(context,&theDeftemplate);
+   if (slotName == NULL)
+     {
+      mCVSetBoolean(returnValue,false);
+      return;
+     }
+
+   /*===================*/
+   /* Create the index. */
+   /*===================*/
+
+   mCVSetBoolean(returnValue,EnvCreateIndex(theEnv,theDeftemplate,ValueToString(slotName)));
+  }
+
+/************************************************/
+/* EnvCreateIndex: C access routine for the     */
+/*   create-index command. Indexes the facts of */
+/*   a deftemplate by the value of a single     */
+/*   field slot so that find-facts-by-slot and  */
+/*   fact-set queries testing the slot with eq  */
+/*   can look them up rather than search for    */
+/*   them. Returns true if the slot is indexed. */
+/************************************************/
+bool EnvCreateIndex(
+  Environment *theEnv,
+  Deftemplate *theDeftemplate,
+  const char *slotName)
+  {
+   struct templateSlot *theSlot;
+   short position;
+
+   theSlot = FindIndexableSlot(theEnv,theDeftemplate,slotName,&position);
+   if (theSlot == NULL)
+     { return false; }
+
+   CreateSlotIndex(theEnv,theDeftemplate,theSlot->slotName,(unsigned short) (position - 1));
+
+   return true;
+  }
+
+/****************************************************/
+/* FindFactsBySlotFunction: H/L access routine      */
+/*   for the find-facts-by-slot function.           */
+/****************************************************/
+void FindFactsBySlotFunction(
+  Environment *theEnv,
+  UDFContext *context,
+  CLIPSValue *returnValue)
+  {
+   Deftemplate *theDeftemplate;
+   SYMBOL_HN *slotName;
+   CLIPSValue theValue;
+
+   /*===================================================*/
+   /* Retrieve the deftemplate and slot name arguments. */
+   /*===================================================*/
+   
+   slotName = CheckDeftemplateAndSlotArguments(context,&theDeftemplate);
+   if (slotName == NULL)
+     {
+      EnvSetMultifieldErrorValue(theEnv,returnValue);
+      return;
+     }
+
+   /*============================*/
+   /* Get the value to look for. */
+   /*============================*/
+
+   if (! UDFNthArgument(context,3,ANY_TYPE,&theValue))
+     {
+      EnvSetMultifieldErrorValue(theEnv,returnValue);
+      return;
+     }
+
+   /*====================*/
+   /* Look up the facts. */
+   /*====================*/
+
+   EnvFindFactsBySlot(theEnv,theDeftemplate,ValueToString(slotName),&theValue,returnValue);
+  }
+
+/****************************************************/
+/* EnvFindFactsBySlot: C access routine for the     */
+/*   find-facts-by-slot function. Returns in a      */
+/*   multifield the facts of a deftemplate whose    */
+/*   single field slot holds a value eq to the      */
+/*   specified value, in the order they appear in   */
+/*   the fact-list. The facts are looked up in the  */
+/*   index of the slot if it has one and otherwise  */
+/*   the facts of the deftemplate are searched.     */
+/****************************************************/
+bool EnvFindFactsBySlot(
+  Environment *theEnv,
+  Deftemplate *theDeftemplate,
+  const char *slotName,
+  CLIPSValue *theValue,
+  CLIPSValue *returnValue)
+  {
+   struct templateSlot *theSlot;
+   struct factSlotIndex *theIndex;
+   struct field *theField;
+   Fact **theFacts, *theFact;
+   unsigned long count, i;
+   short position;
+
+   EnvSetMultifieldErrorValue(theEnv,returnValue);
+
+   theSlot = FindIndexableSlot(theEnv,theDeftemplate,slotName,&position);
+   if (theSlot == NULL)
+     { return false; }
+
+   /*=======================================*/
+   /* Use the index of the slot if it has   */
+   /* one. The facts come back in the order */
+   /* they appear in the fact-list.         */
+   /*=======================================*/
+
+   theIndex = FindSlotIndex(theDeftemplate,theSlot->slotName);
+   if (theIndex != NULL)
+     {
+      count = FindIndexedFacts(theEnv,theIndex,GetType(*theValue),GetValue(*theValue),&theFacts);
+      if (count == 0)
+        { return true; }
+
+      returnValue->value = EnvCreateMultifield(theEnv,count);
+      SetpDOBegin(returnValue,1);
+      SetpDOEnd(returnValue,(long) count);
+      for (i = 0; i < count; i++)
+        {
+         SetMFType(returnValue->value,i + 1,FACT_ADDRESS);
+         SetMFValue(returnValue->value,i + 1,theFacts[i]);
+        }
+
+      rm(theEnv,theFacts,sizeof(Fact *) * count);
+      return true;
+     }
+
+   /*=======================================*/
+   /* Otherwise count the matching facts of */
+   /* the deftemplate and then gather them. */
+   /*=======================================*/
+
+   if (GetType(*theValue) == MULTIFIELD)
+     { return true; }
+
+   for (theFact = theDeftemplate->factList, count = 0;
+        theFact != NULL;
+        theFact = theFact->nextTemplateFact)
+     {
+      theField = &theFact->theProposition.theFields[position - 1];
+      if ((theField->type == GetType(*theValue)) && (theField->value == GetValue(*theValue)))
+        { count++; }
+     }
+
+   if (count == 0)
+     { return true; }
+
+   returnValue->value = EnvCreateMultifield(theEnv,count);
+   SetpDOBegin(returnValue,1);
+   SetpDOEnd(returnValue,(long) count);
+   for (theFact = theDeftemplate->factList, i = 1;
+        theFact != NULL;
+        theFact = theFact->nextTemplateFact)
+     {
+      theField = &theFact->theProposition.theFields[position - 1];
+      if ((theField->type == GetType(*theValue)) && (theField->value == GetValue(*theValue)))
+        {
+         SetMFType(returnValue->value,i,FACT_ADDRESS);
+         SetMFValue(returnValue->value,i,theFact);
+         i++;
+        }
+     }
+
+   return true;
+  }
+
+/**************************************************************/
+/* FindIndexableSlot: Finds a slot of a deftemplate which can */
+/*   be indexed for create-index and find-facts-by-slot. Only */
+/*   the single field slots of an explicit deftemplate can be */
+/*   indexed (the implied slot of an ordered fact is a        */
+/*   multifield slot).                                        */
+/**************************************************************/
+static struct templateSlot *FindIndexableSlot(
+  Environment *theEnv,
+  Deftemplate *theDeftemplate,
+  const char *slotName,
+  short *position)
+  {
+   struct templateSlot *theSlot;
+
+   if (theDeftemplate->implied)
+     { theSlot = NULL; }
+   else
+     { theSlot = FindSlot(theDeftemplate,(SYMBOL_HN *) EnvAddSymbol(theEnv,slotName),position); }
+
+   /*==============================================*/
+   /* The slot must be defined by the deftemplate. */
+   /*==============================================*/
+
+   if ((theSlot == NULL) &&
+       ((! theDeftemplate->implied) || (strcmp(slotName,"implied") != 0)))
+     {
+      EnvSetEvaluationError(theEnv,true);
+      InvalidDeftemplateSlotMessage(theEnv,slotName,
+                                    ValueToString(theDeftemplate->header.name),false);
+      return NULL;
+     }
+
+   /*======================================*/
+   /* It must also be a single field slot. */
+   /*======================================*/
+
+   if ((theSlot == NULL) ? true : theSlot->multislot)
+     {
+      EnvSetEvaluationError(theEnv,true);
+      PrintErrorID(theEnv,"TMPLTFUN",3,false);
+      EnvPrintRouter(theEnv,WERROR,"The multifield slot ");
+      EnvPrintRouter(theEnv,WERROR,slotName);
+      EnvPrintRouter(theEnv,WERROR," of deftemplate ");
+      EnvPrintRouter(theEnv,WERROR,ValueToString(theDeftemplate->header.name));
+      EnvPrintRouter(theEnv,WERROR," cannot be indexed.\n");
+      return NULL;
+     }
+
+   return theSlot;
+  }
+
 /************************************************************/
 /* CheckDeftemplateAndSlotArguments: Checks the deftemplate */
 /*   and slot arguments for various functions.              */
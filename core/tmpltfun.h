@@ -70,6 +70,9 @@
 /*                                                           */
 /*      6.50: Fact ?var:slot references in defrule actions.  */
 /*                                                           */
+/*            Added create-index and find-facts-by-slot      */
+/*            functions.                                     */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_tmpltfun
@@ -114,6 +117,10 @@
    bool                           EnvDeftemplateSlotFacetExistP(Environment *,Deftemplate *,const char *,const char *);
    void                           DeftemplateSlotFacetValueFunction(Environment *,UDFContext *,CLIPSValue *);
    bool                           EnvDeftemplateSlotFacetValue(Environment *,Deftemplate *,const char *,const char *,CLIPSValue *);
+   void                           CreateIndexCommand(Environment *,UDFContext *,CLIPSValue *);
+   bool                           EnvCreateIndex(Environment *,Deftemplate *,const char *);
+   void                           FindFactsBySlotFunction(Environment *,UDFContext *,CLIPSValue *);
+   bool                           EnvFindFactsBySlot(Environment *,Deftemplate *,const char *,CLIPSValue *,CLIPSValue *);
    SYMBOL_HN                     *FindTemplateForFactAddress(SYMBOL_HN *,struct lhsParseNode *);
 
 #endif /* _H_tmpltfun */
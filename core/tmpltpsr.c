@@ -177,6 +177,7 @@ bool ParseDeftemplate(
    newDeftemplate->patternNetwork = NULL;
    newDeftemplate->factList = NULL;
    newDeftemplate->lastFact = NULL;
+   newDeftemplate->slotIndexes = NULL;
    newDeftemplate->header.whichModule = (struct defmoduleItemHeader *)
                                         GetModuleItem(theEnv,NULL,DeftemplateData(theEnv)->DeftemplateModuleIndex);
 
@@ -582,6 +582,7 @@ Deftemplate *CreateImpliedDeftemplate(
    newDeftemplate->patternNetwork = NULL;
    newDeftemplate->factList = NULL;
    newDeftemplate->lastFact = NULL;
+   newDeftemplate->slotIndexes = NULL;
    newDeftemplate->busyCount = 0;
    newDeftemplate->watch = false;
    newDeftemplate->header.next = NULL;
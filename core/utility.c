@@ -65,6 +65,13 @@
 /*      6.50: Added CLIPSBlockStart and CLIPSBlockEnd        */
 /*            functions for garbage collection blocks.       */
 /*                                                           */
+/*            ItemHashValue uses the hash value kept in the  */
+/*            symbol table entry for symbols and strings.    */
+/*                                                           */
+/*            Added StringBuilder functions which enlarge    */
+/*            their buffer geometrically and can hand it     */
+/*            over to the symbol table.                      */
+/*                                                           */
 /*************************************************************/
 
 #include "setup.h"
@@ -95,6 +102,7 @@
 /***************************************/
 
    static void                    DeallocateUtilityData(Environment *);
+   static void                    SBExpand(StringBuilder *,size_t);
 
 /************************************************/
 /* InitializeUtilityData: Allocates environment */
@@ -455,29 +463,32 @@ const char *StringPrintForm(
   Environment *theEnv,
   const char *str)
   {
-   int i = 0;
-   size_t pos = 0;
-   size_t max = 0;
-   char *theString = NULL;
+   const char *segment;
+   StringBuilder *theSB;
    void *thePtr;
 
-   theString = ExpandStringWithChar(theEnv,'"',theString,&pos,&max,max+80);
-   while (str[i] != EOS)
+   theSB = CreateStringBuilder(theEnv,strlen(str) + 2);
+
+   SBAddChar(theSB,'"');
+   while (*str != EOS)
      {
-      if ((str[i] == '"') || (str[i] == '\\'))
+      segment = str;
+      while ((*str != EOS) && (*str != '"') && (*str != '\\'))
+        { str++; }
+
+      SBAppendN(theSB,segment,(size_t) (str - segment));
+
+      if (*str != EOS)
         {
-         theString = ExpandStringWithChar(theEnv,'\\',theString,&pos,&max,max+80);
-         theString = ExpandStringWithChar(theEnv,str[i],theString,&pos,&max,max+80);
+         SBAddChar(theSB,'\\');
+         SBAddChar(theSB,*str);
+         str++;
         }
-      else
-        { theString = ExpandStringWithChar(theEnv,str[i],theString,&pos,&max,max+80); }
-      i++;
      }
+   SBAddChar(theSB,'"');
 
-   theString = ExpandStringWithChar(theEnv,'"',theString,&pos,&max,max+80);
-
-   thePtr = EnvAddSymbol(theEnv,theString);
-   rm(theEnv,theString,max);
+   thePtr = SBAddSymbol(theSB);
+   SBDispose(theSB);
    return(ValueToString(thePtr));
   }
 
@@ -520,16 +531,17 @@ const char *AppendStrings(
   const char *str1,
   const char *str2)
   {
-   size_t pos = 0;
-   size_t max = 0;
-   char *theString = NULL;
+   size_t length1 = strlen(str1);
+   size_t length2 = strlen(str2);
+   StringBuilder *theSB;
    void *thePtr;
 
-   theString = AppendToString(theEnv,str1,theString,&pos,&max);
-   theString = AppendToString(theEnv,str2,theString,&pos,&max);
+   theSB = CreateStringBuilder(theEnv,length1 + length2);
+   SBAppendN(theSB,str1,length1);
+   SBAppendN(theSB,str2,length2);
 
-   thePtr = EnvAddSymbol(theEnv,theString);
-   rm(theEnv,theString,max);
+   thePtr = SBAddSymbol(theSB);
+   SBDispose(theSB);
    return(ValueToString(thePtr));
   }
 
@@ -755,6 +767,171 @@ char *ExpandStringWithChar(
    return(str);
   }
 
+/**************************************************************/
+/* CreateStringBuilder: Creates a string builder which can    */
+/*   hold a string of the specified length before it has to   */
+/*   enlarge its buffer. Unlike the AppendToString functions, */
+/*   the buffer is doubled in size when it is enlarged so a   */
+/*   string built a piece at a time is copied only a few      */
+/*   times rather than once for every piece appended.         */
+/**************************************************************/
+StringBuilder *CreateStringBuilder(
+  Environment *theEnv,
+  size_t initialLength)
+  {
+   StringBuilder *theSB;
+
+   theSB = get_struct(theEnv,stringBuilder);
+   theSB->sbEnv = theEnv;
+   theSB->length = 0;
+   theSB->bufferMaximum = initialLength + 1;
+   theSB->contents = (char *) gm2(theEnv,theSB->bufferMaximum);
+   theSB->contents[0] = EOS;
+
+   return theSB;
+  }
+
+/*************************************************************/
+/* SBExpand: Enlarges the buffer of a string builder so it   */
+/*   can hold the specified number of additional characters  */
+/*   (plus the terminating EOS). The buffer is at least      */
+/*   doubled in size each time it has to be enlarged.        */
+/*************************************************************/
+static void SBExpand(
+  StringBuilder *theSB,
+  size_t additionalLength)
+  {
+   Environment *theEnv = theSB->sbEnv;
+   size_t needed, newMaximum;
+   char *newContents;
+
+   needed = theSB->length + additionalLength + 1;
+   if (needed <= theSB->bufferMaximum) return;
+
+   newMaximum = theSB->bufferMaximum * 2;
+   if (newMaximum < needed)
+     { newMaximum = needed; }
+
+   newContents = (char *) gm2(theEnv,newMaximum);
+   if (theSB->contents != NULL)
+     {
+      memcpy(newContents,theSB->contents,theSB->length + 1);
+      rm(theEnv,theSB->contents,theSB->bufferMaximum);
+     }
+   else
+     { newContents[0] = EOS; }
+
+   theSB->contents = newContents;
+   theSB->bufferMaximum = newMaximum;
+  }
+
+/***************************************************/
+/* SBAppend: Appends a string to a string builder. */
+/***************************************************/
+void SBAppend(
+  StringBuilder *theSB,
+  const char *appendStr)
+  {
+   SBAppendN(theSB,appendStr,strlen(appendStr));
+  }
+
+/***********************************************************/
+/* SBAppendN: Appends the specified number of characters   */
+/*   from a string to a string builder. The characters     */
+/*   appended must not include an EOS.                     */
+/***********************************************************/
+void SBAppendN(
+  StringBuilder *theSB,
+  const char *appendStr,
+  size_t length)
+  {
+   SBExpand(theSB,length);
+
+   memcpy(&theSB->contents[theSB->length],appendStr,length);
+   theSB->length += length;
+   theSB->contents[theSB->length] = EOS;
+  }
+
+/***********************************************************/
+/* SBAddChar: Adds a character to a string builder. As     */
+/*   with ExpandStringWithChar, the backspace character    */
+/*   removes the last UTF-8 character from the string.     */
+/***********************************************************/
+void SBAddChar(
+  StringBuilder *theSB,
+  int inchar)
+  {
+   if (inchar != '\b')
+     {
+      SBExpand(theSB,1);
+      theSB->contents[theSB->length++] = (char) inchar;
+      theSB->contents[theSB->length] = EOS;
+      return;
+     }
+
+   if (theSB->contents == NULL) return;
+
+   while ((theSB->length > 1) &&
+          IsUTF8MultiByteContinuation(theSB->contents[theSB->length - 1]))
+     { theSB->length--; }
+
+   if (theSB->length > 0) theSB->length--;
+   theSB->contents[theSB->length] = EOS;
+  }
+
+/**************************************************************/
+/* SBAddSymbol: Adds the contents of a string builder to the  */
+/*   symbol table and empties the string builder. If the      */
+/*   symbol is new and the buffer is exactly the size of the  */
+/*   string, the buffer is handed over to the symbol table    */
+/*   rather than copied and the string builder allocates a    */
+/*   new buffer the next time something is appended to it.    */
+/**************************************************************/
+void *SBAddSymbol(
+  StringBuilder *theSB)
+  {
+   void *thePtr;
+
+   if (theSB->contents == NULL)
+     { return EnvAddSymbol(theSB->sbEnv,""); }
+
+   thePtr = EnvAddSymbolBuffer(theSB->sbEnv,&theSB->contents,theSB->bufferMaximum);
+   if (theSB->contents == NULL)
+     { theSB->bufferMaximum = 0; }
+   else
+     { theSB->contents[0] = EOS; }
+   theSB->length = 0;
+
+   return thePtr;
+  }
+
+/*****************************************************/
+/* SBReset: Empties a string builder, keeping its    */
+/*   buffer for the next string built with it.       */
+/*****************************************************/
+void SBReset(
+  StringBuilder *theSB)
+  {
+   theSB->length = 0;
+   if (theSB->contents != NULL)
+     { theSB->contents[0] = EOS; }
+  }
+
+/**************************************************/
+/* SBDispose: Deletes a string builder along with */
+/*   the buffer used for its contents.            */
+/**************************************************/
+void SBDispose(
+  StringBuilder *theSB)
+  {
+   Environment *theEnv = theSB->sbEnv;
+
+   if (theSB->contents != NULL)
+     { rm(theEnv,theSB->contents,theSB->bufferMaximum); }
+
+   rtn_struct(theEnv,stringBuilder,theSB);
+  }
+
 /*****************************************************************/
 /* AddFunctionToCallList: Adds a function to a list of functions */
 /*   which are called to perform certain operations (e.g. clear, */
@@ -1055,7 +1232,9 @@ unsigned long ItemHashValue(
 #if OBJECT_SYSTEM
       case INSTANCE_NAME:
 #endif
-        return(HashSymbol(ValueToString(theValue),theRange));
+        if (theRange == 0)
+          { return(((SYMBOL_HN *) theValue)->hashValue); }
+        return(((SYMBOL_HN *) theValue)->hashValue % theRange);
 
       case MULTIFIELD:
         return(HashMultifield((struct multifield *) theValue,theRange));
@@ -64,6 +64,8 @@
 /*      6.50: Added CLIPSBlockStart and CLIPSBlockEnd        */
 /*            functions for garbage collection blocks.       */
 /*                                                           */
+/*            Added StringBuilder functions.                 */
+/*                                                           */
 /*************************************************************/
 
 #ifndef _H_utility
@@ -121,6 +123,14 @@ struct CLIPSBlock
    CLIPSValue *result;
   };
 
+typedef struct stringBuilder
+  {
+   Environment *sbEnv;
+   char *contents;
+   size_t length;
+   size_t bufferMaximum;
+  } StringBuilder;
+
 #define UTILITY_DATA 55
 
 struct utilityData
@@ -159,6 +169,13 @@ struct utilityData
    char                          *AppendNToString(Environment *,const char *,char *,size_t,size_t *,size_t *);
    char                          *EnlargeString(Environment *,size_t,char *,size_t *,size_t *);
    char                          *ExpandStringWithChar(Environment *,int,char *,size_t *,size_t *,size_t);
+   StringBuilder                 *CreateStringBuilder(Environment *,size_t);
+   void                           SBAppend(StringBuilder *,const char *);
+   void                           SBAppendN(StringBuilder *,const char *,size_t);
+   void                           SBAddChar(StringBuilder *,int);
+   void                          *SBAddSymbol(StringBuilder *);
+   void                           SBReset(StringBuilder *);
+   void                           SBDispose(StringBuilder *);
    struct callFunctionItem       *AddFunctionToCallList(Environment *,const char *,int,void (*)(Environment *),
                                                                struct callFunctionItem *);
    struct callFunctionItem       *AddFunctionToCallListWithContext(Environment *,const char *,int,void (*)(Environment *),